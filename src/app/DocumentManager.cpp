@@ -86,8 +86,9 @@ tikz::ui::Document *DocumentManager::openUrl(const QUrl &url)
         doc = createDocument();
     }
 
+    // large documents show up before all items are created
     if (!u.isEmpty()) {
-        doc->load(u);
+        doc->loadProgressive(u);
     }
 
     return doc;
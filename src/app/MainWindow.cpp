@@ -170,6 +170,8 @@ void MainWindow::setupUi()
     auto historyDockWidget = new QDockWidget("History", this);
     m_historyView = new QTreeView(historyDockWidget);
     m_historyView->setHeaderHidden(true);
+    // only query the visible rows of a possibly long history
+    m_historyView->setUniformRowHeights(true);
     m_historyView->setAlternatingRowColors(true);
     historyDockWidget->setWidget(m_historyView);
     addDockWidget(Qt::RightDockWidgetArea, historyDockWidget);
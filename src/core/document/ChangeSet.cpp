@@ -0,0 +1,109 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "ChangeSet.h"
+#include "PropertyManager.h"
+
+namespace tikz {
+namespace core {
+
+bool ChangeSet::isEmpty() const
+{
+    return m_entities.isEmpty();
+}
+
+void ChangeSet::clear()
+{
+    m_entities.clear();
+    m_properties.clear();
+    m_created.clear();
+    m_deleted.clear();
+}
+
+QVector<Uid> ChangeSet::entities() const
+{
+    return m_entities;
+}
+
+bool ChangeSet::contains(const Uid & uid) const
+{
+    return m_properties.contains(uid);
+}
+
+QVector<int> ChangeSet::properties(const Uid & uid) const
+{
+    return m_properties.value(uid);
+}
+
+bool ChangeSet::propertyChanged(const Uid & uid, int propertyId) const
+{
+    const auto it = m_properties.constFind(uid);
+    return it != m_properties.constEnd() && it->contains(propertyId);
+}
+
+bool ChangeSet::propertyChanged(const Uid & uid, const QString & name) const
+{
+    return propertyChanged(uid, propertyManager().propertyId(name));
+}
+
+QVector<Uid> ChangeSet::created() const
+{
+    return m_created;
+}
+
+QVector<Uid> ChangeSet::deleted() const
+{
+    return m_deleted;
+}
+
+void ChangeSet::addEntity(const Uid & uid)
+{
+    // m_properties contains an entry for each changed entity
+    if (!m_properties.contains(uid)) {
+        m_properties.insert(uid, QVector<int>());
+        m_entities.append(uid);
+    }
+}
+
+void ChangeSet::addProperty(const Uid & uid, int propertyId)
+{
+    addEntity(uid);
+
+    auto & properties = m_properties[uid];
+    if (!properties.contains(propertyId)) {
+        properties.append(propertyId);
+    }
+}
+
+void ChangeSet::addCreated(const Uid & uid)
+{
+    addEntity(uid);
+    m_created.append(uid);
+}
+
+void ChangeSet::addDeleted(const Uid & uid)
+{
+    addEntity(uid);
+    m_deleted.append(uid);
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
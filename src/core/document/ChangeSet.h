@@ -0,0 +1,144 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_CHANGE_SET_H
+#define TIKZ_CORE_CHANGE_SET_H
+
+#include "tikz_export.h"
+#include "Uid.h"
+
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+namespace tikz {
+namespace core {
+
+/**
+ * The ChangeSet records which entities changed within a transaction.
+ *
+ * For each entity, the ChangeSet lists the ids of the changed properties,
+ * as far as they are known. For instance, a Style inheriting a changed
+ * property from its parent style is contained in the ChangeSet, but
+ * without properties.
+ *
+ * The property ids are the ids of PropertyManager::propertyId(), which are
+ * also used by the undo items, and cover the properties of all entity types
+ * in contrast to Style::Property.
+ *
+ * The Document collects all changes and passes the ChangeSet with
+ * Document::changesCommitted() once the outermost transaction finished.
+ */
+class TIKZKITCORE_EXPORT ChangeSet
+{
+    public:
+        /**
+         * Returns @e true, if no changes are recorded.
+         */
+        bool isEmpty() const;
+
+        /**
+         * Removes all recorded changes.
+         */
+        void clear();
+
+        /**
+         * Returns all changed entities in the order of their first change.
+         * Created and deleted entities are included.
+         */
+        QVector<Uid> entities() const;
+
+        /**
+         * Returns @e true, if the entity @p uid changed.
+         */
+        bool contains(const Uid & uid) const;
+
+        /**
+         * Returns the ids of the changed properties of entity @p uid.
+         * The list is empty, if the changed properties are not known.
+         */
+        QVector<int> properties(const Uid & uid) const;
+
+        /**
+         * Returns @e true, if the property with id @p propertyId of entity
+         * @p uid changed.
+         */
+        bool propertyChanged(const Uid & uid, int propertyId) const;
+
+        /**
+         * Returns @e true, if the property @p name of entity @p uid changed.
+         */
+        bool propertyChanged(const Uid & uid, const QString & name) const;
+
+        /**
+         * Returns all entities created in the transaction.
+         */
+        QVector<Uid> created() const;
+
+        /**
+         * Returns all entities deleted in the transaction.
+         */
+        QVector<Uid> deleted() const;
+
+    //
+    // recording, typically only used by the Document
+    //
+    public:
+        /**
+         * Records that entity @p uid changed.
+         */
+        void addEntity(const Uid & uid);
+
+        /**
+         * Records that the property with id @p propertyId of entity @p uid
+         * changed.
+         */
+        void addProperty(const Uid & uid, int propertyId);
+
+        /**
+         * Records that entity @p uid was created.
+         */
+        void addCreated(const Uid & uid);
+
+        /**
+         * Records that entity @p uid was deleted.
+         */
+        void addDeleted(const Uid & uid);
+
+    private:
+        // changed entities in order of their first change
+        QVector<Uid> m_entities;
+
+        // changed properties for each changed entity
+        QHash<Uid, QVector<int>> m_properties;
+
+        // created and deleted entities
+        QVector<Uid> m_created;
+        QVector<Uid> m_deleted;
+};
+
+}
+}
+
+Q_DECLARE_METATYPE(tikz::core::ChangeSet)
+
+#endif // TIKZ_CORE_CHANGE_SET_H
+
+// kate: indent-width 4; replace-tabs on;
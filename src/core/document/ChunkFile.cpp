@@ -0,0 +1,525 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "ChunkFile.h"
+#include "UndoGroup.h"
+
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborValue>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace tikz {
+namespace core {
+
+namespace {
+    // file header: magic, version, and the offset of the root chunk.
+    // Version 1 stored property ids in the history, see UndoSetProperty.
+    constexpr char s_magic[] = "TKZC";
+    constexpr quint32 s_version = 2;
+    constexpr qint64 s_headerSize = 16;
+    constexpr qint64 s_rootOffsetPos = 8;
+
+    // each chunk is prefixed with its size
+    constexpr qint64 s_frameSize = sizeof(quint32);
+
+    // each page of the entity table covers 2^10 ids
+    constexpr int s_pageBits = 10;
+
+    // files are not compacted below this amount of unreferenced bytes
+    constexpr qint64 s_minWaste = 256 * 1024;
+
+    qint64 pageOf(qint64 id)
+    {
+        return id >> s_pageBits;
+    }
+
+    // writes the file buffers to the disk, so that the chunks are stored
+    // before the header refers to them
+    bool syncFile(QFileDevice * file)
+    {
+        if (!file->flush()) {
+            return false;
+        }
+#ifdef Q_OS_UNIX
+        return ::fsync(file->handle()) == 0;
+#else
+        return true;
+#endif
+    }
+
+    QCborArray toCbor(const ChunkRef & chunk)
+    {
+        return { chunk.offset, chunk.size };
+    }
+
+    ChunkRef chunkFromCbor(const QCborArray & array, int index)
+    {
+        ChunkRef chunk;
+        chunk.offset = array.at(index).toInteger(-1);
+        chunk.size = static_cast<qint32>(array.at(index + 1).toInteger());
+        return chunk;
+    }
+}
+
+ChunkFile::ChunkFile()
+{
+}
+
+ChunkFile::~ChunkFile()
+{
+    close();
+}
+
+bool ChunkFile::isChunkFile(const QByteArray & data)
+{
+    return data.startsWith(s_magic);
+}
+
+bool ChunkFile::create(const QString & filename)
+{
+    close();
+
+    // the previous file is replaced only once commit() succeeded
+    m_file.reset(new QSaveFile(filename));
+    m_created = true;
+    if (!m_file->open(QIODevice::WriteOnly)) {
+        close();
+        return false;
+    }
+
+    if (!writeHeader(0)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ChunkFile::open(const QString & filename)
+{
+    close();
+
+    m_file.reset(new QFile(filename));
+    if (!m_file->open(QIODevice::ReadWrite)) {
+        m_file.reset();
+        return false;
+    }
+
+    // the tables are read from the mapped file, see read()
+    m_mapSize = m_file->size();
+    m_map = m_file->map(0, m_mapSize);
+
+    if (!m_map || !readTables()) {
+        qWarning() << "Invalid chunk file" << filename;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void ChunkFile::close()
+{
+    releaseMapping();
+    if (m_file && m_created) {
+        static_cast<QSaveFile *>(m_file.get())->cancelWriting();
+    }
+    m_file.reset();
+    m_created = false;
+
+    m_pages.clear();
+    m_dirtyPages.clear();
+    m_properties.clear();
+    m_history.clear();
+    m_historyChunks.clear();
+    m_chunks.clear();
+    m_end = 0;
+    m_entityBytes = 0;
+    m_liveBytes = 0;
+}
+
+bool ChunkFile::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+QString ChunkFile::fileName() const
+{
+    return m_file ? m_file->fileName() : QString();
+}
+
+QVector<ChunkFile::EntityEntry> ChunkFile::entities() const
+{
+    QVector<EntityEntry> entries;
+    for (const auto & page : m_pages) {
+        for (const auto & entry : page.entries) {
+            entries.append(entry);
+        }
+    }
+    return entries;
+}
+
+QByteArray ChunkFile::properties() const
+{
+    return m_properties;
+}
+
+const QVector<ChunkFile::HistoryEntry> & ChunkFile::history() const
+{
+    return m_history;
+}
+
+QByteArray ChunkFile::read(const ChunkRef & chunk) const
+{
+    if (!m_file || !chunk.isValid()) {
+        return QByteArray();
+    }
+
+    if (m_map && chunk.offset + chunk.size <= m_mapSize) {
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(m_map) + chunk.offset, chunk.size);
+    }
+
+    if (!m_file->seek(chunk.offset)) {
+        return QByteArray();
+    }
+    return m_file->read(chunk.size);
+}
+
+void ChunkFile::releaseMapping()
+{
+    if (m_map) {
+        m_file->unmap(m_map);
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+}
+
+void ChunkFile::setEntity(qint64 id, EntityType type, const QByteArray & data)
+{
+    Q_ASSERT(id >= 0);
+
+    const qint64 pageIndex = pageOf(id);
+    auto & entries = m_pages[pageIndex].entries;
+    auto it = entries.find(id);
+    if (it != entries.end()) {
+        m_entityBytes -= it->chunk.size + s_frameSize;
+    } else {
+        it = entries.insert(id, EntityEntry());
+    }
+
+    it->id = id;
+    it->type = type;
+    it->chunk = writeChunk(data);
+    m_entityBytes += it->chunk.size + s_frameSize;
+    m_dirtyPages.insert(pageIndex);
+}
+
+void ChunkFile::removeEntity(qint64 id)
+{
+    const qint64 pageIndex = pageOf(id);
+    auto pageIt = m_pages.find(pageIndex);
+    if (pageIt == m_pages.end()) {
+        return;
+    }
+
+    auto it = pageIt->entries.find(id);
+    if (it != pageIt->entries.end()) {
+        m_entityBytes -= it->chunk.size + s_frameSize;
+        pageIt->entries.erase(it);
+        m_dirtyPages.insert(pageIndex);
+    }
+}
+
+void ChunkFile::setProperties(const QByteArray & data)
+{
+    m_properties = data;
+}
+
+void ChunkFile::setHistory(const QList<UndoGroup *> & groups)
+{
+    QVector<HistoryEntry> history;
+    QHash<quint64, ChunkRef> historyChunks;
+    history.reserve(groups.size());
+
+    for (auto group : groups) {
+        // committed groups never change, so their chunks are written once
+        ChunkRef chunk = m_historyChunks.value(group->key());
+        if (!chunk.isValid()) {
+            chunk = writeChunk(group->compactData());
+        }
+        historyChunks.insert(group->key(), chunk);
+        history.append({ group->text(), group->count(), chunk });
+    }
+
+    m_history = history;
+    m_historyChunks = historyChunks;
+}
+
+void ChunkFile::bindHistory(const QList<UndoGroup *> & groups)
+{
+    // the attached history must match the stored one entry by entry
+    if (groups.size() != m_history.size()) {
+        return;
+    }
+
+    for (int i = 0; i < groups.size(); ++i) {
+        m_historyChunks.insert(groups[i]->key(), m_history[i].chunk);
+    }
+}
+
+bool ChunkFile::commit()
+{
+    if (!m_file) {
+        return false;
+    }
+
+    // write all changed pages of the entity table. The root must never
+    // refer to a chunk that failed to write, including reused chunks.
+    bool valid = true;
+    for (const qint64 pageIndex : qAsConst(m_dirtyPages)) {
+        auto it = m_pages.find(pageIndex);
+        if (it->entries.isEmpty()) {
+            m_pages.erase(it);
+            continue;
+        }
+
+        QCborArray entries;
+        for (const auto & entry : qAsConst(it->entries)) {
+            valid = valid && entry.chunk.isValid();
+            entries.append(QCborArray { entry.id, static_cast<int>(entry.type),
+                                        entry.chunk.offset, entry.chunk.size });
+        }
+        it->chunk = writeChunk(QCborValue(entries).toCbor());
+        valid = valid && it->chunk.isValid();
+    }
+
+    // keep the pages dirty, so that they are written again next time
+    if (!valid) {
+        return false;
+    }
+    m_dirtyPages.clear();
+
+    // the root lists the pages and the history
+    qint64 liveBytes = s_headerSize + m_entityBytes;
+    QCborArray pages;
+    for (auto it = m_pages.cbegin(); it != m_pages.cend(); ++it) {
+        valid = valid && it->chunk.isValid();
+        QCborArray page = toCbor(it->chunk);
+        page.prepend(it.key());
+        pages.append(page);
+        liveBytes += it->chunk.size + s_frameSize;
+    }
+
+    QCborArray history;
+    for (const auto & entry : qAsConst(m_history)) {
+        valid = valid && entry.chunk.isValid();
+        QCborArray item = toCbor(entry.chunk);
+        item.prepend(entry.count);
+        item.prepend(entry.text);
+        history.append(item);
+        liveBytes += entry.chunk.size + s_frameSize;
+    }
+
+    QCborMap root;
+    root.insert(QStringLiteral("pages"), pages);
+    root.insert(QStringLiteral("properties"), m_properties);
+    root.insert(QStringLiteral("history"), history);
+    if (!valid) {
+        return false;
+    }
+
+    const ChunkRef rootChunk = writeChunk(QCborValue(root).toCbor());
+    if (!rootChunk.isValid()) {
+        return false;
+    }
+    liveBytes += rootChunk.size + s_frameSize;
+
+    // make sure all chunks are stored, then switch to the new root
+    if (!syncFile(m_file.get()) || !writeHeader(rootChunk.offset - s_frameSize)
+        || !syncFile(m_file.get()))
+    {
+        return false;
+    }
+
+    if (m_created) {
+        // replace the previous file, and continue with appending
+        const QString filename = m_file->fileName();
+        if (!static_cast<QSaveFile *>(m_file.get())->commit()) {
+            m_file.reset();
+            m_created = false;
+            return false;
+        }
+
+        m_file.reset(new QFile(filename));
+        m_created = false;
+        if (!m_file->open(QIODevice::ReadWrite)) {
+            m_file.reset();
+            return false;
+        }
+    }
+
+    m_liveBytes = liveBytes;
+    return true;
+}
+
+bool ChunkFile::needsCompaction() const
+{
+    const qint64 waste = m_end - m_liveBytes;
+    return waste > m_liveBytes && waste > s_minWaste;
+}
+
+ChunkRef ChunkFile::writeChunk(const QByteArray & data)
+{
+    // reuse an existing chunk with the same content
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    const auto it = m_chunks.constFind(hash);
+    if (it != m_chunks.cend()) {
+        return *it;
+    }
+
+    // chunks are only ever appended
+    if (m_file->pos() != m_end && !m_file->seek(m_end)) {
+        return ChunkRef();
+    }
+
+    // on error, the next chunk overwrites the partially written one,
+    // and the failed chunk is not reused
+    uchar frame[s_frameSize];
+    qToLittleEndian<quint32>(data.size(), frame);
+    if (m_file->write(reinterpret_cast<const char *>(frame), s_frameSize) != s_frameSize
+        || m_file->write(data) != data.size())
+    {
+        return ChunkRef();
+    }
+
+    ChunkRef chunk;
+    chunk.offset = m_end + s_frameSize;
+    chunk.size = data.size();
+    m_end = chunk.offset + chunk.size;
+    m_chunks.insert(hash, chunk);
+    return chunk;
+}
+
+bool ChunkFile::writeHeader(qint64 rootOffset)
+{
+    uchar header[s_headerSize];
+    memcpy(header, s_magic, 4);
+    qToLittleEndian<quint32>(s_version, header + 4);
+    qToLittleEndian<quint64>(rootOffset, header + s_rootOffsetPos);
+
+    if (!m_file->seek(0) || m_file->write(reinterpret_cast<const char *>(header), s_headerSize) != s_headerSize) {
+        return false;
+    }
+
+    m_end = std::max(m_end, s_headerSize);
+    return true;
+}
+
+bool ChunkFile::readTables()
+{
+    Q_ASSERT(m_map);
+
+    if (m_mapSize < s_headerSize || memcmp(m_map, s_magic, 4) != 0
+        || qFromLittleEndian<quint32>(m_map + 4) != s_version)
+    {
+        return false;
+    }
+
+    // reads the chunk at @p offset, including its frame
+    const auto readChunk = [this](qint64 offset) {
+        ChunkRef chunk;
+        if (offset >= s_headerSize && offset + s_frameSize <= m_mapSize) {
+            const qint64 size = qFromLittleEndian<quint32>(m_map + offset);
+            if (offset + s_frameSize + size <= m_mapSize) {
+                chunk.offset = offset + s_frameSize;
+                chunk.size = static_cast<qint32>(size);
+            }
+        }
+        return chunk;
+    };
+
+    // the root is the last chunk of the last successful commit(). Anything
+    // after it stems from an interrupted commit and is overwritten.
+    const ChunkRef rootChunk = readChunk(qFromLittleEndian<quint64>(m_map + s_rootOffsetPos));
+    if (!rootChunk.isValid()) {
+        return false;
+    }
+    m_end = rootChunk.offset + rootChunk.size;
+
+    const QCborMap root = QCborValue::fromCbor(read(rootChunk)).toMap();
+    m_properties = root.value(QStringLiteral("properties")).toByteArray();
+    qint64 liveBytes = s_headerSize + rootChunk.size + s_frameSize;
+
+    for (const auto & value : root.value(QStringLiteral("history")).toArray()) {
+        const QCborArray item = value.toArray();
+        HistoryEntry entry;
+        entry.text = item.at(0).toString();
+        entry.count = static_cast<int>(item.at(1).toInteger());
+        entry.chunk = chunkFromCbor(item, 2);
+        if (entry.chunk.offset + entry.chunk.size > m_end) {
+            return false;
+        }
+        m_history.append(entry);
+        m_chunks.insert(QCryptographicHash::hash(read(entry.chunk), QCryptographicHash::Sha1), entry.chunk);
+        liveBytes += entry.chunk.size + s_frameSize;
+    }
+
+    for (const auto & value : root.value(QStringLiteral("pages")).toArray()) {
+        const QCborArray item = value.toArray();
+        Page & page = m_pages[item.at(0).toInteger()];
+        page.chunk = chunkFromCbor(item, 1);
+        if (page.chunk.offset + page.chunk.size > m_end) {
+            return false;
+        }
+        liveBytes += page.chunk.size + s_frameSize;
+
+        for (const auto & entryValue : QCborValue::fromCbor(read(page.chunk)).toArray()) {
+            const QCborArray entryItem = entryValue.toArray();
+            EntityEntry entry;
+            entry.id = entryItem.at(0).toInteger(-1);
+            entry.type = static_cast<EntityType>(entryItem.at(1).toInteger());
+            entry.chunk = chunkFromCbor(entryItem, 2);
+            if (entry.id < 0 || entry.chunk.offset + entry.chunk.size > m_end) {
+                return false;
+            }
+            page.entries.insert(entry.id, entry);
+            m_chunks.insert(QCryptographicHash::hash(read(entry.chunk), QCryptographicHash::Sha1), entry.chunk);
+            m_entityBytes += entry.chunk.size + s_frameSize;
+        }
+    }
+
+    m_liveBytes = liveBytes + m_entityBytes;
+    return true;
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,278 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_CHUNK_FILE_H
+#define TIKZ_CORE_CHUNK_FILE_H
+
+#include "tikz.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+class QFileDevice;
+
+namespace tikz {
+namespace core {
+
+class UndoGroup;
+
+/**
+ * Location of one chunk in a ChunkFile.
+ */
+struct ChunkRef
+{
+    qint64 offset = -1; // position of the chunk in the file
+    qint32 size = 0;    // size of the payload in bytes
+
+    bool isValid() const
+    {
+        return offset >= 0;
+    }
+};
+
+/**
+ * Storage of a Document in a chunked container, see Document::FileFormat.
+ *
+ * The file consists of a fixed header, followed by chunks that are only
+ * ever appended. Each Entity is stored in its own chunk. The chunks are
+ * content-addressed by their SHA-1 hash, so that writing the same data
+ * twice, e.g. after undoing a change, reuses the existing chunk.
+ *
+ * The entity table maps each entity id to the chunk of the entity. The
+ * table is split into pages of 1024 ids, and each page is a chunk as well.
+ * The root chunk lists all pages, the document properties, and the undo
+ * history, each undo group in a chunk of its compact data.
+ *
+ * commit() appends the chunks of all changed entities, the changed pages
+ * and a new root, and then switches the root offset in the header. Until
+ * the header is written, the file is still valid with the previous root.
+ * Therefore, the cost of a commit depends on the number of changed
+ * entities, and not on the number of all entities.
+ *
+ * Chunks that are no longer referenced stay in the file until the file is
+ * written from scratch with create(), see needsCompaction().
+ */
+class ChunkFile
+{
+    public:
+        /**
+         * Table entry of one entity.
+         */
+        struct EntityEntry
+        {
+            qint64 id = -1;
+            EntityType type = EntityType::Document;
+            ChunkRef chunk;
+        };
+
+        /**
+         * Entry of one undo group of the history.
+         */
+        struct HistoryEntry
+        {
+            QString text;
+            int count = 0;
+            ChunkRef chunk;
+        };
+
+    public:
+        /**
+         * Constructor, creates a closed ChunkFile.
+         */
+        ChunkFile();
+
+        /**
+         * Destructor, closes the file without commit.
+         */
+        ~ChunkFile();
+
+        /**
+         * Returns @e true, if @p data starts with the header of a ChunkFile.
+         */
+        static bool isChunkFile(const QByteArray & data);
+
+        /**
+         * Starts writing the file @p filename from scratch. The previous
+         * contents of the file are replaced atomically by commit().
+         */
+        bool create(const QString & filename);
+
+        /**
+         * Opens the existing file @p filename and reads its tables, so that
+         * the contents can be read, and later commits only append changes.
+         */
+        bool open(const QString & filename);
+
+        /**
+         * Closes the file. Uncommitted changes are discarded.
+         */
+        void close();
+
+        /**
+         * Returns @e true, if a file is opened or created.
+         */
+        bool isOpen() const;
+
+        /**
+         * Returns the file name, if a file is opened or created.
+         */
+        QString fileName() const;
+
+    //
+    // reading
+    //
+    public:
+        /**
+         * Returns the table of all entities, ordered by the entity id.
+         */
+        QVector<EntityEntry> entities() const;
+
+        /**
+         * Returns the document properties, as set with setProperties().
+         */
+        QByteArray properties() const;
+
+        /**
+         * Returns the undo history.
+         */
+        const QVector<HistoryEntry> & history() const;
+
+        /**
+         * Returns the payload of the chunk @p chunk. After open(), the file
+         * is mapped into memory, and the returned data refers to the mapped
+         * file until releaseMapping() is called.
+         */
+        QByteArray read(const ChunkRef & chunk) const;
+
+        /**
+         * Unmaps the file mapped by open().
+         */
+        void releaseMapping();
+
+    //
+    // writing
+    //
+    public:
+        /**
+         * Sets the data of entity @p id to @p data.
+         */
+        void setEntity(qint64 id, EntityType type, const QByteArray & data);
+
+        /**
+         * Removes entity @p id from the entity table.
+         */
+        void removeEntity(qint64 id);
+
+        /**
+         * Sets the document properties to @p data.
+         */
+        void setProperties(const QByteArray & data);
+
+        /**
+         * Sets the undo history to @p groups. Only groups that are not yet
+         * stored in the file are written, see UndoGroup::key().
+         */
+        void setHistory(const QList<UndoGroup *> & groups);
+
+        /**
+         * Associates the stored history with the attached @p groups, so
+         * that the next setHistory() does not write them again. Call this
+         * after attaching the history() to the UndoManager.
+         */
+        void bindHistory(const QList<UndoGroup *> & groups);
+
+        /**
+         * Writes all changes and switches to the new root.
+         * If any chunk could not be written, the header is not changed, so
+         * that the file stays valid with the previous root.
+         * @return @e true on success
+         */
+        bool commit();
+
+        /**
+         * Returns @e true, if more than half of the file is no longer
+         * referenced, so that the file should be written from scratch.
+         */
+        bool needsCompaction() const;
+
+    private:
+        /**
+         * Appends @p data as chunk, or returns the existing chunk with the
+         * same content. On a write error, an invalid ChunkRef is returned.
+         */
+        ChunkRef writeChunk(const QByteArray & data);
+
+        /**
+         * Writes the root offset @p offset into the header.
+         */
+        bool writeHeader(qint64 offset);
+
+        /**
+         * Reads the root and all pages of the entity table.
+         */
+        bool readTables();
+
+    private:
+        std::unique_ptr<QFileDevice> m_file;
+        bool m_created = false;
+
+        // mapped file after open(), see read()
+        uchar * m_map = nullptr;
+        qint64 m_mapSize = 0;
+
+        // page of the entity table
+        struct Page
+        {
+            ChunkRef chunk;
+            QMap<qint64, EntityEntry> entries;
+        };
+
+        // entity table, keyed by the page index, see commit()
+        QMap<qint64, Page> m_pages;
+        QSet<qint64> m_dirtyPages;
+
+        // document properties and undo history
+        QByteArray m_properties;
+        QVector<HistoryEntry> m_history;
+        QHash<quint64, ChunkRef> m_historyChunks;
+
+        // all chunks in the file, keyed by the hash of their content
+        QHash<QByteArray, ChunkRef> m_chunks;
+
+        // end of the valid data, new chunks are appended here
+        qint64 m_end = 0;
+
+        // bytes referenced by the entity table
+        qint64 m_entityBytes = 0;
+        // bytes referenced by the current root, see needsCompaction()
+        qint64 m_liveBytes = 0;
+};
+
+}
+}
+
+#endif // TIKZ_CORE_CHUNK_FILE_H
+
+// kate: indent-width 4; replace-tabs on;
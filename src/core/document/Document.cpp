@@ -22,27 +22,50 @@
 #include "EdgePath.h"
 #include "EllipsePath.h"
 #include "Style.h"
+#include "EntityStore.h"
+#include "NodePathIndex.h"
+#include "RTree.h"
+#include "ChangeSet.h"
+#include "PropertyManager.h"
+#include "ChunkFile.h"
 
 #include "Transaction.h"
 #include "UndoManager.h"
 #include "UndoFactory.h"
 #include "UndoGroup.h"
+#include "UndoJournal.h"
 #include "UndoCreateEntity.h"
+#include "UndoCreateEntities.h"
 #include "UndoDeleteEntity.h"
 #include "UndoSetProperty.h"
 
 #include "Visitor.h"
 #include "SerializeVisitor.h"
+#include "JsonWriter.h"
+#include "CborWriter.h"
 #include "DeserializeVisitor.h"
 #include "TikzExportVisitor.h"
 
 #include <QDebug>
-#include <QTextStream>
 #include <QFile>
+#include <QSaveFile>
 #include <QUrl>
+#include <QCborArray>
+#include <QCborMap>
+#include <QCborStreamReader>
+#include <QCborValue>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QHash>
+#include <QSet>
+#include <QTransform>
+#include <QPointer>
+#include <QScopeGuard>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
 
 namespace tikz {
 namespace core {
@@ -56,6 +79,205 @@ inline static QString removeNewLines(const QString &str)
            .replace(QLatin1Char('\n'), QLatin1Char(' '));
 }
 
+// one undo group of the history stored in a file, see Document::load()
+struct HistoryEntry
+{
+    QString text;
+    int count;
+    QByteArray data;    // compact form, see UndoGroup::compactData()
+    QJsonArray items;   // json form of files without compact data
+};
+
+// one entity record of a CBOR file, see readCborDocument()
+struct CborEntity
+{
+    EntityType type;
+    qint64 id;
+    QByteArray data;    // CBOR encoded json object
+};
+
+// helper: reads the (possibly chunked) text string @p reader points to
+static QString readCborString(QCborStreamReader & reader)
+{
+    QString str;
+    auto chunk = reader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        str += chunk.data;
+        chunk = reader.readString();
+    }
+    return str;
+}
+
+// helper: reads the checkpoint state map @p reader points to. The entity
+// records are copied as raw CBOR data into @p entities, so that they are
+// decoded by the DeserializeVisitor in parallel. All other keys of the
+// state are returned.
+static QCborMap readCborState(QCborStreamReader & reader, const QByteArray & data,
+                              QVector<CborEntity> & entities)
+{
+    static const struct {
+        QLatin1String section;
+        QLatin1String prefix;
+        EntityType type;
+    } sections[] = {
+        { QLatin1String("styles"), QLatin1String("style-"), EntityType::Style },
+        { QLatin1String("nodes"), QLatin1String("node-"), EntityType::Node },
+        { QLatin1String("paths"), QLatin1String("path-"), EntityType::Path },
+    };
+
+    QCborMap state;
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return state;
+    }
+
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        if (!reader.isString()) {
+            // skip key and value
+            reader.next();
+            reader.next();
+            continue;
+        }
+        const QString key = readCborString(reader);
+
+        // the entities are passed with their ids, so the id lists are not needed
+        if (key.endsWith(QLatin1String("-ids"))) {
+            reader.next();
+            continue;
+        }
+
+        const auto section = std::find_if(std::begin(sections), std::end(sections),
+            [&key](const auto & s) { return key == s.section; });
+        if (section == std::end(sections) || !reader.isMap() || !reader.enterContainer()) {
+            state.insert(key, QCborValue::fromCbor(reader));
+            continue;
+        }
+
+        while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+            QString entityKey;
+            if (reader.isString()) {
+                entityKey = readCborString(reader);
+            } else {
+                reader.next();
+            }
+
+            bool ok = false;
+            const qint64 id = entityKey.startsWith(section->prefix)
+                ? entityKey.midRef(section->prefix.size()).toLongLong(&ok)
+                : -1;
+
+            // copy the raw record, the file mapping is released after reading
+            const qint64 begin = reader.currentOffset();
+            reader.next();
+            if (ok) {
+                entities.append({ section->type, id,
+                                  QByteArray(data.constData() + begin, reader.currentOffset() - begin) });
+            } else {
+                qWarning() << "Skipping invalid entity record" << entityKey;
+            }
+        }
+        reader.leaveContainer();
+    }
+    reader.leaveContainer();
+
+    return state;
+}
+
+// helper: reads the CBOR file @p data written by DocumentPrivate::saveStream().
+// The top-level map is walked with a QCborStreamReader instead of building
+// a QCborValue tree of the whole file: The history is appended to @p history,
+// and the entity records of the latest checkpoint to @p entities. The
+// remaining document data is returned as json object.
+static QJsonObject readCborDocument(const QByteArray & data, QVector<HistoryEntry> & history,
+                                    QVector<CborEntity> & entities)
+{
+    QJsonObject root;
+    QCborStreamReader reader(data);
+
+    // skip the self-describe tag, see CborWriter::isCbor()
+    while (reader.isTag()) {
+        reader.next();
+    }
+
+    if (!reader.isMap() || !reader.enterContainer()) {
+        qWarning() << "Invalid CBOR document:" << reader.lastError().toString();
+        return root;
+    }
+
+    int checkpointIndex = -1;
+    QJsonArray checkpoints;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        if (!reader.isString()) {
+            // skip key and value
+            reader.next();
+            reader.next();
+            continue;
+        }
+        const QString key = readCborString(reader);
+
+        if (key == QLatin1String("history") && reader.isArray() && reader.enterContainer()) {
+            // the history data is stored as binary byte string
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                const QCborMap entry = QCborValue::fromCbor(reader).toMap();
+                history.append({ entry.value(QStringLiteral("text")).toString(),
+                                 static_cast<int>(entry.value(QStringLiteral("count")).toInteger()),
+                                 entry.value(QStringLiteral("data")).toByteArray(),
+                                 QJsonArray() });
+            }
+            reader.leaveContainer();
+        } else if (key == QLatin1String("checkpoints") && reader.isArray() && reader.enterContainer()) {
+            // only keep the entities of the checkpoint load() starts from,
+            // i.e. the latest checkpoint within the history
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                if (!reader.isMap() || !reader.enterContainer()) {
+                    reader.next();
+                    continue;
+                }
+
+                int index = -1;
+                QCborMap state;
+                QVector<CborEntity> stateEntities;
+                while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                    if (!reader.isString()) {
+                        // skip key and value
+                        reader.next();
+                        reader.next();
+                        continue;
+                    }
+                    const QString checkpointKey = readCborString(reader);
+                    if (checkpointKey == QLatin1String("history-index")) {
+                        index = static_cast<int>(QCborValue::fromCbor(reader).toInteger(-1));
+                    } else if (checkpointKey == QLatin1String("state")) {
+                        state = readCborState(reader, data, stateEntities);
+                    } else {
+                        reader.next();
+                    }
+                }
+                reader.leaveContainer();
+
+                if (index > checkpointIndex && index <= history.size()) {
+                    checkpointIndex = index;
+                    entities = std::move(stateEntities);
+                    checkpoints = QJsonArray { QJsonObject {
+                        { QStringLiteral("history-index"), index },
+                        { QStringLiteral("state"), state.toJsonObject() }
+                    } };
+                }
+            }
+            reader.leaveContainer();
+        } else {
+            root.insert(key, QCborValue::fromCbor(reader).toJsonValue());
+        }
+    }
+    reader.leaveContainer();
+
+    if (reader.lastError() != QCborError::NoError) {
+        qWarning() << "Invalid CBOR document:" << reader.lastError().toString();
+    }
+
+    root[QStringLiteral("checkpoints")] = checkpoints;
+    return root;
+}
+
 class DocumentPrivate
 {
     public:
@@ -71,14 +293,49 @@ class DocumentPrivate
 
         Unit preferredUnit = Unit::Centimeter;
 
+        // format used by saveAs(), set by load()
+        Document::FileFormat fileFormat = Document::FileFormat::Json;
+
+        // file of the format FileFormat::Chunked, kept open after load()
+        // and saveAs(), so that the next save only appends the changes
+        ChunkFile chunkFile;
+
+        // ids of all entities changed since the last load() or saveAs()
+        QSet<qint64> unsavedEntities;
+
         // global document style options
         Style * style = nullptr;
 
-        // Entity list, contains Nodes and Paths
-        QVector<Entity *> entities;
+        // Entity storage, contains Styles, Nodes and Paths grouped by type.
+        // Also serves as handle table to resolve Uids.
+        EntityStore entities;
+
+        // paths attached to nodes, see attachedPaths()
+        NodePathIndex attachments;
+
+        // spatial index over the bounds of all nodes and paths
+        RTree spatialIndex;
+
+        // subscriptions to node changes, see subscribe()
+        struct Subscription
+        {
+            QPointer<QObject> context;
+            std::function<void()> callback;
+        };
+        QHash<Uid, QVector<Subscription>> subscriptions;
+
+        // changes of the current transaction, see changesCommitted()
+        ChangeSet changes;
 
-        // Node lookup map
-        QHash<Uid, Entity *> entityMap;
+        // property ids by property name, see recordPropertyChange()
+        QHash<const char *, int> propertyIds;
+
+        // styles changed in the current transaction, see scheduleStyleChange()
+        QSet<Uid> dirtyStyles;
+
+        // true while style changes must not be scheduled, e.g. while
+        // flushStyleChanges() notifies the styles
+        bool suppressStyleChanges = false;
 
         // the document-wide unique ids start at 1.
         // Id 0 is reserved for the Document Uid, see Document constructor.
@@ -92,6 +349,12 @@ class DocumentPrivate
 
         QString docName = QString("Untitled");
 
+        // saves the document as json or CBOR stream to @p filename
+        bool saveStream(const QString & filename);
+
+        // saves the document in the format FileFormat::Chunked to @p filename
+        bool saveChunked(const QString & filename);
+
 //
 // helper functions
 //
@@ -112,8 +375,257 @@ public:
             Q_EMIT q->documentNameChanged(q);
         }
     }
+
+    void watchEntity(Entity * e) {
+        // record the change first, so that it is part of the ChangeSet
+        // passed on when the changed() signal reaches the Document.
+        // A single connection per entity keeps creating entities cheap.
+        QObject::connect(e, &ConfigObject::changed, q, [this, e]() {
+            changes.addEntity(e->uid());
+            if (e->entityType() == EntityType::Node) {
+                updateBounds(e);
+                notifyAttachedPaths(e->uid());
+                notifySubscribers(e->uid());
+            } else if (e->entityType() == EntityType::Path) {
+                updateBounds(e);
+            } else if (e->entityType() == EntityType::Style) {
+                // styles notify the Document through scheduleStyleChange(),
+                // so that a single style edit emits changed() only once
+                return;
+            }
+            q->emitChangedIfNeeded();
+        });
+    }
+
+    void notifySubscribers(const Uid & nodeUid) {
+        auto it = subscriptions.find(nodeUid);
+        if (it == subscriptions.end()) {
+            return;
+        }
+
+        // drop subscriptions of destroyed contexts
+        auto & list = *it;
+        list.erase(std::remove_if(list.begin(), list.end(), [](const Subscription & s) {
+            return s.context.isNull();
+        }), list.end());
+        if (list.isEmpty()) {
+            subscriptions.erase(it);
+            return;
+        }
+
+        // callbacks may subscribe or unsubscribe, therefore iterate a copy
+        const QVector<Subscription> current = list;
+        for (const auto & subscription : current) {
+            if (subscription.context) {
+                subscription.callback();
+            }
+        }
+    }
+
+    void updateBounds(Entity * e) {
+        spatialIndex.update(e->uid(), bounds(e));
+    }
+
+    // helper: returns the bounding rect of a Node or Path in pt
+    static QRectF bounds(Entity * e) {
+        if (e->entityType() == EntityType::Node) {
+            return nodeBounds(static_cast<Node *>(e));
+        }
+
+        auto path = static_cast<Path *>(e);
+        if (path->type() == PathType::Ellipse) {
+            auto ellipse = static_cast<EllipsePath *>(path);
+            const QPointF center = ellipse->pos();
+            const qreal rx = ellipse->style()->radiusX().toPoint();
+            const qreal ry = ellipse->style()->radiusY().toPoint();
+            return QRectF(center.x() - rx, center.y() - ry, 2 * rx, 2 * ry);
+        }
+
+        // FIXME: curves may exceed the box of their start and end point
+        if (auto edge = qobject_cast<EdgePath *>(path)) {
+            return QRectF(QPointF(edge->startPos()), QPointF(edge->endPos())).normalized();
+        }
+
+        return QRectF();
+    }
+
+    // helper: returns the bounding rect of @p node in pt. Like the shapes
+    // of the user interface, the text is surrounded by the inner sep, and
+    // the anchors are placed on the outer sep.
+    static QRectF nodeBounds(Node * node) {
+        const Style * style = node->style();
+        const QSizeF text = node->textSize();
+        const qreal innerSep = style->innerSep().toPoint();
+        qreal w = text.width() + 2.0 * innerSep;
+        qreal h = text.height() + 2.0 * innerSep;
+
+        switch (style->shape()) {
+            case Shape::ShapeCircle:
+                w = h = std::sqrt(w * w + h * h);
+                break;
+            case Shape::ShapeEllipse:
+                w *= M_SQRT2;
+                h *= M_SQRT2;
+                break;
+            case Shape::ShapeDiamond:
+                w = h = text.width() + text.height() + 4.0 * innerSep;
+                break;
+            default:
+                break;
+        }
+
+        w = std::max(w, style->minimumWidth().toPoint());
+        h = std::max(h, style->minimumHeight().toPoint());
+        if (style->shape() == Shape::ShapeCircle) {
+            w = h = std::max(w, h);
+        }
+
+        const qreal outerSep = style->outerSep().toPoint();
+        w += 2.0 * outerSep;
+        h += 2.0 * outerSep;
+
+        QRectF rect(-w / 2.0, -h / 2.0, w, h);
+        if (style->rotation() != 0.0) {
+            rect = QTransform().rotate(style->rotation()).mapRect(rect);
+        }
+        const QPointF center = node->pos();
+        return rect.translated(center);
+    }
+
+    void notifyAttachedPaths(const Uid & nodeUid) {
+        // paths attached to a node follow the node
+        for (const auto & pathUid : attachments.paths(nodeUid)) {
+            if (auto path = entities.entity(pathUid)) {
+                path->emitChangedIfNeeded();
+            }
+        }
+    }
 };
 
+// helper: returns the state of @p entity as CBOR encoded json object
+static QByteArray entityData(Entity * entity)
+{
+    QJsonObject json = entity->save();
+
+    // the path type is required to create the path when loading
+    if (entity->entityType() == EntityType::Path) {
+        json["type"] = toString(static_cast<Path *>(entity)->type());
+    }
+
+    return QCborValue::fromJsonValue(json).toCbor();
+}
+
+bool DocumentPrivate::saveStream(const QString & filename)
+{
+    // the previous file is replaced only once commit() succeeded, so that
+    // a failed save never leaves a truncated document behind
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    // stream the document directly into the file, so that no json tree
+    // of the whole document is built in memory
+    std::unique_ptr<StreamWriter> streamWriter;
+    if (fileFormat == Document::FileFormat::Cbor) {
+        streamWriter.reset(new CborWriter(&file));
+    } else {
+        streamWriter.reset(new JsonWriter(&file));
+    }
+    StreamWriter & writer = *streamWriter;
+    writer.beginObject();
+
+    // first serialize the history in its compact form, which contains
+    // both the undo and the redo state, see UndoGroup::compactData()
+    const auto groups = undoManager->undoGroups();
+    writer.key("history");
+    writer.beginArray();
+    for (auto group : groups) {
+        writer.beginObject();
+        writer.key("text");
+        writer.value(group->text());
+        writer.key("count");
+        writer.value(group->count());
+        writer.key("data");
+        writer.binary(group->compactData());
+        writer.endObject();
+    }
+    writer.endArray();
+
+    // the current state is the checkpoint load() starts from,
+    // so that the history is not replayed
+    writer.key("checkpoints");
+    writer.beginArray();
+    writer.beginObject();
+    writer.key("history-index");
+    writer.value(groups.size());
+    writer.key("state");
+    SerializeVisitor serializer(&writer);
+    q->accept(serializer);
+    serializer.finish();
+    writer.endObject();
+    writer.endArray();
+
+    writer.key("next-id");
+    writer.value(nextId);
+    writer.key("preferred-unit");
+    writer.value(toString(preferredUnit));
+    writer.endObject();
+
+    const bool written = writer.flush();
+    streamWriter.reset();
+    if (!written) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool DocumentPrivate::saveChunked(const QString & filename)
+{
+    // append only the changed entities to the file opened by the last
+    // load() or save, unless most of the file is no longer referenced
+    const bool incremental = chunkFile.isOpen()
+                             && chunkFile.fileName() == filename
+                             && !chunkFile.needsCompaction();
+    if (incremental) {
+        for (const qint64 id : qAsConst(unsavedEntities)) {
+            Entity * entity = entities.entity(Uid(id, q));
+            if (entity) {
+                chunkFile.setEntity(id, entity->entityType(), entityData(entity));
+            } else {
+                chunkFile.removeEntity(id);
+            }
+        }
+    } else {
+        if (!chunkFile.create(filename)) {
+            return false;
+        }
+
+        const auto allEntities = entities.allEntities();
+        for (auto entity : allEntities) {
+            chunkFile.setEntity(entity->uid().id(), entity->entityType(), entityData(entity));
+        }
+    }
+
+    QCborMap properties;
+    properties.insert(QStringLiteral("document-style"), QCborValue::fromJsonValue(style->save()));
+    properties.insert(QStringLiteral("next-id"), nextId);
+    properties.insert(QStringLiteral("preferred-unit"), toString(preferredUnit));
+    chunkFile.setProperties(QCborValue(properties).toCbor());
+
+    // groups already stored in the file are not written again
+    chunkFile.setHistory(undoManager->undoGroups());
+
+    if (!chunkFile.commit()) {
+        // the next save writes the file from scratch
+        chunkFile.close();
+        return false;
+    }
+
+    return true;
+}
+
 Document::Document(QObject * parent)
     : Entity(Uid(0, this))
     , d(new DocumentPrivate())
@@ -130,6 +642,20 @@ Document::Document(QObject * parent)
     d->style->setLineWidth(tikz::Value::veryThick());
 
     connect(d->undoManager, SIGNAL(cleanChanged(bool)), this, SIGNAL(modifiedChanged()));
+
+    // pass on the recorded changes whenever the outermost transaction finished
+    connect(this, &ConfigObject::changed, this, [this]() {
+        if (!d->changes.isEmpty()) {
+            const ChangeSet changes = d->changes;
+            d->changes.clear();
+
+            // remember the changed entities for incremental saves
+            for (const auto & uid : changes.entities()) {
+                d->unsavedEntities.insert(uid.id());
+            }
+            Q_EMIT changesCommitted(changes);
+        }
+    });
 }
 
 Document::~Document()
@@ -138,8 +664,7 @@ Document::~Document()
     close();
 
     // make sure things are really gone
-    Q_ASSERT(d->entityMap.isEmpty());
-    Q_ASSERT(d->entities.isEmpty());
+    Q_ASSERT(d->entities.count() == 0);
 
     delete d;
 }
@@ -155,27 +680,18 @@ bool Document::accept(Visitor & visitor)
     visitor.visit(this);
 
     // visit all styles
-    for (auto entity : d->entities) {
-        auto style = qobject_cast<Style *>(entity);
-        if (style) {
-            style->accept(visitor);
-        }
+    for (auto style : styleRange()) {
+        style->accept(visitor);
     }
 
     // visit all nodes
-    for (auto entity : d->entities) {
-        auto node = qobject_cast<Node *>(entity);
-        if (node) {
-            node->accept(visitor);
-        }
+    for (auto node : nodeRange()) {
+        node->accept(visitor);
     }
 
     // visit all paths
-    for (auto entity : d->entities) {
-        auto path = qobject_cast<Path *>(entity);
-        if (path) {
-            path->accept(visitor);
-        }
+    for (auto path : pathRange()) {
+        path->accept(visitor);
     }
 
     return true;
@@ -186,10 +702,21 @@ void Document::close()
     // tell the world that all Nodes and Paths are about to be deleted
     Q_EMIT aboutToClear();
 
-    // free all node and path data
-    qDeleteAll(d->entities);
+    // free all node and path data. Each entity is removed right before
+    // its deletion, so that the remaining entities are still resolvable.
+    d->suppressStyleChanges = true;
+    const auto allEntities = d->entities.allEntities();
+    for (auto entity : allEntities) {
+        d->entities.remove(entity);
+        delete entity;
+    }
     d->entities.clear();
-    d->entityMap.clear();
+    d->attachments.clear();
+    d->spatialIndex.clear();
+    d->subscriptions.clear();
+    d->dirtyStyles.clear();
+    d->changes.clear();
+    d->suppressStyleChanges = false;
 
     // reset unique id counter
     d->nextId = 1;
@@ -198,17 +725,23 @@ void Document::close()
     delete d->style;
     d->style = new Style(Uid(d->uniqueId(), this));
 
-    // clear undo stack
+    // clear undo stack, the journal belongs to the closed state
+    d->undoManager->closeJournal();
     d->undoManager->clear();
 
     // unnamed document
     d->url.clear();
+    d->fileFormat = FileFormat::Json;
+    d->chunkFile.close();
 
     // keep the document name up-to-date
     d->updateDocumentName();
 
-    // propagate change() signal from style
-    connect(d->style, &ConfigObject::changed, this, &ConfigObject::emitChangedIfNeeded);
+    // record changes and propagate change() signal from style
+    d->watchEntity(d->style);
+
+    // nothing to save, the next save writes a new file
+    d->unsavedEntities.clear();
 }
 
 bool Document::load(const QUrl & fileurl)
@@ -216,23 +749,156 @@ bool Document::load(const QUrl & fileurl)
     // first start a clean document
     close();
 
-    // open file + read all json contents
+    // map the file into memory instead of reading a copy
     QFile file(fileurl.toLocalFile());
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
          return false;
     }
 
-    QJsonDocument json = QJsonDocument::fromJson(file.readAll());
-    QJsonObject root = json.object();
+    const qint64 size = file.size();
+    uchar * mapped = size > 0 ? file.map(0, size) : nullptr;
+    const QByteArray data = mapped
+        ? QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size)
+        : file.readAll();
+
+    // the file format is detected from the contents
+    QJsonObject root;
+    QVector<HistoryEntry> history;
+    QVector<CborEntity> cborEntities;
+    if (ChunkFile::isChunkFile(data)) {
+        // read by the ChunkFile below
+        d->fileFormat = FileFormat::Chunked;
+    } else if (CborWriter::isCbor(data)) {
+        d->fileFormat = FileFormat::Cbor;
+        root = readCborDocument(data, history, cborEntities);
+    } else {
+        d->fileFormat = FileFormat::Json;
+        root = QJsonDocument::fromJson(data).object();
+        for (const auto & value : root["history"].toArray()) {
+            const QJsonObject entry = value.toObject();
+            history.append({ entry["text"].toString(),
+                             entry["count"].toInt(),
+                             QByteArray::fromBase64(entry["data"].toString().toLatin1()),
+                             entry["items"].toArray() });
+        }
+    }
+
+    // all data is copied into json, history and cborEntities now
+    if (mapped) {
+        file.unmap(mapped);
+    }
+    file.close();
+
+    if (d->fileFormat == FileFormat::Chunked) {
+        if (!d->chunkFile.open(file.fileName())) {
+            d->fileFormat = FileFormat::Json;
+            return false;
+        }
+
+        root = QCborValue::fromCbor(d->chunkFile.properties()).toMap().toJsonObject();
+        for (const auto & entry : d->chunkFile.history()) {
+            // copy the data, the mapping is released after loading
+            const QByteArray chunk = d->chunkFile.read(entry.chunk);
+            history.append({ entry.text, entry.count,
+                             QByteArray(chunk.constData(), chunk.size()), QJsonArray() });
+        }
+
+        // the stored entities are the state at the end of the history
+        QJsonObject checkpoint;
+        checkpoint["history-index"] = history.size();
+        checkpoint["state"] = QJsonObject { { "document-style", root["document-style"] } };
+        root["checkpoints"] = QJsonArray { checkpoint };
+    }
+
+    // find the latest checkpoint. Files without checkpoint are replayed
+    // from the beginning of the history.
+    int checkpointIndex = -1;
+    QJsonObject checkpointState;
+    for (auto value : root["checkpoints"].toArray()) {
+        const QJsonObject checkpoint = value.toObject();
+        const int index = checkpoint["history-index"].toInt(-1);
+        if (index > checkpointIndex && index <= history.size()) {
+            checkpointIndex = index;
+            checkpointState = checkpoint["state"].toObject();
+        }
+    }
+
+    // history entries after the checkpoint are replayed. Entries that are
+    // only stored in the compact form are restored before the document is
+    // changed, so that a corrupt entry fails the load as a whole.
+    QHash<int, QList<UndoItem *>> compactItems;
+    for (int i = std::max(checkpointIndex, 0); i < history.size(); ++i) {
+        const HistoryEntry & entry = history[i];
+        if (!entry.items.isEmpty() || entry.count == 0) {
+            continue;
+        }
+
+        QList<UndoItem *> items;
+        if (!UndoGroup::createItems(this, entry.data, entry.count, items)) {
+            qWarning() << "Unable to restore the history entry" << entry.text;
+            for (const auto & created : compactItems) {
+                qDeleteAll(created);
+            }
+            return false;
+        }
+        compactItems.insert(i, items);
+    }
+
+    // the loaded state is saved. Since the change notification is emitted
+    // at the end of the transaction, clear the unsaved entities afterwards.
+    const auto clearUnsaved = qScopeGuard([this]() {
+        d->unsavedEntities.clear();
+    });
+
+    // loading is one change notification
+    ConfigTransaction configTransaction(this);
+
+    if (checkpointIndex >= 0) {
+        // attach the history up to the checkpoint without executing it.
+        // Its undo items are created only once the user undoes past the
+        // checkpoint.
+        for (int i = 0; i < checkpointIndex; ++i) {
+            const HistoryEntry & entry = history[i];
+            if (!d->undoManager->attachGroup(entry.text, entry.data, entry.count)) {
+                // the undo history must be contiguous up to the checkpoint,
+                // so drop it completely instead of skipping the entry
+                qWarning() << "Unable to restore the history entry" << entry.text;
+                d->undoManager->clear();
+                break;
+            }
+        }
+
+        // restore the state of the checkpoint directly
+        const bool wasActive = setUndoActive(true);
+        DeserializeVisitor deserializer;
+        deserializer.load(checkpointState);
+        if (d->fileFormat == FileFormat::Chunked) {
+            for (const auto & entry : d->chunkFile.entities()) {
+                deserializer.addEntity(entry.type, entry.id, d->chunkFile.read(entry.chunk));
+            }
+        }
+        for (const auto & entity : qAsConst(cborEntities)) {
+            deserializer.addEntity(entity.type, entity.id, entity.data);
+        }
+        accept(deserializer);
+        setUndoActive(wasActive);
+    }
 
-    // read history and replay
+    if (d->fileFormat == FileFormat::Chunked) {
+        // the attached history is already stored in the file
+        d->chunkFile.bindHistory(d->undoManager->undoGroups());
+        d->chunkFile.releaseMapping();
+    }
+
+    // replay the history after the checkpoint
     UndoFactory factory(this);
-    QJsonArray history = root["history"].toArray();
-    for (auto action : history) {
-        QJsonObject entry = action.toObject();
-        Transaction transaction(this, entry["text"].toString());
-        QJsonArray items = entry["items"].toArray();
-        for (auto item : items) {
+    for (int i = std::max(checkpointIndex, 0); i < history.size(); ++i) {
+        const HistoryEntry & entry = history[i];
+        Transaction transaction(this, entry.text);
+        for (auto undoItem : compactItems.value(i)) {
+            addUndoItem(undoItem);
+        }
+        for (auto item : entry.items) {
             QJsonObject joItem = item.toObject();
             const QString type = joItem["type"].toString();
             UndoItem * undoItem = factory.createItem(type);
@@ -248,11 +914,13 @@ bool Document::load(const QUrl & fileurl)
     }
 
     // now make sure the next free uniq id is valid by finding the maximum
-    // used id, and then add "+1".
-    auto keys = d->entityMap.keys();
-    if (keys.size()) {
-        d->nextId = std::max_element(keys.begin(), keys.end())->id() + 1;
+    // used id, and then add "+1". Entities deleted in the history may have
+    // used higher ids, these are covered by "next-id".
+    const qint64 maxId = d->entities.maxId();
+    if (maxId >= 0) {
+        d->nextId = std::max(d->nextId, maxId + 1);
     }
+    d->nextId = std::max(d->nextId, static_cast<qint64>(root["next-id"].toDouble()));
 
     // keep the document name up-to-date
     d->updateDocumentName();
@@ -278,52 +946,35 @@ bool Document::save()
 
 bool Document::saveAs(const QUrl & targetUrl)
 {
-    SerializeVisitor v;
-    accept(v);
-    v.save(targetUrl.path());
-    return true;
-
     const bool urlChanged = d->url.toLocalFile() != targetUrl.toLocalFile();
 
     if (targetUrl.isLocalFile()) {
 
-        // first serialize to json document
-        QJsonArray jsonHistory;
-        for (auto group : d->undoManager->undoGroups()) {
-            QJsonArray groupItems;
-            for (auto item : group->undoItems()) {
-                groupItems.append(item->save());
+        const QString filename = targetUrl.toLocalFile();
+        if (d->fileFormat == FileFormat::Chunked) {
+            if (!d->saveChunked(filename)) {
+                return false;
+            }
+        } else {
+            // the chunk file is replaced by the stream
+            d->chunkFile.close();
+            if (!d->saveStream(filename)) {
+                return false;
             }
-
-            QJsonObject jsonGroup;
-            jsonGroup["text"] = group->text();
-            jsonGroup["items"] = groupItems;
-            jsonHistory.append(jsonGroup);
-        }
-
-        QJsonObject json;
-        json["history"] = jsonHistory;
-        json["preferred-unit"] = toString(preferredUnit());
-
-        // now save data
-        QFile file(targetUrl.toLocalFile());
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            return false;
         }
 
-        // write json to text stream
-        QTextStream stream(&file);
-        QJsonDocument jsonDoc(json);
-        stream << jsonDoc.toJson();
-
         if (urlChanged) {
             d->url = targetUrl;
             // keep the document name up-to-date
             d->updateDocumentName();
         }
 
-        // mark this state as unmodified
+        // all entities are saved now
+        d->unsavedEntities.clear();
+
+        // mark this state as unmodified, the journal starts again
         d->undoManager->setClean();
+        d->undoManager->truncateJournal();
 
         return true;
     }
@@ -331,6 +982,43 @@ bool Document::saveAs(const QUrl & targetUrl)
     return false;
 }
 
+void Document::setFileFormat(FileFormat format)
+{
+    d->fileFormat = format;
+}
+
+Document::FileFormat Document::fileFormat() const
+{
+    return d->fileFormat;
+}
+
+bool Document::setJournalFile(const QString & filename)
+{
+    if (filename.isEmpty()) {
+        d->undoManager->closeJournal();
+        return true;
+    }
+
+    return d->undoManager->openJournal(filename, true);
+}
+
+QString Document::journalFile() const
+{
+    return d->undoManager->journalFile();
+}
+
+bool Document::recoverJournal(const QString & filename)
+{
+    // the replayed records must not be appended again
+    d->undoManager->closeJournal();
+
+    if (UndoJournal::replay(filename, this) < 0) {
+        return false;
+    }
+
+    return d->undoManager->openJournal(filename, false);
+}
+
 QUrl Document::url() const
 {
     return d->url;
@@ -345,7 +1033,7 @@ bool Document::isEmptyBuffer() const
 {
     return d->url.isEmpty()
         && ! isModified()
-        && d->entities.isEmpty();
+        && d->entities.count() == 0;
 }
 
 QString Document::tikzCode()
@@ -370,6 +1058,30 @@ void Document::beginTransaction(const QString & name)
     d->undoManager->startTransaction(name);
 }
 
+void Document::beginGesture(const QString & name)
+{
+    // track changes
+    beginConfig();
+
+    // pass call to undo mananger
+    d->undoManager->startGesture(name);
+}
+
+bool Document::gestureRunning() const
+{
+    return d->undoManager->gestureActive();
+}
+
+UndoItem * Document::gestureItem(const Uid & uid, const char * typeName) const
+{
+    return d->undoManager->gestureItem(uid, typeName);
+}
+
+void Document::addGestureItem(const Uid & uid, UndoItem * undoItem)
+{
+    d->undoManager->addGestureItem(uid, undoItem);
+}
+
 void Document::cancelTransaction()
 {
     d->undoManager->cancelTransaction();
@@ -380,6 +1092,11 @@ void Document::finishTransaction()
     // first pass call to undo mananger
     d->undoManager->commitTransaction();
 
+    // notify styles about inherited changes once the outermost transaction finished
+    if (!transactionRunning()) {
+        flushStyleChanges();
+    }
+
     // notify world about changes
     endConfig();
 }
@@ -421,12 +1138,41 @@ QAbstractItemModel * Document::historyModel() const
     return d->undoManager;
 }
 
+void Document::setHistoryLimit(int groups)
+{
+    d->undoManager->setUndoLimit(groups);
+}
+
+int Document::historyLimit() const
+{
+    return d->undoManager->undoLimit();
+}
+
+void Document::setHistoryMemoryBudget(qint64 bytes)
+{
+    d->undoManager->setMemoryBudget(bytes);
+}
+
+qint64 Document::historyMemoryBudget() const
+{
+    return d->undoManager->memoryBudget();
+}
+
+qint64 Document::historyMemoryUsage() const
+{
+    return d->undoManager->memoryUsage();
+}
+
 void Document::undo()
 {
     const bool undoWasAvailable = undoAvailable();
     const bool redoWasAvailable = redoAvailable();
 
+    // batch all changes of the undo group
+    beginConfig();
     d->undoManager->undo();
+    flushStyleChanges();
+    endConfig();
 
     const bool undoNowAvailable = undoAvailable();
     const bool redoNowAvailable = redoAvailable();
@@ -445,7 +1191,11 @@ void Document::redo()
     const bool undoWasAvailable = undoAvailable();
     const bool redoWasAvailable = redoAvailable();
 
+    // batch all changes of the undo group
+    beginConfig();
     d->undoManager->redo();
+    flushStyleChanges();
+    endConfig();
 
     const bool undoNowAvailable = undoAvailable();
     const bool redoNowAvailable = redoAvailable();
@@ -489,54 +1239,95 @@ Style * Document::style() const
 
 QVector<Uid> Document::nodes() const
 {
-    QVector <Uid> nodeList;
-    auto it = d->entityMap.cbegin();
-    while (it != d->entityMap.cend()) {
-        if (qobject_cast<Node *>(it.value())) {
-            nodeList.append(it.key());
-        }
-        ++it;
+    QVector<Uid> nodeList;
+    nodeList.reserve(d->entities.count(EntityType::Node));
+    for (auto node : nodeRange()) {
+        nodeList.append(node->uid());
     }
     return nodeList;
 }
 
 QVector<Uid> Document::paths() const
 {
-    QVector <Uid> pathList;
-    auto it = d->entityMap.cbegin();
-    while (it != d->entityMap.cend()) {
-        if (qobject_cast<Path *>(it.value())) {
-            pathList.append(it.key());
-        }
-        ++it;
+    QVector<Uid> pathList;
+    pathList.reserve(d->entities.count(EntityType::Path));
+    for (auto path : pathRange()) {
+        pathList.append(path->uid());
     }
     return pathList;
 }
 
+EntityRange<Node> Document::nodeRange() const
+{
+    return d->entities.range<Node>(EntityType::Node);
+}
+
+EntityRange<Path> Document::pathRange() const
+{
+    return d->entities.range<Path>(EntityType::Path);
+}
+
+EntityRange<Style> Document::styleRange() const
+{
+    return d->entities.range<Style>(EntityType::Style);
+}
+
 Entity * Document::createEntity(tikz::EntityType type)
 {
     // create new node, push will call ::redo()
     const Uid uid(d->uniqueId(), this);
     addUndoItem(new UndoCreateEntity(uid, type, this));
 
-    // now the node should be in the map
-    const auto it = d->entityMap.find(uid);
-    if (it != d->entityMap.end()) {
-        return *it;
+    // now the entity should be in the store
+    if (auto e = d->entities.entity(uid)) {
+        return e;
     }
 
-    // requested id not in map, this is a bug, since UndoCreateEntity should
+    // requested id not in store, this is a bug, since UndoCreateEntity should
     // call createEntity(uid, type) that inserts the Entity
     Q_ASSERT(false);
 
     return nullptr;
 }
 
-Entity * Document::createEntity(const Uid & uid, EntityType type)
+QVector<Entity *> Document::createEntities(tikz::EntityType type, int count, const QVariantMap & properties)
 {
-    Q_ASSERT(uid.isValid());
-    Q_ASSERT(uid.document() == this);
-    Q_ASSERT(!d->entityMap.contains(uid));
+    Q_ASSERT(count >= 0);
+
+    QVector<Entity *> result;
+    if (count <= 0) {
+        return result;
+    }
+
+    // the entities get consecutive ids
+    const qint64 firstId = d->nextId;
+    d->nextId += count;
+
+    // one undo item for all entities, changed() is emitted once at the end
+    Transaction transaction(this, "Create Entities");
+    addUndoItem(new UndoCreateEntities(Uid(firstId, this), count, type, properties, this));
+
+    result.reserve(count);
+    for (qint64 id = firstId; id < firstId + count; ++id) {
+        auto e = d->entities.entity(Uid(id, this));
+        Q_ASSERT(e);
+        result.append(e);
+    }
+
+    return result;
+}
+
+Entity * Document::createEntity(const Uid & uidIn, EntityType type)
+{
+    Q_ASSERT(uidIn.isValid());
+    Q_ASSERT(uidIn.document() == this);
+    Q_ASSERT(!d->entities.contains(uidIn.id()));
+
+    // bind the uid to the current generation of its slot
+    const Uid uid(uidIn.id(), this, d->entities.generation(uidIn.id()));
+
+    // never hand out this id again, e.g. when replaying a journal
+    d->nextId = std::max(d->nextId, uid.id() + 1);
 
     // create new node
     Entity * e = nullptr;
@@ -561,13 +1352,14 @@ Entity * Document::createEntity(const Uid & uid, EntityType type)
     }
 
     Q_ASSERT(e);
-    d->entities.append(e);
-
-    // insert entity into hash map
-    d->entityMap.insert(uid, e);
+    d->entities.insert(e);
+    d->changes.addCreated(uid);
+    if (type == EntityType::Node || type == EntityType::Path) {
+        d->updateBounds(e);
+    }
 
-    // propagate changed signal
-    connect(e, &ConfigObject::changed, this, &ConfigObject::emitChangedIfNeeded);
+    // record changes and propagate changed signal
+    d->watchEntity(e);
 
     return e;
 }
@@ -576,18 +1368,20 @@ void Document::deleteEntity(Entity * e)
 {
     // valid input?
     Q_ASSERT(e != nullptr);
-    Q_ASSERT(d->entityMap.contains(e->uid()));
+    Q_ASSERT(d->entities.entity(e->uid()) == e);
 
     // get id
     const Uid uid = e->uid();
 
-    // start undo group
-    d->undoManager->startTransaction("Remove entity");
+    // start undo group, also delays changed() until the end
+    beginTransaction("Remove entity");
 
-    // make sure no edge points to the deleted node
+    // make sure no edge points to the deleted node. Detaching modifies
+    // the attachments, therefore iterate a copy.
     if (auto nodeEntity = qobject_cast<Node*>(e)) {
-        for (auto entity : d->entities) {
-            if (auto path = qobject_cast<Path *>(entity)) {
+        const QVector<Uid> attached = d->attachments.paths(uid);
+        for (const auto & pathUid : attached) {
+            if (auto path = pathUid.entity<Path>()) {
                 path->detachFromNode(nodeEntity);
             }
 
@@ -600,33 +1394,43 @@ void Document::deleteEntity(Entity * e)
     addUndoItem(new UndoDeleteEntity(uid, this));
 
     // end undo group
-    d->undoManager->commitTransaction();
+    finishTransaction();
 
     // node really removed?
-    Q_ASSERT(!d->entityMap.contains(uid));
+    Q_ASSERT(!d->entities.contains(uid.id()));
 }
 
 void Document::deleteEntity(const Uid & uid)
 {
     // valid input?
     Q_ASSERT(uid.isValid());
-    Q_ASSERT(d->entityMap.contains(uid));
+    Q_ASSERT(d->entities.entity(uid));
 
     // get entity
-    auto it = d->entityMap.find(uid);
-    if (it != d->entityMap.end()) {
-        const auto entity = *it;
-
+    if (auto entity = d->entities.entity(uid)) {
         // unregister entity
-        d->entityMap.erase(it);
-        Q_ASSERT(d->entities.contains(entity));
-        d->entities.erase(std::find(d->entities.begin(), d->entities.end(), entity));
+        d->entities.remove(entity);
+        d->changes.addDeleted(uid);
+
+        // forget all attachments and the bounds of the entity
+        if (entity->entityType() == EntityType::Node) {
+            d->attachments.removeNode(uid);
+            d->spatialIndex.remove(uid);
+        } else if (entity->entityType() == EntityType::Path) {
+            d->attachments.removePath(uid);
+            d->spatialIndex.remove(uid);
+        }
 
         // truly delete node
         delete entity;
     }
 }
 
+void Document::reserveEntities(EntityType type, qint64 maxId, int count)
+{
+    d->entities.reserve(type, maxId, count);
+}
+
 Node * Document::createNode()
 {
     Transaction transaction(this, "Create Node");
@@ -659,9 +1463,16 @@ Path * Document::createPath()
     return path;
 }
 
-Path * Document::createPath(PathType type, const Uid & uid)
+Path * Document::createPath(PathType type, const Uid & uidIn)
 {
-    Q_ASSERT(uid.isValid());
+    Q_ASSERT(uidIn.isValid());
+    Q_ASSERT(!d->entities.contains(uidIn.id()));
+
+    // bind the uid to the current generation of its slot
+    const Uid uid(uidIn.id(), this, d->entities.generation(uidIn.id()));
+
+    // never hand out this id again, e.g. when replaying a journal
+    d->nextId = std::max(d->nextId, uid.id() + 1);
 
     // create new path
     Path* path = nullptr;
@@ -683,13 +1494,12 @@ Path * Document::createPath(PathType type, const Uid & uid)
     }
 
     // register path
-    d->entities.append(path);
-
-    // insert path into hash map
-    d->entityMap.insert(uid, path);
+    d->entities.insert(path);
+    d->changes.addCreated(uid);
+    d->updateBounds(path);
 
-    // propagate changed signal
-    connect(path, &ConfigObject::changed, this, &ConfigObject::emitChangedIfNeeded);
+    // record changes and propagate changed signal
+    d->watchEntity(path);
 
     return path;
 }
@@ -710,18 +1520,164 @@ Entity * Document::entity(const tikz::core::Uid & uid) const
         return d->style;
     }
 
-    // all other entities are in the entity list
-    const auto it = d->entityMap.find(uid);
-    if (it != d->entityMap.end()) {
-        return *it;
+    // all other entities are resolved through the handle table
+    return d->entities.entity(uid);
+}
+
+QVector<Uid> Document::attachedPaths(const Uid & nodeUid) const
+{
+    return d->attachments.paths(nodeUid);
+}
+
+void Document::subscribe(const Uid & nodeUid, QObject * context,
+                         const std::function<void()> & callback)
+{
+    Q_ASSERT(context);
+    Q_ASSERT(callback);
+
+    d->subscriptions[nodeUid].append(DocumentPrivate::Subscription{context, callback});
+}
+
+void Document::unsubscribe(const Uid & nodeUid, QObject * context)
+{
+    auto it = d->subscriptions.find(nodeUid);
+    if (it == d->subscriptions.end()) {
+        return;
+    }
+
+    auto & list = *it;
+    list.erase(std::remove_if(list.begin(), list.end(), [context](const DocumentPrivate::Subscription & s) {
+        return s.context == context || s.context.isNull();
+    }), list.end());
+
+    if (list.isEmpty()) {
+        d->subscriptions.erase(it);
     }
+}
 
-    return nullptr;
+QVector<Uid> Document::entitiesIn(const QRectF & rect) const
+{
+    return d->spatialIndex.intersecting(rect);
+}
+
+QVector<Uid> Document::nearestEntities(const tikz::Pos & pos, int k) const
+{
+    return d->spatialIndex.nearest(pos, k);
+}
+
+void Document::updateNodeAttachment(const Uid & pathUid, Node * oldNode, Node * newNode)
+{
+    if (oldNode) {
+        d->attachments.detach(oldNode->uid(), pathUid);
+    }
+
+    if (newNode) {
+        d->attachments.attach(newNode->uid(), pathUid);
+    }
+}
+
+void Document::recordPropertyChange(const Uid & uid, const char * property)
+{
+    // property names are string literals, so cache their ids by address
+    auto it = d->propertyIds.constFind(property);
+    if (it == d->propertyIds.constEnd()) {
+        it = d->propertyIds.insert(property, propertyManager().propertyId(QLatin1String(property)));
+    }
+    d->changes.addProperty(uid, *it);
+}
+
+void Document::scheduleStyleChange(const Uid & styleUid)
+{
+    // changes caused by the notification itself are already part of it
+    if (d->suppressStyleChanges) {
+        return;
+    }
+
+    d->dirtyStyles.insert(styleUid);
+    d->changes.addEntity(styleUid);
+
+    // outside of transactions, notify immediately
+    if (!configActive()) {
+        flushStyleChanges();
+    }
+}
+
+void Document::flushStyleChanges()
+{
+    if (d->dirtyStyles.isEmpty()) {
+        return;
+    }
+
+    // emit our changed() signal only once at the end
+    ConfigTransaction transaction(this);
+    d->suppressStyleChanges = true;
+
+    // walk the style tree once: the changed styles already emitted changed(),
+    // all styles inheriting from them are notified here exactly once
+    const QSet<Uid> roots = d->dirtyStyles;
+    d->dirtyStyles.clear();
+
+    QVector<Uid> stack = roots.values().toVector();
+    QSet<Uid> visited;
+    QSet<Uid> affectedSet;
+    QVector<Uid> affected;
+    while (!stack.isEmpty()) {
+        const Uid uid = stack.takeLast();
+        if (visited.contains(uid)) {
+            continue;
+        }
+        visited.insert(uid);
+
+        auto style = uid.entity<Style>();
+        if (!style) {
+            continue;
+        }
+
+        affected.append(uid);
+        affectedSet.insert(uid);
+        if (!roots.contains(uid)) {
+            style->emitChangedIfNeeded();
+        }
+        stack += style->childStyles();
+    }
+
+    d->suppressStyleChanges = false;
+
+    if (affected.isEmpty()) {
+        return;
+    }
+
+    // reverse lookup of the nodes and paths using an affected style.
+    // Entities without style entity use an internal style that inherits
+    // from the style it was given as parent.
+    const auto usesAffectedStyle = [&affectedSet](const Uid & styleUid, Style * style) {
+        return affectedSet.contains(styleUid.isValid() ? styleUid : style->parentStyle());
+    };
+    QVector<Uid> users;
+    for (auto node : nodeRange()) {
+        if (usesAffectedStyle(node->styleUid(), node->style())) {
+            users.append(node->uid());
+        }
+    }
+    for (auto path : pathRange()) {
+        if (usesAffectedStyle(path->styleUid(), path->style())) {
+            users.append(path->uid());
+        }
+    }
+
+    Q_EMIT stylesChanged(affected, users);
 }
 
 QVector<Uid> Document::entities() const
 {
-    return QVector<Uid>::fromList(d->entityMap.keys());
+    const auto allEntities = d->entities.allEntities();
+
+    QVector<Uid> uids;
+    uids.reserve(allEntities.size());
+    for (auto entity : allEntities) {
+        uids.append(entity->uid());
+    }
+    return uids;
 }
 
 
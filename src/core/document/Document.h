@@ -25,10 +25,15 @@
 #include "tikz.h"
 #include "Path.h"
 #include "MetaPos.h"
+#include "ChangeSet.h"
 
 #include <QVector>
+#include <QVariantMap>
+
+#include <functional>
 
 class QAbstractItemModel;
+class QRectF;
 class QUrl;
 
 namespace tikz {
@@ -48,6 +53,17 @@ class TIKZKITCORE_EXPORT Document : public Entity
     Q_PROPERTY(Style* style READ style)
 
     public:
+        /**
+         * File formats supported by saveAs().
+         * load() detects the format of the file.
+         */
+        enum class FileFormat {
+            Json,   ///< compact JSON text
+            Cbor,   ///< binary CBOR, see CborWriter
+            Chunked ///< chunked file, saves write only the changes, see ChunkFile
+        };
+        Q_ENUM(FileFormat)
+
         /**
          * Default constructor.
          */
@@ -90,6 +106,10 @@ class TIKZKITCORE_EXPORT Document : public Entity
 
         /**
          * Load the tikz document from @p url.
+         * The state is restored from the latest checkpoint in the file, so
+         * that only the history recorded after the checkpoint is replayed.
+         * The older history is attached and read only when it is undone.
+         * The file format is detected, see fileFormat().
          */
         bool load(const QUrl & url);
 
@@ -105,10 +125,53 @@ class TIKZKITCORE_EXPORT Document : public Entity
         bool save();
 
         /**
-         * Save the tikz document to @p file in json notation.
+         * Save the tikz document to @p file in the format fileFormat().
+         * Besides the undo history, the current state of all entities is
+         * saved as checkpoint, see load().
          */
         bool saveAs(const QUrl & file);
 
+    public:
+        /**
+         * Sets the format used by saveAs() to @p format.
+         * load() sets the format of the loaded file, close() resets the
+         * format to FileFormat::Json.
+         */
+        void setFileFormat(FileFormat format);
+
+        /**
+         * Returns the format used by saveAs().
+         */
+        FileFormat fileFormat() const;
+
+    public Q_SLOTS:
+
+        /**
+         * Starts the autosave journal @p filename. An existing file is
+         * truncated. From now on, each transaction, undo and redo is
+         * appended to the journal, and each save truncates it again.
+         * Therefore, the journal always holds the changes since the
+         * Document was loaded or saved, see recoverJournal().
+         * Passing an empty @p filename stops the journal. The journal is
+         * stopped as well by close() and load().
+         * @return @e true on success
+         */
+        bool setJournalFile(const QString & filename);
+
+        /**
+         * Returns the file name of the running autosave journal, or an
+         * empty string.
+         */
+        QString journalFile() const;
+
+        /**
+         * Replays the journal @p filename, e.g. after a crash. Typically,
+         * the last saved state is loaded with load() first. Afterwards, the
+         * journal continues in @p filename.
+         * @return @e true, if @p filename is a journal
+         */
+        bool recoverJournal(const QString & filename);
+
     public:
         /**
          * Get the current url of this file.
@@ -155,6 +218,24 @@ class TIKZKITCORE_EXPORT Document : public Entity
          */
         void documentNameChanged(tikz::core::Document * doc);
 
+        /**
+         * This signal is emitted once after the outermost transaction if
+         * Style%s changed. @p styles contains all changed styles as well as
+         * all styles inheriting from them, each exactly once.
+         * All styles in @p styles already emitted their changed() signal.
+         * @p entities contains all nodes and paths using one of @p styles.
+         */
+        void stylesChanged(const QVector<tikz::core::Uid> & styles,
+                           const QVector<tikz::core::Uid> & entities);
+
+        /**
+         * This signal is emitted right before changed(), whenever the
+         * outermost transaction finished or an entity changed outside of
+         * a transaction. @p changes contains all entities and properties
+         * that changed since the last emission.
+         */
+        void changesCommitted(const tikz::core::ChangeSet & changes);
+
     //
     // Undo / redo management
     //
@@ -171,6 +252,32 @@ class TIKZKITCORE_EXPORT Document : public Entity
          */
         void beginTransaction(const QString & name);
 
+        /**
+         * Begin undo group @p name for an interactive gesture, such as
+         * dragging nodes. Until the matching finishTransaction(), repeated
+         * changes of the same entity are applied directly and coalesced
+         * into one undo item, see UndoManager::startGesture().
+         */
+        void beginGesture(const QString & name);
+
+        /**
+         * Check whether a gesture is currently running, see beginGesture().
+         */
+        bool gestureRunning() const;
+
+        /**
+         * Returns the undo item of type @p typeName recorded for @p uid in
+         * the running gesture, or nullptr.
+         */
+        tikz::core::UndoItem * gestureItem(const Uid & uid, const char * typeName) const;
+
+        /**
+         * Records @p undoItem for @p uid in the running gesture. The undo
+         * item is not executed, but added to the undo group of the gesture
+         * right away.
+         */
+        void addGestureItem(const Uid & uid, tikz::core::UndoItem * undoItem);
+
         /**
          * Cancel the currently pending transaction. All changes are reverted
          * and the undo / redo stack remains unchanged.
@@ -222,6 +329,35 @@ class TIKZKITCORE_EXPORT Document : public Entity
          */
         QAbstractItemModel * historyModel() const;
 
+        /**
+         * Limits the undo history to @p groups undo groups. Older groups
+         * are deleted. A limit of 0, the default, keeps all groups.
+         */
+        void setHistoryLimit(int groups);
+
+        /**
+         * Returns the maximum number of undo groups, or 0 for no limit.
+         */
+        int historyLimit() const;
+
+        /**
+         * Sets the memory budget of the undo history to @p bytes.
+         * Beyond the budget, the oldest undo groups are spilled to disk and
+         * loaded again transparently when undone. A budget of 0 or less
+         * keeps the entire history in memory.
+         */
+        void setHistoryMemoryBudget(qint64 bytes);
+
+        /**
+         * Returns the memory budget of the undo history in bytes.
+         */
+        qint64 historyMemoryBudget() const;
+
+        /**
+         * Returns the estimated memory in bytes held by the undo history.
+         */
+        qint64 historyMemoryUsage() const;
+
     public Q_SLOTS:
         /**
          * Undo one undo group.
@@ -301,6 +437,27 @@ class TIKZKITCORE_EXPORT Document : public Entity
          */
         QVector<Uid> paths() const;
 
+        /**
+         * Returns a range over all nodes of the tikz document.
+         * In contrast to nodes(), no list is copied.
+         * @note The range is invalidated when entities are created or deleted.
+         */
+        EntityRange<Node> nodeRange() const;
+
+        /**
+         * Returns a range over all paths of the tikz document.
+         * In contrast to paths(), no list is copied.
+         * @note The range is invalidated when entities are created or deleted.
+         */
+        EntityRange<Path> pathRange() const;
+
+        /**
+         * Returns a range over all styles of the tikz document.
+         * The global document style() is not part of this range.
+         * @note The range is invalidated when entities are created or deleted.
+         */
+        EntityRange<Style> styleRange() const;
+
         /**
          * Returns the Entity for the Uid @p uid.
          * A null pointer is returned if the Entity does not exist, or if the
@@ -313,6 +470,46 @@ class TIKZKITCORE_EXPORT Document : public Entity
          */
         QVector<Uid> entities() const;
 
+        /**
+         * Returns all Path%s attached to the Node @p nodeUid, i.e., all
+         * paths with a MetaPos referring to the node. Each path is
+         * contained exactly once. The lookup does not iterate all paths.
+         */
+        QVector<Uid> attachedPaths(const Uid & nodeUid) const;
+
+        /**
+         * Returns all Node%s and Path%s whose bounding rect intersects
+         * @p rect. The coordinates of @p rect are in Unit::Point.
+         * The bounds are looked up in a spatial index, i.e. the query
+         * does not iterate all entities.
+         */
+        QVector<Uid> entitiesIn(const QRectF & rect) const;
+
+        /**
+         * Returns up to @p k Node%s and Path%s with the bounding rects
+         * closest to @p pos, sorted by increasing distance.
+         */
+        QVector<Uid> nearestEntities(const tikz::Pos & pos, int k) const;
+
+    //
+    // change notification of nodes referred to by MetaPos%s
+    //
+    public:
+        /**
+         * Calls @p callback whenever the Node @p nodeUid changed, e.g. since
+         * it moved. Use this to get notified about changes of the node a
+         * MetaPos refers to, since MetaPos itself has no signals.
+         * The subscription ends with unsubscribe(), or as soon as @p context
+         * is destroyed. Paths are notified about their attached nodes anyway.
+         */
+        void subscribe(const Uid & nodeUid, QObject * context,
+                       const std::function<void()> & callback);
+
+        /**
+         * Removes all subscriptions of @p context to the Node @p nodeUid.
+         */
+        void unsubscribe(const Uid & nodeUid, QObject * context);
+
     //
     // Node and path creation
     //
@@ -332,6 +529,19 @@ class TIKZKITCORE_EXPORT Document : public Entity
             return qobject_cast<T*>(createEntity(type));
         }
 
+        /**
+         * Creates @p count entities of @p type at once, and sets the initial
+         * @p properties of each entity, e.g. "text" or "pos" for Nodes.
+         *
+         * In contrast to calling createEntity() @p count times, all entities
+         * are created by a single undo item, and changesCommitted() as well
+         * as changed() are emitted only once.
+         *
+         * @return the created entities, in the order of their Uids
+         */
+        QVector<Entity *> createEntities(tikz::EntityType type, int count,
+                                         const QVariantMap & properties = QVariantMap());
+
         /**
          * Helper function to create a Node.
          */
@@ -363,11 +573,50 @@ class TIKZKITCORE_EXPORT Document : public Entity
          */
         virtual void deleteEntity(const Uid & uid);
 
+        /**
+         * Preallocates the storage for @p count entities of @p type with
+         * ids up to @p maxId. Called before creating many entities at once.
+         */
+        void reserveEntities(EntityType type, qint64 maxId, int count);
+
         /**
          * Create a new path associated with this document with @p uid.
          */
         virtual Path * createPath(PathType type, const Uid & uid);
 
+    //
+    // internal: change tracking
+    //
+    protected:
+        /**
+         * Called by a Path whenever one of its MetaPos%s is attached to a
+         * different Node. Updates the index used by attachedPaths().
+         */
+        void updateNodeAttachment(const Uid & pathUid, Node * oldNode, Node * newNode);
+
+        /**
+         * Called by Entity::propertyChanged() to record that @p property
+         * of the entity @p uid changed. @p property must be a string literal.
+         */
+        void recordPropertyChange(const Uid & uid, const char * property);
+
+        /**
+         * Called by a Style whenever its properties or its parent changed.
+         * Within a transaction, the notification of all styles inheriting
+         * from @p styleUid is delayed until the outermost transaction
+         * finished. This way, each style emits changed() only once, even
+         * if its parent styles change several times.
+         */
+        void scheduleStyleChange(const Uid & styleUid);
+
+    private:
+        /**
+         * Emits changed() for all styles inheriting from the scheduled styles,
+         * and finally emits stylesChanged() for these styles and the nodes
+         * and paths using them.
+         */
+        void flushStyleChanges();
+
     //
     // data pointer
     //
@@ -381,8 +630,14 @@ class TIKZKITCORE_EXPORT Document : public Entity
         // visitors
         friend class DeserializeVisitor;
 
+        // change tracking and style change notification
+        friend class Entity;
+        friend class Path;
+        friend class Style;
+
         // uddo/redo system
         friend class UndoCreateEntity;
+        friend class UndoCreateEntities;
         friend class UndoDeleteEntity;
         friend class UndoCreatePath;
         friend class UndoDeletePath;
@@ -0,0 +1,176 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "EntityStore.h"
+
+namespace tikz {
+namespace core {
+
+void EntityStore::insert(Entity * entity)
+{
+    Q_ASSERT(entity);
+
+    const qint64 id = entity->uid().id();
+    Q_ASSERT(id >= 0 && id <= MaxId);
+    Q_ASSERT(!contains(id));
+
+    Q_ASSERT(entity->uid().generation() == 0
+             || entity->uid().generation() == generation(id));
+
+    // grow slot array, if required (new slots are default initialized)
+    if (id >= m_slots.size()) {
+        m_slots.resize(id + 1);
+    }
+
+    const int type = static_cast<int>(entity->entityType());
+    Slot & slot = m_slots[id];
+    slot.entity = entity;
+    slot.index = m_dense[type].size();
+    m_dense[type].append(entity);
+    ++m_count[type];
+}
+
+void EntityStore::remove(Entity * entity)
+{
+    Q_ASSERT(entity);
+
+    const qint64 id = entity->uid().id();
+    Q_ASSERT(contains(id));
+
+    const int type = static_cast<int>(entity->entityType());
+    Slot & slot = m_slots[id];
+    Q_ASSERT(m_dense[type][slot.index] == entity);
+
+    // leave a hole to keep the order of all other entities.
+    // The generation is kept, since undo may insert the entity again.
+    m_dense[type][slot.index] = nullptr;
+    slot.entity = nullptr;
+    slot.index = -1;
+    --m_count[type];
+
+    // compact, if more than half of the entries are holes
+    if (2 * m_count[type] < m_dense[type].size()) {
+        compact(static_cast<EntityType>(type));
+    }
+}
+
+void EntityStore::reserve(EntityType type, qint64 maxId, int count)
+{
+    Q_ASSERT(maxId >= 0 && maxId <= MaxId);
+    Q_ASSERT(count >= 0);
+
+    if (maxId >= m_slots.size()) {
+        m_slots.reserve(maxId + 1);
+    }
+
+    auto & dense = m_dense[static_cast<int>(type)];
+    dense.reserve(dense.size() + count);
+}
+
+void EntityStore::clear()
+{
+    for (int i = 0; i < TypeCount; ++i) {
+        m_dense[i].clear();
+        m_count[i] = 0;
+    }
+
+    // keep the slots, so that stale Uids never match a new generation
+    for (auto & slot : m_slots) {
+        slot.entity = nullptr;
+        slot.index = -1;
+        ++slot.generation;
+    }
+}
+
+quint32 EntityStore::generation(qint64 id) const
+{
+    Q_ASSERT(id >= 0);
+    return id < m_slots.size() ? m_slots[id].generation : Slot().generation;
+}
+
+bool EntityStore::contains(qint64 id) const
+{
+    return id >= 0 && id < m_slots.size() && m_slots[id].entity != nullptr;
+}
+
+int EntityStore::count(EntityType type) const
+{
+    return m_count[static_cast<int>(type)];
+}
+
+int EntityStore::count() const
+{
+    int sum = 0;
+    for (int i = 0; i < TypeCount; ++i) {
+        sum += m_count[i];
+    }
+    return sum;
+}
+
+const QVector<Entity *> & EntityStore::entities(EntityType type) const
+{
+    return m_dense[static_cast<int>(type)];
+}
+
+QVector<Entity *> EntityStore::allEntities() const
+{
+    QVector<Entity *> list;
+    list.reserve(count());
+    for (int i = 0; i < TypeCount; ++i) {
+        for (auto entity : m_dense[i]) {
+            if (entity) {
+                list.append(entity);
+            }
+        }
+    }
+    return list;
+}
+
+qint64 EntityStore::maxId() const
+{
+    for (qint64 id = m_slots.size() - 1; id >= 0; --id) {
+        if (m_slots[id].entity) {
+            return id;
+        }
+    }
+    return -1;
+}
+
+void EntityStore::compact(EntityType type)
+{
+    auto & dense = m_dense[static_cast<int>(type)];
+
+    int next = 0;
+    for (int i = 0; i < dense.size(); ++i) {
+        Entity * entity = dense[i];
+        if (entity) {
+            dense[next] = entity;
+            m_slots[entity->uid().id()].index = next;
+            ++next;
+        }
+    }
+    dense.resize(next);
+
+    Q_ASSERT(next == m_count[static_cast<int>(type)]);
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,181 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_ENTITY_STORE_H
+#define TIKZ_CORE_ENTITY_STORE_H
+
+#include "tikz.h"
+#include "Entity.h"
+
+#include <QVector>
+
+namespace tikz {
+namespace core {
+
+/**
+ * Internal storage of all entities of a Document, grouped by EntityType.
+ *
+ * Each EntityType has its own dense array of Entity pointers in insertion
+ * order. The Uid::id() of an entity is used as stable handle into a slot
+ * array that holds the position of the entity in its dense array. This way,
+ * inserting and removing is O(1), and iterating all entities of one type
+ * does neither require a type check nor a copy.
+ *
+ * Removing an entity leaves a nullptr in the dense array, so that the order
+ * of all other entities is kept. The dense array is compacted as soon as
+ * more than half of its entries are removed.
+ *
+ * Besides, the slot array is the handle table behind Uid::entity(): each
+ * slot holds the Entity pointer and a generation. Resolving a Uid is a
+ * bounds check plus an array access, and Uids bound to an older generation
+ * of the slot resolve to a null pointer. The generation of all slots is
+ * increased in clear(), since afterwards the ids are handed out again.
+ */
+class EntityStore
+{
+    public:
+        /**
+         * Highest id insert() accepts. The slot array is indexed by the id,
+         * so its size is bounded by the highest id ever inserted.
+         */
+        static constexpr qint64 MaxId = (qint64(1) << 26) - 1;
+
+        /**
+         * Insert @p entity. The entity's Uid must not yet be contained,
+         * and its id must not exceed MaxId.
+         */
+        void insert(Entity * entity);
+
+        /**
+         * Remove @p entity. The entity is not deleted.
+         */
+        void remove(Entity * entity);
+
+        /**
+         * Preallocates the slot array for ids up to @p maxId, and the dense
+         * array of @p type for @p count additional entities. Use this prior
+         * to inserting many entities at once.
+         */
+        void reserve(EntityType type, qint64 maxId, int count);
+
+        /**
+         * Removes all entities. The entities are not deleted.
+         * All Uids bound to the current generation become stale.
+         */
+        void clear();
+
+        /**
+         * Returns the generation of the slot for @p id, i.e. the generation
+         * an Entity with this id is bound to when inserted now.
+         */
+        quint32 generation(qint64 id) const;
+
+        /**
+         * Resolves @p uid to the Entity stored in its slot.
+         * Returns a null pointer, if the slot is empty, or if @p uid is bound
+         * to a different generation than the slot.
+         */
+        inline Entity * entity(const Uid & uid) const
+        {
+            const qint64 id = uid.id();
+            if (id < 0 || id >= m_slots.size()) {
+                return nullptr;
+            }
+
+            const Slot & slot = m_slots[id];
+            if (uid.generation() != 0 && uid.generation() != slot.generation) {
+                return nullptr;
+            }
+            return slot.entity;
+        }
+
+        /**
+         * Returns @e true, if an entity with the id @p id is contained.
+         */
+        bool contains(qint64 id) const;
+
+        /**
+         * Returns the number of entities of type @p type.
+         */
+        int count(EntityType type) const;
+
+        /**
+         * Returns the number of all entities.
+         */
+        int count() const;
+
+        /**
+         * Returns the dense array of entities of type @p type.
+         * @note The array may contain null pointers for removed entities.
+         */
+        const QVector<Entity *> & entities(EntityType type) const;
+
+        /**
+         * Returns a range over all entities of type T that are stored as @p type.
+         */
+        template <typename T>
+        EntityRange<T> range(EntityType type) const
+        {
+            return EntityRange<T>(entities(type), count(type));
+        }
+
+        /**
+         * Returns a list of all entities, grouped by type.
+         */
+        QVector<Entity *> allEntities() const;
+
+        /**
+         * Returns the highest id of all contained entities, or -1.
+         */
+        qint64 maxId() const;
+
+    private:
+        /**
+         * Removes all null pointers from the dense array of @p type.
+         */
+        void compact(EntityType type);
+
+    private:
+        // entry of the handle table
+        struct Slot
+        {
+            Entity * entity = nullptr;
+            int index = -1;         // position in the dense array, or -1
+            quint32 generation = 1; // 0 is reserved for unbound Uids
+        };
+
+        // number of entity types stored in the dense arrays
+        static constexpr int TypeCount = static_cast<int>(EntityType::Path) + 1;
+
+        // dense entity arrays, one per EntityType
+        QVector<Entity *> m_dense[TypeCount];
+
+        // number of valid (non-null) entries in the dense arrays
+        int m_count[TypeCount] = {};
+
+        // handle table, indexed by Uid::id()
+        QVector<Slot> m_slots;
+};
+
+}
+}
+
+#endif // TIKZ_CORE_ENTITY_STORE_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,114 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "NodePathIndex.h"
+
+namespace tikz {
+namespace core {
+
+void NodePathIndex::attach(const Uid & node, const Uid & path)
+{
+    Q_ASSERT(node.isValid());
+    Q_ASSERT(path.isValid());
+
+    m_nodePaths[node].append(path);
+    m_pathNodes[path].append(node);
+}
+
+void NodePathIndex::detach(const Uid & node, const Uid & path)
+{
+    auto pathsIt = m_nodePaths.find(node);
+    if (pathsIt != m_nodePaths.end()) {
+        pathsIt->removeOne(path);
+        if (pathsIt->isEmpty()) {
+            m_nodePaths.erase(pathsIt);
+        }
+    }
+
+    auto nodesIt = m_pathNodes.find(path);
+    if (nodesIt != m_pathNodes.end()) {
+        nodesIt->removeOne(node);
+        if (nodesIt->isEmpty()) {
+            m_pathNodes.erase(nodesIt);
+        }
+    }
+}
+
+void NodePathIndex::removePath(const Uid & path)
+{
+    const QVector<Uid> nodes = m_pathNodes.take(path);
+    for (const auto & node : nodes) {
+        auto it = m_nodePaths.find(node);
+        if (it != m_nodePaths.end()) {
+            it->removeAll(path);
+            if (it->isEmpty()) {
+                m_nodePaths.erase(it);
+            }
+        }
+    }
+}
+
+void NodePathIndex::removeNode(const Uid & node)
+{
+    const QVector<Uid> paths = m_nodePaths.take(node);
+    for (const auto & path : paths) {
+        auto it = m_pathNodes.find(path);
+        if (it != m_pathNodes.end()) {
+            it->removeAll(node);
+            if (it->isEmpty()) {
+                m_pathNodes.erase(it);
+            }
+        }
+    }
+}
+
+void NodePathIndex::clear()
+{
+    m_nodePaths.clear();
+    m_pathNodes.clear();
+}
+
+QVector<Uid> NodePathIndex::paths(const Uid & node) const
+{
+    return unique(m_nodePaths.value(node));
+}
+
+QVector<Uid> NodePathIndex::nodes(const Uid & path) const
+{
+    return unique(m_pathNodes.value(path));
+}
+
+QVector<Uid> NodePathIndex::unique(const QVector<Uid> & uids)
+{
+    // typically, only very few paths are attached to a node, so a linear
+    // search is faster than a set
+    QVector<Uid> result;
+    result.reserve(uids.size());
+    for (const auto & uid : uids) {
+        if (!result.contains(uid)) {
+            result.append(uid);
+        }
+    }
+    return result;
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
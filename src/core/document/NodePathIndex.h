@@ -0,0 +1,99 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_NODE_PATH_INDEX_H
+#define TIKZ_CORE_NODE_PATH_INDEX_H
+
+#include "Uid.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace tikz {
+namespace core {
+
+/**
+ * Internal adjacency index of a Document from Node%s to the Path%s
+ * attached to them, and vice versa.
+ *
+ * The index is updated by the Path%s whenever the Node of one of their
+ * MetaPos%s changes, see Path::nodeAttachmentChanged(). This way, the
+ * paths attached to a node are found without iterating all paths of
+ * the Document, e.g. when deleting or moving a node.
+ *
+ * A path may be attached to the same node more than once, e.g. if the
+ * start and the end of an EdgePath refer to the same node. Therefore,
+ * each attachment is stored separately.
+ */
+class NodePathIndex
+{
+    public:
+        /**
+         * Adds an attachment of @p path to @p node.
+         */
+        void attach(const Uid & node, const Uid & path);
+
+        /**
+         * Removes one attachment of @p path to @p node.
+         */
+        void detach(const Uid & node, const Uid & path);
+
+        /**
+         * Removes all attachments of @p path.
+         */
+        void removePath(const Uid & path);
+
+        /**
+         * Removes all attachments to @p node.
+         */
+        void removeNode(const Uid & node);
+
+        /**
+         * Removes all attachments.
+         */
+        void clear();
+
+        /**
+         * Returns all paths attached to @p node, each path exactly once.
+         */
+        QVector<Uid> paths(const Uid & node) const;
+
+        /**
+         * Returns all nodes @p path is attached to, each node exactly once.
+         */
+        QVector<Uid> nodes(const Uid & path) const;
+
+    private:
+        // helper: returns @p uids without duplicates
+        static QVector<Uid> unique(const QVector<Uid> & uids);
+
+    private:
+        // node -> attached paths
+        QHash<Uid, QVector<Uid>> m_nodePaths;
+
+        // path -> nodes the path is attached to
+        QHash<Uid, QVector<Uid>> m_pathNodes;
+};
+
+}
+}
+
+#endif // TIKZ_CORE_NODE_PATH_INDEX_H
+
+// kate: indent-width 4; replace-tabs on;
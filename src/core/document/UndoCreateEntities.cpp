@@ -0,0 +1,192 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2013-2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "UndoCreateEntities.h"
+#include "Document.h"
+#include "Value.h"
+#include "Pos.h"
+
+#include <QDataStream>
+#include <QMetaType>
+
+namespace tikz {
+namespace core {
+
+// helper: serialize a property value, including the tikz types
+static QJsonObject variantToJson(const QVariant & value)
+{
+    QJsonObject json;
+    json["type"] = QString::fromLatin1(value.typeName());
+
+    if (value.userType() == qMetaTypeId<Uid>()) {
+        json["value"] = value.value<Uid>().toString();
+    } else if (value.userType() == qMetaTypeId<tikz::Value>()) {
+        json["value"] = value.value<tikz::Value>().toString();
+    } else if (value.userType() == qMetaTypeId<tikz::Pos>()) {
+        json["value"] = value.value<tikz::Pos>().toString();
+    } else {
+        json["value"] = QJsonValue::fromVariant(value);
+    }
+    return json;
+}
+
+// helper: deserialize a property value written by variantToJson()
+static QVariant variantFromJson(const QJsonObject & json, Document * doc)
+{
+    const QByteArray type = json["type"].toString().toLatin1();
+    const int typeId = QMetaType::type(type.constData());
+    const QJsonValue value = json["value"];
+
+    if (typeId == qMetaTypeId<Uid>()) {
+        return QVariant::fromValue(Uid(value.toString(), doc));
+    } else if (typeId == qMetaTypeId<tikz::Value>()) {
+        return QVariant::fromValue(tikz::Value::fromString(value.toString()));
+    } else if (typeId == qMetaTypeId<tikz::Pos>()) {
+        return QVariant::fromValue(tikz::Pos::fromString(value.toString()));
+    }
+
+    QVariant variant = value.toVariant();
+    if (typeId != QMetaType::UnknownType) {
+        variant.convert(typeId);
+    }
+    return variant;
+}
+
+UndoCreateEntities::UndoCreateEntities(Document * doc)
+    : UndoItem("Create Entities", doc)
+{
+}
+
+UndoCreateEntities::UndoCreateEntities(const Uid & firstUid, int count, EntityType type,
+                                       const QVariantMap & properties, Document * doc)
+    : UndoItem("Create Entities", doc)
+    , m_firstId(firstUid.id())
+    , m_count(count)
+    , m_entityType(type)
+{
+    m_properties.reserve(properties.size());
+    for (auto it = properties.cbegin(); it != properties.cend(); ++it) {
+        m_properties.append(qMakePair(it.key().toLatin1(), it.value()));
+    }
+}
+
+UndoCreateEntities::~UndoCreateEntities() = default;
+
+void UndoCreateEntities::undo()
+{
+    // delete in reverse order, so that the entity store removes the
+    // entities from the back of its arrays
+    auto doc = document();
+    for (qint64 id = m_firstId + m_count - 1; id >= m_firstId; --id) {
+        doc->deleteEntity(Uid(id, doc));
+    }
+}
+
+void UndoCreateEntities::redo()
+{
+    auto doc = document();
+    doc->reserveEntities(m_entityType, m_firstId + m_count, m_count);
+
+    for (qint64 id = m_firstId; id < m_firstId + m_count; ++id) {
+        Entity * e = doc->createEntity(Uid(id, doc), m_entityType);
+        Q_ASSERT(e);
+
+        for (const auto & property : m_properties) {
+            e->setProperty(property.first.constData(), property.second);
+        }
+    }
+}
+
+void UndoCreateEntities::loadData(const QJsonObject & json)
+{
+    const Uid firstUid(json["uid"].toString(), document());
+    m_firstId = firstUid.id();
+    m_count = json["count"].toInt();
+    m_entityType = toEntityType(json["type"].toString());
+
+    m_properties.clear();
+    const QJsonObject properties = json["properties"].toObject();
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        m_properties.append(qMakePair(it.key().toLatin1(),
+                                      variantFromJson(it.value().toObject(), document())));
+    }
+}
+
+QJsonObject UndoCreateEntities::saveData() const
+{
+    QJsonObject json;
+    json["uid"] = QString::number(m_firstId);
+    json["count"] = m_count;
+    json["type"] = toString(m_entityType);
+
+    QJsonObject properties;
+    for (const auto & property : m_properties) {
+        properties[QString::fromLatin1(property.first)] = variantToJson(property.second);
+    }
+    json["properties"] = properties;
+
+    return json;
+}
+
+const char * UndoCreateEntities::typeName() const
+{
+    return "entities-create";
+}
+
+qint64 UndoCreateEntities::memoryUsage() const
+{
+    qint64 size = UndoItem::memoryUsage()
+                + m_properties.capacity() * static_cast<qint64>(sizeof(QPair<QByteArray, QVariant>));
+    for (const auto & property : m_properties) {
+        size += property.first.capacity();
+    }
+    return size;
+}
+
+void UndoCreateEntities::loadCompactData(QDataStream & stream)
+{
+    qint32 count, type, propertyCount;
+    stream >> m_firstId >> count >> type >> propertyCount;
+    m_count = count;
+    m_entityType = static_cast<EntityType>(type);
+
+    m_properties.clear();
+    m_properties.reserve(propertyCount);
+    for (int i = 0; i < propertyCount; ++i) {
+        QByteArray name;
+        stream >> name;
+        m_properties.append(qMakePair(name, readVariant(stream)));
+    }
+}
+
+void UndoCreateEntities::saveCompactData(QDataStream & stream) const
+{
+    stream << m_firstId << static_cast<qint32>(m_count)
+           << static_cast<qint32>(m_entityType)
+           << static_cast<qint32>(m_properties.size());
+    for (const auto & property : m_properties) {
+        stream << property.first;
+        writeVariant(stream, property.second);
+    }
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,134 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2018 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_UNDO_CREATE_ENTITIES_H
+#define TIKZ_UNDO_CREATE_ENTITIES_H
+
+#include "UndoItem.h"
+#include "Uid.h"
+
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+#include <QPair>
+
+namespace tikz {
+namespace core {
+
+class Document;
+
+/**
+ * Undo item that creates @p count entities of the same type at once.
+ *
+ * In contrast to one UndoCreateEntity per entity, the created entities
+ * share one undo item: the Uids are consecutive, so only the first Uid
+ * and the number of entities are stored, along with the initial
+ * properties that are applied to each created entity.
+ */
+class UndoCreateEntities : public UndoItem
+{
+    public:
+        /**
+         * Constructor.
+         */
+        UndoCreateEntities(Document * doc);
+
+        /**
+         * Constructor. Creates the entities with the ids
+         * [firstUid.id(), firstUid.id() + count) of type @p type, and
+         * sets the initial @p properties of each entity.
+         */
+        UndoCreateEntities(const Uid & firstUid, int count, EntityType type,
+                           const QVariantMap & properties, Document * doc);
+
+        /**
+         * Destructor.
+         */
+        virtual ~UndoCreateEntities();
+
+        /**
+         * Returns "entities-create".
+         */
+        const char * typeName() const override;
+
+        /**
+         * Returns the estimated memory usage of this item.
+         */
+        qint64 memoryUsage() const override;
+
+        /**
+         * Undo: delete all entities again.
+         */
+        void undo() override;
+
+        /**
+         * Redo: create all entities again.
+         */
+        void redo() override;
+
+    protected:
+        /**
+         * Load the undo item state from the @p json object.
+         */
+        void loadData(const QJsonObject & json) override;
+
+        /**
+         * Serializie to JSON object.
+         */
+        QJsonObject saveData() const override;
+
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
+    private:
+        /**
+         * The id of the first created entity.
+         */
+        qint64 m_firstId = -1;
+
+        /**
+         * The number of created entities.
+         */
+        int m_count = 0;
+
+        /**
+         * The entity type of the created entities.
+         */
+        EntityType m_entityType = EntityType::Node;
+
+        /**
+         * The initial properties, the names are kept in Latin1 to avoid
+         * a conversion for each entity.
+         */
+        QVector<QPair<QByteArray, QVariant>> m_properties;
+};
+
+}
+}
+
+#endif // TIKZ_UNDO_CREATE_ENTITIES_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -20,6 +20,8 @@
 #include "UndoCreateEntity.h"
 #include "Document.h"
 
+#include <QDataStream>
+
 namespace tikz {
 namespace core {
 
@@ -61,6 +63,25 @@ QJsonObject UndoCreateEntity::saveData() const
     return json;
 }
 
+const char * UndoCreateEntity::typeName() const
+{
+    return "entity-create";
+}
+
+void UndoCreateEntity::loadCompactData(QDataStream & stream)
+{
+    qint32 type;
+    m_uid = readUid(stream);
+    stream >> type;
+    m_entityType = static_cast<EntityType>(type);
+}
+
+void UndoCreateEntity::saveCompactData(QDataStream & stream) const
+{
+    writeUid(stream, m_uid);
+    stream << static_cast<qint32>(m_entityType);
+}
+
 }
 }
 
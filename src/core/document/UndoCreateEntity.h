@@ -46,6 +46,11 @@ class UndoCreateEntity : public UndoItem
          */
         virtual ~UndoCreateEntity();
 
+        /**
+         * Returns "entity-create".
+         */
+        const char * typeName() const override;
+
         /**
          * Undo: delete node again.
          */
@@ -67,6 +72,16 @@ class UndoCreateEntity : public UndoItem
          */
         QJsonObject saveData() const override;
 
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
     private:
         /**
          * The entity's uid.
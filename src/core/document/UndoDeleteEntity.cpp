@@ -20,6 +20,13 @@
 #include "UndoDeleteEntity.h"
 #include "Entity.h"
 #include "Document.h"
+#include "Node.h"
+#include "Path.h"
+
+#include <QCborValue>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonDocument>
 
 namespace tikz {
 namespace core {
@@ -40,6 +47,7 @@ UndoDeleteEntity::UndoDeleteEntity(const Uid & uid, Document * doc)
 
     // save properties
     m_data = entity->save();
+    updateDataSize();
 }
 
 UndoDeleteEntity::~UndoDeleteEntity() = default;
@@ -51,12 +59,37 @@ void UndoDeleteEntity::undo()
     auto entity = m_uid.entity();
     Q_ASSERT(entity);
 
-    ConfigTransaction transaction(entity);
-    entity->load(m_data);
+    {
+        ConfigTransaction transaction(entity);
+        entity->load(m_data);
+    }
+
+    // attach the paths again
+    for (const auto & json : qAsConst(m_attachedPaths)) {
+        const Uid pathUid(json["uid"].toString(), document());
+        if (auto path = pathUid.entity<Path>()) {
+            ConfigTransaction transaction(path);
+            path->load(json);
+        }
+    }
 }
 
 void UndoDeleteEntity::redo()
 {
+    // Document::deleteEntity(Entity*) detaches all paths with own undo
+    // items. Detach paths attached meanwhile as part of this item.
+    m_attachedPaths.clear();
+    if (auto node = m_uid.entity<Node>()) {
+        const auto attached = document()->attachedPaths(m_uid);
+        for (const auto & pathUid : attached) {
+            if (auto path = pathUid.entity<Path>()) {
+                m_attachedPaths.append(path->save());
+                path->detachFromNode(node);
+            }
+        }
+    }
+    updateDataSize();
+
     document()->deleteEntity(m_uid);
 }
 
@@ -65,6 +98,13 @@ void UndoDeleteEntity::loadData(const QJsonObject & json)
     m_uid = Uid(json["uid"].toString(), document());
     m_entityType = toEntityType(json["type"].toString());
     m_data = json["data"].toObject();
+
+    m_attachedPaths.clear();
+    const QJsonArray paths = json["attached-paths"].toArray();
+    for (const auto & path : paths) {
+        m_attachedPaths.append(path.toObject());
+    }
+    updateDataSize();
 }
 
 QJsonObject UndoDeleteEntity::saveData() const
@@ -73,9 +113,66 @@ QJsonObject UndoDeleteEntity::saveData() const
     json["uid"] = m_uid.toString();
     json["type"] = toString(m_entityType);
     json["data"] = m_data;
+    if (!m_attachedPaths.isEmpty()) {
+        QJsonArray paths;
+        for (const auto & path : m_attachedPaths) {
+            paths.append(path);
+        }
+        json["attached-paths"] = paths;
+    }
     return json;
 }
 
+const char * UndoDeleteEntity::typeName() const
+{
+    return "entity-delete";
+}
+
+qint64 UndoDeleteEntity::memoryUsage() const
+{
+    return UndoItem::memoryUsage() + m_dataSize;
+}
+
+void UndoDeleteEntity::updateDataSize()
+{
+    // rough estimate: the JSON snapshot holds at least its textual size.
+    // Computed once whenever the snapshot changes, since the UndoManager
+    // queries the memory usage after each transaction.
+    m_dataSize = QJsonDocument(m_data).toJson(QJsonDocument::Compact).size();
+    for (const auto & path : qAsConst(m_attachedPaths)) {
+        m_dataSize += QJsonDocument(path).toJson(QJsonDocument::Compact).size();
+    }
+}
+
+void UndoDeleteEntity::loadCompactData(QDataStream & stream)
+{
+    qint32 type;
+    QByteArray data;
+    quint32 pathCount = 0;
+    m_uid = readUid(stream);
+    stream >> type >> data >> pathCount;
+    m_entityType = static_cast<EntityType>(type);
+    m_data = QCborValue::fromCbor(data).toJsonValue().toObject();
+
+    m_attachedPaths.clear();
+    for (quint32 i = 0; i < pathCount && stream.status() == QDataStream::Ok; ++i) {
+        stream >> data;
+        m_attachedPaths.append(QCborValue::fromCbor(data).toJsonValue().toObject());
+    }
+    updateDataSize();
+}
+
+void UndoDeleteEntity::saveCompactData(QDataStream & stream) const
+{
+    writeUid(stream, m_uid);
+    stream << static_cast<qint32>(m_entityType)
+           << QCborValue::fromJsonValue(m_data).toCbor()
+           << static_cast<quint32>(m_attachedPaths.size());
+    for (const auto & path : m_attachedPaths) {
+        stream << QCborValue::fromJsonValue(path).toCbor();
+    }
+}
+
 }
 }
 
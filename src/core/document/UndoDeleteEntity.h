@@ -20,16 +20,19 @@
 #ifndef TIKZ_UNDO_DELETE_ENTITY_H
 #define TIKZ_UNDO_DELETE_ENTITY_H
 
+#include "tikz_export.h"
 #include "UndoItem.h"
 #include "Uid.h"
 
+#include <QVector>
+
 namespace tikz {
 namespace core {
 
 class Node;
 class Document;
 
-class UndoDeleteEntity : public UndoItem
+class TIKZKITCORE_EXPORT UndoDeleteEntity : public UndoItem
 {
     public:
         /**
@@ -48,12 +51,23 @@ class UndoDeleteEntity : public UndoItem
         virtual ~UndoDeleteEntity();
 
         /**
-         * Undo: add node again.
+         * Returns "entity-delete".
+         */
+        const char * typeName() const override;
+
+        /**
+         * Returns the estimated memory usage of this item.
+         */
+        qint64 memoryUsage() const override;
+
+        /**
+         * Undo: add the entity again, and attach the paths detached in redo().
          */
         void undo() override;
 
         /**
-         * Redo: delete node again.
+         * Redo: delete the entity again. Paths still attached to a deleted
+         * node are detached, and their state is kept for undo().
          */
         void redo() override;
 
@@ -68,6 +82,22 @@ class UndoDeleteEntity : public UndoItem
          */
         QJsonObject saveData() const override;
 
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
+    private:
+        /**
+         * Updates m_dataSize from m_data and m_attachedPaths.
+         */
+        void updateDataSize();
+
     private:
         /**
          * The entity's uid.
@@ -83,6 +113,17 @@ class UndoDeleteEntity : public UndoItem
          * The entity serialized to json.
          */
         QJsonObject m_data;
+
+        /**
+         * The paths detached from the deleted node in redo(), serialized
+         * to json while they were still attached.
+         */
+        QVector<QJsonObject> m_attachedPaths;
+
+        /**
+         * Estimated size of m_data and m_attachedPaths, see memoryUsage().
+         */
+        qint64 m_dataSize = 0;
 };
 
 }
@@ -22,6 +22,9 @@
 #include "Document.h"
 #include "PropertyManager.h"
 
+#include <QDataStream>
+#include <QDebug>
+
 namespace tikz {
 namespace core {
 
@@ -31,31 +34,33 @@ UndoSetProperty::UndoSetProperty(Document * doc)
 }
 
 UndoSetProperty::UndoSetProperty(const Uid & entityUid, const QString & propertyName, const QVariant & newValue)
+    : UndoSetProperty(entityUid, propertyManager().propertyId(propertyName), newValue)
+{
+}
+
+UndoSetProperty::UndoSetProperty(const Uid & entityUid, int propertyId, const QVariant & newValue)
     : UndoItem("Change Property", entityUid.document())
     , m_entityUid(entityUid)
-    , m_propertyName(propertyName)
+    , m_propertyId(propertyId)
     , m_redoValue(newValue)
 {
     // get path to save data
     auto entity = m_entityUid.entity();
     Q_ASSERT(entity);
 
-    auto info = propertyManager().info(propertyName);
-    if (info.isResettable()) {
-        bool isModified = false;
-        const bool ok = QMetaObject::invokeMethod(entity,
-                                                  info.modifiedFunction().toLatin1().data(),
-                                                  Qt::DirectConnection,
-                                                  Q_RETURN_ARG(bool, isModified)
-        );
+    const auto accessor = propertyManager().accessor(entity->metaObject(), m_propertyId);
+    Q_ASSERT(accessor.isValid());
+
+    if (accessor.isResettable()) {
+        bool ok = false;
+        const bool isModified = accessor.isModified(entity, &ok);
         if (!ok) {
-            qDebug() << "Unable to check modified state of property" + m_propertyName;
-            entity->setProperty(m_propertyName.toLatin1().data(), m_undoValue);
+            qDebug() << "Unable to check modified state of property" << propertyManager().propertyName(m_propertyId);
         }
 
-        m_undoValue = (ok && isModified) ? entity->property(propertyName.toLatin1().data()) : QVariant();
+        m_undoValue = (ok && isModified) ? accessor.read(entity) : QVariant();
     } else {
-        m_undoValue = entity->property(propertyName.toLatin1().data());
+        m_undoValue = accessor.read(entity);
     }
 }
 
@@ -63,51 +68,35 @@ UndoSetProperty::~UndoSetProperty()
 {
 }
 
-void UndoSetProperty::undo()
+// helper: sets @p value, or resets the property, if @p value is invalid
+static void applyValue(Entity * entity, int propertyId, const QVariant & value)
 {
-    auto entity = m_entityUid.entity();
     Q_ASSERT(entity);
 
-    if (m_undoValue.isValid()) {
-        entity->setProperty(m_propertyName.toLatin1().data(), m_undoValue);
-    } else {
-        const auto info = propertyManager().info(m_propertyName);
-        const bool ok = QMetaObject::invokeMethod(entity,
-                                                  info.resetFunction().toLatin1().data(),
-                                                  Qt::DirectConnection
-        );
-        if (!ok) {
-            qDebug() << "Unable to reset property" + m_propertyName;
-            entity->setProperty(m_propertyName.toLatin1().data(), m_undoValue);
-        }
+    const auto accessor = propertyManager().accessor(entity->metaObject(), propertyId);
+    if (value.isValid()) {
+        accessor.write(entity, value);
+    } else if (!accessor.reset(entity)) {
+        qDebug() << "Unable to reset property" << propertyManager().propertyName(propertyId);
+        accessor.write(entity, value);
     }
 }
 
-void UndoSetProperty::redo()
+void UndoSetProperty::undo()
 {
-    auto entity = m_entityUid.entity();
-    Q_ASSERT(entity);
+    applyValue(m_entityUid.entity(), m_propertyId, m_undoValue);
+}
 
-    if (m_redoValue.isValid()) {
-        entity->setProperty(m_propertyName.toLatin1().data(), m_redoValue);
-    } else {
-        const auto info = propertyManager().info(m_propertyName);
-        const bool ok = QMetaObject::invokeMethod(entity,
-                                                  info.resetFunction().toLatin1().data(),
-                                                  Qt::DirectConnection
-        );
-        if (!ok) {
-            qDebug() << "Unable to reset property" + m_propertyName;
-            entity->setProperty(m_propertyName.toLatin1().data(), m_redoValue);
-        }
-    }
+void UndoSetProperty::redo()
+{
+    applyValue(m_entityUid.entity(), m_propertyId, m_redoValue);
 }
 
 bool UndoSetProperty::mergeWith(const UndoItem * command)
 {
     // only merge when command is of correct type
     auto other = static_cast<const UndoSetProperty*>(command);
-    if (m_entityUid != other->m_entityUid || m_propertyName != other->m_propertyName) {
+    if (m_entityUid != other->m_entityUid || m_propertyId != other->m_propertyId) {
         return false;
     }
 
@@ -118,6 +107,7 @@ bool UndoSetProperty::mergeWith(const UndoItem * command)
 void UndoSetProperty::loadData(const QJsonObject & json)
 {
     m_entityUid = Uid(json["uid"].toString(), document());
+    m_propertyId = propertyManager().propertyId(json["property"].toString());
     //m_redoStyle.load(json["style"].toObject());
 }
 
@@ -126,10 +116,54 @@ QJsonObject UndoSetProperty::saveData() const
     QJsonObject json;
     json["type"] = "entity-set-property";
     json["uid"] = m_entityUid.toString();
+    // property ids are not persistent, therefore save the name
+    json["property"] = propertyManager().propertyName(m_propertyId);
 //     json["style"] = m_redoStyle.save();
     return json;
 }
 
+const char * UndoSetProperty::typeName() const
+{
+    return "entity-set-property";
+}
+
+// helper: returns the heap memory held by @p value, roughly
+static qint64 variantMemoryUsage(const QVariant & value)
+{
+    if (value.userType() == QMetaType::QString) {
+        return value.toString().capacity() * static_cast<qint64>(sizeof(QChar));
+    }
+    return 0;
+}
+
+qint64 UndoSetProperty::memoryUsage() const
+{
+    return UndoItem::memoryUsage()
+         + static_cast<qint64>(sizeof(UndoSetProperty) - sizeof(UndoItem))
+         + variantMemoryUsage(m_undoValue)
+         + variantMemoryUsage(m_redoValue);
+}
+
+void UndoSetProperty::loadCompactData(QDataStream & stream)
+{
+    QByteArray propertyName;
+    m_entityUid = readUid(stream);
+    stream >> propertyName;
+    m_propertyId = propertyManager().propertyId(QString::fromLatin1(propertyName));
+    m_undoValue = readVariant(stream);
+    m_redoValue = readVariant(stream);
+}
+
+void UndoSetProperty::saveCompactData(QDataStream & stream) const
+{
+    // the compact form is stored in files and journals, and property ids
+    // depend on the registration order, therefore save the name
+    writeUid(stream, m_entityUid);
+    stream << propertyManager().propertyName(m_propertyId).toLatin1();
+    writeVariant(stream, m_undoValue);
+    writeVariant(stream, m_redoValue);
+}
+
 }
 }
 
@@ -43,11 +43,26 @@ class TIKZKITCORE_EXPORT UndoSetProperty : public UndoItem
          */
         UndoSetProperty(const Uid & entityUid, const QString & propertyName, const QVariant & newValue);
 
+        /**
+         * Constructor taking the property id, see PropertyManager::propertyId().
+         */
+        UndoSetProperty(const Uid & entityUid, int propertyId, const QVariant & newValue);
+
         /**
          * Destructor
          */
         virtual ~UndoSetProperty();
 
+        /**
+         * Returns "entity-set-property".
+         */
+        const char * typeName() const override;
+
+        /**
+         * Returns the estimated memory usage of this item.
+         */
+        qint64 memoryUsage() const override;
+
         /**
          * Return uniq undo item id.
          */
@@ -81,6 +96,16 @@ protected:
          */
         QJsonObject saveData() const override;
 
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
     private:
         /**
          * The unique Entity id.
@@ -88,9 +113,9 @@ protected:
         Uid m_entityUid;
 
         /**
-         * The property name.
+         * The property id, see PropertyManager::propertyId().
          */
-        QString m_propertyName;
+        int m_propertyId = -1;
 
         /**
          * The old value of the property.
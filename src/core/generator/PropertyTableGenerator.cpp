@@ -0,0 +1,127 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2018 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Build tool that converts data/properties.json into a C++ header with a
+ * constexpr table of tikz::core::PropertyData entries, sorted by name.
+ *
+ * Usage: tikzkit-propertytable <properties.json> <PropertyTable.h>
+ */
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QStringList>
+#include <QTextStream>
+
+#include <cstdio>
+
+// helper: returns @p value as C string literal, or nullptr
+static QString cString(const QJsonValue & value)
+{
+    if (value.isUndefined() || value.isNull()) {
+        return QStringLiteral("nullptr");
+    }
+
+    QString str = value.isDouble() ? QString::number(value.toDouble(), 'g', 15)
+                                   : value.toString();
+    str.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    str.replace(QLatin1Char('"'), QLatin1String("\\\""));
+    return QLatin1Char('"') + str + QLatin1Char('"');
+}
+
+int main(int argc, char * argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    if (args.size() != 3) {
+        fprintf(stderr, "Usage: %s <properties.json> <PropertyTable.h>\n", argv[0]);
+        return 1;
+    }
+
+    QFile input(args[1]);
+    if (!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        fprintf(stderr, "Could not read file %s\n", qPrintable(args[1]));
+        return 1;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument json = QJsonDocument::fromJson(input.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        fprintf(stderr, "%s: %s at offset %d\n", qPrintable(args[1]),
+                qPrintable(error.errorString()), error.offset);
+        return 1;
+    }
+
+    // QJsonObject iterates the keys in sorted order, which is the order
+    // PropertyManager relies on for its binary search
+    const QJsonObject properties = json.object()[QStringLiteral("properties")].toObject();
+
+    QString table;
+    QTextStream out(&table);
+    out << "// Generated from properties.json by tikzkit-propertytable, do not edit.\n"
+        << "\n"
+        << "#ifndef TIKZ_CORE_PROPERTY_TABLE_H\n"
+        << "#define TIKZ_CORE_PROPERTY_TABLE_H\n"
+        << "\n"
+        << "#include \"PropertyManager.h\"\n"
+        << "\n"
+        << "namespace tikz {\n"
+        << "namespace core {\n"
+        << "\n"
+        << "static constexpr PropertyData s_propertyTable[] = {\n";
+
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        const QJsonObject property = it.value().toObject();
+        const QJsonValue minimum = property[QStringLiteral("minimum")];
+        out << "    { " << cString(it.key())
+            << ", " << cString(property[QStringLiteral("type")])
+            << ", " << cString(property[QStringLiteral("title")])
+            << ", " << cString(property[QStringLiteral("modified")])
+            << ", " << cString(property[QStringLiteral("reset")])
+            << ", " << cString(minimum)
+            << ", " << cString(property[QStringLiteral("maximum")])
+            << ", " << (minimum.isDouble() ? "true" : "false")
+            << ", " << QString::number(property[QStringLiteral("singleStep")].toDouble(1.0), 'g', 15)
+            << " },\n";
+    }
+
+    out << "};\n"
+        << "\n"
+        << "static constexpr int s_propertyTableSize = " << properties.size() << ";\n"
+        << "\n"
+        << "}\n"
+        << "}\n"
+        << "\n"
+        << "#endif // TIKZ_CORE_PROPERTY_TABLE_H\n";
+    out.flush();
+
+    QFile output(args[2]);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "Could not write file %s\n", qPrintable(args[2]));
+        return 1;
+    }
+    output.write(table.toUtf8());
+    return 0;
+}
+
+// kate: indent-width 4; replace-tabs on;
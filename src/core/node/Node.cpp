@@ -25,6 +25,7 @@
 
 #include "UndoSetNodePos.h"
 
+#include <atomic>
 #include <cmath>
 
 #include <QUndoStack>
@@ -33,6 +34,13 @@
 namespace tikz {
 namespace core {
 
+// helper: returns a new revision, unique for all nodes
+static quint64 nextRevision()
+{
+    static std::atomic<quint64> s_revision(0);
+    return ++s_revision;
+}
+
 class NodePrivate
 {
     public:
@@ -49,6 +57,12 @@ class NodePrivate
         // this node's style
         Uid styleUid;
         Style * style = nullptr;
+
+        // revision, see Node::revision()
+        quint64 revision = nextRevision();
+
+        // size of the typeset text, see Node::setTextSize()
+        QSizeF textSize;
 };
 
 Node::Node(const Uid & uid)
@@ -87,7 +101,10 @@ void Node::loadData(const QJsonObject & json)
     }
 
     if (json.contains("pos")) {
-        d->pos = MetaPos(json["pos"].toString(), document());
+        d->pos = MetaPos(document());
+        d->pos.fromJson(json["pos"]);
+        bumpRevision();
+        propertyChanged("pos");
     }
 
     if (json.contains("style")) {
@@ -101,7 +118,7 @@ QJsonObject Node::saveData() const
     QJsonObject json = Entity::saveData();
 
     json["text"] = d->text;
-    json["pos"] = d->pos.toString();
+    json["pos"] = d->pos.toJson();
     json["style"] = style()->uid().toString();
 
     return json;
@@ -130,6 +147,21 @@ void Node::setMetaPos(const tikz::core::MetaPos & pos)
     if (document()->undoActive()) {
         ConfigTransaction transaction(this);
         d->pos = pos;
+        bumpRevision();
+        propertyChanged("pos");
+    } else if (document()->gestureRunning()) {
+        // one undo item per gesture keeps the start position
+        auto item = static_cast<UndoSetNodePos *>(document()->gestureItem(uid(), "node-set-pos"));
+        if (item) {
+            item->setRedoPos(pos);
+        } else {
+            document()->addGestureItem(uid(), new UndoSetNodePos(this, pos, document()));
+        }
+
+        ConfigTransaction transaction(this);
+        d->pos = pos;
+        bumpRevision();
+        propertyChanged("pos");
     } else {
         document()->addUndoItem(new UndoSetNodePos(this, pos, document()));
     }
@@ -149,6 +181,8 @@ void Node::setText(const QString& text)
 
     ConfigTransaction transaction(this);
     d->text = text;
+    bumpRevision();
+    propertyChanged("text");
     Q_EMIT textChanged(d->text);
 }
 
@@ -173,7 +207,7 @@ void Node::setStyle(const Uid & styleUid)
         delete d->style;
         d->style = nullptr;
     } else {
-        disconnect(d->styleUid.entity<Style>(), SIGNAL(changed()), this, SLOT(emitChangedIfNeeded()));
+        disconnect(d->styleUid.entity<Style>(), SIGNAL(changed()), this, SLOT(styleChanged()));
     }
 
     if (styleUid.isValid()) {
@@ -183,7 +217,43 @@ void Node::setStyle(const Uid & styleUid)
         d->style->setParentStyle(document()->style()->uid());
     }
 
-    connect(style(), SIGNAL(changed()), this, SLOT(emitChangedIfNeeded()));
+    connect(style(), SIGNAL(changed()), this, SLOT(styleChanged()));
+    bumpRevision();
+    propertyChanged("style");
+}
+
+quint64 Node::revision() const
+{
+    return d->revision;
+}
+
+QSizeF Node::textSize() const
+{
+    return d->textSize;
+}
+
+void Node::invalidate()
+{
+    bumpRevision();
+    emitChangedIfNeeded();
+}
+
+void Node::setTextSize(const QSizeF & size)
+{
+    d->textSize = size;
+    invalidate();
+}
+
+void Node::styleChanged()
+{
+    // e.g. the shape or the size of the node may have changed
+    bumpRevision();
+    emitChangedIfNeeded();
+}
+
+void Node::bumpRevision()
+{
+    d->revision = nextRevision();
 }
 
 }
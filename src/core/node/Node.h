@@ -24,6 +24,7 @@
 #include "tikz.h"
 #include "Pos.h"
 
+#include <QSizeF>
 #include <QString>
 #include <QVariant>
 
@@ -133,6 +134,39 @@ class TIKZKITCORE_EXPORT Node : public Entity
          */
         void setStyle(const Uid & styleUid);
 
+        /**
+         * Returns the revision of this node. The revision changes whenever
+         * the position, the text or the style of this node changed, i.e.,
+         * whenever the scene position of an anchor may have changed.
+         * Revisions are never reused, not even by other nodes. Therefore,
+         * the revision can be used as cache key, see MetaPos::pos().
+         */
+        quint64 revision() const;
+
+        /**
+         * Marks the geometry of this node as changed, although none of its
+         * properties changed, e.g. if the user interface typeset the text.
+         * Increases the revision() and emits changed(), so that cached
+         * anchor positions and attached paths are updated.
+         */
+        void invalidate();
+
+        /**
+         * Returns the size of the typeset text in pt, see setTextSize().
+         * Initially, the size is empty.
+         */
+        QSizeF textSize() const;
+
+        /**
+         * Sets the size of the typeset text to @p size in pt. The text is
+         * typeset by the user interface, therefore the core does not know
+         * its size otherwise. The size is used for the bounds of this node,
+         * see Document::entitiesIn(). It is not saved and not undoable.
+         * Setting the size always calls invalidate(), since a new text of
+         * the same size still changes the node.
+         */
+        void setTextSize(const QSizeF & size);
+
     Q_SIGNALS:
         /**
          * This signal is emitted whenever this node's text changed.
@@ -153,7 +187,18 @@ class TIKZKITCORE_EXPORT Node : public Entity
          */
         Node(const Uid & nodeUid);
 
+    private Q_SLOTS:
+        /**
+         * Called whenever the style of this node changed.
+         */
+        void styleChanged();
+
     private:
+        /**
+         * Increases the revision(), call this whenever this node changes.
+         */
+        void bumpRevision();
+
         /**
          * private default constructor, not implemented
          */
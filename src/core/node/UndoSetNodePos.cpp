@@ -21,6 +21,8 @@
 #include "Document.h"
 #include "Node.h"
 
+#include <QDataStream>
+
 namespace tikz {
 namespace core {
 
@@ -72,6 +74,11 @@ bool UndoSetNodePos::mergeWith(const UndoItem * command)
     return true;
 }
 
+void UndoSetNodePos::setRedoPos(const MetaPos & pos)
+{
+    m_redoPos = pos;
+}
+
 void UndoSetNodePos::loadData(const QJsonObject & json)
 {
     m_nodeUid = Uid(json["uid"].toString(), document());
@@ -87,6 +94,23 @@ QJsonObject UndoSetNodePos::saveData() const
     return json;
 }
 
+const char * UndoSetNodePos::typeName() const
+{
+    return "node-set-pos";
+}
+
+void UndoSetNodePos::loadCompactData(QDataStream & stream)
+{
+    m_nodeUid = readUid(stream);
+    stream >> m_undoPos >> m_redoPos;
+}
+
+void UndoSetNodePos::saveCompactData(QDataStream & stream) const
+{
+    writeUid(stream, m_nodeUid);
+    stream << m_undoPos << m_redoPos;
+}
+
 }
 }
 
@@ -50,6 +50,11 @@ class UndoSetNodePos : public UndoItem
          */
         virtual ~UndoSetNodePos();
 
+        /**
+         * Returns "node-set-pos".
+         */
+        const char * typeName() const override;
+
         /**
          * Return uniq undo item id.
          */
@@ -72,6 +77,11 @@ class UndoSetNodePos : public UndoItem
          */
         bool mergeWith(const UndoItem * command) override;
 
+        /**
+         * Sets the redo position to @p pos, e.g. while a gesture runs.
+         */
+        void setRedoPos(const tikz::core::MetaPos & pos);
+
     protected:
         /**
          * Load the undo item state from the @p json object.
@@ -83,6 +93,16 @@ class UndoSetNodePos : public UndoItem
          */
         QJsonObject saveData() const override;
 
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
     private:
         /**
          * The unique Node id.
@@ -21,6 +21,7 @@
 #include "Style.h"
 #include "Visitor.h"
 #include "Document.h"
+#include "Node.h"
 
 namespace tikz {
 namespace core {
@@ -69,6 +70,11 @@ void Path::detachFromNode(Node * node)
     Q_UNUSED(node)
 }
 
+void Path::nodeAttachmentChanged(Node * oldNode, Node * newNode)
+{
+    document()->updateNodeAttachment(uid(), oldNode, newNode);
+}
+
 bool Path::accept(Visitor & visitor)
 {
     visitor.visit(this);
@@ -121,6 +127,7 @@ void Path::setStyle(const Uid & styleUid)
     }
 
     connect(style(), SIGNAL(changed()), this, SLOT(emitChangedIfNeeded()));
+    propertyChanged("style");
 }
 
 // Edge * Path::createEdge(int index)
@@ -132,8 +132,8 @@ class TIKZKITCORE_EXPORT Path : public Entity
         virtual void deconstruct();
 
         /**
-         * This function is called for all paths to notify that @p node is
-         * about to be deleted. If a path is attached to this node,
+         * This function is called for all paths attached to @p node to
+         * notify that @p node is about to be deleted. If a path is attached to this node,
          * detach it here such that the path is still consistent.
          *
          * The default implementation is empty.
@@ -142,6 +142,14 @@ class TIKZKITCORE_EXPORT Path : public Entity
          */
         virtual void detachFromNode(Node * node);
 
+    protected:
+        /**
+         * Call this whenever a MetaPos of this path is attached to a
+         * different node, i.e., from @p oldNode to @p newNode. Either
+         * may be a null pointer. Keeps Document::attachedPaths() up-to-date.
+         */
+        void nodeAttachmentChanged(Node * oldNode, Node * newNode);
+
     //
     // internal
     //
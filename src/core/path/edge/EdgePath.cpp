@@ -49,8 +49,9 @@ EdgePath::EdgePath(PathType type, const Uid & uid)
 {
     d->type = type;
 
-    connect(d->start.notificationObject(), SIGNAL(changed(tikz::core::MetaPos*)), this, SLOT(emitChangedIfNeeded()));
-    connect(d->end.notificationObject(), SIGNAL(changed(tikz::core::MetaPos*)), this, SLOT(emitChangedIfNeeded()));
+    // changes of the start and end MetaPos are notified in setStartMetaPos()
+    // and setEndMetaPos(). Changes of attached nodes are forwarded by the
+    // Document, see Document::attachedPaths().
 }
 
 EdgePath::~EdgePath()
@@ -171,8 +172,10 @@ void EdgePath::setStartMetaPos(const tikz::core::MetaPos & pos)
         ConfigTransaction transaction(this);
         auto oldNode = startNode();
         d->start = pos;
+        propertyChanged("start");
         auto newNode = startNode();
         if (oldNode != newNode) {
+            nodeAttachmentChanged(oldNode, newNode);
             Q_EMIT startNodeChanged(newNode);
         }
     } else {
@@ -191,8 +194,10 @@ void EdgePath::setEndMetaPos(const tikz::core::MetaPos & pos)
         ConfigTransaction transaction(this);
         auto oldNode = endNode();
         d->end = pos;
+        propertyChanged("end");
         auto newNode = endNode();
         if (oldNode != newNode) {
+            nodeAttachmentChanged(oldNode, newNode);
             Q_EMIT endNodeChanged(newNode);
         }
     } else {
@@ -235,11 +240,15 @@ void EdgePath::loadData(const QJsonObject & json)
     Path::loadData(json);
 
     if (json.contains("start")) {
-        setStartMetaPos(MetaPos(json["start"].toString(), document()));
+        MetaPos start(document());
+        start.fromJson(json["start"]);
+        setStartMetaPos(start);
     }
 
     if (json.contains("end")) {
-        setEndMetaPos(MetaPos(json["end"].toString(), document()));
+        MetaPos end(document());
+        end.fromJson(json["end"]);
+        setEndMetaPos(end);
     }
 
     if (json.contains("style")) {
@@ -252,8 +261,8 @@ QJsonObject EdgePath::saveData() const
 {
     QJsonObject json = Path::saveData();
 
-    json["start"] = d->start.toString();
-    json["end"] = d->end.toString();
+    json["start"] = d->start.toJson();
+    json["end"] = d->end.toJson();
     json["style"] = styleUid().toString();
 
     return json;
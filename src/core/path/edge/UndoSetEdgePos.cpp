@@ -21,6 +21,8 @@
 #include "Document.h"
 #include "EdgePath.h"
 
+#include <QDataStream>
+
 namespace tikz {
 namespace core {
 
@@ -100,6 +102,23 @@ QJsonObject UndoSetEdgePos::saveData() const
     return json;
 }
 
+const char * UndoSetEdgePos::typeName() const
+{
+    return "edge-set-pos";
+}
+
+void UndoSetEdgePos::loadCompactData(QDataStream & stream)
+{
+    m_pathUid = readUid(stream);
+    stream >> m_undoPos >> m_redoPos >> m_isStart;
+}
+
+void UndoSetEdgePos::saveCompactData(QDataStream & stream) const
+{
+    writeUid(stream, m_pathUid);
+    stream << m_undoPos << m_redoPos << m_isStart;
+}
+
 }
 }
 
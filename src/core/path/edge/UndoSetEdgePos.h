@@ -51,6 +51,11 @@ class UndoSetEdgePos : public UndoItem
          */
         virtual ~UndoSetEdgePos();
 
+        /**
+         * Returns "edge-set-pos".
+         */
+        const char * typeName() const override;
+
         /**
          * Return uniq undo item id.
          */
@@ -84,6 +89,16 @@ class UndoSetEdgePos : public UndoItem
          */
         QJsonObject saveData() const override;
 
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
     private:
         /**
          * The unique Edge id.
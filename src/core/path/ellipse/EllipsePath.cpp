@@ -41,8 +41,8 @@ EllipsePath::EllipsePath(const Uid & uid)
     : Path(uid)
     , d(new EllipsePathPrivate(uid.document()))
 {
-    connect(d->pos.notificationObject(), SIGNAL(changed(tikz::core::MetaPos*)),
-            this, SLOT(emitChangedIfNeeded()));
+    // changes of the MetaPos are notified in setMetaPos(). Changes of the
+    // attached node are forwarded by the Document, see Document::attachedPaths().
 }
 
 EllipsePath::~EllipsePath()
@@ -120,8 +120,10 @@ void EllipsePath::setMetaPos(const tikz::core::MetaPos & pos)
         ConfigTransaction transaction(this);
         auto oldNode = node();
         d->pos = pos;
+        propertyChanged("pos");
         auto newNode = node();
         if (oldNode != newNode) {
+            nodeAttachmentChanged(oldNode, newNode);
             Q_EMIT nodeChanged(newNode);
         }
     } else {
@@ -21,6 +21,8 @@
 #include "Document.h"
 #include "EllipsePath.h"
 
+#include <QDataStream>
+
 namespace tikz {
 namespace core {
 
@@ -87,6 +89,23 @@ QJsonObject UndoSetEllipsePos::saveData() const
     return json;
 }
 
+const char * UndoSetEllipsePos::typeName() const
+{
+    return "ellipse-set-pos";
+}
+
+void UndoSetEllipsePos::loadCompactData(QDataStream & stream)
+{
+    m_pathUid = readUid(stream);
+    stream >> m_undoPos >> m_redoPos;
+}
+
+void UndoSetEllipsePos::saveCompactData(QDataStream & stream) const
+{
+    writeUid(stream, m_pathUid);
+    stream << m_undoPos << m_redoPos;
+}
+
 }
 }
 // kate: indent-width 4; replace-tabs on;
@@ -50,6 +50,11 @@ class UndoSetEllipsePos : public UndoItem
          */
         virtual ~UndoSetEllipsePos();
 
+        /**
+         * Returns "ellipse-set-pos".
+         */
+        const char * typeName() const override;
+
         /**
          * Return uniq undo item id.
          */
@@ -83,6 +88,16 @@ class UndoSetEllipsePos : public UndoItem
          */
         QJsonObject saveData() const override;
 
+        /**
+         * Load the undo and redo state from @p stream.
+         */
+        void loadCompactData(QDataStream & stream) override;
+
+        /**
+         * Write the undo and redo state to @p stream.
+         */
+        void saveCompactData(QDataStream & stream) const override;
+
     private:
         /**
          * The unique Edge id.
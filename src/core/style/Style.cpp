@@ -22,59 +22,122 @@
 #include "Document.h"
 #include "Visitor.h"
 
-#include <QSet>
+#include <QMultiHash>
+#include <QSharedData>
+
+#include <bitset>
 
 namespace tikz {
 namespace core {
 
 // NOTE: these strings have to match the Q_PROPERTY strings, otherise
-//       serialization will not work correctly.
-static constexpr char s_penStyle[] = "penStyle";
-static constexpr char s_lineWidth[] = "lineWidth";
-static constexpr char s_doubleLine[] = "doubleLine";
-static constexpr char s_innerLineWidth[] = "innerLineWidth";
-static constexpr char s_penOpacity[] = "penOpacity";
-static constexpr char s_fillOpacity[] = "fillOpacity";
-static constexpr char s_penColor[] = "penColor";
-static constexpr char s_innerLineColor[] = "innerLineColor";
-static constexpr char s_fillColor[] = "fillColor";
-static constexpr char s_rotation[] = "rotation";
-
-// Path properties
-static constexpr char s_radiusX[] = "radiusX";
-static constexpr char s_radiusY[] = "radiusY";
-static constexpr char s_bendAngle[] = "bendAngle";
-static constexpr char s_looseness[] = "looseness";
-static constexpr char s_outAngle[] = "outAngle";
-static constexpr char s_inAngle[] = "inAngle";
-static constexpr char s_arrowTail[] = "arrowTail";
-static constexpr char s_arrowHead[] = "arrowHead";
-static constexpr char s_shortenStart[] = "shortenStart";
-static constexpr char s_shortenEnd[] = "shortenEnd";
-
-// Node properties
-static constexpr char s_align[] = "textAlign";
-static constexpr char s_shape[] = "shape";
-static constexpr char s_innerSep[] = "innerSep";
-static constexpr char s_outerSep[] = "outerSep";
-static constexpr char s_minimumHeight[] = "minimumHeight";
-static constexpr char s_minimumWidth[] = "minimumWidth";
+//       serialization will not work correctly. The order has to match
+//       the order of Style::Property.
+static constexpr const char * s_propertyNames[] = {
+    "penStyle",
+    "lineWidth",
+    "doubleLine",
+    "innerLineWidth",
+    "penOpacity",
+    "fillOpacity",
+    "penColor",
+    "innerLineColor",
+    "fillColor",
+    "rotation",
+
+    // Path properties
+    "radiusX",
+    "radiusY",
+    "bendAngle",
+    "looseness",
+    "outAngle",
+    "inAngle",
+    "arrowTail",
+    "arrowHead",
+    "shortenStart",
+    "shortenEnd",
+
+    // Node properties
+    "textAlign",
+    "shape",
+    "innerSep",
+    "outerSep",
+    "minimumHeight",
+    "minimumWidth",
+};
+
+static_assert(sizeof(s_propertyNames) / sizeof(s_propertyNames[0])
+              == static_cast<std::size_t>(Style::Property::Count),
+              "s_propertyNames must contain a name for each Style::Property");
 
 /**
- * Private data and helper functions of class Style.
+ * Effective values of all style properties, i.e. the values with all
+ * parent styles resolved. The member defaults are the values used if
+ * neither the style nor any of its parents sets a property.
  */
-class StylePrivate
+struct ResolvedStyle
+{
+    PenStyle penStyle = tikz::PenStyle::SolidLine;
+    tikz::Value lineWidth = tikz::Value::semiThick();
+    bool doubleLine = false;
+    tikz::Value innerLineWidth = tikz::Value::semiThick();
+    tikz::Value penWidth = tikz::Value::semiThick();
+
+    QColor penColor = Qt::black;
+    QColor innerLineColor = Qt::white;
+    QColor fillColor = Qt::transparent;
+    qreal penOpacity = 1.0;
+    qreal fillOpacity = 1.0;
+    qreal rotation = 0.0;
+
+    tikz::Value radiusX = 0.0_cm;
+    tikz::Value radiusY = 0.0_cm;
+    qreal bendAngle = 0.0;
+    qreal looseness = 1.0;
+    qreal outAngle = 45.0;
+    qreal inAngle = 135.0;
+    Arrow arrowTail = tikz::Arrow::NoArrow;
+    Arrow arrowHead = tikz::Arrow::NoArrow;
+    tikz::Value shortenStart = 0.0_cm;
+    tikz::Value shortenEnd = 0.0_cm;
+
+    TextAlignment textAlign = tikz::TextAlignment::NoAlign;
+    Shape shape = tikz::Shape::ShapeRectangle;
+    tikz::Value innerSep = 3.0_pt;
+    tikz::Value outerSep = 0.5_pt;
+    tikz::Value minimumHeight = 0.0_cm;
+    tikz::Value minimumWidth = 0.0_cm;
+};
+
+/**
+ * The property values of a Style.
+ *
+ * StyleData is shared between all styles that set the same properties to
+ * the same values: after each change, a Style looks up an identical
+ * StyleData in a global pool (interning) and shares it instead of keeping
+ * its own copy. Interned StyleData is immutable, a Style that changes a
+ * property first detaches, see StylePrivate::edit().
+ */
+class StyleData : public QSharedData
 {
 public:
-    // parent / child hierarchy
-    Uid parentStyle;
-    QVector<Uid> children;
+    // true, if this StyleData is registered in the pool, see StylePrivate::intern()
+    bool interned = false;
+
+    ~StyleData();
 
-    // config reference counter
-    int refCounter = 0;
+    bool operator==(const StyleData & other) const;
 
-    // list of set properties
-    QSet<QString> properties;
+    // set properties, indexed by Style::Property
+    std::bitset<static_cast<std::size_t>(Style::Property::Count)> properties;
+
+    /**
+     * Returns @e true, if @p property is set in this style.
+     */
+    inline bool isSet(Style::Property property) const
+    {
+        return properties.test(static_cast<std::size_t>(property));
+    }
 
     // line style
     PenStyle penStyle = tikz::PenStyle::SolidLine;
@@ -127,25 +190,294 @@ public:
     tikz::Value minimumWidth = 0.0_cm;
 };
 
+namespace {
+    // values are compared exactly: styles sharing the StyleData also share
+    // the units, which are saved and exported
+    inline bool sameValue(const tikz::Value & a, const tikz::Value & b)
+    {
+        return a.value() == b.value() && a.unit() == b.unit();
+    }
+
+    template<typename T>
+    inline bool sameValue(const T & a, const T & b)
+    {
+        return a == b;
+    }
+
+    inline uint hashValue(const tikz::Value & value)
+    {
+        return ::qHash(value.value()) ^ static_cast<uint>(value.unit());
+    }
+
+    inline void hashCombine(uint & h, uint value)
+    {
+        h ^= value + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+}
+
+uint qHash(const StyleData & data)
+{
+    // hash only a few set values, the rest is compared in operator==()
+    uint h = ::qHash(static_cast<quint64>(data.properties.to_ullong()));
+    if (data.isSet(Style::Property::PenColor)) {
+        hashCombine(h, static_cast<uint>(data.penColor.rgba()));
+    }
+    if (data.isSet(Style::Property::FillColor)) {
+        hashCombine(h, static_cast<uint>(data.fillColor.rgba()));
+    }
+    if (data.isSet(Style::Property::LineWidth)) {
+        hashCombine(h, hashValue(data.lineWidth));
+    }
+    if (data.isSet(Style::Property::InnerSep)) {
+        hashCombine(h, hashValue(data.innerSep));
+    }
+    return h;
+}
+
+// pool of all interned StyleData
+typedef QMultiHash<uint, StyleData *> StyleDataPool;
+Q_GLOBAL_STATIC(StyleDataPool, s_stylePool)
+
+StyleData::~StyleData()
+{
+    if (interned && !s_stylePool.isDestroyed()) {
+        s_stylePool->remove(qHash(*this), this);
+    }
+}
+
+bool StyleData::operator==(const StyleData & other) const
+{
+    if (properties != other.properties) {
+        return false;
+    }
+
+    // members of unset properties are not part of the style
+    auto same = [this](Style::Property property, const auto & a, const auto & b) {
+        return !isSet(property) || sameValue(a, b);
+    };
+
+    using P = Style::Property;
+    return same(P::PenStyle, penStyle, other.penStyle)
+        && same(P::LineWidth, lineWidth, other.lineWidth)
+        && same(P::DoubleLine, doubleLine, other.doubleLine)
+        && same(P::InnerLineWidth, innerLineWidth, other.innerLineWidth)
+        && same(P::PenColor, penColor, other.penColor)
+        && same(P::InnerLineColor, innerLineColor, other.innerLineColor)
+        && same(P::FillColor, fillColor, other.fillColor)
+        && same(P::PenOpacity, penOpacity, other.penOpacity)
+        && same(P::FillOpacity, fillOpacity, other.fillOpacity)
+        && same(P::Rotation, rotation, other.rotation)
+        && same(P::RadiusX, radiusX, other.radiusX)
+        && same(P::RadiusY, radiusY, other.radiusY)
+        && same(P::BendAngle, bendAngle, other.bendAngle)
+        && same(P::Looseness, looseness, other.looseness)
+        && same(P::OutAngle, outAngle, other.outAngle)
+        && same(P::InAngle, inAngle, other.inAngle)
+        && same(P::ArrowTail, arrowTail, other.arrowTail)
+        && same(P::ArrowHead, arrowHead, other.arrowHead)
+        && same(P::ShortenStart, shortenStart, other.shortenStart)
+        && same(P::ShortenEnd, shortenEnd, other.shortenEnd)
+        && same(P::TextAlign, textAlign, other.textAlign)
+        && same(P::Shape, shape, other.shape)
+        && same(P::InnerSep, innerSep, other.innerSep)
+        && same(P::OuterSep, outerSep, other.outerSep)
+        && same(P::MinimumHeight, minimumHeight, other.minimumHeight)
+        && same(P::MinimumWidth, minimumWidth, other.minimumWidth);
+}
+
+/**
+ * Private data and helper functions of class Style.
+ */
+class StylePrivate
+{
+public:
+    // parent / child hierarchy
+    Uid parentStyle;
+    QVector<Uid> children;
+
+    // cache of the effective property values, see resolvedStyle()
+    ResolvedStyle resolved;
+    bool resolvedValid = false;
+
+    /**
+     * Returns the effective values of all properties. The values are
+     * computed only if this style or one of its parents changed since
+     * the last call.
+     */
+    const ResolvedStyle & resolvedStyle();
+
+    /**
+     * Invalidates the resolved values of this style and all child styles.
+     * Must be called whenever a property or the parent style changes.
+     */
+    void invalidateResolved();
+
+    // property values, possibly shared with other styles
+    QExplicitlySharedDataPointer<StyleData> data;
+
+    /**
+     * Returns the property values for writing. If the values are shared
+     * or interned, this style detaches first.
+     */
+    StyleData & edit();
+
+    /**
+     * Shares the property values with an identical interned StyleData.
+     * If none exists, the own StyleData is interned.
+     */
+    void intern();
+};
+
+StyleData & StylePrivate::edit()
+{
+    if (data->ref.load() != 1) {
+        // shared: diverge by creating an own copy
+        data = new StyleData(*data);
+        data->interned = false;
+    } else if (data->interned) {
+        // only user: unregister, since the hash changes
+        s_stylePool->remove(qHash(*data), data.data());
+        data->interned = false;
+    }
+    return *data;
+}
+
+void StylePrivate::intern()
+{
+    if (data->interned) {
+        return;
+    }
+
+    const uint hash = qHash(*data);
+    auto it = s_stylePool->constFind(hash);
+    while (it != s_stylePool->constEnd() && it.key() == hash) {
+        if (*it.value() == *data) {
+            data = it.value();
+            return;
+        }
+        ++it;
+    }
+
+    data->interned = true;
+    s_stylePool->insert(hash, data.data());
+}
+
+const ResolvedStyle & StylePrivate::resolvedStyle()
+{
+    if (resolvedValid) {
+        return resolved;
+    }
+
+    // start with the effective values of the parent style, or the defaults
+    auto parent = parentStyle.entity<Style>();
+    const ResolvedStyle * p = parent ? &parent->d->resolvedStyle() : nullptr;
+    ResolvedStyle & r = resolved;
+    r = p ? *p : ResolvedStyle();
+
+    // now override all properties set in this style
+    if (data->isSet(Style::Property::PenStyle)) r.penStyle = data->penStyle;
+    if (data->isSet(Style::Property::LineWidth)) r.lineWidth = data->lineWidth;
+    if (data->isSet(Style::Property::DoubleLine)) r.doubleLine = data->doubleLine;
+    if (data->isSet(Style::Property::PenColor)) r.penColor = data->penColor;
+    if (data->isSet(Style::Property::InnerLineColor)) r.innerLineColor = data->innerLineColor;
+    if (data->isSet(Style::Property::FillColor)) r.fillColor = data->fillColor;
+    if (data->isSet(Style::Property::PenOpacity)) r.penOpacity = data->penOpacity;
+    if (data->isSet(Style::Property::FillOpacity)) r.fillOpacity = data->fillOpacity;
+    if (data->isSet(Style::Property::Rotation)) r.rotation = data->rotation;
+    if (data->isSet(Style::Property::RadiusX)) r.radiusX = data->radiusX;
+    if (data->isSet(Style::Property::RadiusY)) r.radiusY = data->radiusY;
+    if (data->isSet(Style::Property::BendAngle)) r.bendAngle = data->bendAngle;
+    if (data->isSet(Style::Property::Looseness)) r.looseness = data->looseness;
+    if (data->isSet(Style::Property::OutAngle)) r.outAngle = data->outAngle;
+    if (data->isSet(Style::Property::InAngle)) r.inAngle = data->inAngle;
+    if (data->isSet(Style::Property::ArrowTail)) r.arrowTail = data->arrowTail;
+    if (data->isSet(Style::Property::ArrowHead)) r.arrowHead = data->arrowHead;
+    if (data->isSet(Style::Property::ShortenStart)) r.shortenStart = data->shortenStart;
+    if (data->isSet(Style::Property::ShortenEnd)) r.shortenEnd = data->shortenEnd;
+    if (data->isSet(Style::Property::TextAlign)) r.textAlign = data->textAlign;
+    if (data->isSet(Style::Property::Shape)) r.shape = data->shape;
+    if (data->isSet(Style::Property::MinimumHeight)) r.minimumHeight = data->minimumHeight;
+    if (data->isSet(Style::Property::MinimumWidth)) r.minimumWidth = data->minimumWidth;
+
+    // the inner line width is inherited only from double lined parents
+    if (data->isSet(Style::Property::InnerLineWidth)) {
+        r.innerLineWidth = data->innerLineWidth;
+    } else if (!p || !p->doubleLine) {
+        r.innerLineWidth = tikz::Value::semiThick();
+    }
+
+    // without parent, the inner sep is the (possibly unset) own value
+    if (data->isSet(Style::Property::InnerSep) || !p) {
+        r.innerSep = data->innerSep;
+    }
+
+    // the pen width and outer sep are computed from the resolved values
+    r.penWidth = r.doubleLine ? 2.0 * r.lineWidth + r.innerLineWidth
+                              : r.lineWidth;
+    r.outerSep = data->isSet(Style::Property::OuterSep) ? data->outerSep
+                                                        : 0.5 * r.penWidth;
+
+    resolvedValid = true;
+    return resolved;
+}
+
+void StylePrivate::invalidateResolved()
+{
+    resolvedValid = false;
+
+    // an invalid child implies that all its children are invalid as well
+    for (const Uid & childUid : qAsConst(children)) {
+        auto child = childUid.entity<Style>();
+        if (child && child->d->resolvedValid) {
+            child->d->invalidateResolved();
+        }
+    }
+}
+
 Style::Style()
     : Entity()
     , d(new StylePrivate())
 {
+    d->data = new StyleData();
+    d->intern();
+
+    // share the property values again after each change, and let the
+    // document notify all styles inheriting from this style
+    connect(this, &ConfigObject::changed, this, [this]() {
+        d->intern();
+        if (document()) {
+            document()->scheduleStyleChange(uid());
+        }
+    });
 }
 
 Style::Style(const Uid & uid)
     : Entity(uid)
     , d(new StylePrivate())
 {
+    d->data = new StyleData();
+    d->intern();
+
+    // share the property values again after each change, and let the
+    // document notify all styles inheriting from this style
+    connect(this, &ConfigObject::changed, this, [this]() {
+        d->intern();
+        if (document()) {
+            document()->scheduleStyleChange(uid());
+        }
+    });
 }
 
 Style::~Style()
 {
     // unregister all child styles
-    for (const Uid & styleUid : qAsConst(d->children)) {
-        styleUid.entity<Style>()->setParentStyle(d->parentStyle);
+    const auto children = d->children;
+    for (const Uid & styleUid : children) {
+        if (auto child = styleUid.entity<Style>()) {
+            child->setParentStyle(d->parentStyle);
+        }
     }
-    Q_ASSERT(d->children.size() == 0);
+    d->children.clear();
 
     // avoid unnecessary propagation of the changed() signal
     disconnect(this, SIGNAL(changed()), nullptr, nullptr);
@@ -174,14 +506,22 @@ void Style::setStyle(const Style * other)
     // start configuration
     ConfigTransaction transaction(this);
 
-    // backup properties not to copy
-    Uid parent = d->parentStyle;
+    // share the property values, the parent style is kept
+    d->data = other->d->data;
+    d->invalidateResolved();
+}
 
-    // perform copy of properties
-    *d = *other->d;
+bool Style::hasSameProperties(const Style * other) const
+{
+    Q_ASSERT(other);
+    return propertiesKey() == other->propertiesKey();
+}
 
-    // restore persistent properties
-    d->parentStyle = parent;
+quintptr Style::propertiesKey() const
+{
+    // within a config transaction, the values may not be interned yet
+    d->intern();
+    return reinterpret_cast<quintptr>(d->data.data());
 }
 
 void Style::loadData(const QJsonObject & json)
@@ -189,7 +529,15 @@ void Style::loadData(const QJsonObject & json)
     ConfigTransaction transaction(this);
 
     if (json.contains("parentStyle")) {
-        d->parentStyle = Uid(json["parentStyle"].toString(), document());
+        const Uid parentUid(json["parentStyle"].toString(), document());
+        if (parentUid.entity<Style>()) {
+            // register as child, so that parent changes are propagated
+            setParentStyle(parentUid);
+        } else {
+            // the parent is not loaded yet, see linkParentStyle()
+            d->parentStyle = parentUid;
+            d->invalidateResolved();
+        }
     }
 
     if (json.contains("penColor")) {
@@ -213,7 +561,7 @@ void Style::loadData(const QJsonObject & json)
     }
 
     if (json.contains("lineWidth")) {
-        setLineWidth(Value::fromString(json["lineWidth"].toString()));
+        setLineWidth(tikz::Value::fromJson(json["lineWidth"]));
     }
     // FIXME line type, inner line type?
 
@@ -222,7 +570,7 @@ void Style::loadData(const QJsonObject & json)
     }
 
     if (json.contains("innerLineWidth")) {
-        setInnerLineWidth(Value::fromString(json["innerLineWidth"].toString()));
+        setInnerLineWidth(tikz::Value::fromJson(json["innerLineWidth"]));
     }
 
     if (json.contains("innerLineColor")) {
@@ -234,11 +582,11 @@ void Style::loadData(const QJsonObject & json)
     }
 
     if (json.contains("radiusX")) {
-        setRadiusX(tikz::Value::fromString(json["radiusX"].toString()));
+        setRadiusX(tikz::Value::fromJson(json["radiusX"]));
     }
 
     if (json.contains("radiusY")) {
-        setRadiusY(tikz::Value::fromString(json["radiusY"].toString()));
+        setRadiusY(tikz::Value::fromJson(json["radiusY"]));
     }
 
     if (json.contains("bendAngle")) {
@@ -266,11 +614,11 @@ void Style::loadData(const QJsonObject & json)
     }
 
     if (json.contains("shortenStart")) {
-        setShortenStart(tikz::Value::fromString(json["shortenStart"].toString()));
+        setShortenStart(tikz::Value::fromJson(json["shortenStart"]));
     }
 
     if (json.contains("shortenEnd")) {
-        setShortenEnd(tikz::Value::fromString(json["shortenEnd"].toString()));
+        setShortenEnd(tikz::Value::fromJson(json["shortenEnd"]));
     }
 
     if (json.contains("textAlign")) {
@@ -282,19 +630,19 @@ void Style::loadData(const QJsonObject & json)
     }
 
     if (json.contains("minimumWidth")) {
-        setMinimumWidth(tikz::Value::fromString(json["minimumWidth"].toString()));
+        setMinimumWidth(tikz::Value::fromJson(json["minimumWidth"]));
     }
 
     if (json.contains("minimumHeight")) {
-        setMinimumHeight(tikz::Value::fromString(json["minimumHeight"].toString()));
+        setMinimumHeight(tikz::Value::fromJson(json["minimumHeight"]));
     }
 
     if (json.contains("innerSep")) {
-        setInnerSep(tikz::Value::fromString(json["innerSep"].toString()));
+        setInnerSep(tikz::Value::fromJson(json["innerSep"]));
     }
 
     if (json.contains("outerSep")) {
-        setOuterSep(tikz::Value::fromString(json["outerSep"].toString()));
+        setOuterSep(tikz::Value::fromJson(json["outerSep"]));
     }
 }
 
@@ -325,7 +673,7 @@ QJsonObject Style::saveData() const
     }
 
     if (lineWidthSet()) {
-        json["lineWidth"] = lineWidth().toString();
+        json["lineWidth"] = lineWidth().toJson();
     }
 
     // FIXME line type
@@ -335,7 +683,7 @@ QJsonObject Style::saveData() const
     }
 
     if (innerLineWidthSet()) {
-        json["innerLineWidth"] = innerLineWidth().toString();
+        json["innerLineWidth"] = innerLineWidth().toJson();
     }
 
     if (innerLineColorSet()) {
@@ -347,11 +695,11 @@ QJsonObject Style::saveData() const
     }
 
     if (radiusXSet()) {
-        json["radiusX"] = radiusX().toString();
+        json["radiusX"] = radiusX().toJson();
     }
 
     if (radiusYSet()) {
-        json["radiusY"] = radiusY().toString();
+        json["radiusY"] = radiusY().toJson();
     }
 
     if (bendAngleSet()) {
@@ -379,11 +727,11 @@ QJsonObject Style::saveData() const
     }
 
     if (shortenStartSet()) {
-        json["shortenStart"] = shortenStart().toString();
+        json["shortenStart"] = shortenStart().toJson();
     }
 
     if (shortenEndSet()) {
-        json["shortenEnd"] = shortenEnd().toString();
+        json["shortenEnd"] = shortenEnd().toJson();
     }
 
     if (textAlignSet()) {
@@ -395,19 +743,19 @@ QJsonObject Style::saveData() const
     }
 
     if (minimumWidthSet()) {
-        json["minimumWidth"] = minimumWidth().toString();
+        json["minimumWidth"] = minimumWidth().toJson();
     }
 
     if (minimumHeightSet()) {
-        json["minimumHeight"] = minimumHeight().toString();
+        json["minimumHeight"] = minimumHeight().toJson();
     }
 
     if (innerSepSet()) {
-        json["innerSep"] = innerSep().toString();
+        json["innerSep"] = innerSep().toJson();
     }
 
     if (outerSepSet()) {
-        json["outerSep"] = outerSep().toString();
+        json["outerSep"] = outerSep().toJson();
     }
 
     return json;
@@ -425,23 +773,21 @@ void Style::setParentStyle(const Uid & parentUid)
     }
 
     if (d->parentStyle != parentUid) {
+        // changes of the parent are propagated by the Document, see
+        // Document::scheduleStyleChange()
         ConfigTransaction transaction(this);
-        if (d->parentStyle.isValid()) {
-            // disconnect all signals (e.g. changed())
-            disconnect(d->parentStyle.entity(), nullptr, this, nullptr);
-
+        if (auto oldParent = d->parentStyle.entity<Style>()) {
             // remove this in old parent's children list
-            Q_ASSERT(d->parentStyle.entity<Style>()->d->children.contains(uid()));
-            d->parentStyle.entity<Style>()->d->children.remove(d->parentStyle.entity<Style>()->d->children.indexOf(uid()));
+            Q_ASSERT(oldParent->d->children.contains(uid()));
+            oldParent->d->children.removeOne(uid());
         }
         d->parentStyle = parentUid;
-        if (d->parentStyle.isValid()) {
-            // forward changed() signal
-            connect(d->parentStyle.entity(), SIGNAL(changed()), this, SIGNAL(changed()));
-
+        d->invalidateResolved();
+        propertyChanged("parentStyle");
+        if (auto newParent = d->parentStyle.entity<Style>()) {
             // insert us into the new parent's children list
-            Q_ASSERT(! d->parentStyle.entity<Style>()->d->children.contains(uid()));
-            d->parentStyle.entity<Style>()->d->children.append(uid());
+            Q_ASSERT(! newParent->d->children.contains(uid()));
+            newParent->d->children.append(uid());
         }
     }
 }
@@ -451,485 +797,430 @@ bool Style::hasChildStyles() const
     return d->children.size() > 0;
 }
 
-void Style::addProperty(const QString & property)
+QVector<Uid> Style::childStyles() const
 {
-    d->properties.insert(property);
+    return d->children;
 }
 
-void Style::removeProperty(const QString & property)
+void Style::linkParentStyle()
 {
-    d->properties.remove(property);
+    auto parent = d->parentStyle.entity<Style>();
+    if (parent && !parent->d->children.contains(uid())) {
+        parent->d->children.append(uid());
+        d->invalidateResolved();
+    }
 }
 
-bool Style::propertySet(const QString & property) const
+QString Style::propertyName(Property property)
 {
-    return d->properties.contains(property);
+    Q_ASSERT(property != Property::Count);
+    return QLatin1String(s_propertyNames[static_cast<int>(property)]);
 }
 
-PenStyle Style::penStyle() const
+Style::Property Style::propertyFromName(const QString & name)
 {
-    if (propertySet(s_penStyle)) {
-        return d->penStyle;
+    for (int i = 0; i < static_cast<int>(Property::Count); ++i) {
+        if (name == QLatin1String(s_propertyNames[i])) {
+            return static_cast<Property>(i);
+        }
     }
+    return Property::Count;
+}
+
+void Style::addProperty(Property property)
+{
+    Q_ASSERT(property != Property::Count);
+    d->edit().properties.set(static_cast<std::size_t>(property));
+    d->invalidateResolved();
+    propertyChanged(s_propertyNames[static_cast<int>(property)]);
+}
 
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->penStyle();
+void Style::removeProperty(Property property)
+{
+    Q_ASSERT(property != Property::Count);
+    d->edit().properties.reset(static_cast<std::size_t>(property));
+    d->invalidateResolved();
+    propertyChanged(s_propertyNames[static_cast<int>(property)]);
+}
+
+bool Style::propertySet(Property property) const
+{
+    return d->data->isSet(property);
+}
+
+void Style::addProperty(const QString & property)
+{
+    const Property p = propertyFromName(property);
+    if (p != Property::Count) {
+        addProperty(p);
     }
+}
+
+void Style::removeProperty(const QString & property)
+{
+    const Property p = propertyFromName(property);
+    if (p != Property::Count) {
+        removeProperty(p);
+    }
+}
 
-    return tikz::PenStyle::SolidLine;
+bool Style::propertySet(const QString & property) const
+{
+    const Property p = propertyFromName(property);
+    return p != Property::Count && d->data->isSet(p);
+}
+
+PenStyle Style::penStyle() const
+{
+    return d->resolvedStyle().penStyle;
 }
 
 bool Style::penStyleSet() const
 {
-    return propertySet(s_penStyle);
+    return propertySet(Property::PenStyle);
 }
 
 void Style::setPenStyle(tikz::PenStyle style)
 {
-    if (!propertySet(s_penStyle) || d->penStyle != style) {
+    if (!propertySet(Property::PenStyle) || d->data->penStyle != style) {
         ConfigTransaction transaction(this);
-        addProperty(s_penStyle);
-        d->penStyle = style;
+        addProperty(Property::PenStyle);
+        d->edit().penStyle = style;
     }
 }
 
 void Style::unsetPenStyle()
 {
-    if (propertySet(s_penStyle)) {
+    if (propertySet(Property::PenStyle)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_penStyle);
-        d->penStyle = tikz::PenStyle::SolidLine;
+        removeProperty(Property::PenStyle);
+        d->edit().penStyle = tikz::PenStyle::SolidLine;
     }
 }
 
 tikz::Value Style::penWidth() const
 {
-    if (!doubleLine()) {
-        return lineWidth();
-    } else {
-        const Value width = lineWidth();
-        const Value innerWidth = innerLineWidth();
-        return 2.0 * width + innerWidth;
-    }
+    return d->resolvedStyle().penWidth;
 }
 
 bool Style::lineWidthSet() const
 {
-    return propertySet(s_lineWidth);
+    return propertySet(Property::LineWidth);
 }
 
 void Style::setLineWidth(const tikz::Value & width)
 {
-    if (!propertySet(s_lineWidth)
-        || d->lineWidth != width
+    if (!propertySet(Property::LineWidth)
+        || d->data->lineWidth != width
     ) {
         ConfigTransaction transaction(this);
-        addProperty(s_lineWidth);
-        d->lineWidth = width;
+        addProperty(Property::LineWidth);
+        d->edit().lineWidth = width;
     }
 }
 
 tikz::Value Style::lineWidth() const
 {
-    if (propertySet(s_lineWidth)) {
-        return d->lineWidth;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->lineWidth();
-    }
-
-    return tikz::Value::semiThick();
+    return d->resolvedStyle().lineWidth;
 }
 
 void Style::unsetLineWidth()
 {
-    if (propertySet(s_lineWidth)) {
+    if (propertySet(Property::LineWidth)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_lineWidth);
-        d->lineWidth = tikz::Value::semiThick();
+        removeProperty(Property::LineWidth);
+        d->edit().lineWidth = tikz::Value::semiThick();
     }
 }
 
 bool Style::doubleLine() const
 {
-    if (propertySet(s_doubleLine)) {
-        return d->doubleLine;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->doubleLine();
-    }
-
-    return false;
+    return d->resolvedStyle().doubleLine;
 }
 
 bool Style::doubleLineSet() const
 {
-    return propertySet(s_doubleLine);
+    return propertySet(Property::DoubleLine);
 }
 
 void Style::setDoubleLine(bool enabled)
 {
-    if (!propertySet(s_doubleLine) || d->doubleLine != enabled) {
+    if (!propertySet(Property::DoubleLine) || d->data->doubleLine != enabled) {
         ConfigTransaction transaction(this);
-        addProperty(s_doubleLine);
-        d->doubleLine = enabled;
+        addProperty(Property::DoubleLine);
+        d->edit().doubleLine = enabled;
     }
 }
 
 void Style::unsetDoubleLine()
 {
-    if (propertySet(s_doubleLine)) {
+    if (propertySet(Property::DoubleLine)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_doubleLine);
-        d->doubleLine = false;
+        removeProperty(Property::DoubleLine);
+        d->edit().doubleLine = false;
     }
 }
 
 tikz::Value Style::innerLineWidth() const
 {
-    if (propertySet(s_innerLineWidth)) {
-        return d->innerLineWidth;
-    }
-
-    if (parentStyle().isValid() && parentStyle().entity<Style>()->doubleLine()) {
-        return parentStyle().entity<Style>()->innerLineWidth();
-    }
-
-    return tikz::Value::semiThick();
+    return d->resolvedStyle().innerLineWidth;
 }
 
 bool Style::innerLineWidthSet() const
 {
-    return propertySet(s_innerLineWidth);
+    return propertySet(Property::InnerLineWidth);
 }
 
 void Style::setInnerLineWidth(const tikz::Value & width)
 {
-    if (!propertySet(s_innerLineWidth) || d->innerLineWidth != width) {
+    if (!propertySet(Property::InnerLineWidth) || d->data->innerLineWidth != width) {
         ConfigTransaction transaction(this);
-        addProperty(s_innerLineWidth);
-        d->innerLineWidth = width;
+        addProperty(Property::InnerLineWidth);
+        d->edit().innerLineWidth = width;
     }
 }
 
 void Style::unsetInnerLineWidth()
 {
-    if (propertySet(s_innerLineWidth)) {
+    if (propertySet(Property::InnerLineWidth)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_innerLineWidth);
-        d->innerLineWidth = tikz::Value::semiThick();
+        removeProperty(Property::InnerLineWidth);
+        d->edit().innerLineWidth = tikz::Value::semiThick();
     }
 }
 
 qreal Style::penOpacity() const
 {
-    if (propertySet(s_penOpacity)) {
-        return d->penOpacity;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->penOpacity();
-    }
-
-    return 1.0;
+    return d->resolvedStyle().penOpacity;
 }
 
 void Style::setPenOpacity(qreal opacity)
 {
-    if (!propertySet(s_penOpacity) || d->penOpacity != opacity) {
+    if (!propertySet(Property::PenOpacity) || d->data->penOpacity != opacity) {
         ConfigTransaction transaction(this);
-        addProperty(s_penOpacity);
-        d->penOpacity = opacity;
+        addProperty(Property::PenOpacity);
+        d->edit().penOpacity = opacity;
     }
 }
 
 bool Style::penOpacitySet() const
 {
-    return propertySet(s_penOpacity);
+    return propertySet(Property::PenOpacity);
 }
 
 void Style::unsetPenOpacity()
 {
-    if (propertySet(s_penOpacity)) {
+    if (propertySet(Property::PenOpacity)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_penOpacity);
-        d->penOpacity = 1.0;
+        removeProperty(Property::PenOpacity);
+        d->edit().penOpacity = 1.0;
     }
 }
 
 qreal Style::fillOpacity() const
 {
-    if (propertySet(s_fillOpacity)) {
-        return d->fillOpacity;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->fillOpacity();
-    }
-
-    return 1.0;
+    return d->resolvedStyle().fillOpacity;
 }
 
 bool Style::fillOpacitySet() const
 {
-    return propertySet(s_fillOpacity);
+    return propertySet(Property::FillOpacity);
 }
 
 void Style::setFillOpacity(qreal opacity)
 {
-    if (!propertySet(s_fillOpacity) || d->fillOpacity != opacity) {
+    if (!propertySet(Property::FillOpacity) || d->data->fillOpacity != opacity) {
         ConfigTransaction transaction(this);
-        addProperty(s_fillOpacity);
-        d->fillOpacity = opacity;
+        addProperty(Property::FillOpacity);
+        d->edit().fillOpacity = opacity;
     }
 }
 
 void Style::unsetFillOpacity()
 {
-    if (propertySet(s_fillOpacity)) {
+    if (propertySet(Property::FillOpacity)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_fillOpacity);
-        d->fillOpacity = 1.0;
+        removeProperty(Property::FillOpacity);
+        d->edit().fillOpacity = 1.0;
     }
 }
 
 QColor Style::penColor() const
 {
-    if (propertySet(s_penColor)) {
-        return d->penColor;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->penColor();
-    }
-
-    return Qt::black;
+    return d->resolvedStyle().penColor;
 }
 
 bool Style::penColorSet() const
 {
-    return propertySet(s_penColor);
+    return propertySet(Property::PenColor);
 }
 
 QColor Style::innerLineColor() const
 {
-    if (propertySet(s_innerLineColor)) {
-        return d->innerLineColor;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->innerLineColor();
-    }
-
-    return Qt::white;
+    return d->resolvedStyle().innerLineColor;
 }
 
 bool Style::innerLineColorSet() const
 {
-    return propertySet(s_innerLineColor);
+    return propertySet(Property::InnerLineColor);
 }
 
 QColor Style::fillColor() const
 {
-    if (propertySet(s_fillColor)) {
-        return d->fillColor;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->fillColor();
-    }
-
-    return Qt::transparent;
+    return d->resolvedStyle().fillColor;
 }
 
 bool Style::fillColorSet() const
 {
-    return propertySet(s_fillColor);
+    return propertySet(Property::FillColor);
 }
 
 void Style::setPenColor(const QColor & color)
 {
-    if (!propertySet(s_penColor) || d->penColor != color) {
+    if (!propertySet(Property::PenColor) || d->data->penColor != color) {
         ConfigTransaction transaction(this);
-        addProperty(s_penColor);
-        d->penColor = color;
+        addProperty(Property::PenColor);
+        d->edit().penColor = color;
     }
 }
 
 void Style::unsetPenColor()
 {
-    if (propertySet(s_penColor)) {
+    if (propertySet(Property::PenColor)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_penColor);
-        d->penColor = Qt::black;
+        removeProperty(Property::PenColor);
+        d->edit().penColor = Qt::black;
     }
 }
 
 void Style::setInnerLineColor(const QColor & color)
 {
-    if (!propertySet(s_innerLineColor) || d->innerLineColor != color) {
+    if (!propertySet(Property::InnerLineColor) || d->data->innerLineColor != color) {
         ConfigTransaction transaction(this);
-        addProperty(s_innerLineColor);
-        d->innerLineColor = color;
+        addProperty(Property::InnerLineColor);
+        d->edit().innerLineColor = color;
     }
 }
 
 void Style::unsetInnerLineColor()
 {
-    if (propertySet(s_innerLineColor)) {
+    if (propertySet(Property::InnerLineColor)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_innerLineColor);
-        d->innerLineColor = Qt::white;
+        removeProperty(Property::InnerLineColor);
+        d->edit().innerLineColor = Qt::white;
     }
 }
 
 void Style::setFillColor(const QColor & color)
 {
-    if (!propertySet(s_fillColor) || d->fillColor != color) {
+    if (!propertySet(Property::FillColor) || d->data->fillColor != color) {
         ConfigTransaction transaction(this);
-        addProperty(s_fillColor);
-        d->fillColor = color;
+        addProperty(Property::FillColor);
+        d->edit().fillColor = color;
     }
 }
 
 void Style::unsetFillColor()
 {
-    if (propertySet(s_fillColor)) {
+    if (propertySet(Property::FillColor)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_fillColor);
-        d->fillColor = Qt::transparent;
+        removeProperty(Property::FillColor);
+        d->edit().fillColor = Qt::transparent;
     }
 }
 
 qreal Style::rotation() const
 {
-    if (propertySet(s_rotation)) {
-        return d->rotation;
-    }
-
-    if (parentStyle().isValid()) {
-        return parentStyle().entity<Style>()->rotation();
-    }
-
-    return 0.0;
+    return d->resolvedStyle().rotation;
 }
 
 bool Style::rotationSet() const
 {
-    return propertySet(s_rotation);
+    return propertySet(Property::Rotation);
 }
 
 void Style::setRotation(qreal angle)
 {
-    if (!propertySet(s_rotation) || d->rotation != angle) {
+    if (!propertySet(Property::Rotation) || d->data->rotation != angle) {
         ConfigTransaction transaction(this);
-        addProperty(s_rotation);
-        d->rotation = angle;
+        addProperty(Property::Rotation);
+        d->edit().rotation = angle;
     }
 }
 
 void Style::unsetRotation()
 {
-    if (propertySet(s_rotation)) {
+    if (propertySet(Property::Rotation)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_rotation);
-        d->rotation = 0.0;
+        removeProperty(Property::Rotation);
+        d->edit().rotation = 0.0;
     }
 }
 
 tikz::Value Style::radiusX() const
 {
-    if (propertySet(s_radiusX)) {
-        return d->radiusX;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->radiusX();
-    }
-
-    return 0.0_cm;
+    return d->resolvedStyle().radiusX;
 }
 
 tikz::Value Style::radiusY() const
 {
-    if (propertySet(s_radiusY)) {
-        return d->radiusY;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->radiusY();
-    }
-
-    return 0.0_cm;
+    return d->resolvedStyle().radiusY;
 }
 
 bool Style::radiusXSet() const
 {
-    return propertySet(s_radiusX);
+    return propertySet(Property::RadiusX);
 }
 
 bool Style::radiusYSet() const
 {
-    return propertySet(s_radiusY);
+    return propertySet(Property::RadiusY);
 }
 
 void Style::setRadiusX(const tikz::Value & xradius)
 {
-    if (!propertySet(s_radiusX) || d->radiusX != xradius) {
+    if (!propertySet(Property::RadiusX) || d->data->radiusX != xradius) {
         ConfigTransaction transaction(this);
-        addProperty(s_radiusX);
-        d->radiusX = xradius;
+        addProperty(Property::RadiusX);
+        d->edit().radiusX = xradius;
     }
 }
 
 void Style::setRadiusY(const tikz::Value & yradius)
 {
-    if (!propertySet(s_radiusY) || d->radiusY != yradius) {
+    if (!propertySet(Property::RadiusY) || d->data->radiusY != yradius) {
         ConfigTransaction transaction(this);
-        addProperty(s_radiusY);
-        d->radiusY = yradius;
+        addProperty(Property::RadiusY);
+        d->edit().radiusY = yradius;
     }
 }
 
 void Style::unsetRadiusX()
 {
-    if (propertySet(s_radiusX)) {
+    if (propertySet(Property::RadiusX)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_radiusX);
-        d->radiusX = 0.0_cm;
+        removeProperty(Property::RadiusX);
+        d->edit().radiusX = 0.0_cm;
     }
 }
 
 void Style::unsetRadiusY()
 {
-    if (propertySet(s_radiusY)) {
+    if (propertySet(Property::RadiusY)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_radiusY);
-        d->radiusY = 0.0_cm;
+        removeProperty(Property::RadiusY);
+        d->edit().radiusY = 0.0_cm;
     }
 }
 
 qreal Style::bendAngle() const
 {
-    if (propertySet(s_bendAngle)) {
-        return d->bendAngle;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->bendAngle();
-    }
-
-    return 0.0;
+    return d->resolvedStyle().bendAngle;
 }
 
 bool Style::bendAngleSet() const
 {
-    return propertySet(s_bendAngle);
+    return propertySet(Property::BendAngle);
 }
 
 void Style::setBendAngle(qreal angle)
@@ -938,56 +1229,47 @@ void Style::setBendAngle(qreal angle)
     while (angle > 180) angle -= 360.0;
     while (angle < -180) angle += 360.0;
 
-    if (!propertySet(s_bendAngle) || d->bendAngle != angle) {
+    if (!propertySet(Property::BendAngle) || d->data->bendAngle != angle) {
         ConfigTransaction transaction(this);
-        addProperty(s_bendAngle);
-        d->bendAngle = angle;
+        addProperty(Property::BendAngle);
+        d->edit().bendAngle = angle;
     }
 }
 
 void Style::unsetBendAngle()
 {
-    if (propertySet(s_bendAngle)) {
+    if (propertySet(Property::BendAngle)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_bendAngle);
-        d->bendAngle = 0.0;
+        removeProperty(Property::BendAngle);
+        d->edit().bendAngle = 0.0;
     }
 }
 
 qreal Style::looseness() const
 {
-    if (propertySet(s_looseness)) {
-        return d->looseness;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->looseness();
-    }
-
-    return 1.0;
+    return d->resolvedStyle().looseness;
 }
 
 bool Style::loosenessSet() const
 {
-    return propertySet(s_looseness);
+    return propertySet(Property::Looseness);
 }
 
 void Style::setLooseness(qreal looseness)
 {
-    if (!propertySet(s_looseness) || d->looseness != looseness) {
+    if (!propertySet(Property::Looseness) || d->data->looseness != looseness) {
         ConfigTransaction transaction(this);
-        addProperty(s_looseness);
-        d->looseness = looseness;
+        addProperty(Property::Looseness);
+        d->edit().looseness = looseness;
     }
 }
 
 void Style::unsetLooseness()
 {
-    if (propertySet(s_looseness)) {
+    if (propertySet(Property::Looseness)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_looseness);
-        d->looseness = 1.0;
+        removeProperty(Property::Looseness);
+        d->edit().looseness = 1.0;
     }
 }
 
@@ -1015,434 +1297,337 @@ QPointF Style::endControlPoint() const
 
 qreal Style::outAngle() const
 {
-    if (propertySet(s_outAngle)) {
-        return d->outAngle;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->outAngle();
-    }
-
-    return 45;
+    return d->resolvedStyle().outAngle;
 }
 
 bool Style::outAngleSet() const
 {
-    return propertySet(s_outAngle);
+    return propertySet(Property::OutAngle);
 }
 
 void Style::setOutAngle(qreal angle)
 {
-    if (!propertySet(s_outAngle) || d->outAngle != angle) {
+    if (!propertySet(Property::OutAngle) || d->data->outAngle != angle) {
         ConfigTransaction transaction(this);
-        addProperty(s_outAngle);
-        d->outAngle = angle;
+        addProperty(Property::OutAngle);
+        d->edit().outAngle = angle;
     }
 }
 
 void Style::unsetOutAngle()
 {
-    if (propertySet(s_outAngle)) {
+    if (propertySet(Property::OutAngle)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_outAngle);
-        d->outAngle = 45;
+        removeProperty(Property::OutAngle);
+        d->edit().outAngle = 45;
     }
 }
 
 qreal Style::inAngle() const
 {
-    if (propertySet(s_inAngle)) {
-        return d->inAngle;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->inAngle();
-    }
-
-    return 135;
+    return d->resolvedStyle().inAngle;
 }
 
 bool Style::inAngleSet() const
 {
-    return propertySet(s_inAngle);
+    return propertySet(Property::InAngle);
 }
 
 void Style::setInAngle(qreal angle)
 {
-    if (!propertySet(s_inAngle) || d->inAngle != angle) {
+    if (!propertySet(Property::InAngle) || d->data->inAngle != angle) {
         ConfigTransaction transaction(this);
-        addProperty(s_inAngle);
-        d->inAngle = angle;
+        addProperty(Property::InAngle);
+        d->edit().inAngle = angle;
     }
 }
 
 void Style::unsetInAngle()
 {
-    if (propertySet(s_inAngle)) {
+    if (propertySet(Property::InAngle)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_inAngle);
-        d->inAngle = 135;
+        removeProperty(Property::InAngle);
+        d->edit().inAngle = 135;
     }
 }
 
 Arrow Style::arrowTail() const
 {
-    if (propertySet(s_arrowTail)) {
-        return d->arrowTail;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->arrowTail();
-    }
-
-    return tikz::Arrow::NoArrow;
+    return d->resolvedStyle().arrowTail;
 }
 
 bool Style::arrowTailSet() const
 {
-    return propertySet(s_arrowTail);
+    return propertySet(Property::ArrowTail);
 }
 
 Arrow Style::arrowHead() const
 {
-    if (propertySet(s_arrowHead)) {
-        return d->arrowHead;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->arrowHead();
-    }
-
-    return tikz::Arrow::NoArrow;
+    return d->resolvedStyle().arrowHead;
 }
 
 bool Style::arrowHeadSet() const
 {
-    return propertySet(s_arrowHead);
+    return propertySet(Property::ArrowHead);
 }
 
 void Style::setArrowTail(tikz::Arrow tail)
 {
-    if (!propertySet(s_arrowTail) || d->arrowTail != tail) {
+    if (!propertySet(Property::ArrowTail) || d->data->arrowTail != tail) {
         ConfigTransaction transaction(this);
-        addProperty(s_arrowTail);
-        d->arrowTail = tail;
+        addProperty(Property::ArrowTail);
+        d->edit().arrowTail = tail;
     }
 }
 
 void Style::setArrowHead(tikz::Arrow head)
 {
-    if (!propertySet(s_arrowHead) || d->arrowHead != head) {
+    if (!propertySet(Property::ArrowHead) || d->data->arrowHead != head) {
         ConfigTransaction transaction(this);
-        addProperty(s_arrowHead);
-        d->arrowHead = head;
+        addProperty(Property::ArrowHead);
+        d->edit().arrowHead = head;
     }
 }
 
 void Style::unsetArrowTail()
 {
-    if (propertySet(s_arrowTail)) {
+    if (propertySet(Property::ArrowTail)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_arrowTail);
-        d->arrowTail = tikz::Arrow::NoArrow;
+        removeProperty(Property::ArrowTail);
+        d->edit().arrowTail = tikz::Arrow::NoArrow;
     }
 }
 
 void Style::unsetArrowHead()
 {
-    if (propertySet(s_arrowHead)) {
+    if (propertySet(Property::ArrowHead)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_arrowHead);
-        d->arrowHead = tikz::Arrow::NoArrow;
+        removeProperty(Property::ArrowHead);
+        d->edit().arrowHead = tikz::Arrow::NoArrow;
     }
 }
 
 tikz::Value Style::shortenStart() const
 {
-    if (propertySet(s_shortenStart)) {
-        return d->shortenStart;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->shortenStart();
-    }
-
-    return 0.0_cm;
+    return d->resolvedStyle().shortenStart;
 }
 
 bool Style::shortenStartSet() const
 {
-    return propertySet(s_shortenStart);
+    return propertySet(Property::ShortenStart);
 }
 
 tikz::Value Style::shortenEnd() const
 {
-    if (propertySet(s_shortenEnd)) {
-        return d->shortenEnd;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->shortenEnd();
-    }
-
-    return 0.0_cm;
+    return d->resolvedStyle().shortenEnd;
 }
 
 bool Style::shortenEndSet() const
 {
-    return propertySet(s_shortenEnd);
+    return propertySet(Property::ShortenEnd);
 }
 
 void Style::setShortenStart(const tikz::Value & shorten)
 {
-    if (!propertySet(s_shortenStart) || d->shortenStart != shorten) {
+    if (!propertySet(Property::ShortenStart) || d->data->shortenStart != shorten) {
         ConfigTransaction transaction(this);
-        addProperty(s_shortenStart);
-        d->shortenStart = shorten;
+        addProperty(Property::ShortenStart);
+        d->edit().shortenStart = shorten;
     }
 }
 
 void Style::setShortenEnd(const tikz::Value & shorten)
 {
-    if (!propertySet(s_shortenEnd) || d->shortenEnd != shorten) {
+    if (!propertySet(Property::ShortenEnd) || d->data->shortenEnd != shorten) {
         ConfigTransaction transaction(this);
-        addProperty(s_shortenEnd);
-        d->shortenEnd = shorten;
+        addProperty(Property::ShortenEnd);
+        d->edit().shortenEnd = shorten;
     }
 }
 
 void Style::unsetShortenStart()
 {
-    if (propertySet(s_shortenStart)) {
+    if (propertySet(Property::ShortenStart)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_shortenStart);
-        d->shortenStart = 0.0_cm;
+        removeProperty(Property::ShortenStart);
+        d->edit().shortenStart = tikz::Value();
     }
 }
 
 void Style::unsetShortenEnd()
 {
-    if (propertySet(s_shortenEnd)) {
+    if (propertySet(Property::ShortenEnd)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_shortenEnd);
-        d->shortenEnd = 0.0_cm;
+        removeProperty(Property::ShortenEnd);
+        d->edit().shortenEnd = tikz::Value();
     }
 }
 
 TextAlignment Style::textAlign() const
 {
-    if (propertySet(s_align)) {
-        return d->textAlign;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->textAlign();
-    }
-
-    return TextAlignment::NoAlign;
+    return d->resolvedStyle().textAlign;
 }
 
 bool Style::textAlignSet() const
 {
-    return propertySet(s_align);
+    return propertySet(Property::TextAlign);
 }
 
 void Style::setTextAlign(tikz::TextAlignment align)
 {
-    if (!propertySet(s_align) || d->textAlign != align) {
+    if (!propertySet(Property::TextAlign) || d->data->textAlign != align) {
         ConfigTransaction transaction(this);
-        addProperty(s_align);
-        d->textAlign = align;
+        addProperty(Property::TextAlign);
+        d->edit().textAlign = align;
     }
 }
 
 void Style::unsetTextAlign()
 {
-    if (propertySet(s_align)) {
+    if (propertySet(Property::TextAlign)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_align);
-        d->textAlign = TextAlignment::NoAlign;
+        removeProperty(Property::TextAlign);
+        d->edit().textAlign = TextAlignment::NoAlign;
     }
 }
 
 Shape Style::shape() const
 {
-    if (propertySet(s_shape)) {
-        return d->shape;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->shape();
-    }
-
-    return Shape::ShapeRectangle;
+    return d->resolvedStyle().shape;
 }
 
 bool Style::shapeSet() const
 {
-    return propertySet(s_shape);
+    return propertySet(Property::Shape);
 }
 
 void Style::setShape(tikz::Shape shape)
 {
-    if (!propertySet(s_shape) || d->shape != shape) {
+    if (!propertySet(Property::Shape) || d->data->shape != shape) {
         ConfigTransaction transaction(this);
-        addProperty(s_shape);
-        d->shape = shape;
+        addProperty(Property::Shape);
+        d->edit().shape = shape;
     }
 }
 
 void Style::unsetShape()
 {
-    if (propertySet(s_shape)) {
+    if (propertySet(Property::Shape)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_shape);
-        d->shape = Shape::ShapeRectangle;
+        removeProperty(Property::Shape);
+        d->edit().shape = Shape::ShapeRectangle;
     }
 }
 
 void Style::setInnerSep(const tikz::Value & sep)
 {
-    if (!propertySet(s_innerSep) || d->innerSep != sep) {
+    if (!propertySet(Property::InnerSep) || d->data->innerSep != sep) {
         ConfigTransaction transaction(this);
-        addProperty(s_innerSep);
-        d->innerSep = sep;
+        addProperty(Property::InnerSep);
+        d->edit().innerSep = sep;
     }
 }
 
 bool Style::innerSepSet() const
 {
-    return propertySet(s_innerSep);
+    return propertySet(Property::InnerSep);
 }
 
 tikz::Value Style::innerSep() const
 {
-    auto style = parentStyle().entity<Style>();
-    if (!propertySet(s_innerSep) && style) {
-        return style->innerSep();
-    }
-    return d->innerSep;
+    return d->resolvedStyle().innerSep;
 }
 
 void Style::setOuterSep(const tikz::Value & sep)
 {
-    if (!propertySet(s_outerSep) || d->outerSep != sep) {
+    if (!propertySet(Property::OuterSep) || d->data->outerSep != sep) {
         ConfigTransaction transaction(this);
-        addProperty(s_outerSep);
-        d->outerSep = sep;
+        addProperty(Property::OuterSep);
+        d->edit().outerSep = sep;
     }
 }
 
 bool Style::outerSepSet() const
 {
-    return propertySet(s_outerSep);
+    return propertySet(Property::OuterSep);
 }
 
 tikz::Value Style::outerSep() const
 {
-    if (!propertySet(s_outerSep)) {
-        return 0.5 * penWidth();
-    }
-    return d->outerSep;
+    return d->resolvedStyle().outerSep;
 }
 
 void Style::unsetInnerSep()
 {
-    if (propertySet(s_innerSep)) {
+    if (propertySet(Property::InnerSep)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_innerSep);
-        d->innerSep = 3.0_pt; //FIXME: 0.3333em
+        removeProperty(Property::InnerSep);
+        d->edit().innerSep = 3.0_pt; //FIXME: 0.3333em
     }
 }
 
 void Style::unsetOuterSep()
 {
-    if (propertySet(s_outerSep)) {
+    if (propertySet(Property::OuterSep)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_outerSep);
-        d->outerSep = 3.0_pt; //FIXME: 0.3333em
+        removeProperty(Property::OuterSep);
+        d->edit().outerSep = 0.5_pt; // 0.5 \pgflinewidth
     }
 }
 
 tikz::Value Style::minimumHeight() const
 {
-    if (propertySet(s_minimumHeight)) {
-        return d->minimumHeight;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->minimumHeight();
-    }
-
-    return 0.0_cm;
+    return d->resolvedStyle().minimumHeight;
 }
 
 bool Style::minimumHeightSet() const
 {
-    return propertySet(s_minimumHeight);
+    return propertySet(Property::MinimumHeight);
 }
 
 tikz::Value Style::minimumWidth() const
 {
-    if (propertySet(s_minimumWidth)) {
-        return d->minimumWidth;
-    }
-
-    auto style = parentStyle().entity<Style>();
-    if (style) {
-        return style->minimumWidth();
-    }
-
-    return 0.0_cm;
+    return d->resolvedStyle().minimumWidth;
 }
 
 bool Style::minimumWidthSet() const
 {
-    return propertySet(s_minimumWidth);
+    return propertySet(Property::MinimumWidth);
 }
 
 void Style::setMinimumHeight(const tikz::Value & height)
 {
-    if (!propertySet(s_minimumHeight) || d->minimumHeight != height) {
+    if (!propertySet(Property::MinimumHeight) || d->data->minimumHeight != height) {
         ConfigTransaction transaction(this);
-        addProperty(s_minimumHeight);
-        d->minimumHeight = height;
+        addProperty(Property::MinimumHeight);
+        d->edit().minimumHeight = height;
     }
 }
 
 void Style::setMinimumWidth(const tikz::Value & width)
 {
-    if (!propertySet(s_minimumWidth) || d->minimumWidth != width) {
+    if (!propertySet(Property::MinimumWidth) || d->data->minimumWidth != width) {
         ConfigTransaction transaction(this);
-        addProperty(s_minimumWidth);
-        d->minimumWidth = width;
+        addProperty(Property::MinimumWidth);
+        d->edit().minimumWidth = width;
     }
 }
 
 void Style::unsetMinimumHeight()
 {
-    if (propertySet(s_minimumHeight)) {
+    if (propertySet(Property::MinimumHeight)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_minimumHeight);
-        d->minimumHeight = 0.0_cm;
+        removeProperty(Property::MinimumHeight);
+        d->edit().minimumHeight = 0.0_cm;
     }
 }
 
 void Style::unsetMinimumWidth()
 {
-    if (propertySet(s_minimumWidth)) {
+    if (propertySet(Property::MinimumWidth)) {
         ConfigTransaction transaction(this);
-        removeProperty(s_minimumWidth);
-        d->minimumWidth = 0.0_cm;
+        removeProperty(Property::MinimumWidth);
+        d->edit().minimumWidth = 0.0_cm;
     }
 }
 
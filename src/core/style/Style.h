@@ -77,6 +77,22 @@ class TIKZKITCORE_EXPORT Style : public Entity
          */
         virtual void setStyle(const Style * other);
 
+        /**
+         * Returns @e true, if this style and @p other set the same properties
+         * to the same values. The parent styles are not taken into account.
+         *
+         * Styles with identical properties share their data, so this is
+         * a pointer comparison.
+         */
+        bool hasSameProperties(const Style * other) const;
+
+        /**
+         * Returns a key that identifies the set properties and their values.
+         * Styles with the same properties return the same key, see
+         * hasSameProperties(). The key is valid until the style changes.
+         */
+        quintptr propertiesKey() const;
+
         /**
          * Load the style to a JSON object.
          */
@@ -117,17 +133,100 @@ class TIKZKITCORE_EXPORT Style : public Entity
          */
         bool hasChildStyles() const;
 
+        /**
+         * Returns the styles directly inheriting from this style.
+         */
+        QVector<Uid> childStyles() const;
+
+        /**
+         * Registers this style as child of its parent style. Call this once
+         * all styles are loaded: if the parent style did not exist yet when
+         * this style was loaded, changes of the parent style are otherwise
+         * not propagated to this style.
+         */
+        void linkParentStyle();
+
     //
     // properties
     //
+    public:
+        /**
+         * Identifiers of all properties a Style may set.
+         * The name of each property matches its Q_PROPERTY name,
+         * see propertyName() and propertyFromName().
+         */
+        enum class Property : int {
+            PenStyle = 0,
+            LineWidth,
+            DoubleLine,
+            InnerLineWidth,
+            PenOpacity,
+            FillOpacity,
+            PenColor,
+            InnerLineColor,
+            FillColor,
+            Rotation,
+
+            // Path properties
+            RadiusX,
+            RadiusY,
+            BendAngle,
+            Looseness,
+            OutAngle,
+            InAngle,
+            ArrowTail,
+            ArrowHead,
+            ShortenStart,
+            ShortenEnd,
+
+            // Node properties
+            TextAlign,
+            Shape,
+            InnerSep,
+            OuterSep,
+            MinimumHeight,
+            MinimumWidth,
+
+            // number of properties, also used as invalid Property
+            Count
+        };
+
+        /**
+         * Returns the name of @p property, e.g. "penColor".
+         */
+        static QString propertyName(Property property);
+
+        /**
+         * Returns the Property with the name @p name.
+         * If @p name is no Style property, Property::Count is returned.
+         */
+        static Property propertyFromName(const QString & name);
+
+        /**
+         * Add @p property to the list of set properties.
+         */
+        void addProperty(Property property);
+
+        /**
+         * Remove @p property from the list of set properties.
+         */
+        void removeProperty(Property property);
+
+        /**
+         * Check whether @p property is set.
+         */
+        bool propertySet(Property property) const;
+
     public Q_SLOTS:
         /**
          * Add @p property to the list of set properties.
+         * Unknown property names are ignored.
          */
         void addProperty(const QString & property);
 
         /**
          * Remove @p property from the list of set properties.
+         * Unknown property names are ignored.
          */
         void removeProperty(const QString & property);
 
@@ -889,6 +988,7 @@ private:
     //
     protected:
         friend class Document;
+        friend class StylePrivate;
 
         /**
          * Associate this style with @p uid.
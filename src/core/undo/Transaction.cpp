@@ -29,6 +29,11 @@ Transaction::Transaction(Document *document)
 }
 
 Transaction::Transaction(Document * document, const QString & name)
+    : Transaction(document, name, Immediate)
+{
+}
+
+Transaction::Transaction(Document * document, const QString & name, Mode mode)
     : m_document(document)
 {
     // Alghouth it works in release-mode, we usually want a valid document
@@ -36,7 +41,11 @@ Transaction::Transaction(Document * document, const QString & name)
 
     // start the editing transaction
     if (m_document) {
-        m_document->beginTransaction(name);
+        if (mode == Gesture) {
+            m_document->beginGesture(name);
+        } else {
+            m_document->beginTransaction(name);
+        }
     }
 }
 
@@ -54,10 +54,25 @@ class TransactionPrivate;
  *
  * Further, if a running transaction should be aborted, just call cancel().
  * This is handy whenever the user hits Escape during a modification.
+ *
+ * For interactive gestures such as dragging nodes with the mouse, pass the
+ * mode Transaction::Gesture. Then, each mouse move changes the node
+ * positions directly, and only one undo item per node is recorded when the
+ * transaction finishes.
  */
 class TIKZKITCORE_EXPORT Transaction
 {
     public:
+        /**
+         * Mode of the transaction.
+         */
+        enum Mode {
+            //! each change creates an undo item right away
+            Immediate,
+            //! repeated changes of an entity are coalesced, see Document::beginGesture()
+            Gesture
+        };
+
         /**
          * Constructor. Will automatically start an editing transaction.
          *
@@ -73,6 +88,16 @@ class TIKZKITCORE_EXPORT Transaction
          */
         explicit Transaction(Document * document, const QString & name);
 
+        /**
+         * Constructs the object and starts an editing transaction in
+         * the mode @p mode.
+         *
+         * @param document document for the transaction
+         * @param name the transaction name
+         * @param mode the transaction mode
+         */
+        explicit Transaction(Document * document, const QString & name, Mode mode);
+
         /**
          * Destructs the object and, if needed, finishes a running editing
          * transaction by calling finish().
@@ -21,14 +21,60 @@
 #include "Document.h"
 
 #include "UndoCreateEntity.h"
+#include "UndoCreateEntities.h"
 #include "UndoDeleteEntity.h"
+#include "UndoSetProperty.h"
 #include "UndoSetNodePos.h"
 #include "UndoSetEdgePos.h"
 #include "UndoSetEllipsePos.h"
 
+#include <QHash>
+
 namespace tikz {
 namespace core {
 
+namespace {
+    template <typename T>
+    UndoItem * create(Document * doc)
+    {
+        return new T(doc);
+    }
+
+    struct UndoType
+    {
+        const char * name;
+        UndoItem * (*create)(Document * doc);
+    };
+
+    // registered undo item types. The index is the compact type id,
+    // so only append new types.
+    const UndoType s_undoTypes[] = {
+        { "entity-create", &create<UndoCreateEntity> },
+        { "entities-create", &create<UndoCreateEntities> },
+        { "entity-delete", &create<UndoDeleteEntity> },
+        { "entity-set-property", &create<UndoSetProperty> },
+        { "node-set-pos", &create<UndoSetNodePos> },
+        { "edge-set-pos", &create<UndoSetEdgePos> },
+        { "ellipse-set-pos", &create<UndoSetEllipsePos> },
+    };
+
+    constexpr int s_undoTypeCount = sizeof(s_undoTypes) / sizeof(s_undoTypes[0]);
+
+    // maps the type names to the compact type ids
+    const QHash<QByteArray, int> & undoTypeIds()
+    {
+        static const QHash<QByteArray, int> ids = [] {
+            QHash<QByteArray, int> hash;
+            hash.reserve(s_undoTypeCount);
+            for (int i = 0; i < s_undoTypeCount; ++i) {
+                hash.insert(QByteArray::fromRawData(s_undoTypes[i].name, qstrlen(s_undoTypes[i].name)), i);
+            }
+            return hash;
+        }();
+        return ids;
+    }
+}
+
 class UndoFactoryPrivate {
 public:
     /**
@@ -60,20 +106,23 @@ UndoItem * UndoFactory::createItem(const QString & type)
         return nullptr;
     }
 
-    if (type == "entity-create") {
-        return new UndoCreateEntity(document());
-    } else if (type == "entity-delete") {
-        return new UndoDeleteEntity(document());
-    } else if (type == "node-set-pos") {
-        return new UndoSetNodePos(document());
-    } else if (type == "edge-set-pos") {
-        return new UndoSetEdgePos(document());
-    } else if (type == "ellipse-set-pos") {
-        return new UndoSetEllipsePos(document());
+    const int id = undoTypeIds().value(type.toLatin1(), -1);
+    Q_ASSERT(id >= 0);
+    return createItem(id);
+}
+
+UndoItem * UndoFactory::createItem(int typeId)
+{
+    if (typeId < 0 || typeId >= s_undoTypeCount) {
+        return nullptr;
     }
 
-    Q_ASSERT(false);
-    return nullptr;
+    return s_undoTypes[typeId].create(document());
+}
+
+int UndoFactory::typeId(const char * typeName)
+{
+    return undoTypeIds().value(QByteArray::fromRawData(typeName, qstrlen(typeName)), -1);
 }
 
 }
@@ -32,7 +32,13 @@ class UndoItem;
 class UndoFactoryPrivate;
 
 /**
- * Base class for undo/redo items.
+ * Factory for undo items.
+ *
+ * All undo item types are registered in a static table, together with the
+ * type name (see UndoItem::typeName()) and a function creating the item.
+ * Besides the type name, each type is identified by its index in the table,
+ * which is used as compact type id, e.g. in the UndoJournal. Therefore, new
+ * undo item types must only be appended to the table.
  */
 class UndoFactory
 {
@@ -54,10 +60,23 @@ public:
     Document* document();
 
     /**
-     * Creates an undo item from the @p json object.
+     * Creates an undo item of type @p type, e.g. "node-set-pos".
+     * Returns nullptr, if @p type is not registered.
      */
     UndoItem * createItem(const QString & type);
 
+    /**
+     * Creates an undo item with the compact type id @p typeId.
+     * Returns nullptr, if @p typeId is not registered.
+     */
+    UndoItem * createItem(int typeId);
+
+    /**
+     * Returns the compact type id of the undo item type @p typeName,
+     * or -1 if the type is not registered.
+     */
+    static int typeId(const char * typeName);
+
 private:
     /**
      * Pimpl pointer to the held data.
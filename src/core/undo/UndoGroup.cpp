@@ -20,12 +20,21 @@
 #include "UndoGroup.h"
 #include "UndoItem.h"
 #include "UndoManager.h"
+#include "UndoFactory.h"
+#include "tikz.h"
 
+#include <QDataStream>
+#include <QIODevice>
 #include <QDebug>
 
 namespace tikz {
 namespace core {
 
+namespace {
+    // stream version of the compact data, since it is also stored in files
+    constexpr int s_streamVersion = QDataStream::Qt_5_15;
+}
+
 class UndoGroupPrivate
 {
 public:
@@ -39,17 +48,56 @@ public:
      */
     QString text;
 
+    /**
+     * Unique key of the group, see UndoGroup::key().
+     */
+    quint64 key = 0;
+
     /**
      * list of items contained
      */
     QList<UndoItem *> items;
+
+    /**
+     * Cached memory usage of the items, -1 if not yet computed.
+     */
+    qint64 memoryUsage = -1;
+
+    /**
+     * Device the items were spilled to, or nullptr if the items are loaded.
+     */
+    QIODevice * spillDevice = nullptr;
+
+    /**
+     * Location and item count of the spilled items in spillDevice.
+     */
+    qint64 spillOffset = 0;
+    int spillSize = 0;
+    int spillCount = 0;
+
+    /**
+     * Device that still holds the items at spillOffset after they were
+     * loaded again, or nullptr. Since loaded items are not modified until
+     * a new item is added, spilling them again reuses this data instead of
+     * appending it once more.
+     */
+    QIODevice * storedDevice = nullptr;
+
+    /**
+     * true, if the spilled items could not be loaded again.
+     */
+    bool loadFailed = false;
 };
 
 UndoGroup::UndoGroup(const QString & text, UndoManager * manager)
     : d(new UndoGroupPrivate())
 {
+    // keys are never reused within a process
+    static quint64 nextKey = 1;
+
     d->manager = manager;
     d->text = text;
+    d->key = nextKey++;
 }
 
 UndoGroup::~UndoGroup()
@@ -64,6 +112,11 @@ Document * UndoGroup::document() const
     return d->manager->document();
 }
 
+quint64 UndoGroup::key() const
+{
+    return d->key;
+}
+
 QString UndoGroup::text() const
 {
     return d->text;
@@ -71,52 +124,231 @@ QString UndoGroup::text() const
 
 bool UndoGroup::isEmpty() const
 {
-    return d->items.isEmpty();
+    return count() == 0;
 }
 
-void UndoGroup::undo()
+bool UndoGroup::undo()
 {
+    if (!ensureLoaded()) {
+        return false;
+    }
+
     for (int i = d->items.size() - 1; i >= 0; --i) {
         d->items[i]->undo();
     }
+    return true;
 }
 
-void UndoGroup::redo()
+bool UndoGroup::redo()
 {
+    if (!ensureLoaded()) {
+        return false;
+    }
+
     for (int i = 0; i < d->items.size(); ++i) {
         d->items[i]->redo();
     }
+    return true;
 }
 
-void UndoGroup::addItem(UndoItem *item)
+UndoItem * UndoGroup::addItem(UndoItem *item)
 {
+    ensureLoaded();
+    d->memoryUsage = -1;
+    d->storedDevice = nullptr;
+
     // only try merge, if undo item id's match
     const int lastUndoId = d->items.isEmpty() ? -1 : d->items.last()->id();
     const int newUndoId = item->id();
     if (lastUndoId >= 0 && lastUndoId == newUndoId && d->items.last()->mergeWith(item)) {
         delete item;
-    } else {
-        // add to this undo group
-        d->items.append(item);
-
-        // associate the UndoItem's group with this UndoGroup
-        item->setGroup(this);
+        return d->items.last();
     }
+
+    // add to this undo group
+    d->items.append(item);
+
+    // associate the UndoItem's group with this UndoGroup
+    item->setGroup(this);
+    return item;
 }
 
 QList<UndoItem *> UndoGroup::undoItems() const
 {
+    ensureLoaded();
     return d->items;
 }
 
 int UndoGroup::count() const
 {
-    return d->items.count();
+    return d->spillDevice ? d->spillCount : d->items.count();
+}
+
+qint64 UndoGroup::memoryUsage() const
+{
+    if (d->spillDevice) {
+        return 0;
+    }
+
+    if (d->memoryUsage < 0) {
+        d->memoryUsage = 0;
+        for (auto item : d->items) {
+            d->memoryUsage += item->memoryUsage();
+        }
+    }
+    return d->memoryUsage;
+}
+
+bool UndoGroup::isSpilled() const
+{
+    return d->spillDevice != nullptr;
+}
+
+bool UndoGroup::spill(QIODevice * device)
+{
+    Q_ASSERT(device && device->isOpen());
+
+    if (d->spillDevice) {
+        return true;
+    }
+
+    // unchanged items are still stored on the device
+    if (d->storedDevice == device) {
+        d->spillDevice = device;
+    } else if (!writeCompactData(device, compactData(), d->items.size())) {
+        return false;
+    }
+
+    qDeleteAll(d->items);
+    d->items.clear();
+    d->memoryUsage = -1;
+
+    return true;
+}
+
+QByteArray UndoGroup::compactData() const
+{
+    // spilled data is returned as is
+    if (d->spillDevice) {
+        if (!d->spillDevice->seek(d->spillOffset)) {
+            return QByteArray();
+        }
+        return d->spillDevice->read(d->spillSize);
+    }
+
+    // serialize: the type name is required to recreate each item
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(s_streamVersion);
+        for (auto item : d->items) {
+            stream << QByteArray(item->typeName());
+            item->saveCompact(stream);
+        }
+    }
+    return qCompress(data);
+}
+
+bool UndoGroup::attach(QIODevice * device, const QByteArray & data, int count)
+{
+    Q_ASSERT(device && device->isOpen());
+    Q_ASSERT(d->items.isEmpty() && !d->spillDevice);
+    Q_ASSERT(count >= 0);
+
+    // e.g. a history entry without data in the file
+    if (count > 0 && data.isEmpty()) {
+        return false;
+    }
+
+    return writeCompactData(device, data, count);
+}
+
+bool UndoGroup::writeCompactData(QIODevice * device, const QByteArray & data, int count)
+{
+    // append to the device
+    const qint64 offset = device->size();
+    if (!device->seek(offset) || device->write(data) != data.size()) {
+        qWarning() << "Unable to spill undo group" << d->text;
+        return false;
+    }
+
+    d->spillDevice = device;
+    d->storedDevice = device;
+    d->spillOffset = offset;
+    d->spillSize = data.size();
+    d->spillCount = count;
+
+    return true;
+}
+
+bool UndoGroup::ensureLoaded() const
+{
+    if (!d->spillDevice) {
+        return !d->loadFailed;
+    }
+
+    QIODevice * device = d->spillDevice;
+    d->spillDevice = nullptr;
+
+    QByteArray data;
+    if (device->seek(d->spillOffset)) {
+        data = device->read(d->spillSize);
+    }
+
+    // never apply a part of the group
+    if (createItems(document(), data, d->spillCount, d->items)) {
+        for (auto item : d->items) {
+            item->setGroup(const_cast<UndoGroup *>(this));
+        }
+    } else {
+        tikz::warn(QStringLiteral("Unable to restore the undo items of \"") + d->text + QStringLiteral("\"."));
+        d->loadFailed = true;
+    }
+
+    // let the manager account for the memory again
+    d->manager->groupLoaded(const_cast<UndoGroup *>(this));
+    return !d->loadFailed;
+}
+
+bool UndoGroup::createItems(Document * doc, const QByteArray & data, int count, QList<UndoItem *> & items)
+{
+    const QByteArray uncompressed = qUncompress(data);
+
+    UndoFactory factory(doc);
+    QDataStream stream(uncompressed);
+    stream.setVersion(s_streamVersion);
+    if (uncompressed.isEmpty() && count > 0) {
+        stream.setStatus(QDataStream::ReadPastEnd);
+    }
+
+    QList<UndoItem *> created;
+    for (int i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray type;
+        stream >> type;
+        UndoItem * item = factory.createItem(QString::fromLatin1(type));
+        if (!item) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        item->loadCompact(stream);
+        created.append(item);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qDeleteAll(created);
+        return false;
+    }
+
+    items = created;
+    return true;
 }
 
 void UndoGroup::printTree()
 {
     QString str = "group: " + text();
+    if (d->spillDevice) {
+        str += " (spilled)";
+    }
     for (auto item : d->items) {
         str += " -->" + item->text();
     }
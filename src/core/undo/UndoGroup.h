@@ -20,9 +20,12 @@
 #ifndef TIKZ_CORE_UNDO_GROUP_H
 #define TIKZ_CORE_UNDO_GROUP_H
 
+#include <QByteArray>
 #include <QObject>
 #include <QString>
 
+class QIODevice;
+
 namespace tikz {
 namespace core {
 
@@ -57,6 +60,13 @@ public:
      */
     QString text() const;
 
+    /**
+     * Returns a key that identifies this group. In contrast to pointers
+     * and the serials of the UndoStack, keys are never reused within a
+     * process, so that data derived from a group can be cached by its key.
+     */
+    quint64 key() const;
+
 public:
     /**
      * is this undogroup empty?
@@ -65,13 +75,17 @@ public:
 
     /**
      * Undo the contained undo items.
+     * Returns @e false, if the spilled undo items could not be loaded
+     * again. In this case, no undo item is applied.
      */
-    void undo();
+    bool undo();
 
     /**
      * Redo the contained undo items.
+     * Returns @e false, if the spilled undo items could not be loaded
+     * again. In this case, no undo item is applied.
      */
-    void redo();
+    bool redo();
 
 public:
     /**
@@ -79,8 +93,10 @@ public:
      * If possible, @p item is merged with the last item in this undo group.
      * If a merge was performed, the @p item pointer is invalid afterwards,
      * so never access @p item after adding an item to a group.
+     * @return the undo item that now holds the change of @p item, i.e.
+     *         either @p item, or the last item @p item was merged into
      */
-    void addItem(UndoItem * item);
+    UndoItem * addItem(UndoItem * item);
 
     /**
      * Returns a list of all undo items.
@@ -93,6 +109,73 @@ public:
      */
     int count() const;
 
+//
+// memory management
+//
+public:
+    /**
+     * Returns the estimated memory in bytes held by the undo items.
+     * If the undo items are spilled, 0 is returned.
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * Returns @e true, if the undo items were written to disk with spill().
+     */
+    bool isSpilled() const;
+
+    /**
+     * Writes all undo items in a compressed binary form to the end of
+     * @p device and deletes them. The items are transparently loaded again
+     * as soon as they are accessed, e.g. by undo() or undoItems().
+     * The @p device must stay open as long as this group exists.
+     * If the items were loaded from @p device and not changed since, they
+     * are not written again.
+     * @return @e true on success. On error, the undo items are kept.
+     */
+    bool spill(QIODevice * device);
+
+    /**
+     * Returns all undo items in the compressed binary form that spill()
+     * writes. If the items are spilled, the data is read from disk without
+     * creating the items.
+     */
+    QByteArray compactData() const;
+
+    /**
+     * Attaches @p count undo items in the compressed binary form @p data,
+     * as returned by compactData(), to this empty group. Like for spill(),
+     * @p data is written to the end of @p device, and the items are created
+     * only once they are accessed.
+     * @return @e true on success, @e false on a write error or if @p data
+     *         is empty although @p count is not 0.
+     */
+    bool attach(QIODevice * device, const QByteArray & data, int count);
+
+    /**
+     * Creates the @p count undo items of the compressed binary form @p data,
+     * as returned by compactData(), for the Document @p doc. In contrast to
+     * attach(), the items are created immediately, and are not added to
+     * any group. The items are neither executed.
+     * @return @e true on success. On error, @p items is left unchanged.
+     */
+    static bool createItems(Document * doc, const QByteArray & data, int count,
+                            QList<UndoItem *> & items);
+
+private:
+    /**
+     * Writes @p data of @p count undo items to the end of @p device, and
+     * marks this group as spilled.
+     */
+    bool writeCompactData(QIODevice * device, const QByteArray & data, int count);
+
+    /**
+     * Loads the undo items again, if they were spilled.
+     * Returns @e false, if the items could not be restored. Then the
+     * group stays empty, and the error is logged.
+     */
+    bool ensureLoaded() const;
+
 public:
     // debugging
     void printTree();
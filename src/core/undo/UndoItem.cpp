@@ -19,6 +19,11 @@
 
 #include "UndoItem.h"
 #include "Document.h"
+#include "Uid.h"
+#include "Value.h"
+#include "Pos.h"
+
+#include <QDataStream>
 
 namespace tikz {
 namespace core {
@@ -68,6 +73,12 @@ QString UndoItem::text() const
     return d->text;
 }
 
+qint64 UndoItem::memoryUsage() const
+{
+    return static_cast<qint64>(sizeof(UndoItem) + sizeof(UndoItemPrivate))
+         + d->text.capacity() * static_cast<qint64>(sizeof(QChar));
+}
+
 int UndoItem::id() const
 {
     return -1;
@@ -101,6 +112,103 @@ QJsonObject UndoItem::save() const
 
 }
 
+void UndoItem::loadCompact(QDataStream & stream)
+{
+    stream >> d->text;
+    loadCompactData(stream);
+}
+
+void UndoItem::saveCompact(QDataStream & stream) const
+{
+    stream << d->text;
+    saveCompactData(stream);
+}
+
+void UndoItem::writeUid(QDataStream & stream, const Uid & uid)
+{
+    stream << uid.id();
+}
+
+Uid UndoItem::readUid(QDataStream & stream)
+{
+    qint64 id;
+    stream >> id;
+    return (id >= 0) ? Uid(id, document()) : Uid();
+}
+
+namespace {
+    // tags of writeVariant()
+    enum VariantTag : qint8 {
+        PlainVariant = 0,
+        ValueVariant,
+        PosVariant,
+        UidVariant,
+        EnumVariant
+    };
+}
+
+void UndoItem::writeVariant(QDataStream & stream, const QVariant & value)
+{
+    const int type = value.userType();
+    if (type == qMetaTypeId<tikz::Value>()) {
+        stream << static_cast<qint8>(ValueVariant) << value.value<tikz::Value>();
+    } else if (type == qMetaTypeId<tikz::Pos>()) {
+        stream << static_cast<qint8>(PosVariant) << value.value<tikz::Pos>();
+    } else if (type == qMetaTypeId<Uid>()) {
+        stream << static_cast<qint8>(UidVariant);
+        writeUid(stream, value.value<Uid>());
+    } else if (QMetaType::typeFlags(type) & QMetaType::IsEnumeration) {
+        // enums such as tikz::Shape have no stream operators
+        stream << static_cast<qint8>(EnumVariant)
+               << QByteArray(QMetaType::typeName(type))
+               << static_cast<qint64>(value.toLongLong());
+    } else {
+        stream << static_cast<qint8>(PlainVariant) << value;
+    }
+}
+
+QVariant UndoItem::readVariant(QDataStream & stream)
+{
+    qint8 tag;
+    stream >> tag;
+    switch (tag) {
+        case ValueVariant: {
+            tikz::Value value;
+            stream >> value;
+            return QVariant::fromValue(value);
+        }
+        case PosVariant: {
+            tikz::Pos pos;
+            stream >> pos;
+            return QVariant::fromValue(pos);
+        }
+        case UidVariant:
+            return QVariant::fromValue(readUid(stream));
+        case EnumVariant: {
+            QByteArray typeName;
+            qint64 number = 0;
+            stream >> typeName >> number;
+
+            // construct the enum from an integer of the same size
+            const int type = QMetaType::type(typeName.constData());
+            switch (type != QMetaType::UnknownType ? QMetaType::sizeOf(type) : 0) {
+                case 1: { const qint8 v = static_cast<qint8>(number); return QVariant(type, &v); }
+                case 2: { const qint16 v = static_cast<qint16>(number); return QVariant(type, &v); }
+                case 4: { const qint32 v = static_cast<qint32>(number); return QVariant(type, &v); }
+                case 8: return QVariant(type, &number);
+                default: break;
+            }
+            stream.setStatus(QDataStream::ReadCorruptData);
+            return QVariant();
+        }
+        default: {
+            QVariant value;
+            stream >> value;
+            return value;
+        }
+    }
+}
+
 UndoGroup * UndoItem::group() const
 {
     return d->group;
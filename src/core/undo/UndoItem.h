@@ -24,6 +24,9 @@
 
 #include <QString>
 #include <QJsonObject>
+#include <QVariant>
+
+class QDataStream;
 
 namespace tikz {
 namespace core {
@@ -31,6 +34,7 @@ namespace core {
 class Document;
 class UndoGroup;
 class UndoItemPrivate;
+class Uid;
 
 /**
  * Base class for undo/redo items.
@@ -74,6 +78,20 @@ public:
      */
     virtual void undo() = 0;
 
+    /**
+     * Returns the type name of this undo item, e.g. "node-set-pos".
+     * UndoFactory::createItem() creates an undo item for this name.
+     */
+    virtual const char * typeName() const = 0;
+
+    /**
+     * Returns an estimate of the heap memory in bytes held by this item.
+     * The UndoManager uses this estimate to keep the undo history within
+     * its memory budget. The default implementation accounts for the
+     * object and its text, reimplement if an item holds more data.
+     */
+    virtual qint64 memoryUsage() const;
+
     /**
      * Returns the uniq undo item identifier of this undo item.
      * Whenever two successive undo items have the same id, the function
@@ -124,6 +142,62 @@ protected:
      */
     virtual QJsonObject saveData() const = 0;
 
+//
+// compact binary serialization
+//
+public:
+    /**
+     * Load the complete undo and redo state from @p stream.
+     * In contrast to load(), no state is read from the Document, so that
+     * an item can be restored at any time.
+     */
+    void loadCompact(QDataStream & stream);
+
+    /**
+     * Write the complete undo and redo state to @p stream.
+     */
+    void saveCompact(QDataStream & stream) const;
+
+protected:
+    /**
+     * Load the undo and redo state from @p stream.
+     */
+    virtual void loadCompactData(QDataStream & stream) = 0;
+
+    /**
+     * Write the undo and redo state to @p stream.
+     */
+    virtual void saveCompactData(QDataStream & stream) const = 0;
+
+    /**
+     * Helper to write @p uid to @p stream. The generation is not written,
+     * since the compact form is also stored in files, see Document::saveAs().
+     */
+    static void writeUid(QDataStream & stream, const Uid & uid);
+
+    /**
+     * Helper to read a Uid written with writeUid() from @p stream.
+     * The returned Uid is associated with document(), and not bound to
+     * a generation.
+     */
+    Uid readUid(QDataStream & stream);
+
+    /**
+     * Helper to write the property value @p value to @p stream.
+     * In contrast to QVariant's stream operator, this also supports
+     * tikz::Value, tikz::Pos and tikz::core::Uid values, and enums
+     * registered with Q_ENUM_NS such as tikz::Shape. Enums are written
+     * by type name and value.
+     */
+    static void writeVariant(QDataStream & stream, const QVariant & value);
+
+    /**
+     * Helper to read a value written with writeVariant() from @p stream.
+     * If the value cannot be restored, e.g. for an unknown enum type, the
+     * status of @p stream is set to QDataStream::ReadCorruptData.
+     */
+    QVariant readVariant(QDataStream & stream);
+
 // group information
 public:
     /**
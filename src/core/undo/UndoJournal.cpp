@@ -0,0 +1,268 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "UndoJournal.h"
+#include "UndoGroup.h"
+#include "UndoItem.h"
+#include "UndoFactory.h"
+#include "Document.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+namespace tikz {
+namespace core {
+
+namespace {
+    // file header: magic number and format version. Version 1 stored
+    // property ids, which differ between application runs.
+    constexpr quint32 s_magic = 0x544b4a4e; // "TKJN"
+    constexpr quint32 s_version = 2;
+    constexpr qint64 s_headerSize = 2 * sizeof(quint32);
+
+    // QDataStream version of all records
+    constexpr int s_streamVersion = QDataStream::Qt_5_15;
+
+    // record kinds
+    enum RecordKind : quint8 {
+        CommitRecord = 1,
+        UndoRecord,
+        RedoRecord
+    };
+
+    // reads the record at the current position of @p file.
+    // Returns false at the end of the file, or at an incomplete record.
+    bool readRecord(QFile & file, quint8 & kind, QByteArray & payload)
+    {
+        QDataStream stream(&file);
+        quint32 size = 0;
+        quint16 checksum = 0;
+        stream >> size >> kind >> checksum;
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+
+        payload = file.read(size);
+        return payload.size() == static_cast<int>(size)
+            && qChecksum(payload.constData(), payload.size()) == checksum;
+    }
+
+    // reads the file header of @p file
+    bool readHeader(QFile & file)
+    {
+        QDataStream stream(&file);
+        quint32 magic = 0;
+        quint32 version = 0;
+        stream >> magic >> version;
+        return stream.status() == QDataStream::Ok
+            && magic == s_magic
+            && version == s_version;
+    }
+}
+
+UndoJournal::~UndoJournal()
+{
+    close();
+}
+
+bool UndoJournal::open(const QString & filename, bool truncate)
+{
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Unable to open the journal" << filename;
+        return false;
+    }
+
+    if (!truncate && readHeader(m_file)) {
+        // drop an incomplete record at the end, e.g. after a crash
+        qint64 end = m_file.pos();
+        quint8 kind;
+        QByteArray payload;
+        while (readRecord(m_file, kind, payload)) {
+            end = m_file.pos();
+        }
+        m_file.resize(end);
+    } else {
+        m_file.resize(0);
+        m_file.seek(0);
+        if (!writeHeader()) {
+            close();
+            return false;
+        }
+    }
+
+    // append all records
+    m_file.seek(m_file.size());
+    return true;
+}
+
+void UndoJournal::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool UndoJournal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString UndoJournal::fileName() const
+{
+    return m_file.fileName();
+}
+
+bool UndoJournal::truncate()
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    return m_file.resize(s_headerSize) && m_file.seek(s_headerSize);
+}
+
+bool UndoJournal::writeHeader()
+{
+    Q_ASSERT(m_file.size() == 0);
+
+    QDataStream stream(&m_file);
+    stream << s_magic << s_version;
+    return m_file.flush() && stream.status() == QDataStream::Ok;
+}
+
+void UndoJournal::appendCommit(UndoGroup * group)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    const auto items = group->undoItems();
+
+    QByteArray payload;
+    {
+        QDataStream stream(&payload, QIODevice::WriteOnly);
+        stream.setVersion(s_streamVersion);
+        stream << group->text() << static_cast<quint32>(items.size());
+        for (auto item : items) {
+            const int typeId = UndoFactory::typeId(item->typeName());
+            Q_ASSERT(typeId >= 0 && typeId < 256);
+            stream << static_cast<quint8>(typeId);
+            item->saveCompact(stream);
+        }
+    }
+
+    appendRecord(CommitRecord, payload);
+}
+
+void UndoJournal::appendUndo()
+{
+    appendRecord(UndoRecord, QByteArray());
+}
+
+void UndoJournal::appendRedo()
+{
+    appendRecord(RedoRecord, QByteArray());
+}
+
+void UndoJournal::appendRecord(quint8 kind, const QByteArray & payload)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    // record: size, kind, checksum, payload. One write() per record,
+    // so that a crash leaves at most the last record incomplete.
+    QByteArray record;
+    record.reserve(payload.size() + 7);
+    {
+        QDataStream stream(&record, QIODevice::WriteOnly);
+        stream << static_cast<quint32>(payload.size()) << kind
+               << qChecksum(payload.constData(), payload.size());
+    }
+    record.append(payload);
+
+    if (m_file.write(record) != record.size() || !m_file.flush()) {
+        qWarning() << "Unable to write to the journal" << m_file.fileName();
+    }
+}
+
+int UndoJournal::replay(const QString & filename, Document * doc)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly) || !readHeader(file)) {
+        return -1;
+    }
+
+    UndoFactory factory(doc);
+    int records = 0;
+    quint8 kind = 0;
+    QByteArray payload;
+    while (readRecord(file, kind, payload)) {
+        if (kind == UndoRecord) {
+            doc->undo();
+        } else if (kind == RedoRecord) {
+            doc->redo();
+        } else if (kind == CommitRecord) {
+            QDataStream stream(payload);
+            stream.setVersion(s_streamVersion);
+            QString text;
+            quint32 count = 0;
+            stream >> text >> count;
+
+            doc->beginTransaction(text);
+            for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+                quint8 typeId = 0;
+                stream >> typeId;
+                UndoItem * item = factory.createItem(typeId);
+                if (!item) {
+                    qWarning() << "Unknown undo item type" << typeId << "in journal" << filename;
+                    stream.setStatus(QDataStream::ReadCorruptData);
+                    break;
+                }
+                item->loadCompact(stream);
+                if (stream.status() != QDataStream::Ok) {
+                    qWarning() << "Corrupt undo item in journal" << filename;
+                    delete item;
+                    break;
+                }
+                doc->addUndoItem(item);
+            }
+
+            // never replay a part of a transaction, and stop at the first error,
+            // since all later records depend on this one
+            if (stream.status() != QDataStream::Ok) {
+                doc->cancelTransaction();
+                break;
+            }
+            doc->finishTransaction();
+        }
+
+        ++records;
+    }
+
+    return records;
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,137 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_UNDO_JOURNAL_H
+#define TIKZ_CORE_UNDO_JOURNAL_H
+
+#include <QFile>
+#include <QString>
+
+namespace tikz {
+namespace core {
+
+class Document;
+class UndoGroup;
+
+/**
+ * Append-only journal of the undo history, used for autosave.
+ *
+ * The UndoManager appends a record for each committed undo group, and for
+ * each undo() and redo(). A commit record holds the undo items in their
+ * compact binary form (see UndoItem::saveCompact()), each prefixed by its
+ * compact type id (see UndoFactory::typeId()). Therefore, appending costs
+ * about as much as writing the undo items themselves, independent of the
+ * size of the Document.
+ *
+ * Each record is written with a single write() followed by flush(), and
+ * carries its size and a checksum. If the application crashes while a
+ * record is written, replay() stops at the last complete record. The file
+ * is not synced to disk, so a crash of the operating system may still lose
+ * the latest records.
+ *
+ * The journal always holds the changes since the Document was saved the
+ * last time, so a successful save truncates the journal.
+ */
+class UndoJournal
+{
+public:
+    /**
+     * Constructor. The journal is not open.
+     */
+    UndoJournal() = default;
+
+    /**
+     * Destructor, closes the journal.
+     */
+    ~UndoJournal();
+
+    /**
+     * Opens the journal @p filename for writing. If @p truncate is @e true,
+     * all existing records are removed. Otherwise, new records are appended
+     * to the existing ones.
+     * @return @e true on success
+     */
+    bool open(const QString & filename, bool truncate);
+
+    /**
+     * Closes the journal. The file is kept.
+     */
+    void close();
+
+    /**
+     * Returns @e true, if the journal is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * Returns the file name of the journal.
+     */
+    QString fileName() const;
+
+    /**
+     * Removes all records, e.g. after the Document was saved.
+     */
+    bool truncate();
+
+    /**
+     * Appends a record for the committed undo group @p group.
+     */
+    void appendCommit(UndoGroup * group);
+
+    /**
+     * Appends a record for UndoManager::undo().
+     */
+    void appendUndo();
+
+    /**
+     * Appends a record for UndoManager::redo().
+     */
+    void appendRedo();
+
+    /**
+     * Applies all complete records of the journal @p filename to @p doc.
+     * Commit records are added to the undo history of @p doc like any
+     * other transaction.
+     * @return the number of applied records, or -1 if @p filename is not
+     *         a journal
+     */
+    static int replay(const QString & filename, Document * doc);
+
+private:
+    /**
+     * Writes the record @p payload of kind @p kind.
+     */
+    void appendRecord(quint8 kind, const QByteArray & payload);
+
+    /**
+     * Writes the file header, the file must be empty.
+     */
+    bool writeHeader();
+
+private:
+    // the journal file
+    QFile m_file;
+};
+
+}
+}
+
+#endif // TIKZ_CORE_UNDO_JOURNAL_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -21,10 +21,17 @@
 #include "Document.h"
 #include "UndoItem.h"
 #include "UndoGroup.h"
+#include "UndoStack.h"
+#include "UndoJournal.h"
+#include "Uid.h"
 
 #include <QAction>
+#include <QMultiHash>
 #include <QIcon>
 #include <QPointer>
+#include <QTemporaryFile>
+
+#include <memory>
 
 namespace tikz {
 namespace core {
@@ -37,9 +44,10 @@ public:
     Document* doc = nullptr;
 
     /**
-     * Pointer to the clean undo group.
+     * Cursor position of the clean state, see UndoStack::cursor().
+     * If the clean state cannot be reached anymore, the value is -1.
      */
-    UndoGroup * cleanUndoGroup = nullptr;
+    int cleanIndex = 0;
 
     /**
      * Track previous clean state.
@@ -47,14 +55,14 @@ public:
     bool wasClean = true;
 
     /**
-     * Holds all undo items.
+     * Holds all undo and redo groups.
      */
-    QList<UndoGroup *> undoItems;
+    UndoStack groups;
 
     /**
-     * Holds all redo items.
+     * Maximum number of undo groups, 0 for no limit.
      */
-    QList<UndoGroup *> redoItems;
+    int undoLimit = 0;
 
     /**
      * Holds the items of a currently pending transaction.
@@ -72,22 +80,115 @@ public:
      */
     bool transactionCanceled = false;
 
+    /**
+     * Autosave journal, see UndoManager::openJournal().
+     */
+    UndoJournal journal;
+
+    /**
+     * Flag that is set to true, if the pending transaction is a gesture.
+     */
+    bool gesture = false;
+
+    /**
+     * Undo items recorded in the running gesture, by entity. The items
+     * are owned by currentUndoGroup.
+     */
+    QMultiHash<Uid, UndoItem *> gestureItems;
+
+    /**
+     * Memory budget in bytes, see UndoManager::setMemoryBudget().
+     */
+    qint64 memoryBudget = 128 * 1024 * 1024;
+
+    /**
+     * Estimated memory in bytes of all loaded undo groups.
+     */
+    qint64 memoryUsage = 0;
+
+    /**
+     * Temporary file the undo groups are spilled to, created on demand.
+     */
+    std::unique_ptr<QTemporaryFile> spillFile;
+
+    /**
+     * All undo groups with an index less than spillHint are spilled.
+     */
+    int spillHint = 0;
+
 public: // helper functions
     UndoGroup * groupForRow(int row) const
     {
-        if (row < 0) {
+        if (row < 0 || row >= groups.count()) {
             return nullptr;
         }
+        return groups.at(row);
+    }
+
+    // top-level rows have the internal id 0, child rows the serial of
+    // their group plus 1, see UndoStack::serial().
+    int rowForInternalId(quintptr id) const
+    {
+        return groups.indexOfSerial(static_cast<qint64>(id) - 1);
+    }
+
+    QIODevice * spillDevice()
+    {
+        if (!spillFile) {
+            spillFile.reset(new QTemporaryFile());
+            if (!spillFile->open()) {
+                qWarning() << "Unable to create temporary file for the undo history";
+            }
+        }
+        return spillFile->isOpen() ? spillFile.get() : nullptr;
+    }
+
+    bool spillGroup(UndoGroup * group, QIODevice * device)
+    {
+        if (group->isSpilled()) {
+            return true;
+        }
 
-        if (row < undoItems.size()) {
-            // an undo item
-            return undoItems[row];
-        } else if (row < undoItems.size() + redoItems.size()) {
-            // a redo item
-            return redoItems[row - undoItems.size()];
+        const qint64 usage = group->memoryUsage();
+        if (!group->spill(device)) {
+            return false;
         }
 
-        return nullptr;
+        memoryUsage -= usage;
+        return true;
+    }
+
+    void enforceMemoryBudget()
+    {
+        if (memoryBudget <= 0 || memoryUsage <= memoryBudget) {
+            return;
+        }
+
+        QIODevice * device = spillDevice();
+        if (!device) {
+            return;
+        }
+
+        // first spill the oldest undo groups, but keep the current one
+        while (spillHint < groups.cursor() - 1 && memoryUsage > memoryBudget) {
+            if (!spillGroup(groups.at(spillHint), device)) {
+                return;
+            }
+            ++spillHint;
+        }
+
+        // then the redo groups farthest away, but keep the next one
+        for (int i = groups.count() - 1; i > groups.cursor() && memoryUsage > memoryBudget; --i) {
+            if (!spillGroup(groups.at(i), device)) {
+                return;
+            }
+        }
+    }
+
+    void deleteGroup(UndoGroup * group)
+    {
+        memoryUsage -= group->memoryUsage();
+        delete group;
     }
 };
 
@@ -113,45 +214,59 @@ Document* UndoManager::document()
 void UndoManager::setClean()
 {
     if (! isClean()) {
-        d->cleanUndoGroup = d->undoItems.isEmpty() ? nullptr : d->undoItems.last();
+        // repaint the decoration of the old and the new clean group
+        const int oldRow = d->cleanIndex - 1;
+        d->cleanIndex = d->groups.cursor();
+        if (oldRow >= 0 && oldRow < d->groups.count()) {
+            Q_EMIT dataChanged(index(oldRow, 0), index(oldRow, 0), {Qt::DecorationRole});
+        }
+        if (d->cleanIndex > 0) {
+            const QModelIndex cleanIndex = index(d->cleanIndex - 1, 0);
+            Q_EMIT dataChanged(cleanIndex, cleanIndex, {Qt::DecorationRole});
+        }
+
         Q_EMIT cleanChanged(true);
     }
 }
 
 bool UndoManager::isClean() const
 {
-    return d->cleanUndoGroup == (d->undoItems.isEmpty() ? nullptr : d->undoItems.last());
+    return d->cleanIndex == d->groups.cursor();
 }
 
 bool UndoManager::undoAvailable() const
 {
-    return ! d->undoItems.isEmpty();
+    return d->groups.cursor() > 0;
 }
 
 bool UndoManager::redoAvailable() const
 {
-    return ! d->redoItems.isEmpty();
+    return d->groups.redoCount() > 0;
 }
 
 void UndoManager::undo()
 {
-    if (! d->undoItems.isEmpty()) {
+    if (undoAvailable()) {
         const bool oldClean = isClean();
 
         // perform undo action
         const bool wasActive = document()->setUndoActive(true);
-        d->undoItems.last()->undo();
+        const bool ok = d->groups.undoGroup()->undo();
         document()->setUndoActive(wasActive);
 
-        d->redoItems.prepend(d->undoItems.last());
-        d->undoItems.removeLast();
+        // the history beyond a corrupt group cannot be undone
+        if (!ok) {
+            return;
+        }
+
+        d->groups.undo();
+        d->journal.appendUndo();
+        d->enforceMemoryBudget();
 
         // send dataChanged() signal, since the current undo item is bold (needs repaint)
-        const int startRow = d->undoItems.size();
-        QModelIndex startIndex = index(startRow, 0);
-        QModelIndex endIndex = index(startRow + 1, 0);
+        const int row = d->groups.cursor();
         const QVector<int> roles {Qt::FontRole};
-        Q_EMIT dataChanged(startIndex, endIndex, roles);
+        Q_EMIT dataChanged(index(qMax(0, row - 1), 0), index(row, 0), roles);
 
         // emit cleanChanged() if required
         const bool newClean = isClean();
@@ -163,22 +278,25 @@ void UndoManager::undo()
 
 void UndoManager::redo()
 {
-    if (! d->redoItems.isEmpty()) {
+    if (redoAvailable()) {
         const bool oldClean = isClean();
 
         const bool wasActive = document()->setUndoActive(true);
-        d->redoItems.first()->redo();
+        const bool ok = d->groups.redoGroup()->redo();
         document()->setUndoActive(wasActive);
 
-        d->undoItems.append(d->redoItems.first());
-        d->redoItems.removeFirst();
+        if (!ok) {
+            return;
+        }
+
+        d->groups.redo();
+        d->journal.appendRedo();
+        d->enforceMemoryBudget();
 
         // send dataChanged() signal, since the current undo item is bold (needs repaint)
-        const int startRow = d->undoItems.size() - 1;
-        QModelIndex startIndex = index(startRow, 0);
-        QModelIndex endIndex = index(startRow + 1, 0);
+        const int row = d->groups.cursor() - 1;
         const QVector<int> roles {Qt::FontRole};
-        Q_EMIT dataChanged(startIndex, endIndex, roles);
+        Q_EMIT dataChanged(index(qMax(0, row - 1), 0), index(row, 0), roles);
 
         const bool newClean = isClean();
         if (oldClean != newClean) {
@@ -189,24 +307,30 @@ void UndoManager::redo()
 
 void UndoManager::clear()
 {
-    beginResetModel();
-
-    // a group for a clean state does not exist anymore
-    d->cleanUndoGroup = nullptr;
-
     // delete undo and redo items
-    qDeleteAll(d->undoItems);
-    qDeleteAll(d->redoItems);
+    if (!d->groups.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, d->groups.count() - 1);
+        for (int i = 0; i < d->groups.count(); ++i) {
+            d->deleteGroup(d->groups.at(i));
+        }
+        d->groups.clear();
+        endRemoveRows();
+    }
+    Q_ASSERT(d->memoryUsage == 0);
 
-    d->undoItems.clear();
-    d->redoItems.clear();
+    // the clean state is the empty history
+    d->cleanIndex = 0;
+
+    // all spilled groups are gone, so start with a fresh file
+    d->spillFile.reset();
+    d->spillHint = 0;
 
     // delete/reset pending transaction data
+    d->gestureItems.clear();
+    d->gesture = false;
     delete d->currentUndoGroup;
     d->currentUndoGroup = nullptr;
     d->transactionRefCount = 0;
-
-    endResetModel();
 }
 
 void UndoManager::addUndoItem(UndoItem * item)
@@ -238,7 +362,43 @@ void UndoManager::addUndoItem(UndoItem * item)
 
 QList<UndoGroup*> UndoManager::undoGroups() const
 {
-    return d->undoItems;
+    QList<UndoGroup*> list;
+    list.reserve(d->groups.cursor());
+    for (int i = 0; i < d->groups.cursor(); ++i) {
+        list.append(d->groups.at(i));
+    }
+    return list;
+}
+
+bool UndoManager::attachGroup(const QString & text, const QByteArray & data, int count)
+{
+    Q_ASSERT(!redoAvailable());
+    Q_ASSERT(!transactionActive());
+
+    QIODevice * device = d->spillDevice();
+    if (!device) {
+        return false;
+    }
+
+    auto group = new UndoGroup(text, this);
+    if (!group->attach(device, data, count)) {
+        delete group;
+        return false;
+    }
+
+    const int rowIndex = d->groups.count();
+    beginInsertRows(QModelIndex(), rowIndex, rowIndex);
+    d->groups.push(group);
+    endInsertRows();
+
+    // the group is spilled, so enforceMemoryBudget() can skip it
+    if (d->spillHint == rowIndex) {
+        ++d->spillHint;
+    }
+
+    enforceUndoLimit();
+
+    return true;
 }
 
 void UndoManager::startTransaction(const QString & text)
@@ -265,11 +425,14 @@ void UndoManager::cancelTransaction()
 
     // undo all, and delete group
     d->transactionCanceled = true;
+    const bool wasActive = document()->setUndoActive(true);
+    d->gestureItems.clear();
     if (d->currentUndoGroup) {
         d->currentUndoGroup->undo();
         delete d->currentUndoGroup;
         d->currentUndoGroup = nullptr;
     }
+    document()->setUndoActive(wasActive);
 }
 
 void UndoManager::commitTransaction()
@@ -283,6 +446,9 @@ void UndoManager::commitTransaction()
         return;
     }
 
+    // the gesture ends with the outermost transaction
+    d->gesture = false;
+
     // if the transaction was canceled, there is nothing to do.
     if (d->transactionCanceled) {
         Q_ASSERT(! d->currentUndoGroup);
@@ -290,6 +456,9 @@ void UndoManager::commitTransaction()
         return;
     }
 
+    // the undo items of the gesture are already in the group
+    d->gestureItems.clear();
+
     // calling startTransaction() immediately followed by commitTransaction()
     // will create an empty pending undo group. We don't want empty groups.
     if (d->currentUndoGroup && d->currentUndoGroup->isEmpty()) {
@@ -301,28 +470,43 @@ void UndoManager::commitTransaction()
     //
     // ok, now the real work: add to undo stack
     //
-    const int rowIndex = d->undoItems.count();
+    const int rowIndex = d->groups.cursor();
 
     // first: clear redo items
-    if (! d->redoItems.isEmpty()) {
-        beginRemoveRows(index(rowIndex, 0), rowIndex, rowIndex + d->redoItems.count());
-        removeRows(rowIndex, d->redoItems.count());
-        qDeleteAll(d->redoItems);
-        d->redoItems.clear();
+    if (redoAvailable()) {
+        beginRemoveRows(QModelIndex(), rowIndex, d->groups.count() - 1);
+        while (d->groups.redoCount() > 0) {
+            d->deleteGroup(d->groups.takeLast());
+        }
         endRemoveRows();
+
+        // a clean state among the redo groups cannot be reached anymore
+        if (d->cleanIndex > rowIndex) {
+            d->cleanIndex = -1;
+        }
     }
 
     // next: add pending undo group
-    {
-        beginInsertRows(index(rowIndex, 0), rowIndex, rowIndex + 1);
+    UndoGroup * group = d->currentUndoGroup;
+    beginInsertRows(QModelIndex(), rowIndex, rowIndex);
+    d->groups.push(group);
+    d->memoryUsage += group->memoryUsage();
+    d->currentUndoGroup = nullptr;
+    endInsertRows();
 
-        insertRows(rowIndex, 1);
-        d->undoItems.append(d->currentUndoGroup);
-        d->currentUndoGroup = nullptr;
+    // autosave, before the group may be spilled
+    d->journal.appendCommit(group);
 
-        endInsertRows();
+    // the previous group is not bold anymore
+    if (rowIndex > 0) {
+        const QModelIndex previous = index(rowIndex - 1, 0);
+        Q_EMIT dataChanged(previous, previous, {Qt::FontRole});
     }
 
+    // keep the history within its limits
+    enforceUndoLimit();
+    d->enforceMemoryBudget();
+
     // track clean state
     if (d->wasClean) {
         Q_EMIT cleanChanged(false);
@@ -334,58 +518,157 @@ bool UndoManager::transactionActive() const
     return d->transactionRefCount > 0;
 }
 
+void UndoManager::startGesture(const QString & text)
+{
+    startTransaction(text);
+    d->gesture = true;
+}
+
+bool UndoManager::gestureActive() const
+{
+    return d->gesture && d->currentUndoGroup;
+}
+
+UndoItem * UndoManager::gestureItem(const Uid & uid, const char * typeName) const
+{
+    for (auto it = d->gestureItems.constFind(uid); it != d->gestureItems.cend() && it.key() == uid; ++it) {
+        if (qstrcmp(it.value()->typeName(), typeName) == 0) {
+            return it.value();
+        }
+    }
+    return nullptr;
+}
+
+void UndoManager::addGestureItem(const Uid & uid, UndoItem * item)
+{
+    Q_ASSERT(item);
+    Q_ASSERT(gestureActive());
+
+    // the item is added to the group right away, so that undo reverts it
+    // in the order it was recorded relative to all other undo items.
+    // Since it may be merged, keep track of the item holding the change.
+    d->gestureItems.insert(uid, d->currentUndoGroup->addItem(item));
+}
+
+void UndoManager::setUndoLimit(int limit)
+{
+    d->undoLimit = qMax(0, limit);
+    enforceUndoLimit();
+}
+
+int UndoManager::undoLimit() const
+{
+    return d->undoLimit;
+}
+
+void UndoManager::enforceUndoLimit()
+{
+    const int excess = d->undoLimit > 0 ? d->groups.cursor() - d->undoLimit : 0;
+    if (excess <= 0) {
+        return;
+    }
+
+    // remove the oldest groups
+    beginRemoveRows(QModelIndex(), 0, excess - 1);
+    for (int i = 0; i < excess; ++i) {
+        d->deleteGroup(d->groups.takeFirst());
+    }
+    endRemoveRows();
+
+    // the clean state may have been removed as well
+    d->cleanIndex = d->cleanIndex >= excess ? d->cleanIndex - excess : -1;
+    d->spillHint = qMax(0, d->spillHint - excess);
+}
+
+bool UndoManager::openJournal(const QString & filename, bool truncate)
+{
+    return d->journal.open(filename, truncate);
+}
+
+void UndoManager::closeJournal()
+{
+    d->journal.close();
+}
+
+QString UndoManager::journalFile() const
+{
+    return d->journal.isOpen() ? d->journal.fileName() : QString();
+}
+
+bool UndoManager::truncateJournal()
+{
+    return d->journal.truncate();
+}
+
+void UndoManager::setMemoryBudget(qint64 bytes)
+{
+    d->memoryBudget = bytes;
+    d->enforceMemoryBudget();
+}
+
+qint64 UndoManager::memoryBudget() const
+{
+    return d->memoryBudget;
+}
+
+qint64 UndoManager::memoryUsage() const
+{
+    return d->memoryUsage;
+}
+
+void UndoManager::groupLoaded(UndoGroup * group)
+{
+    d->memoryUsage += group->memoryUsage();
+
+    // typically, the current undo group is loaded by undo()
+    const int index = group == d->groups.undoGroup() ? d->groups.cursor() - 1 : 0;
+    d->spillHint = qMin(d->spillHint, index);
+}
+
 QModelIndex UndoManager::index(int row, int column, const QModelIndex & parent) const
 {
     // currently, we only support one column
-    if (column != 0) {
+    if (column != 0 || row < 0) {
         return QModelIndex();
     }
 
     // a top-level item is requested
     if (!parent.isValid()) {
-        auto group = d->groupForRow(row);
-        if (!group) {
+        if (row >= d->groups.count()) {
             return QModelIndex();
         }
-        return createIndex(row, column, nullptr);
+        return createIndex(row, column, quintptr(0));
     }
 
-    // a child item of a top-level item is requrested
-    UndoGroup * group = d->groupForRow(parent.row());
-    if (!group) {
+    // a child item of a top-level item is requrested. The group is not
+    // accessed, so that spilled groups are not loaded
+    if (parent.internalId() != 0 || parent.row() >= d->groups.count()) {
         return QModelIndex();
     }
-    return createIndex(row, column, group);
+    return createIndex(row, column, static_cast<quintptr>(d->groups.serial(parent.row()) + 1));
 }
 
 QModelIndex UndoManager::parent(const QModelIndex & index) const
 {
-    if (!index.isValid()) {
+    if (!index.isValid() || index.internalId() == 0) {
+        // top-level item
         return QModelIndex();
     }
 
-    auto group = static_cast<UndoGroup *>(index.internalPointer());
-    if (group) {
-        // child item
-        int row = d->undoItems.indexOf(group);
-        if (row < 0) {
-            row = d->redoItems.indexOf(group);
-            Q_ASSERT(row >= 0);
-            row += d->undoItems.size();
-        }
-        return createIndex(row, 0, nullptr);
-    } else {
-        // top-level item
+    // child item
+    const int row = d->rowForInternalId(index.internalId());
+    if (row < 0) {
         return QModelIndex();
     }
+    return createIndex(row, 0, quintptr(0));
 }
 
 int UndoManager::rowCount(const QModelIndex & parent) const
 {
     if (!parent.isValid()) {
         // top-level items
-        return d->undoItems.size() + d->redoItems.size();
-    } else if (! parent.internalPointer()){
+        return d->groups.count();
+    } else if (parent.internalId() == 0) {
         // child items
         auto group = d->groupForRow(parent.row());
         if (group) {
@@ -418,73 +701,54 @@ QVariant UndoManager::data(const QModelIndex & index, int role) const
         return QVariant();
     }
 
+    const bool isGroup = index.internalId() == 0;
+    const int row = isGroup ? index.row() : d->rowForInternalId(index.internalId());
+
     if (role == Qt::DisplayRole) {
-        auto group = static_cast<UndoGroup *>(index.internalPointer());
-        if (group) {
-            // child item
-            return group->undoItems()[index.row()]->text();
-        } else {
-            auto group = d->groupForRow(index.row());
-            Q_ASSERT(group);
+        auto group = d->groupForRow(row);
+        if (!group) {
+            return QVariant();
+        }
+
+        if (isGroup) {
             return group->text();
         }
+
+        // child item: only now the items of a spilled group are loaded
+        const auto items = group->undoItems();
+        if (index.row() < items.size()) {
+            return items[index.row()]->text();
+        }
     }
 
-    if (role == Qt::FontRole) {
-        auto group = static_cast<UndoGroup *>(index.internalPointer());
-        if (!group) {
-            // top-level item
-            if (index.row() == d->undoItems.size() - 1) {
-                QFont font;
-                font.setBold(true);
-                return font;
-            }
+    if (role == Qt::FontRole && isGroup) {
+        // top-level item
+        if (row == d->groups.cursor() - 1) {
+            QFont font;
+            font.setBold(true);
+            return font;
         }
     }
 
-    if (role == Qt::DecorationRole && d->cleanUndoGroup) {
-        auto group = static_cast<UndoGroup *>(index.internalPointer());
-        if (!group) {
-            group = d->groupForRow(index.row());
-            if (group == d->cleanUndoGroup) {
-                return QColor(Qt::red);
-            }
+    if (role == Qt::DecorationRole && isGroup) {
+        if (row == d->cleanIndex - 1) {
+            return QColor(Qt::red);
         }
     }
 
     return QVariant();
 }
 
-bool UndoManager::insertRows(int row, int count, const QModelIndex & parent)
-{
-    Q_UNUSED(row)
-    Q_UNUSED(count)
-    Q_UNUSED(parent)
-
-    // for now, inserting is only supported at top-level
-    return true;
-}
-
-bool UndoManager::removeRows(int row, int count, const QModelIndex & parent)
-{
-    Q_UNUSED(row)
-    Q_UNUSED(count)
-    Q_UNUSED(parent)
-
-    // for now, inserting is only supported at top-level
-    return true;
-}
-
 void UndoManager::printTree()
 {
     qDebug() << "-- undo items --";
-    for (auto item : d->undoItems) {
-        item->printTree();
+    for (int i = 0; i < d->groups.cursor(); ++i) {
+        d->groups.at(i)->printTree();
     }
 
     qDebug() << "\n-- redo items --";
-    for (auto item : d->redoItems) {
-        item->printTree();
+    for (int i = d->groups.cursor(); i < d->groups.count(); ++i) {
+        d->groups.at(i)->printTree();
     }
 }
 
@@ -30,6 +30,7 @@ class Document;
 class UndoManagerPrivate;
 class UndoGroup;
 class UndoItem;
+class Uid;
 
 /**
  * Base class for undo/redo items.
@@ -113,6 +114,86 @@ public:
      */
     QList<UndoGroup*> undoGroups() const;
 
+    /**
+     * Appends an undo group with the description @p text to the undo groups,
+     * without executing it. The group consists of @p count undo items in
+     * the compact form @p data, see UndoGroup::compactData(). The undo items
+     * are created only once the group is undone.
+     * This is used to restore the undo history when loading a Document.
+     * @note There must be neither redo groups nor a pending transaction.
+     * @return @e true on success.
+     */
+    bool attachGroup(const QString & text, const QByteArray & data, int count);
+
+//
+// history limits
+//
+public:
+    /**
+     * Limits the number of undo groups to @p limit. If there are more undo
+     * groups, the oldest ones are deleted. A limit of 0 means no limit,
+     * which is the default.
+     */
+    void setUndoLimit(int limit);
+
+    /**
+     * Returns the maximum number of undo groups, or 0 for no limit.
+     */
+    int undoLimit() const;
+
+//
+// autosave journal
+//
+public:
+    /**
+     * Opens the journal @p filename. From now on, each committed undo
+     * group and each undo() and redo() is appended to the journal, see
+     * UndoJournal. If @p truncate is @e true, existing records are removed,
+     * otherwise new records are appended.
+     * @return @e true on success
+     */
+    bool openJournal(const QString & filename, bool truncate);
+
+    /**
+     * Closes the journal, the file is kept.
+     */
+    void closeJournal();
+
+    /**
+     * Returns the file name of the open journal, or an empty string.
+     */
+    QString journalFile() const;
+
+    /**
+     * Removes all records from the journal, e.g. after saving.
+     */
+    bool truncateJournal();
+
+//
+// memory management
+//
+public:
+    /**
+     * Sets the memory budget of the undo history to @p bytes.
+     * If the estimated memory of all undo groups exceeds the budget, the
+     * oldest undo groups are spilled to a temporary file in a compact
+     * binary form, see UndoGroup::spill(). Spilled undo groups are loaded
+     * again transparently once they are undone.
+     * A budget of 0 or less disables spilling.
+     */
+    void setMemoryBudget(qint64 bytes);
+
+    /**
+     * Returns the memory budget of the undo history in bytes.
+     * The default budget is 128 MiB.
+     */
+    qint64 memoryBudget() const;
+
+    /**
+     * Returns the estimated memory in bytes held by all loaded undo groups.
+     */
+    qint64 memoryUsage() const;
+
 public:
     /**
      * Start a new undo group.
@@ -148,9 +229,51 @@ public:
      */
     bool transactionActive() const;
 
+//
+// gestures
+//
+public:
+    /**
+     * Starts a transaction like startTransaction() for an interactive
+     * gesture, such as dragging nodes with the mouse. The gesture lasts
+     * until the outermost transaction is committed or canceled.
+     *
+     * During a gesture, entities apply repeated changes directly and keep
+     * one undo item per entity and change type, see gestureItem() and
+     * addGestureItem(). These undo items are added to the undo group when
+     * they are recorded first, and updated in place afterwards, so each
+     * change of the gesture neither allocates an undo item nor runs the
+     * merge check of the undo group.
+     */
+    void startGesture(const QString & text = QString());
+
+    /**
+     * Returns @e true, if a gesture is running that was not canceled.
+     */
+    bool gestureActive() const;
+
+    /**
+     * Returns the undo item of type @p typeName that was recorded for
+     * @p uid in the running gesture, or nullptr.
+     */
+    UndoItem * gestureItem(const Uid & uid, const char * typeName) const;
+
+    /**
+     * Records @p item for @p uid in the running gesture. In contrast to
+     * addUndoItem(), @p item is not executed, the caller already applied
+     * the change. The UndoManager takes ownership of @p item.
+     */
+    void addGestureItem(const Uid & uid, UndoItem * item);
+
 //
 // Implementation of QAbstractItemModel
 //
+// There is one top-level row for each undo and redo group, and one child
+// row for each undo item. Rows and indexes are computed from the position
+// in the undo stack, so that the groups are accessed only for the rows a
+// view actually shows. In particular, the undo items of spilled groups are
+// loaded only if the view shows them.
+//
 public:
     /**
      * Returns a QModelIndex for the requested position.
@@ -177,21 +300,23 @@ public:
      */
     QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override;
 
+public:
+    // for debugging
+    void printTree();
+
+private:
+    friend class UndoGroup;
+
     /**
-     * Inserts @p count rows starting at @p row.
+     * Deletes the oldest undo groups that exceed the undoLimit().
      */
-    bool insertRows(int row, int count, const QModelIndex & parent = QModelIndex()) override;
+    void enforceUndoLimit();
 
     /**
-     * Removes @p count rows starting at @p row.
+     * Called by @p group, whenever its spilled items were loaded again.
      */
-    bool removeRows(int row, int count, const QModelIndex & parent = QModelIndex()) override;
-
-public:
-    // for debugging
-    void printTree();
+    void groupLoaded(UndoGroup * group);
 
-private:
     /**
      * Pimpl pointer to the held data.
      */
@@ -0,0 +1,94 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "UndoStack.h"
+
+namespace tikz {
+namespace core {
+
+void UndoStack::undo()
+{
+    Q_ASSERT(m_cursor > 0);
+    --m_cursor;
+}
+
+void UndoStack::redo()
+{
+    Q_ASSERT(m_cursor < m_count);
+    ++m_cursor;
+}
+
+void UndoStack::push(UndoGroup * group)
+{
+    Q_ASSERT(group);
+    Q_ASSERT(m_cursor == m_count);
+
+    // grow: unroll the ring into a buffer of twice the size
+    if (m_count == m_buffer.size()) {
+        QVector<UndoGroup *> buffer(qMax(16, 2 * m_buffer.size()), nullptr);
+        for (int i = 0; i < m_count; ++i) {
+            buffer[i] = at(i);
+        }
+        m_buffer.swap(buffer);
+        m_head = 0;
+    }
+
+    m_buffer[(m_head + m_count) & (m_buffer.size() - 1)] = group;
+    ++m_count;
+    ++m_cursor;
+}
+
+UndoGroup * UndoStack::takeFirst()
+{
+    Q_ASSERT(m_cursor > 0);
+
+    UndoGroup * group = at(0);
+    m_buffer[m_head] = nullptr;
+    m_head = (m_head + 1) & (m_buffer.size() - 1);
+    --m_count;
+    --m_cursor;
+    ++m_firstSerial;
+    return group;
+}
+
+UndoGroup * UndoStack::takeLast()
+{
+    Q_ASSERT(m_count > m_cursor);
+
+    UndoGroup * group = at(m_count - 1);
+    m_buffer[(m_head + m_count - 1) & (m_buffer.size() - 1)] = nullptr;
+    --m_count;
+    return group;
+}
+
+void UndoStack::clear()
+{
+    // continue the serials of the removed groups
+    m_firstSerial += m_count;
+
+    m_buffer.clear();
+    m_head = 0;
+    m_count = 0;
+    m_cursor = 0;
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
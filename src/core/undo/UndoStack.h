@@ -0,0 +1,177 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_UNDO_STACK_H
+#define TIKZ_CORE_UNDO_STACK_H
+
+#include <QVector>
+
+namespace tikz {
+namespace core {
+
+class UndoGroup;
+
+/**
+ * Storage of the undo and redo groups of the UndoManager.
+ *
+ * All groups are stored in a single ring buffer in the order they were
+ * committed. A cursor separates the undo groups [0, cursor()) from the redo
+ * groups [cursor(), count()). Therefore, undo() and redo() only move the
+ * cursor, and removing the oldest group with takeFirst() does not move any
+ * other group. All operations run in O(1), push() in amortized O(1).
+ *
+ * Each group has a serial number that stays the same as long as the group
+ * is stored, even if older groups are removed. The UndoManager uses the
+ * serial to refer to groups in QModelIndex%es.
+ *
+ * The UndoStack does not own the groups.
+ */
+class UndoStack
+{
+public:
+    /**
+     * Returns the number of all groups.
+     */
+    inline int count() const
+    {
+        return m_count;
+    }
+
+    /**
+     * Returns @e true, if there are no groups.
+     */
+    inline bool isEmpty() const
+    {
+        return m_count == 0;
+    }
+
+    /**
+     * Returns the number of undo groups. The groups with an index less than
+     * the cursor are undo groups, all others are redo groups.
+     */
+    inline int cursor() const
+    {
+        return m_cursor;
+    }
+
+    /**
+     * Returns the number of redo groups.
+     */
+    inline int redoCount() const
+    {
+        return m_count - m_cursor;
+    }
+
+    /**
+     * Returns the group at @p index, the oldest group has index 0.
+     */
+    inline UndoGroup * at(int index) const
+    {
+        Q_ASSERT(index >= 0 && index < m_count);
+        return m_buffer[(m_head + index) & (m_buffer.size() - 1)];
+    }
+
+    /**
+     * Returns the group that is undone next, or nullptr.
+     */
+    inline UndoGroup * undoGroup() const
+    {
+        return m_cursor > 0 ? at(m_cursor - 1) : nullptr;
+    }
+
+    /**
+     * Returns the group that is redone next, or nullptr.
+     */
+    inline UndoGroup * redoGroup() const
+    {
+        return m_cursor < m_count ? at(m_cursor) : nullptr;
+    }
+
+    /**
+     * Returns the serial number of the group at @p index.
+     */
+    inline qint64 serial(int index) const
+    {
+        return m_firstSerial + index;
+    }
+
+    /**
+     * Returns the index of the group with the serial number @p serial,
+     * or -1 if the group is not stored.
+     */
+    inline int indexOfSerial(qint64 serial) const
+    {
+        const qint64 index = serial - m_firstSerial;
+        return (index >= 0 && index < m_count) ? static_cast<int>(index) : -1;
+    }
+
+    /**
+     * Moves the cursor before the current undo group.
+     */
+    void undo();
+
+    /**
+     * Moves the cursor behind the current redo group.
+     */
+    void redo();
+
+    /**
+     * Appends @p group as the latest undo group.
+     * @note There must be no redo groups.
+     */
+    void push(UndoGroup * group);
+
+    /**
+     * Removes and returns the oldest group, which must be an undo group.
+     */
+    UndoGroup * takeFirst();
+
+    /**
+     * Removes and returns the latest group, which must be a redo group.
+     */
+    UndoGroup * takeLast();
+
+    /**
+     * Removes all groups. The groups are not deleted.
+     */
+    void clear();
+
+private:
+    // ring buffer, the size is zero or a power of two
+    QVector<UndoGroup *> m_buffer;
+
+    // index of the oldest group in m_buffer
+    int m_head = 0;
+
+    // number of groups in m_buffer
+    int m_count = 0;
+
+    // number of undo groups
+    int m_cursor = 0;
+
+    // serial number of the oldest group
+    qint64 m_firstSerial = 0;
+};
+
+}
+}
+
+#endif // TIKZ_CORE_UNDO_STACK_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -69,7 +69,11 @@ void Entity::unsetObjectName()
 void Entity::load(const QJsonObject & json)
 {
     if (json.contains("uid")) {
-        d->uid = Uid(json["uid"].toString(), d->uid.document());
+        // keep the generation the Document bound this entity to
+        const Uid uid(json["uid"].toString(), d->uid.document());
+        if (uid.id() != d->uid.id()) {
+            d->uid = uid;
+        }
     }
 
     if (json.contains("entityType")) {
@@ -110,6 +114,13 @@ void Entity::loadData(const QJsonObject & json)
     Q_UNUSED(json)
 }
 
+void Entity::propertyChanged(const char * property)
+{
+    if (auto doc = document()) {
+        doc->recordPropertyChange(uid(), property);
+    }
+}
+
 Document * Entity::document() const
 {
     return d->uid.document();
@@ -27,6 +27,7 @@
 #include <memory>
 #include <QObject>
 #include <QJsonObject>
+#include <QVector>
 
 namespace tikz {
 namespace core {
@@ -107,6 +108,13 @@ class TIKZKITCORE_EXPORT Entity : public ConfigObject
          */
         virtual QJsonObject saveData() const;
 
+    protected:
+        /**
+         * Records in the Document's ChangeSet that the property @p property
+         * of this entity changed. Call this in all setters.
+         */
+        void propertyChanged(const char * property);
+
     //
     // internal to tikz::Document
     //
@@ -123,6 +131,110 @@ class TIKZKITCORE_EXPORT Entity : public ConfigObject
         std::unique_ptr<EntityPrivate> const d;
 };
 
+/**
+ * Read-only range over all entities of type T of a Document.
+ *
+ * The range directly iterates the Document's internal entity storage,
+ * i.e., no list is copied. Therefore, the range is only valid as long as
+ * no entities are added to or removed from the Document.
+ *
+ * @code
+ * for (Node * node : document->nodeRange()) {
+ *     // ...
+ * }
+ * @endcode
+ */
+template <typename T>
+class EntityRange
+{
+    public:
+        class const_iterator
+        {
+            public:
+                const_iterator(QVector<Entity *>::const_iterator it,
+                               QVector<Entity *>::const_iterator end)
+                    : m_it(it)
+                    , m_end(end)
+                {
+                    skipRemoved();
+                }
+
+                T * operator*() const
+                {
+                    return static_cast<T *>(*m_it);
+                }
+
+                const_iterator & operator++()
+                {
+                    ++m_it;
+                    skipRemoved();
+                    return *this;
+                }
+
+                bool operator==(const const_iterator & other) const
+                {
+                    return m_it == other.m_it;
+                }
+
+                bool operator!=(const const_iterator & other) const
+                {
+                    return m_it != other.m_it;
+                }
+
+            private:
+                // removed entities leave a nullptr until the storage is compacted
+                void skipRemoved()
+                {
+                    while (m_it != m_end && *m_it == nullptr) {
+                        ++m_it;
+                    }
+                }
+
+                QVector<Entity *>::const_iterator m_it;
+                QVector<Entity *>::const_iterator m_end;
+        };
+
+        /**
+         * Constructor. @p entities may contain null pointers, @p count is
+         * the number of non-null entries.
+         */
+        EntityRange(const QVector<Entity *> & entities, int count)
+            : m_entities(entities)
+            , m_count(count)
+        {
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(m_entities.cbegin(), m_entities.cend());
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(m_entities.cend(), m_entities.cend());
+        }
+
+        /**
+         * Returns the number of entities in this range.
+         */
+        int size() const
+        {
+            return m_count;
+        }
+
+        /**
+         * Returns @e true, if this range contains no entities.
+         */
+        bool isEmpty() const
+        {
+            return m_count == 0;
+        }
+
+    private:
+        const QVector<Entity *> & m_entities;
+        int m_count;
+};
+
 }
 }
 #endif // TIKZ_CORE_ENTITY_H
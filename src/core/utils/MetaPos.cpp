@@ -18,33 +18,27 @@
  */
 
 #include "MetaPos.h"
-#include "MetaPos_p.h"
 
 #include "Document.h"
 #include "Node.h"
+#include "NumberCodec.h"
 
+#include <QDataStream>
+#include <QJsonValue>
 #include <QDebug>
 
+#include <cstring>
+
 namespace tikz {
 namespace core {
 
 MetaPos::MetaPos(Document * doc)
-    : d(new MetaPosPrivate(this))
+    : m_doc(doc)
 {
     Q_ASSERT(doc != nullptr);
-    d->doc = doc;
 
-    Q_ASSERT(! d->nodeId.isValid());
-    Q_ASSERT(d->anchor.isEmpty());
-}
-
-MetaPos::MetaPos(const MetaPos & pos)
-    : d(new MetaPosPrivate(this))
-{
-    d->doc = pos.d->doc;
-
-    // now copy object
-    *this = pos;
+    Q_ASSERT(! m_nodeId.isValid());
+    Q_ASSERT(m_anchor.isEmpty());
 }
 
 MetaPos::MetaPos(const QString & str, Document * document)
@@ -53,79 +47,79 @@ MetaPos::MetaPos(const QString & str, Document * document)
     fromString(str);
 }
 
-MetaPos::~MetaPos()
-{
-    delete d;
-}
-
-Document * MetaPos::document() const
-{
-    return d->doc;
-}
-
 QString MetaPos::toString() const
 {
     if (node()) {
-        return QString("(%1%2)")
-            .arg(d->nodeId.toString())
-            .arg(d->anchor.isEmpty() ? QString() : (QLatin1Char('.') + d->anchor));
+        if (m_anchor.isEmpty()) {
+            return QLatin1Char('(') + m_nodeId.toString() + QLatin1Char(')');
+        }
+        return QLatin1Char('(') + m_nodeId.toString() + QLatin1Char('.') + m_anchor + QLatin1Char(')');
     } else {
-        return d->pos.toString();
+        return m_pos.toString();
     }
 }
 
 void MetaPos::fromString(const QString & str)
 {
-    if (str.contains(QLatin1Char(','))) {
+    // format examples: (12.50cm, -13.5pt), (12) or (12.north east)
+    QVarLengthArray<char, 64> buffer;
+    codec::toLatin1(str, buffer);
+    const char * const first = buffer.constData();
+    const char * const last = first + buffer.size();
+
+    if (std::memchr(first, ',', last - first)) {
         setPos(tikz::Pos::fromString(str));
-    } else {
-        const int openIndex = str.indexOf(QLatin1Char('('));
-        const int dotIndex = str.indexOf(QLatin1Char('.'));
-        const int closeIndex = str.indexOf(QLatin1Char(')'));
-
-        Q_ASSERT(openIndex >= 0);
-        Q_ASSERT(closeIndex >= openIndex);
-
-        d->beginChange();
-        const int endIndex = (dotIndex > 0) ? dotIndex : closeIndex;
-        bool ok;
-        d->nodeId = Uid(str.mid(openIndex + 1, endIndex - (openIndex + 1)).toLongLong(&ok), d->doc);
-        Q_ASSERT(ok);
-
-        // read the anchor
-        if (dotIndex > 0) {
-            d->anchor = str.mid(dotIndex + 1, closeIndex - (dotIndex + 1));
-        } else {
-            d->anchor.clear();
-        }
-        d->endChange();
+        return;
     }
-}
 
-MetaPos & MetaPos::operator=(const MetaPos & other)
-{
-    if (*this == other) {
-        return *this;
+    // node id, followed by an optional anchor
+    qint64 id = -1;
+    const char * anchor = nullptr;
+    const char * it = static_cast<const char *>(std::memchr(first, '(', last - first));
+    if (it) {
+        it = codec::parseInteger(codec::skipSpaces(it + 1, last), last, id);
+    }
+    if (it) {
+        it = codec::skipSpaces(it, last);
+    }
+    if (it && it != last && *it == '.') {
+        anchor = it + 1;
+        it = static_cast<const char *>(std::memchr(anchor, ')', last - anchor));
+    }
+    if (! it || it == last || *it != ')') {
+        Q_ASSERT(false);
+        setPos(tikz::Pos());
+        return;
     }
 
-    // for now, only same Document is supported
-    Q_ASSERT(d->doc == other.d->doc);
-
-    // start copying private data
-    d->beginChange();
+    m_cachedRevision = 0;
+    m_nodeId = Uid(id, m_doc);
 
-    // call setNode() to properly set up signals & slots
-    setNode(other.node());
+    // the buffer holds one char per QChar, so the anchor is taken from
+    // @p str to keep non-Latin-1 chars
+    if (anchor) {
+        m_anchor = str.mid(static_cast<int>(anchor - first), static_cast<int>(it - anchor));
+    } else {
+        m_anchor.clear();
+    }
+}
 
-    // now copy rest
-    d->doc = other.d->doc;
-    d->pos = other.d->pos;
-    d->anchor = other.d->anchor;
+QJsonValue MetaPos::toJson() const
+{
+    if (node()) {
+        return toString();
+    }
 
-    // calls changed
-    d->endChange();
+    return m_pos.toJson();
+}
 
-    return *this;
+void MetaPos::fromJson(const QJsonValue & json)
+{
+    if (json.isString()) {
+        fromString(json.toString());
+    } else {
+        setPos(tikz::Pos::fromJson(json));
+    }
 }
 
 bool MetaPos::operator==(const MetaPos & other) const
@@ -134,17 +128,17 @@ bool MetaPos::operator==(const MetaPos & other) const
         return true;
     }
 
-    if (d->doc != other.d->doc) {
-        Q_ASSERT(d->doc == other.d->doc);
+    if (m_doc != other.m_doc) {
+        Q_ASSERT(m_doc == other.m_doc);
         return false;
     }
 
-    if (d->nodeId.isValid() || other.d->nodeId.isValid()) {
-        return d->nodeId == other.d->nodeId
-            && d->anchor == other.d->anchor;
+    if (m_nodeId.isValid() || other.m_nodeId.isValid()) {
+        return m_nodeId == other.m_nodeId
+            && m_anchor == other.m_anchor;
     }
 
-    return d->pos == other.d->pos;
+    return m_pos == other.m_pos;
 }
 
 bool MetaPos::operator!=(const MetaPos & other) const
@@ -154,40 +148,31 @@ bool MetaPos::operator!=(const MetaPos & other) const
 
 tikz::Pos MetaPos::pos() const
 {
-    if (! d->nodeId.isValid()) {
+    if (! m_nodeId.isValid()) {
         Q_ASSERT(node() == nullptr);
-        return d->pos;
+        return m_pos;
     }
 
-    Q_ASSERT(node() != nullptr);
-    return document()->scenePos(*this);
+    // the node may not exist (anymore), e.g. while loading or undoing
+    const Node * n = node();
+    if (! n) {
+        return m_pos;
+    }
+
+    if (m_cachedRevision != n->revision()) {
+        m_cachedPos = document()->scenePos(*this);
+        m_cachedRevision = n->revision();
+    }
+    return m_cachedPos;
 }
 
 void MetaPos::setPos(const tikz::Pos & pos)
 {
-    bool change = false;
-
     // detach from node, if required
-    Node * oldNode = node();
-    if (oldNode) {
-        // disconnect changed() signal
-        QObject::disconnect(oldNode, nullptr, d, nullptr);
-        d->nodeId = Uid();
-
-        change = true;
-    }
-
-    if (d->pos != pos) {
-        // update pos
-        d->pos = pos;
-
-        change = true;
-    }
-
-    // notify about change
-    if (change) {
-        d->changeRequest();
-    }
+    m_nodeId = Uid();
+    m_anchor.clear();
+    m_pos = pos;
+    m_cachedRevision = 0;
 }
 
 bool MetaPos::setNode(Node* newNode)
@@ -199,33 +184,15 @@ bool MetaPos::setNode(Node* newNode)
         return false;
     }
 
-    // start changing this MetaPos
-    d->beginChange();
-
-    // detach from old node
+    // keep the current scene position, in case the newNode is 0
     if (curNode) {
-        // disconnect changed() signal
-        QObject::disconnect(curNode, nullptr, d, nullptr);
-
-        // update pos in case the newNode is 0
-        d->pos = pos();
+        m_pos = pos();
     }
 
-    // set new node and forward change() signal if applicable
-    d->nodeId = newNode ? newNode->uid() : Uid();
-    curNode = node();
-
-    // attach to newNode
-    if (curNode) {
-        // connect changed() signal to helper object
-        QObject::connect(curNode, SIGNAL(changed()), d, SLOT(changeRequest()));
-    }
-
-    // reset anchor
-    d->anchor.clear();
-
-    // notify about change
-    d->endChange();
+    // set new node and reset anchor
+    m_nodeId = newNode ? newNode->uid() : Uid();
+    m_anchor.clear();
+    m_cachedRevision = 0;
 
     // node was changed
     return true;
@@ -233,29 +200,37 @@ bool MetaPos::setNode(Node* newNode)
 
 Node* MetaPos::node() const
 {
-    return d->nodeId.entity<Node>();
+    return m_nodeId.entity<Node>();
 }
 
 void MetaPos::setAnchor(const QString & anchor)
 {
     // setting an anchor only makes sense with a node
-    Q_ASSERT(d->nodeId.isValid());
+    Q_ASSERT(m_nodeId.isValid());
 
-    if (d->anchor != anchor) {
-        d->beginChange();
-        d->anchor = anchor;
-        d->endChange();
-    }
+    m_anchor = anchor;
+    m_cachedRevision = 0;
 }
 
 QString MetaPos::anchor() const
 {
-    return (d->nodeId.isValid()) ? d->anchor : QString();
+    return (m_nodeId.isValid()) ? m_anchor : QString();
+}
+
+QDataStream & operator<<(QDataStream & stream, const MetaPos & pos)
+{
+    return stream << pos.m_pos
+                  << pos.m_nodeId.id()
+                  << pos.m_anchor;
 }
 
-QObject * MetaPos::notificationObject()
+QDataStream & operator>>(QDataStream & stream, MetaPos & pos)
 {
-    return d;
+    qint64 id;
+    stream >> pos.m_pos >> id >> pos.m_anchor;
+    pos.m_nodeId = (id >= 0) ? Uid(id, pos.m_doc) : Uid();
+    pos.m_cachedRevision = 0;
+    return stream;
 }
 
 }
@@ -23,14 +23,17 @@
 #include "tikz.h"
 #include "tikz_export.h"
 #include "Pos.h"
+#include "Uid.h"
 
 #include <QSharedPointer>
+#include <QString>
+
+class QDataStream;
 
 namespace tikz {
 namespace core {
 
 class MetaPos;
-class MetaPosPrivate;
 class Node;
 class Document;
 
@@ -38,6 +41,17 @@ class Document;
  * MetaPos represents a position in the TikZ scene.
  * This position may either be a simple coordinate, or a node.
  * In case of a node, the anchor additionally takes effect.
+ *
+ * MetaPos is a compact value type: copying, assigning and comparing
+ * neither allocates memory nor creates signal/slot connections.
+ * Consequently, a MetaPos does not notify about changes itself. The owner
+ * of a MetaPos knows when it changes its value. To get notified whenever
+ * the node() a MetaPos refers to changes (e.g. moves), subscribe to the
+ * node with Document::subscribe().
+ *
+ * If a node is set, pos() resolves the scene position of the node's anchor
+ * through Document::scenePos(). The result is cached and reused as long as
+ * the Node::revision() and the anchor stay the same.
  */
 class TIKZKITCORE_EXPORT MetaPos
 {
@@ -75,20 +89,21 @@ class TIKZKITCORE_EXPORT MetaPos
 
         /**
          * Copy constructor.
-         *
-         * Copies all data except the signal and slot connections.
          */
-        MetaPos(const MetaPos & pos);
+        MetaPos(const MetaPos & pos) = default;
 
         /**
          * Non-virtual destructor.
          */
-        ~MetaPos();
+        ~MetaPos() = default;
 
         /**
          * Get the associated Document.
          */
-        Document * document() const;
+        inline Document * document() const
+        {
+            return m_doc;
+        }
 
         /**
          * Convert this MetaPos to a string.
@@ -104,16 +119,26 @@ class TIKZKITCORE_EXPORT MetaPos
          */
         void fromString(const QString & str);
 
+        /**
+         * Convert this MetaPos to json. Positions attached to a node are
+         * stored as in toString(), scene coordinates as in Pos::toJson().
+         */
+        QJsonValue toJson() const;
+
+        /**
+         * Set this MetaPos from @p json. Both the forms of toJson() and
+         * the string forms of toString() are supported.
+         */
+        void fromJson(const QJsonValue & json);
+
     //
     // operators
     //
     public:
         /**
          * Assignment operator.
-         * The assignment operator copies all data. The notification object
-         * as well as its connection remain unchanged.
          */
-        MetaPos & operator=(const MetaPos & other);
+        MetaPos & operator=(const MetaPos & other) = default;
 
         /**
          * Check for equality of this object with @p other.
@@ -132,13 +157,14 @@ class TIKZKITCORE_EXPORT MetaPos
         /**
          * Get the coordinate of this node.
          * If no Node is associated, the position set with setPos() is returned.
-         * If node() is non-null, node()->pos() is returned.
+         * If node() is non-null, the scene position of the anchor() is returned.
+         * The scene position is cached until the node's revision changes.
          */
         tikz::Pos pos() const;
 
         /**
          * Set the coordinates to @p pos.
-         * Calling this function emits changed(), if @p pos != pos().
+         * If a node was set, the node is reset.
          */
         void setPos(const tikz::Pos & pos);
 
@@ -154,7 +180,7 @@ class TIKZKITCORE_EXPORT MetaPos
 
         /**
          * Set the node to @p node.
-         * Calling this function emits changed(), if @p pos != pos().
+         * Setting a null pointer keeps the current scene position.
          * @return @p true, if the node changed, otherwise @p false.
          */
         bool setNode(Node * node);
@@ -170,18 +196,32 @@ class TIKZKITCORE_EXPORT MetaPos
          */
         void setAnchor(const QString & anchor);
 
+        /**
+         * Get the Uid of the node of this MetaPos.
+         * In contrast to node(), the Uid is not resolved.
+         */
+        inline Uid nodeUid() const
+        {
+            return m_nodeId;
+        }
+
     //
-    // Notification object
+    // binary serialization
     //
     public:
         /**
-         * Call this function to get the notification object.
-         * The notification object is a QObject that emits the signal
-         * \p void changed(MetaPos * metaPos).
-         *
-         * Connect to this object if you need to get change signals.
+         * Writes @p pos in binary form to @p stream. In contrast to
+         * toString(), the scene position, the node and the anchor are
+         * written, even if the node does not exist (anymore).
+         */
+        friend TIKZKITCORE_EXPORT QDataStream & operator<<(QDataStream & stream, const MetaPos & pos);
+
+        /**
+         * Reads @p pos in binary form from @p stream.
+         * The document of @p pos is kept. Since the binary form may be read
+         * in a later session, the node's Uid is not bound to a generation.
          */
-        QObject * notificationObject();
+        friend TIKZKITCORE_EXPORT QDataStream & operator>>(QDataStream & stream, MetaPos & pos);
 
     private:
         /**
@@ -189,12 +229,28 @@ class TIKZKITCORE_EXPORT MetaPos
          */
         MetaPos() = delete;
 
-        /**
-         * Private data pointer.
-         */
-        MetaPosPrivate * const d;
+    private:
+        // associated document
+        Document * m_doc;
+
+        // scene position, if no node is set
+        tikz::Pos m_pos;
+
+        // the node, if set
+        Uid m_nodeId;
+
+        // anchor of the node, if set
+        QString m_anchor;
+
+        // cached scene position of the anchor, valid if m_cachedRevision
+        // equals the node's revision. Revision 0 is never used by nodes.
+        mutable tikz::Pos m_cachedPos;
+        mutable quint64 m_cachedRevision = 0;
 };
 
+TIKZKITCORE_EXPORT QDataStream & operator<<(QDataStream & stream, const MetaPos & pos);
+TIKZKITCORE_EXPORT QDataStream & operator>>(QDataStream & stream, MetaPos & pos);
+
 }
 }
 
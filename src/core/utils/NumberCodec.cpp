@@ -0,0 +1,375 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2013 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "NumberCodec.h"
+#include "Value.h"
+
+#include <QByteArray>
+#include <QLocale>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+// std::to_chars and std::from_chars for double are not available in all
+// standard libraries. Without them, Qt's conversion is used.
+#if defined(__cpp_lib_to_chars)
+#define TIKZ_HAVE_FLOAT_CHARCONV
+#endif
+
+namespace tikz
+{
+namespace codec
+{
+
+namespace {
+    // significant digits written by formatFixed()
+    constexpr int s_maxDigits = 15;
+
+    bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // copies @p data to [first, last)
+    char * copy(char * first, char * last, const QByteArray & data)
+    {
+        if (data.size() > last - first) {
+            return nullptr;
+        }
+        std::memcpy(first, data.constData(), data.size());
+        return first + data.size();
+    }
+
+    // writes the shortest representation of @p value in fixed notation
+    char * writeFixed(char * first, char * last, double value)
+    {
+#ifdef TIKZ_HAVE_FLOAT_CHARCONV
+        const auto result = std::to_chars(first, last, value, std::chars_format::fixed);
+        return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+        return copy(first, last, QByteArray::number(value, 'f', QLocale::FloatingPointShortest));
+#endif
+    }
+
+    // returns the number of digits from the first to the last non-zero digit
+    int significantDigits(const char * first, const char * last)
+    {
+        int count = 0;
+        int zeros = 0;
+        for (; first != last; ++first) {
+            if (*first == '0') {
+                ++zeros;
+            } else if (*first >= '1' && *first <= '9') {
+                count += (count > 0 ? zeros : 0) + 1;
+                zeros = 0;
+            }
+        }
+        return count;
+    }
+
+    // writes @p value rounded to @p digits significant digits in fixed
+    // notation, without trailing zeros after the dot
+    char * writeRounded(char * first, char * last, double value, int digits)
+    {
+        // round in scientific notation, "-d.ddde-xx"
+        char buffer[32];
+#ifdef TIKZ_HAVE_FLOAT_CHARCONV
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                          std::chars_format::scientific, digits - 1);
+        if (result.ec != std::errc()) {
+            return nullptr;
+        }
+        const char * end = result.ptr;
+#else
+        const char * end = copy(buffer, buffer + sizeof(buffer), QByteArray::number(value, 'e', digits - 1));
+        if (!end) {
+            return nullptr;
+        }
+#endif
+
+        const char * it = buffer;
+        const bool negative = *it == '-';
+        if (negative) {
+            ++it;
+        }
+
+        // collect the mantissa digits without trailing zeros
+        char mantissa[32];
+        int count = 0;
+        for (; it != end && *it != 'e'; ++it) {
+            if (isDigit(*it)) {
+                mantissa[count++] = *it;
+            }
+        }
+        while (count > 1 && mantissa[count - 1] == '0') {
+            --count;
+        }
+        int exponent = 0;
+        if (it != end) {
+            const bool negativeExponent = *++it == '-';
+            for (; it != end; ++it) {
+                if (isDigit(*it)) {
+                    exponent = 10 * exponent + (*it - '0');
+                }
+            }
+            if (negativeExponent) {
+                exponent = -exponent;
+            }
+        }
+
+        // sign, digits and dot, plus the zeros added by the exponent
+        if (last - first < count + std::abs(exponent) + 3) {
+            return nullptr;
+        }
+
+        char * out = first;
+        if (negative) {
+            *out++ = '-';
+        }
+        if (exponent < 0) {
+            *out++ = '0';
+            *out++ = '.';
+            out = std::fill_n(out, -exponent - 1, '0');
+            out = std::copy(mantissa, mantissa + count, out);
+        } else if (exponent + 1 >= count) {
+            out = std::copy(mantissa, mantissa + count, out);
+            out = std::fill_n(out, exponent + 1 - count, '0');
+        } else {
+            out = std::copy(mantissa, mantissa + exponent + 1, out);
+            *out++ = '.';
+            out = std::copy(mantissa + exponent + 1, mantissa + count, out);
+        }
+        return out;
+    }
+
+    bool isLetter(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    // returns the end of the number at @p first, or @p first
+    const char * scanNumber(const char * first, const char * last)
+    {
+        const char * it = first;
+        if (it != last && *it == '-') {
+            ++it;
+        }
+
+        const char * digits = it;
+        while (it != last && isDigit(*it)) {
+            ++it;
+        }
+        bool hasDigits = it != digits;
+
+        if (it != last && *it == '.') {
+            ++it;
+            const char * fraction = it;
+            while (it != last && isDigit(*it)) {
+                ++it;
+            }
+            hasDigits = hasDigits || it != fraction;
+        }
+
+        if (!hasDigits) {
+            return first;
+        }
+
+        // the exponent is only part of the number, if it has digits
+        if (it != last && (*it == 'e' || *it == 'E')) {
+            const char * exponent = it + 1;
+            if (exponent != last && (*exponent == '+' || *exponent == '-')) {
+                ++exponent;
+            }
+            if (exponent != last && isDigit(*exponent)) {
+                it = exponent;
+                while (it != last && isDigit(*it)) {
+                    ++it;
+                }
+            }
+        }
+
+        return it;
+    }
+}
+
+char * formatShortest(char * first, char * last, double value)
+{
+#ifdef TIKZ_HAVE_FLOAT_CHARCONV
+    const auto result = std::to_chars(first, last, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+    return copy(first, last, QByteArray::number(value, 'g', QLocale::FloatingPointShortest));
+#endif
+}
+
+char * formatFixed(char * first, char * last, double value)
+{
+    // also covers -0, which TikZ should not see
+    if (value == 0.0) {
+        return copy(first, last, QByteArrayLiteral("0"));
+    }
+
+    if (!std::isfinite(value)) {
+        return formatShortest(first, last, value);
+    }
+
+    char * end = writeFixed(first, last, value);
+    if (!end || significantDigits(first, end) <= s_maxDigits) {
+        return end;
+    }
+
+    // more digits stem from rounding errors, e.g. 0.30000000000000004
+    return writeRounded(first, last, value, s_maxDigits);
+}
+
+char * formatValue(char * first, char * last, const Value & value)
+{
+    if (!value.isValid()) {
+        return copy(first, last, QByteArrayLiteral("nan"));
+    }
+
+    const char * suffix = nullptr;
+    switch (value.unit()) {
+        case Unit::Point: suffix = "pt"; break;
+        case Unit::Millimeter: suffix = "mm"; break;
+        case Unit::Centimeter: suffix = "cm"; break;
+        case Unit::Inch: suffix = "in"; break;
+        default: Q_ASSERT(false); return nullptr;
+    }
+
+    char * end = formatFixed(first, last - 2, value.value());
+    if (!end) {
+        return nullptr;
+    }
+
+    end[0] = suffix[0];
+    end[1] = suffix[1];
+    return end + 2;
+}
+
+const char * parseNumber(const char * first, const char * last, double & value)
+{
+    // a leading '+' is not accepted by std::from_chars
+    const char * begin = (first != last && *first == '+') ? first + 1 : first;
+    if (begin != first && begin != last && *begin == '-') {
+        return nullptr;
+    }
+
+    const char * end = scanNumber(begin, last);
+    if (end == begin) {
+        return nullptr;
+    }
+
+#ifdef TIKZ_HAVE_FLOAT_CHARCONV
+    const auto result = std::from_chars(begin, end, value);
+    if (result.ec != std::errc() || result.ptr != end) {
+        return nullptr;
+    }
+#else
+    bool ok = false;
+    value = QByteArray::fromRawData(begin, end - begin).toDouble(&ok);
+    if (!ok) {
+        return nullptr;
+    }
+#endif
+
+    return end;
+}
+
+const char * parseInteger(const char * first, const char * last, qint64 & value)
+{
+    const bool negative = first != last && *first == '-';
+    const char * const begin = (negative || (first != last && *first == '+')) ? first + 1 : first;
+
+    // the magnitude of the lowest qint64 is one more than the highest
+    const quint64 limit = static_cast<quint64>(std::numeric_limits<qint64>::max()) + (negative ? 1 : 0);
+    quint64 magnitude = 0;
+    const char * it = begin;
+    for (; it != last && isDigit(*it); ++it) {
+        const unsigned digit = static_cast<unsigned>(*it - '0');
+        if (magnitude > (limit - digit) / 10) {
+            return nullptr;
+        }
+        magnitude = 10 * magnitude + digit;
+    }
+
+    if (it == begin) {
+        return nullptr;
+    }
+
+    value = negative ? -static_cast<qint64>(magnitude - 1) - 1 : static_cast<qint64>(magnitude);
+    return it;
+}
+
+const char * parseValue(const char * first, const char * last, Value & value)
+{
+    first = skipSpaces(first, last);
+
+    // string form of invalid Values
+    if (last - first >= 3 && std::memcmp(first, "nan", 3) == 0) {
+        value = Value::invalid();
+        return first + 3;
+    }
+
+    double number = 0.0;
+    const char * it = parseNumber(first, last, number);
+    if (!it) {
+        return nullptr;
+    }
+
+    // the unit may be separated by whitespace
+    const char * unitBegin = skipSpaces(it, last);
+    const char * unitEnd = unitBegin;
+    while (unitEnd != last && isLetter(*unitEnd)) {
+        ++unitEnd;
+    }
+
+    Unit unit = Unit::Point;
+    if (unitEnd == unitBegin) {
+        // no unit given, implicitly pt
+        value = Value(number, Unit::Point);
+        return it;
+    } else if (unitEnd - unitBegin != 2) {
+        return nullptr;
+    } else if (std::memcmp(unitBegin, "pt", 2) == 0) {
+        unit = Unit::Point;
+    } else if (std::memcmp(unitBegin, "mm", 2) == 0) {
+        unit = Unit::Millimeter;
+    } else if (std::memcmp(unitBegin, "cm", 2) == 0) {
+        unit = Unit::Centimeter;
+    } else if (std::memcmp(unitBegin, "in", 2) == 0) {
+        unit = Unit::Inch;
+    } else {
+        return nullptr;
+    }
+
+    value = Value(number, unit);
+    return unitEnd;
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
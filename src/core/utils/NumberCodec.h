@@ -0,0 +1,120 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2013-2014 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_NUMBER_CODEC_H
+#define TIKZ_NUMBER_CODEC_H
+
+#include "tikz.h"
+
+#include <QString>
+#include <QVarLengthArray>
+
+namespace tikz
+{
+
+class Value;
+
+/**
+ * Locale-independent conversion between numbers and text, used by the
+ * string forms of Value, Pos and MetaPos, and by the JsonWriter.
+ *
+ * All functions work on plain char ranges, so that neither regular
+ * expressions nor temporary QStrings are involved. The format functions
+ * write at most BufferSize chars, and return the end of the written chars.
+ * The parse functions return the end of the parsed chars, or a null
+ * pointer if the text does not start with a valid number.
+ */
+namespace codec
+{
+    /**
+     * Buffer size that is sufficient for any number written by the format
+     * functions. Numbers in fixed notation take up to 327 digits.
+     */
+    constexpr int BufferSize = 400;
+
+    /**
+     * Writes the shortest representation of @p value that is parsed back
+     * to exactly @p value, e.g. 0.1 as "0.1", and 1e+300 as "1e+300".
+     */
+    char * formatShortest(char * first, char * last, double value);
+
+    /**
+     * Writes @p value in fixed notation with at most 15 significant digits.
+     * This removes the rounding noise of calculations, e.g. 0.1 + 0.2 is
+     * written as "0.3". Each number with at most 15 significant digits is
+     * written as is, and therefore parsed back to exactly @p value.
+     */
+    char * formatFixed(char * first, char * last, double value);
+
+    /**
+     * Writes the string form of @p value, e.g. "3.5cm", see Value::toString().
+     */
+    char * formatValue(char * first, char * last, const Value & value);
+
+    /**
+     * Parses a number with optional sign, fraction and exponent, e.g.
+     * "+3.5", ".5", "5." or "1e-3".
+     */
+    const char * parseNumber(const char * first, const char * last, double & value);
+
+    /**
+     * Parses an integer with optional sign, e.g. "42" or "-7". Integers
+     * that do not fit into qint64 are not accepted.
+     */
+    const char * parseInteger(const char * first, const char * last, qint64 & value);
+
+    /**
+     * Parses the string form of a Value, i.e. a number followed by an
+     * optional unit, e.g. "3.5cm" or "3.5 cm". A number without unit is
+     * in Unit::Point. Leading whitespace is skipped.
+     */
+    const char * parseValue(const char * first, const char * last, Value & value);
+
+    /**
+     * Returns the first char in [@p first, @p last) that is no whitespace.
+     */
+    inline const char * skipSpaces(const char * first, const char * last)
+    {
+        while (first != last && (*first == ' ' || *first == '\t' || *first == '\n' || *first == '\r')) {
+            ++first;
+        }
+        return first;
+    }
+
+    /**
+     * Copies @p str to @p buffer as Latin-1 text, so that it can be parsed
+     * without allocating memory for short strings.
+     */
+    template <int Prealloc>
+    inline void toLatin1(const QString & str, QVarLengthArray<char, Prealloc> & buffer)
+    {
+        const int size = str.size();
+        const QChar * data = str.constData();
+        buffer.resize(size);
+        for (int i = 0; i < size; ++i) {
+            buffer[i] = data[i].toLatin1();
+        }
+    }
+}
+
+}
+
+#endif // TIKZ_NUMBER_CODEC_H
+
+// kate: indent-width 4; replace-tabs on;
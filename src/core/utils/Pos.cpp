@@ -18,6 +18,13 @@
  */
 
 #include "Pos.h"
+#include "NumberCodec.h"
+
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonValue>
+
+#include <cstring>
 
 namespace tikz {
 
@@ -26,36 +33,85 @@ QString Pos::toString() const
     // we require a valid number
     Q_ASSERT(isValid());
 
-    return QLatin1Char('(') + m_x.toString()
-      + QLatin1String(", ") + m_y.toString()
-      + QLatin1Char(')');
+    char buffer[2 * codec::BufferSize + 4];
+    char * const last = buffer + sizeof(buffer);
+    char * it = buffer;
+    *it++ = '(';
+    it = codec::formatValue(it, last, m_x);
+    *it++ = ',';
+    *it++ = ' ';
+    it = codec::formatValue(it, last, m_y);
+    *it++ = ')';
+
+    return QString::fromLatin1(buffer, it - buffer);
 }
 
 Pos Pos::fromString(const QString & str)
 {
     // format example: (12.50cm, -13.5pt)
-    
-    // 1. find index of '(', ',', and ')'
-    const int indexOfOpen = str.indexOf('(');
-    const int indexOfComma = str.indexOf(',');
-    const int indexOfClose = str.indexOf(')');
+    QVarLengthArray<char, 64> buffer;
+    codec::toLatin1(str, buffer);
+    const char * it = buffer.constData();
+    const char * const last = it + buffer.size();
 
     // for now: strict sanity check
     // FIXME: In a releas, this should be more tolerant
-    Q_ASSERT(indexOfOpen >= 0);
-    Q_ASSERT(indexOfComma >= 0);
-    Q_ASSERT(indexOfClose >= 0);
-    Q_ASSERT(indexOfComma > indexOfOpen);
-    Q_ASSERT(indexOfClose > indexOfOpen);
-    Q_ASSERT(indexOfClose > indexOfComma);
+    Value x;
+    Value y;
+    it = static_cast<const char *>(std::memchr(it, '(', last - it));
+    if (it) {
+        it = codec::parseValue(it + 1, last, x);
+    }
+    if (it) {
+        it = codec::skipSpaces(it, last);
+        it = (it != last && *it == ',') ? codec::parseValue(it + 1, last, y) : nullptr;
+    }
+    if (it) {
+        it = codec::skipSpaces(it, last);
+    }
+    if (! it || it == last || *it != ')') {
+        Q_ASSERT(false);
+        return Pos();
+    }
+
+    return Pos(x, y);
+}
 
-    // 2. extract 
-    const QString p1 = str.mid(indexOfOpen + 1, indexOfComma - (indexOfOpen + 1)).trimmed();
-    const QString p2 = str.mid(indexOfComma + 1, indexOfClose - (indexOfComma + 1)).trimmed();
+QJsonValue Pos::toJson() const
+{
+    if (m_x.unit() == m_y.unit()) {
+        return QJsonArray { m_x.value(), m_y.value(), tikz::toString(m_x.unit()) };
+    }
 
-//     qDebug() << "reading Pos from" << str << "results in:" << p1 << p2;
+    return QJsonArray { m_x.toJson(), m_y.toJson() };
+}
 
-    return Pos(Value::fromString(p1), Value::fromString(p2));
+Pos Pos::fromJson(const QJsonValue & json)
+{
+    if (! json.isArray()) {
+        return fromString(json.toString());
+    }
+
+    const QJsonArray array = json.toArray();
+    if (array.size() == 3) {
+        const Unit unit = toEnum<Unit>(array[2].toString());
+        return Pos(Value(array[0].toDouble(), unit), Value(array[1].toDouble(), unit));
+    }
+
+    return Pos(Value::fromJson(array[0]), Value::fromJson(array[1]));
+}
+
+QDataStream & operator<<(QDataStream & stream, const Pos & pos)
+{
+    return stream << pos.x() << pos.y();
+}
+
+QDataStream & operator>>(QDataStream & stream, Pos & pos)
+{
+    Value x, y;
+    stream >> x >> y;
+    pos = Pos(x, y);
+    return stream;
 }
 
 }
@@ -119,6 +119,18 @@ class TIKZKITCORE_EXPORT Pos
          */
         static Pos fromString(const QString & str);
 
+        /**
+         * Convert this Pos to json in the form [x, y, "unit"]. If x and y
+         * have different units, the form is [[x, "unit"], [y, "unit"]].
+         */
+        QJsonValue toJson() const;
+
+        /**
+         * Convert @p json to a Pos. Both the forms of toJson() and the
+         * string form of toString() are supported.
+         */
+        static Pos fromJson(const QJsonValue & json);
+
     //
     // operators
     //
@@ -269,6 +281,16 @@ inline Pos operator/(qreal divisor, const Pos & pos)
     return Pos(pos.x() / divisor, pos.y() / divisor);
 }
 
+/**
+ * Writes @p pos in binary form to @p stream.
+ */
+TIKZKITCORE_EXPORT QDataStream & operator<<(QDataStream & stream, const Pos & pos);
+
+/**
+ * Reads @p pos in binary form from @p stream.
+ */
+TIKZKITCORE_EXPORT QDataStream & operator>>(QDataStream & stream, Pos & pos);
+
 }
 
 namespace QTest
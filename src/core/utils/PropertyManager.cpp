@@ -18,84 +18,248 @@
  */
 
 #include "PropertyManager.h"
-#include "Document.h"
+#include "PropertyTable.h"
 
-#include <QFile>
+#include <algorithm>
+#include <iterator>
 
 namespace tikz {
 namespace core {
 
-PropertyInfo::PropertyInfo(const QString & name, const QJsonObject & json)
-    : m_name(name)
-    , m_json(json)
-{
-}
-
 bool PropertyInfo::isValid() const
 {
-    return !m_json.isEmpty();
+    return m_data && m_data->type;
 }
 
-QString PropertyInfo::type() const
+QLatin1String PropertyInfo::type() const
 {
-    return m_json["type"].toString();
+    return QLatin1String(m_data ? m_data->type : nullptr);
 }
 
-QString PropertyInfo::name() const
+QLatin1String PropertyInfo::name() const
 {
-    return m_name;
+    return QLatin1String(m_data ? m_data->name : nullptr);
 }
 
-QString PropertyInfo::title() const
+QLatin1String PropertyInfo::title() const
 {
-    return m_json["title"].toString();
+    return QLatin1String(m_data ? m_data->title : nullptr);
 }
 
 QVariant PropertyInfo::minimum() const
 {
-    return m_json["minimum"].toVariant();
+    if (!m_data || !m_data->minimum) {
+        return QVariant();
+    }
+    return m_data->numericRange ? QVariant(QByteArray(m_data->minimum).toDouble())
+                                : QVariant(QString::fromLatin1(m_data->minimum));
 }
 
 QVariant PropertyInfo::maximum() const
 {
-    return m_json["maximum"].toVariant();
+    if (!m_data || !m_data->maximum) {
+        return QVariant();
+    }
+    return m_data->numericRange ? QVariant(QByteArray(m_data->maximum).toDouble())
+                                : QVariant(QString::fromLatin1(m_data->maximum));
 }
 
 double PropertyInfo::singleStep() const
 {
-    return m_json["singleStep"].toDouble(1.0);
+    return m_data ? m_data->singleStep : 1.0;
 }
 
-QString PropertyInfo::modifiedFunction() const
+QLatin1String PropertyInfo::modifiedFunction() const
 {
-    return m_json["modified"].toString();
+    return QLatin1String(m_data ? m_data->modified : nullptr);
 }
 
 bool PropertyInfo::isResettable() const
 {
-    return !m_json["reset"].toString().isEmpty();
+    return !resetFunction().isEmpty();
 }
 
-QString PropertyInfo::resetFunction() const
+QLatin1String PropertyInfo::resetFunction() const
 {
-    return m_json["reset"].toString();
+    return QLatin1String(m_data ? m_data->reset : nullptr);
 }
 
-PropertyManager::PropertyManager()
+// helper: returns the index of the method @p function() of @p metaObject
+static int methodIndex(const QMetaObject * metaObject, QLatin1String function)
+{
+    if (function.isEmpty()) {
+        return -1;
+    }
+
+    const QByteArray signature = QByteArray(function.data(), function.size()) + "()";
+    return metaObject->indexOfMethod(signature.constData());
+}
+
+PropertyAccessor::PropertyAccessor(const QMetaObject * metaObject, const PropertyInfo & info)
 {
-    QFile file("../data/properties.json");
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Could not read file properties.json";
+    Q_ASSERT(metaObject);
+
+    const int index = metaObject->indexOfProperty(info.name().data());
+    if (index < 0) {
         return;
     }
-    m_json = QJsonDocument::fromJson(file.readAll());
+    m_property = metaObject->property(index);
+
+    m_modifiedIndex = methodIndex(metaObject, info.modifiedFunction());
+    if (m_modifiedIndex < 0 && !info.modifiedFunction().isEmpty()) {
+        tikz::debug(QStringLiteral("properties.json: Invalid modified getter ") + info.modifiedFunction());
+    }
+
+    m_resetIndex = methodIndex(metaObject, info.resetFunction());
+    if (m_resetIndex < 0 && !info.resetFunction().isEmpty()) {
+        tikz::debug(QStringLiteral("properties.json: Invalid reset function ") + info.resetFunction());
+    }
+}
+
+bool PropertyAccessor::isValid() const
+{
+    return m_property.isValid();
+}
+
+bool PropertyAccessor::isResettable() const
+{
+    return m_resetIndex >= 0;
+}
+
+QVariant PropertyAccessor::read(const QObject * object) const
+{
+    Q_ASSERT(isValid());
+    return m_property.read(object);
+}
+
+bool PropertyAccessor::write(QObject * object, const QVariant & value) const
+{
+    Q_ASSERT(isValid());
+    return m_property.write(object, value);
+}
+
+bool PropertyAccessor::isModified(const QObject * object, bool * ok) const
+{
+    if (ok) {
+        *ok = true;
+    }
+
+    if (m_modifiedIndex < 0) {
+        return true;
+    }
+
+    bool modified = false;
+    void * args[] = { &modified };
+    const bool called = QMetaObject::metacall(const_cast<QObject *>(object),
+                                              QMetaObject::InvokeMetaMethod,
+                                              m_modifiedIndex, args) < 0;
+    if (ok) {
+        *ok = called;
+    }
+    return modified;
+}
+
+bool PropertyAccessor::reset(QObject * object) const
+{
+    if (m_resetIndex < 0) {
+        return false;
+    }
+
+    void * args[] = { nullptr };
+    return QMetaObject::metacall(object, QMetaObject::InvokeMetaMethod,
+                                 m_resetIndex, args) < 0;
+}
+
+PropertyManager::PropertyManager()
+{
+    Q_ASSERT(std::is_sorted(std::begin(s_propertyTable), std::end(s_propertyTable),
+        [](const PropertyData & a, const PropertyData & b) {
+            return qstrcmp(a.name, b.name) < 0;
+        }));
+}
+
+int PropertyManager::tableIndex(const QString & name) const
+{
+    // the generated table is sorted by name
+    const auto begin = std::begin(s_propertyTable);
+    const auto end = std::end(s_propertyTable);
+    const auto it = std::lower_bound(begin, end, name,
+        [](const PropertyData & data, const QString & name) {
+            return QString::compare(QLatin1String(data.name), name) < 0;
+        });
+
+    if (it != end && QLatin1String(it->name) == name) {
+        return static_cast<int>(it - begin);
+    }
+    return -1;
 }
 
 PropertyInfo PropertyManager::info(const QString & name) const
 {
-    return PropertyInfo(name, m_json["properties"][name].toObject());
+    const int index = tableIndex(name);
+    return (index < 0) ? PropertyInfo() : PropertyInfo(&s_propertyTable[index]);
+}
+
+PropertyInfo PropertyManager::info(int id) const
+{
+    Q_ASSERT(id >= 0 && id < s_propertyTableSize + static_cast<int>(m_extraData.size()));
+    return (id < s_propertyTableSize) ? PropertyInfo(&s_propertyTable[id])
+                                      : PropertyInfo(&m_extraData[id - s_propertyTableSize]);
+}
+
+int PropertyManager::propertyId(const QString & name)
+{
+    const int index = tableIndex(name);
+    if (index >= 0) {
+        return index;
+    }
+
+    const auto it = m_extraIds.constFind(name);
+    if (it != m_extraIds.constEnd()) {
+        return *it;
+    }
+
+    // not described in properties.json: register without meta information
+    const int id = s_propertyTableSize + static_cast<int>(m_extraData.size());
+    m_extraNames.push_back(name.toLatin1());
+    m_extraData.push_back(PropertyData{ m_extraNames.back().constData(),
+                                        nullptr, nullptr, nullptr, nullptr,
+                                        nullptr, nullptr, false, 1.0 });
+    m_extraIds.insert(name, id);
+    return id;
+}
+
+QString PropertyManager::propertyName(int id) const
+{
+    return info(id).name();
 }
 
+PropertyAccessor PropertyManager::accessor(const QMetaObject * metaObject, int id)
+{
+    const int count = s_propertyTableSize + static_cast<int>(m_extraData.size());
+    Q_ASSERT(id >= 0 && id < count);
+
+    // extend the table of this class by all properties registered meanwhile
+    auto & table = m_accessors[metaObject];
+    if (id >= table.size()) {
+        table.reserve(count);
+        for (int i = table.size(); i < count; ++i) {
+            table.append(PropertyAccessor(metaObject, info(i)));
+        }
+    }
+
+    return table[id];
+}
+
+void PropertyManager::clearRegisteredProperties()
+{
+    m_extraIds.clear();
+    m_extraData.clear();
+    m_extraNames.clear();
+
+    // the accessor tables contain accessors of the unregistered ids
+    m_accessors.clear();
+}
 
 PropertyManager & propertyManager()
 {
@@ -22,32 +22,68 @@
 #include "tikz.h"
 #include "tikz_export.h"
 
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QDebug>
+#include <QMetaProperty>
+#include <QHash>
+#include <QVector>
+
+#include <deque>
 
 namespace tikz {
 namespace core {
 
+/**
+ * Meta information about one property, as described in properties.json.
+ *
+ * The table of all properties is generated from data/properties.json at
+ * build time, see generator/PropertyTableGenerator.cpp. Strings that are
+ * not set in properties.json are null pointers.
+ */
+struct PropertyData
+{
+    const char * name;
+    const char * type;
+    const char * title;
+    const char * modified;
+    const char * reset;
+    const char * minimum;
+    const char * maximum;
+    bool numericRange;  // true, if minimum and maximum are numbers
+    double singleStep;
+};
+
+/**
+ * Non-allocating view on the PropertyData of one property.
+ * PropertyInfo objects are cheap to copy, and remain valid as long as
+ * the PropertyManager exists.
+ */
 class TIKZKITCORE_EXPORT PropertyInfo
 {
 public:
     /**
-     * Constructor for property @p name based on the data @p json.
+     * Default constructor. Creates an invalid PropertyInfo.
+     */
+    constexpr PropertyInfo() noexcept = default;
+
+    /**
+     * Constructor for the meta information @p data.
      */
-    PropertyInfo(const QString & name, const QJsonObject & json);
+    constexpr explicit PropertyInfo(const PropertyData * data) noexcept
+        : m_data(data)
+    {
+    }
 
     //! Check whether the property is valid.
+    //! Properties not described in properties.json are invalid.
     bool isValid() const;
 
     //! Returns the property type.
-    QString type() const;
+    QLatin1String type() const;
 
     //! Returns the property name.
-    QString name() const;
+    QLatin1String name() const;
 
     //! Returns a description / title of the property.
-    QString title() const;
+    QLatin1String title() const;
 
     //! Returns the minimum value. Not supported by all properties.
     QVariant minimum() const;
@@ -61,22 +97,75 @@ public:
 
     //! Returns a function to be called via QObject::invokeMethod() to check
     //! whether this property was set. Not supported by all properties.
-    QString modifiedFunction() const;
+    QLatin1String modifiedFunction() const;
 
     //! Returns true, if this property can be unset.
     bool isResettable() const;
 
     //! Returns true, if this property can be unset.
-    QString resetFunction() const;
+    QLatin1String resetFunction() const;
 
 private:
-    QString m_name;
-    QJsonObject m_json;
+    const PropertyData * m_data = nullptr;
+};
+
+/**
+ * The PropertyAccessor class provides indexed access to one property of
+ * one class derived from QObject.
+ *
+ * All method and property lookups by name are performed once when the
+ * accessor is created. Reading, writing, checking the modified state and
+ * resetting are then direct calls through the QMetaObject system.
+ *
+ * Accessors are created and owned by the PropertyManager, use
+ * PropertyManager::accessor() to get an accessor.
+ */
+class TIKZKITCORE_EXPORT PropertyAccessor
+{
+public:
+    /**
+     * Default constructor. Creates an invalid PropertyAccessor.
+     */
+    PropertyAccessor() = default;
+
+    /**
+     * Constructor for property @p info of the class @p metaObject.
+     */
+    PropertyAccessor(const QMetaObject * metaObject, const PropertyInfo & info);
+
+    //! Returns true, if the class has a property with this name.
+    bool isValid() const;
+
+    //! Returns true, if this property can be unset.
+    bool isResettable() const;
+
+    //! Returns the value of this property of @p object.
+    QVariant read(const QObject * object) const;
+
+    //! Sets the value of this property of @p object to @p value.
+    //! Returns false, if the value could not be set.
+    bool write(QObject * object, const QVariant & value) const;
+
+    //! Returns true, if this property is set for @p object.
+    //! Returns true as well, if the property has no modified function.
+    //! If non-null, @p ok is set to false if the modified function exists
+    //! but could not be called.
+    bool isModified(const QObject * object, bool * ok = nullptr) const;
+
+    //! Unsets this property of @p object.
+    //! Returns false, if this property is not resettable.
+    bool reset(QObject * object) const;
+
+private:
+    QMetaProperty m_property;
+    int m_modifiedIndex = -1;
+    int m_resetIndex = -1;
 };
 
 /**
  * The PropertyManager class provides meta information about properties.
- * The meta information is loaded from a json file.
+ * The meta information is compiled in from data/properties.json, i.e.,
+ * no file is read and no JSON is parsed at runtime.
  *
  * @see Entity
  */
@@ -84,7 +173,7 @@ class TIKZKITCORE_EXPORT PropertyManager
 {
 public:
     /**
-     * Default constructor. Creates an invalid PropertyManager.
+     * Default constructor.
      */
     PropertyManager();
 
@@ -93,11 +182,66 @@ public:
      */
     PropertyInfo info(const QString & name) const;
 
+    /**
+     * Returns the meta information for the property with id @p id.
+     */
+    PropertyInfo info(int id) const;
+
+    /**
+     * Returns the compact id of the property @p name. Ids are assigned
+     * in the order properties are registered, and are not persistent,
+     * i.e. always save the property name instead.
+     * Properties described in properties.json have the ids 0 to n-1.
+     * Unknown property names are registered on the fly, since not all
+     * properties are described in the properties.json file.
+     */
+    int propertyId(const QString & name);
+
+    /**
+     * Returns the name of the property with id @p id.
+     */
+    QString propertyName(int id) const;
+
+    /**
+     * Returns the accessor for the property with id @p id of the class
+     * described by @p metaObject. The accessor table of a class is built
+     * on first use, afterwards this is a hash and an array lookup.
+     * The accessor is returned by value, since registering further
+     * properties may reallocate the accessor table.
+     */
+    PropertyAccessor accessor(const QMetaObject * metaObject, int id);
+
+    /**
+     * Unregisters all properties registered on the fly, so that the next
+     * unknown property name gets the first free id again. This simulates
+     * a new application run, and is meant for unit tests only: all ids of
+     * such properties held elsewhere become invalid.
+     */
+    void clearRegisteredProperties();
+
 private:
     /**
-     * Internal data structure for querying meta data about properties.
+     * Returns the index of @p name in the generated table, or -1.
+     */
+    int tableIndex(const QString & name) const;
+
+private:
+    /**
+     * Names and meta information of properties registered on the fly.
+     * std::deque keeps the elements in place when appending.
+     */
+    std::deque<QByteArray> m_extraNames;
+    std::deque<PropertyData> m_extraData;
+
+    /**
+     * Maps names of properties registered on the fly to property ids.
+     */
+    QHash<QString, int> m_extraIds;
+
+    /**
+     * Accessor tables, indexed by property id.
      */
-    QJsonDocument m_json;
+    QHash<const QMetaObject *, QVector<PropertyAccessor>> m_accessors;
 };
 
 /**
@@ -0,0 +1,562 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "RTree.h"
+
+#include <QHash>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace tikz {
+namespace core {
+
+// maximum and minimum number of entries per tree node
+static constexpr int MaxEntries = 16;
+static constexpr int MinEntries = 6;
+
+/**
+ * Axis aligned box. In contrast to QRectF, empty boxes are united
+ * correctly, which is required for entities located at a single point.
+ */
+struct RTreeBox
+{
+    qreal x1 = 0.0;
+    qreal y1 = 0.0;
+    qreal x2 = 0.0;
+    qreal y2 = 0.0;
+
+    static RTreeBox fromRect(const QRectF & rect)
+    {
+        const QRectF r = rect.normalized();
+        return RTreeBox{r.left(), r.top(), r.right(), r.bottom()};
+    }
+
+    QRectF toRect() const
+    {
+        return QRectF(QPointF(x1, y1), QPointF(x2, y2));
+    }
+
+    qreal area() const
+    {
+        return (x2 - x1) * (y2 - y1);
+    }
+
+    RTreeBox united(const RTreeBox & other) const
+    {
+        return RTreeBox{std::min(x1, other.x1), std::min(y1, other.y1),
+                   std::max(x2, other.x2), std::max(y2, other.y2)};
+    }
+
+    qreal enlargement(const RTreeBox & other) const
+    {
+        return united(other).area() - area();
+    }
+
+    bool intersects(const RTreeBox & other) const
+    {
+        return x1 <= other.x2 && other.x1 <= x2
+            && y1 <= other.y2 && other.y1 <= y2;
+    }
+
+    qreal squaredDistance(const QPointF & p) const
+    {
+        const qreal dx = std::max({x1 - p.x(), qreal(0), p.x() - x2});
+        const qreal dy = std::max({y1 - p.y(), qreal(0), p.y() - y2});
+        return dx * dx + dy * dy;
+    }
+
+    bool operator==(const RTreeBox & other) const
+    {
+        return x1 == other.x1 && y1 == other.y1
+            && x2 == other.x2 && y2 == other.y2;
+    }
+};
+
+struct RTreeNode;
+
+/**
+ * Entry of a tree node: either a child node, or an indexed Uid in leaves.
+ */
+struct RTreeEntry
+{
+    RTreeBox box;
+    RTreeNode * child = nullptr;
+    Uid uid;
+};
+
+struct RTreeNode
+{
+    RTreeNode * parent = nullptr;
+    bool leaf = true;
+    QVector<RTreeEntry> entries;
+};
+
+class RTreePrivate
+{
+    public:
+        RTreePrivate()
+            : root(new RTreeNode())
+        {
+        }
+
+        ~RTreePrivate()
+        {
+            deleteTree(root);
+        }
+
+        // root node, never null
+        RTreeNode * root;
+
+        // leaf node that holds the entry of a Uid
+        QHash<Uid, RTreeNode *> leaves;
+
+    public:
+        static void deleteTree(RTreeNode * node)
+        {
+            if (!node->leaf) {
+                for (const auto & entry : node->entries) {
+                    deleteTree(entry.child);
+                }
+            }
+            delete node;
+        }
+
+        static RTreeBox nodeBox(const RTreeNode * node)
+        {
+            Q_ASSERT(!node->entries.isEmpty());
+            RTreeBox box = node->entries.first().box;
+            for (int i = 1; i < node->entries.size(); ++i) {
+                box = box.united(node->entries[i].box);
+            }
+            return box;
+        }
+
+        // returns the index of the entry in the parent that refers to node
+        static int indexInParent(const RTreeNode * node)
+        {
+            Q_ASSERT(node->parent);
+            const auto & entries = node->parent->entries;
+            for (int i = 0; i < entries.size(); ++i) {
+                if (entries[i].child == node) {
+                    return i;
+                }
+            }
+            Q_ASSERT(false);
+            return -1;
+        }
+
+        // returns the index of the entry of uid in the leaf
+        static int indexInLeaf(const RTreeNode * leaf, const Uid & uid)
+        {
+            const auto & entries = leaf->entries;
+            for (int i = 0; i < entries.size(); ++i) {
+                if (entries[i].uid == uid) {
+                    return i;
+                }
+            }
+            Q_ASSERT(false);
+            return -1;
+        }
+
+        // recomputes the boxes of all ancestors of node
+        static void adjustBoxes(RTreeNode * node)
+        {
+            while (node->parent) {
+                node->parent->entries[indexInParent(node)].box = nodeBox(node);
+                node = node->parent;
+            }
+        }
+
+        // descends to the leaf that needs the least enlargement for box
+        RTreeNode * chooseLeaf(const RTreeBox & box) const
+        {
+            RTreeNode * node = root;
+            while (!node->leaf) {
+                const RTreeEntry * best = nullptr;
+                qreal bestEnlargement = std::numeric_limits<qreal>::max();
+                qreal bestArea = std::numeric_limits<qreal>::max();
+                for (const auto & entry : node->entries) {
+                    const qreal enlargement = entry.box.enlargement(box);
+                    const qreal area = entry.box.area();
+                    if (enlargement < bestEnlargement
+                        || (enlargement == bestEnlargement && area < bestArea)) {
+                        best = &entry;
+                        bestEnlargement = enlargement;
+                        bestArea = area;
+                    }
+                }
+                node = best->child;
+            }
+            return node;
+        }
+
+        // adds entry to node, and splits node if it overflows
+        void addEntry(RTreeNode * node, const RTreeEntry & entry)
+        {
+            node->entries.append(entry);
+            if (entry.child) {
+                entry.child->parent = node;
+            } else {
+                leaves.insert(entry.uid, node);
+            }
+
+            if (node->entries.size() > MaxEntries) {
+                split(node);
+            } else {
+                adjustBoxes(node);
+            }
+        }
+
+        // sets the owner of all entries of node to node
+        void adopt(RTreeNode * node)
+        {
+            for (const auto & entry : node->entries) {
+                if (entry.child) {
+                    entry.child->parent = node;
+                } else {
+                    leaves[entry.uid] = node;
+                }
+            }
+        }
+
+        // quadratic split of Guttman's R-tree
+        void split(RTreeNode * node)
+        {
+            QVector<RTreeEntry> remaining = std::move(node->entries);
+
+            // pick the two entries that waste the most area if put together
+            int seedA = 0;
+            int seedB = 1;
+            qreal maxWaste = -std::numeric_limits<qreal>::max();
+            for (int i = 0; i < remaining.size(); ++i) {
+                for (int j = i + 1; j < remaining.size(); ++j) {
+                    const qreal waste = remaining[i].box.united(remaining[j].box).area()
+                                      - remaining[i].box.area() - remaining[j].box.area();
+                    if (waste > maxWaste) {
+                        maxWaste = waste;
+                        seedA = i;
+                        seedB = j;
+                    }
+                }
+            }
+
+            QVector<RTreeEntry> groupA;
+            QVector<RTreeEntry> groupB;
+            groupA.append(remaining[seedA]);
+            groupB.append(remaining[seedB]);
+            RTreeBox boxA = remaining[seedA].box;
+            RTreeBox boxB = remaining[seedB].box;
+            remaining.removeAt(seedB); // seedB > seedA
+            remaining.removeAt(seedA);
+
+            while (!remaining.isEmpty()) {
+                // make sure both groups get the minimum number of entries
+                if (groupA.size() + remaining.size() == MinEntries) {
+                    for (const auto & entry : remaining) {
+                        boxA = boxA.united(entry.box);
+                        groupA.append(entry);
+                    }
+                    break;
+                }
+                if (groupB.size() + remaining.size() == MinEntries) {
+                    for (const auto & entry : remaining) {
+                        boxB = boxB.united(entry.box);
+                        groupB.append(entry);
+                    }
+                    break;
+                }
+
+                // pick the entry with the strongest preference for one group
+                int next = 0;
+                qreal maxDiff = -1;
+                for (int i = 0; i < remaining.size(); ++i) {
+                    const qreal diff = std::abs(boxA.enlargement(remaining[i].box)
+                                              - boxB.enlargement(remaining[i].box));
+                    if (diff > maxDiff) {
+                        maxDiff = diff;
+                        next = i;
+                    }
+                }
+
+                const RTreeEntry entry = remaining.takeAt(next);
+                const qreal enlargementA = boxA.enlargement(entry.box);
+                const qreal enlargementB = boxB.enlargement(entry.box);
+                bool toA = enlargementA < enlargementB;
+                if (enlargementA == enlargementB) {
+                    toA = boxA.area() < boxB.area()
+                       || (boxA.area() == boxB.area() && groupA.size() <= groupB.size());
+                }
+
+                if (toA) {
+                    boxA = boxA.united(entry.box);
+                    groupA.append(entry);
+                } else {
+                    boxB = boxB.united(entry.box);
+                    groupB.append(entry);
+                }
+            }
+
+            node->entries = std::move(groupA);
+            auto sibling = new RTreeNode();
+            sibling->leaf = node->leaf;
+            sibling->entries = std::move(groupB);
+            adopt(node);
+            adopt(sibling);
+
+            if (node == root) {
+                // grow the tree by one level
+                root = new RTreeNode();
+                root->leaf = false;
+                root->entries.append(RTreeEntry{boxA, node, Uid()});
+                root->entries.append(RTreeEntry{boxB, sibling, Uid()});
+                node->parent = root;
+                sibling->parent = root;
+            } else {
+                node->parent->entries[indexInParent(node)].box = boxA;
+                addEntry(node->parent, RTreeEntry{boxB, sibling, Uid()});
+            }
+        }
+
+        // collects all leaf entries of the subtree, and deletes its nodes
+        void collectEntries(RTreeNode * node, QVector<RTreeEntry> & entries)
+        {
+            if (node->leaf) {
+                for (const auto & entry : node->entries) {
+                    entries.append(entry);
+                }
+            } else {
+                for (const auto & entry : node->entries) {
+                    collectEntries(entry.child, entries);
+                }
+            }
+            delete node;
+        }
+
+        // removes underflowing nodes on the path from leaf to the root,
+        // and reinserts their entries
+        void condense(RTreeNode * node)
+        {
+            QVector<RTreeEntry> orphans;
+
+            while (node != root) {
+                RTreeNode * parent = node->parent;
+                if (node->entries.size() < MinEntries) {
+                    parent->entries.removeAt(indexInParent(node));
+                    collectEntries(node, orphans);
+                } else {
+                    parent->entries[indexInParent(node)].box = nodeBox(node);
+                }
+                node = parent;
+            }
+
+            // shrink the tree, if the root has a single child
+            while (!root->leaf && root->entries.size() == 1) {
+                RTreeNode * oldRoot = root;
+                root = root->entries.first().child;
+                root->parent = nullptr;
+                delete oldRoot;
+            }
+
+            // an inner root without children is an empty tree
+            if (!root->leaf && root->entries.isEmpty()) {
+                root->leaf = true;
+            }
+
+            for (const auto & entry : orphans) {
+                addEntry(chooseLeaf(entry.box), entry);
+            }
+        }
+};
+
+RTree::RTree()
+    : d(new RTreePrivate())
+{
+}
+
+RTree::~RTree()
+{
+    delete d;
+}
+
+void RTree::insert(const Uid & uid, const QRectF & bounds)
+{
+    if (d->leaves.contains(uid)) {
+        update(uid, bounds);
+        return;
+    }
+
+    const RTreeBox box = RTreeBox::fromRect(bounds);
+    d->addEntry(d->chooseLeaf(box), RTreeEntry{box, nullptr, uid});
+}
+
+bool RTree::remove(const Uid & uid)
+{
+    RTreeNode * leaf = d->leaves.take(uid);
+    if (!leaf) {
+        return false;
+    }
+
+    leaf->entries.removeAt(RTreePrivate::indexInLeaf(leaf, uid));
+    d->condense(leaf);
+    return true;
+}
+
+void RTree::update(const Uid & uid, const QRectF & bounds)
+{
+    const RTreeBox box = RTreeBox::fromRect(bounds);
+
+    auto it = d->leaves.constFind(uid);
+    if (it != d->leaves.constEnd()) {
+        RTreeNode * leaf = *it;
+        RTreeEntry & entry = leaf->entries[RTreePrivate::indexInLeaf(leaf, uid)];
+        if (entry.box == box) {
+            return;
+        }
+
+        // small moves within the leaf's box do not change the structure
+        const RTreeBox leafBox = leaf->parent
+            ? leaf->parent->entries[RTreePrivate::indexInParent(leaf)].box
+            : RTreePrivate::nodeBox(leaf);
+        if (leafBox.united(box) == leafBox) {
+            entry.box = box;
+            RTreePrivate::adjustBoxes(leaf);
+            return;
+        }
+
+        remove(uid);
+    }
+
+    d->addEntry(d->chooseLeaf(box), RTreeEntry{box, nullptr, uid});
+}
+
+void RTree::clear()
+{
+    RTreePrivate::deleteTree(d->root);
+    d->root = new RTreeNode();
+    d->leaves.clear();
+}
+
+bool RTree::contains(const Uid & uid) const
+{
+    return d->leaves.contains(uid);
+}
+
+QRectF RTree::bounds(const Uid & uid) const
+{
+    const RTreeNode * leaf = d->leaves.value(uid, nullptr);
+    if (!leaf) {
+        return QRectF();
+    }
+    return leaf->entries[RTreePrivate::indexInLeaf(leaf, uid)].box.toRect();
+}
+
+int RTree::size() const
+{
+    return d->leaves.size();
+}
+
+bool RTree::isEmpty() const
+{
+    return d->leaves.isEmpty();
+}
+
+QVector<Uid> RTree::intersecting(const QRectF & rect) const
+{
+    QVector<Uid> result;
+    if (d->root->entries.isEmpty()) {
+        return result;
+    }
+
+    const RTreeBox box = RTreeBox::fromRect(rect);
+    QVarLengthArray<const RTreeNode *, 64> stack;
+    stack.append(d->root);
+    while (!stack.isEmpty()) {
+        const RTreeNode * node = stack.last();
+        stack.removeLast();
+        for (const auto & entry : node->entries) {
+            if (!entry.box.intersects(box)) {
+                continue;
+            }
+            if (node->leaf) {
+                result.append(entry.uid);
+            } else {
+                stack.append(entry.child);
+            }
+        }
+    }
+    return result;
+}
+
+QVector<Uid> RTree::nearest(const QPointF & point, int k) const
+{
+    QVector<Uid> result;
+    if (k <= 0 || d->root->entries.isEmpty()) {
+        return result;
+    }
+
+    // best-first search: a candidate is either a tree node or a leaf entry
+    struct Candidate
+    {
+        qreal distance;
+        const RTreeNode * node;
+        Uid uid;
+
+        bool operator>(const Candidate & other) const
+        {
+            return distance > other.distance;
+        }
+    };
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    queue.push(Candidate{0.0, d->root, Uid()});
+
+    result.reserve(std::min(k, size()));
+    while (!queue.empty() && result.size() < k) {
+        const Candidate candidate = queue.top();
+        queue.pop();
+
+        if (!candidate.node) {
+            // a leaf entry: no other candidate is closer
+            result.append(candidate.uid);
+            continue;
+        }
+
+        const RTreeNode * node = candidate.node;
+        for (const auto & entry : node->entries) {
+            const qreal distance = entry.box.squaredDistance(point);
+            if (node->leaf) {
+                queue.push(Candidate{distance, nullptr, entry.uid});
+            } else {
+                queue.push(Candidate{distance, entry.child, Uid()});
+            }
+        }
+    }
+    return result;
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,134 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CORE_RTREE_H
+#define TIKZ_CORE_RTREE_H
+
+#include "tikz_export.h"
+#include "Uid.h"
+
+#include <QRectF>
+#include <QPointF>
+#include <QVector>
+
+namespace tikz {
+namespace core {
+
+class RTreePrivate;
+
+/**
+ * The RTree class is a spatial index over the bounding rectangles of
+ * entities, keyed by their Uid.
+ *
+ * The tree is maintained incrementally: insert(), remove() and update()
+ * run in O(log n) on average. Queries for all entities intersecting a
+ * rectangle, and for the k entities nearest to a point, only visit the
+ * branches of the tree that may contain results.
+ *
+ * In contrast to QRectF::united(), empty rectangles are supported as
+ * bounds, e.g. an entity located at a single point has the bounds
+ * QRectF(point, QSizeF(0, 0)).
+ *
+ * The Document uses an RTree to index the bounds of all Node%s and Path%s,
+ * see Document::entitiesIn() and Document::nearestEntities().
+ */
+class TIKZKITCORE_EXPORT RTree
+{
+    public:
+        /**
+         * Constructor, creates an empty tree.
+         */
+        RTree();
+
+        /**
+         * Destructor.
+         */
+        ~RTree();
+
+        /**
+         * Inserts @p uid with the bounding rectangle @p bounds.
+         * If @p uid is already contained, its bounds are updated.
+         */
+        void insert(const Uid & uid, const QRectF & bounds);
+
+        /**
+         * Removes @p uid. Returns @e true, if @p uid was contained.
+         */
+        bool remove(const Uid & uid);
+
+        /**
+         * Same as insert(). Does nothing if the bounds of @p uid did not change.
+         */
+        void update(const Uid & uid, const QRectF & bounds);
+
+        /**
+         * Removes all entries.
+         */
+        void clear();
+
+        /**
+         * Returns @e true, if @p uid is contained.
+         */
+        bool contains(const Uid & uid) const;
+
+        /**
+         * Returns the bounds of @p uid, or an invalid QRectF.
+         */
+        QRectF bounds(const Uid & uid) const;
+
+        /**
+         * Returns the number of entries.
+         */
+        int size() const;
+
+        /**
+         * Returns @e true, if the tree contains no entries.
+         */
+        bool isEmpty() const;
+
+    //
+    // queries
+    //
+    public:
+        /**
+         * Returns all entries whose bounds intersect @p rect.
+         * Touching borders count as intersection. The order is unspecified.
+         */
+        QVector<Uid> intersecting(const QRectF & rect) const;
+
+        /**
+         * Returns up to @p k entries whose bounds are closest to @p point,
+         * sorted by increasing distance. Entries containing @p point have
+         * the distance 0.
+         */
+        QVector<Uid> nearest(const QPointF & point, int k) const;
+
+    private:
+        RTree(const RTree &) = delete;
+        RTree & operator=(const RTree &) = delete;
+
+        RTreePrivate * const d;
+};
+
+}
+}
+
+#endif // TIKZ_CORE_RTREE_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -38,6 +38,14 @@ class Document;
  * The Uid is defined by an integer number that refers to an Entity of
  * the associated Document.
  *
+ * The id is used by the Document as slot index into its entity table.
+ * Additionally, a Uid may carry the generation of this slot. Uids that are
+ * handed out by the Document (e.g. Entity::uid()) carry the generation,
+ * so that a Uid that outlives its Entity (e.g. after Document::close())
+ * resolves to a null pointer instead of a different Entity with the same id.
+ * Uids created from ids only (e.g. when reading files) have generation 0
+ * and always resolve to the Entity currently stored in the slot.
+ *
  * @see Entity, Document
  */
 class TIKZKITCORE_EXPORT Uid
@@ -57,6 +65,17 @@ class TIKZKITCORE_EXPORT Uid
         {
         }
 
+        /**
+         * Constructor with value, type and slot generation.
+         * Typically, only the Document creates Uids with a generation.
+         */
+        explicit constexpr Uid(qint64 id, Document * doc, quint32 generation) noexcept
+            : m_document(doc)
+            , m_id(id)
+            , m_generation(generation)
+        {
+        }
+
         /**
          * Constructor with value and type.
          */
@@ -97,6 +116,15 @@ class TIKZKITCORE_EXPORT Uid
             return m_id;
         }
 
+        /**
+         * Get the slot generation this Uid was created for.
+         * A generation of 0 means the Uid is not bound to a generation.
+         */
+        inline constexpr quint32 generation() const noexcept
+        {
+            return m_generation;
+        }
+
         /**
          * Returns the Entity type Uid refers to.
          */
@@ -161,11 +189,17 @@ class TIKZKITCORE_EXPORT Uid
          * The value.
          */
         qint64 m_id = -1;
+
+        /**
+         * The slot generation, or 0 if unbound.
+         */
+        quint32 m_generation = 0;
 };
 
 /**
  * Equality operator.
  * Return @e true, if the Uid @p lhs refers to the same Entity as Uid @p rhs.
+ * The generation is not taken into account.
  */
 inline constexpr bool operator==(const Uid & lhs, const Uid & rhs) noexcept
 {
@@ -18,145 +18,70 @@
  */
 
 #include "Value.h"
+#include "NumberCodec.h"
 
-#include <QRegularExpression>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonValue>
 #include <QDebug>
 
 namespace tikz {
 
 QString Value::toString() const
 {
-    if (! isValid()) {
-        return QLatin1String("nan");
-    }
-
-    // use C locale with out thousand-',' separators
-    QLocale locale = QLocale::c();
-    locale.setNumberOptions(QLocale::OmitGroupSeparator);
-    QString number = locale.toString(m_value, 'f', 20);
-
-    // TikZ doesn't allow commas as separator
-    Q_ASSERT(! number.contains(QLatin1Char(',')));
-
-    // allow only a single '.' as floating point separator
-    Q_ASSERT(number.count(QLatin1Char('.')) <= 1);
-
-    int dotIndex = number.indexOf(QLatin1Char('.'));
-
-    // Rounding errors typically result in several consecutive '9' chars.
-    // Catch this case and fix it to get a nice reacable number.
-    int nineIndex;
-    if ((nineIndex = number.indexOf(QLatin1String("099999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "1");
-    } else if ((nineIndex = number.indexOf(QLatin1String("199999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "2");
-    } else if ((nineIndex = number.indexOf(QLatin1String("299999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "3");
-    } else if ((nineIndex = number.indexOf(QLatin1String("399999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "4");
-    } else if ((nineIndex = number.indexOf(QLatin1String("499999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "5");
-    } else if ((nineIndex = number.indexOf(QLatin1String("599999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "6");
-    } else if ((nineIndex = number.indexOf(QLatin1String("699999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "7");
-    } else if ((nineIndex = number.indexOf(QLatin1String("799999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "8");
-    } else if ((nineIndex = number.indexOf(QLatin1String("899999"))) > dotIndex) {
-        number.truncate(nineIndex + 1);
-        number.replace(nineIndex, 1, "9");
-    } else if ((nineIndex = number.indexOf(QLatin1String(".999999"))) == dotIndex) {
-        number.truncate(nineIndex);
-        number = QString::number(number.toInt() + 1);
-        dotIndex = -1;
-    }
-
-    // we have 20 digits after the '.', which is usually too much.
-    // Therefore, search for '00000' after the '.', and if we find these
-    // 5 consecutive zeros, just kill the rest.
-    // Example: the number 3.567 turns into 3.56700000000000017053. After
-    //          the truncation, it'll be '3.5670000000'
-    if (dotIndex >= 0) {
-        const int indexOfZeros = number.lastIndexOf(QLatin1String("00000"));
-        if (indexOfZeros > dotIndex) {
-            number.truncate(indexOfZeros);
-        }
-    }
+    char buffer[codec::BufferSize];
+    const char * end = codec::formatValue(buffer, buffer + codec::BufferSize, *this);
+    Q_ASSERT(end);
 
-    // beautify step I: remove trailing zeros, e.g. 3.5670000000 -> 3.567
-    while (dotIndex >= 0 && number.endsWith(QLatin1Char('0'))) {
-        number.truncate(number.length() - 1);
-    }
+    return QString::fromLatin1(buffer, end - buffer);
+}
 
-    // beautify step II: remove trailing dot, if applicable, e.g. 3. -> 3
-    if (number.endsWith(QLatin1Char('.'))) {
-        number.truncate(number.length() - 1);
-    }
+Value Value::fromString(const QString & str)
+{
+    // format example: 12.50cm
+    QVarLengthArray<char, 64> buffer;
+    codec::toLatin1(str, buffer);
 
-    QString suffix;
-    switch (m_unit) {
-        case Unit::Point: suffix = "pt"; break;
-        case Unit::Millimeter: suffix = "mm"; break;
-        case Unit::Centimeter: suffix = "cm"; break;
-        case Unit::Inch: suffix = "in"; break;
-        default: Q_ASSERT(false);
+    Value value;
+    if (! codec::parseValue(buffer.constData(), buffer.constData() + buffer.size(), value)) {
+        Q_ASSERT(false);
+        return Value();
     }
 
-    return number + suffix;
+    return value;
 }
 
-Value Value::fromString(const QString & str)
+QJsonValue Value::toJson() const
 {
-    // we require a valid number
-    if (str == QLatin1String("nan")) {
-        return invalid();
+    if (! isValid()) {
+        return QLatin1String("nan");
     }
 
-    // format example: 12.50cm
-    static QRegularExpression re("([-+]?\\d*\\.?\\d*)\\s*(\\w*)");
-
-    QRegularExpressionMatch match = re.match(str);
+    return QJsonArray { m_value, tikz::toString(m_unit) };
+}
 
-    if (! match.hasMatch()) {
-        Q_ASSERT(false);
-        return Value();
+Value Value::fromJson(const QJsonValue & json)
+{
+    if (json.isArray()) {
+        const QJsonArray array = json.toArray();
+        return Value(array[0].toDouble(), toEnum<Unit>(array[1].toString()));
     }
 
-    const QString number = match.captured(1);
-    const QString suffix = match.captured(2);
-
-//     qDebug() << str << "converts to:" << number << suffix;
-
-    Unit u;
-    if (suffix.isEmpty()) {
-        // assume pt
-        qDebug() << "no unit given, implicit conversion to pt: " << str;
-        u = Unit::Point;
-    } else if (suffix == "pt") {
-        u = Unit::Point;
-    } else if (suffix == "mm") {
-        u = Unit::Millimeter;
-    } else if (suffix == "cm") {
-        u = Unit::Centimeter;
-    } else if (suffix == "in") {
-        u = Unit::Inch;
-    } else {
-        Q_ASSERT(false);
-    }
+    return fromString(json.toString());
+}
 
-    bool ok;
-    const double val = number.toDouble(&ok);
-    Q_ASSERT(ok);
+QDataStream & operator<<(QDataStream & stream, const Value & value)
+{
+    return stream << value.value() << static_cast<qint8>(value.unit());
+}
 
-    return Value(val, u);
+QDataStream & operator>>(QDataStream & stream, Value & value)
+{
+    double val;
+    qint8 unit;
+    stream >> val >> unit;
+    value = Value(val, static_cast<Unit>(unit));
+    return stream;
 }
 
 }
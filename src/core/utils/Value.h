@@ -25,6 +25,9 @@
 #include <cmath>
 #include <QDebug>
 
+class QDataStream;
+class QJsonValue;
+
 namespace tikz
 {
 
@@ -165,15 +168,30 @@ class TIKZKITCORE_EXPORT Value
         }
 
         /**
-         * Convert this number to a string.
+         * Convert this number to a string, e.g. "3.5cm". The number is
+         * written in fixed notation with at most 15 significant digits.
          */
         QString toString() const;
 
         /**
-         * Convert @p str to a Value.
+         * Convert @p str, e.g. "3.5cm" or "3.5 cm", to a Value.
+         * A number without unit is in Unit::Point.
          */
         static Value fromString(const QString & str);
 
+        /**
+         * Convert this number to json in the form [value, "unit"], so that
+         * the number is stored without string conversion.
+         * An invalid Value is stored as "nan".
+         */
+        QJsonValue toJson() const;
+
+        /**
+         * Convert @p json to a Value. Both the form of toJson() and the
+         * string form of toString() are supported.
+         */
+        static Value fromJson(const QJsonValue & json);
+
     //
     // operators for qreal values
     //
@@ -531,6 +549,16 @@ inline constexpr qreal in2mm(qreal value)
     return convertTo(value, Unit::Inch, Unit::Millimeter);
 }
 
+/**
+ * Writes @p value in binary form to @p stream.
+ */
+TIKZKITCORE_EXPORT QDataStream & operator<<(QDataStream & stream, const Value & value);
+
+/**
+ * Reads @p value in binary form from @p stream.
+ */
+TIKZKITCORE_EXPORT QDataStream & operator>>(QDataStream & stream, Value & value);
+
 }
 
 inline constexpr tikz::Value operator""_pt(long double value)
@@ -0,0 +1,129 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "CborWriter.h"
+
+#include <QFileDevice>
+#include <QIODevice>
+#include <QString>
+
+namespace tikz {
+namespace core {
+
+namespace {
+    // the encoded self-describe tag 55799, see RFC 7049, section 2.4.5
+    constexpr char s_signature[] = "\xd9\xd9\xf7";
+}
+
+CborWriter::CborWriter(QIODevice * device)
+    : m_device(device)
+    , m_writer(device)
+{
+    Q_ASSERT(m_device);
+    m_writer.append(QCborKnownTags::Signature);
+}
+
+CborWriter::~CborWriter()
+{
+    flush();
+}
+
+bool CborWriter::flush()
+{
+    if (auto file = qobject_cast<QFileDevice *>(m_device)) {
+        return file->flush() && !hasError();
+    }
+    return !hasError();
+}
+
+bool CborWriter::hasError() const
+{
+    auto file = qobject_cast<QFileDevice *>(m_device);
+    return file && file->error() != QFileDevice::NoError;
+}
+
+bool CborWriter::isCbor(const QByteArray & data)
+{
+    return data.startsWith(QByteArray::fromRawData(s_signature, sizeof(s_signature) - 1));
+}
+
+void CborWriter::beginObject()
+{
+    m_writer.startMap();
+}
+
+void CborWriter::endObject()
+{
+    m_writer.endMap();
+}
+
+void CborWriter::beginArray()
+{
+    m_writer.startArray();
+}
+
+void CborWriter::endArray()
+{
+    m_writer.endArray();
+}
+
+void CborWriter::key(const QString & name)
+{
+    m_writer.append(name);
+}
+
+void CborWriter::value(const QString & str)
+{
+    m_writer.append(str);
+}
+
+void CborWriter::value(double number)
+{
+    const float single = static_cast<float>(number);
+    if (static_cast<double>(single) == number) {
+        m_writer.append(single);
+    } else {
+        m_writer.append(number);
+    }
+}
+
+void CborWriter::value(qint64 number)
+{
+    m_writer.append(number);
+}
+
+void CborWriter::value(bool b)
+{
+    m_writer.append(b);
+}
+
+void CborWriter::binary(const QByteArray & data)
+{
+    m_writer.append(data);
+}
+
+void CborWriter::null()
+{
+    m_writer.appendNull();
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
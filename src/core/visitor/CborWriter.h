@@ -0,0 +1,100 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_CBOR_WRITER_H
+#define TIKZ_CBOR_WRITER_H
+
+#include "StreamWriter.h"
+
+#include <QCborStreamWriter>
+
+class QIODevice;
+
+namespace tikz {
+namespace core {
+
+/**
+ * Streaming writer for binary CBOR (RFC 7049).
+ *
+ * The output starts with the CBOR self-describe tag, so that CBOR files
+ * are distinguished from JSON by the first three bytes, see isCbor().
+ * Objects and arrays are written as maps and arrays of indefinite length,
+ * since their size is not known in advance. Numbers are stored as raw
+ * floating point values, binary data as byte string.
+ *
+ * CborWriter relies on the buffering of the QIODevice, e.g. a QFile that
+ * is not opened with QIODevice::Unbuffered.
+ */
+class TIKZKITCORE_EXPORT CborWriter : public StreamWriter
+{
+    public:
+        /**
+         * Constructor. The CBOR data is written to @p device, which must be
+         * open for writing.
+         */
+        explicit CborWriter(QIODevice * device);
+
+        /**
+         * Destructor. Flushes all buffered data.
+         */
+        ~CborWriter() override;
+
+        bool flush() override;
+        bool hasError() const override;
+
+        /**
+         * Returns @e true, if @p data starts with the CBOR self-describe tag.
+         */
+        static bool isCbor(const QByteArray & data);
+
+    //
+    // StreamWriter interface
+    //
+    public:
+        using StreamWriter::key;
+        using StreamWriter::value;
+
+        void beginObject() override;
+        void endObject() override;
+        void beginArray() override;
+        void endArray() override;
+        void key(const QString & name) override;
+
+        /**
+         * Numbers that are exactly representable as float are written
+         * in single precision.
+         */
+        void value(double number) override;
+        void value(const QString & str) override;
+        void value(qint64 number) override;
+        void value(bool b) override;
+        void binary(const QByteArray & data) override;
+        void null() override;
+
+    private:
+        QIODevice * m_device;
+        QCborStreamWriter m_writer;
+};
+
+}
+}
+
+#endif // TIKZ_CBOR_WRITER_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -20,22 +20,197 @@
 #include "DeserializeVisitor.h"
 
 #include "Document.h"
+#include "EntityStore.h"
 #include "Node.h"
 #include "Path.h"
 #include "EdgePath.h"
 #include "EllipsePath.h"
 #include "Style.h"
 
+#include <QCborMap>
+#include <QCborValue>
 #include <QJsonDocument>
 #include <QStringList>
 #include <QTextStream>
 #include <QMetaProperty>
 #include <QFile>
 #include <QDebug>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
 
 namespace tikz {
 namespace core {
 
+namespace {
+    // minimal number of records parsed by one thread
+    constexpr int s_minChunkSize = 1024;
+
+    // Ids index the entity slots of the Document, so an id read from a file
+    // allocates a slot for each lower id. Ids are sparse only due to the
+    // entities deleted in the history, therefore ids far beyond the number
+    // of records are rejected, see idLimit().
+    constexpr qint64 s_minIdLimit = qint64(1) << 20;
+    constexpr qint64 s_maxIdsPerRecord = 64;
+
+    // returns the highest id accepted for a file with @p recordCount records
+    qint64 idLimit(qint64 recordCount)
+    {
+        return std::min(EntityStore::MaxId,
+                        std::max(s_minIdLimit, s_maxIdsPerRecord * recordCount));
+    }
+
+    // an entity record, parsed without touching the Document
+    struct EntityRecord
+    {
+        qint64 id = -1;                         // -1, if the record is invalid
+        PathType pathType = PathType::Invalid;  // only used for paths
+        QJsonObject json;
+        Entity * entity = nullptr;              // set when committed
+    };
+
+    // calls func(begin, end) for chunks of [0, count) on all cores
+    template <typename Func>
+    void parallelFor(int count, const Func & func)
+    {
+        const int threads = std::min(QThread::idealThreadCount(), count / s_minChunkSize);
+        if (threads <= 1) {
+            func(0, count);
+            return;
+        }
+
+        // the calling thread parses the first chunk itself
+        const int chunkSize = (count + threads - 1) / threads;
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads - 1);
+        for (int begin = chunkSize; begin < count; begin += chunkSize) {
+            const int end = std::min(begin + chunkSize, count);
+            pool.start([&func, begin, end]() {
+                func(begin, end);
+            });
+        }
+        func(0, chunkSize);
+        pool.waitForDone();
+    }
+
+    // validates the record of entity @p id with the state @p json,
+    // and sets @p record.id, if the record is valid
+    void validateRecord(EntityRecord & record, qint64 id, EntityType type, qint64 maxId)
+    {
+        // ids 0 and 1 are reserved for the document and its style
+        if (id < 2 || record.json.isEmpty()) {
+            return;
+        }
+
+        if (id > maxId) {
+            qWarning() << "Skipping" << toString(type) << "with implausible id" << id;
+            return;
+        }
+
+        // older files do not contain the path type
+        if (type == EntityType::Path) {
+            const QString pathType = record.json.value(QStringLiteral("type")).toString();
+            record.pathType = pathType.isEmpty() ? PathType::Line : toEnum<PathType>(pathType);
+            if (record.pathType == PathType::Invalid
+                || record.pathType == PathType::Rectangle
+                || record.pathType == PathType::Grid) {
+                // not supported by Document::createPath()
+                return;
+            }
+        }
+
+        record.id = id;
+    }
+
+    // parses the records of all entities listed in @p idList in parallel.
+    // The record of an entity is the object "<prefix>-<id>" in @p section.
+    QVector<EntityRecord> parseRecords(const QStringList & idList, const QJsonObject & section,
+                                       const QString & prefix, EntityType type, qint64 maxId)
+    {
+        QVector<EntityRecord> records(idList.size());
+        EntityRecord * const data = records.data();
+
+        parallelFor(idList.size(), [&](int begin, int end) {
+            // concurrent reads of the same shared json data are safe
+            const QJsonObject jsonSection = section;
+            for (int i = begin; i < end; ++i) {
+                EntityRecord & record = data[i];
+
+                bool ok = false;
+                const qint64 id = idList[i].toLongLong(&ok);
+                if (ok) {
+                    record.json = jsonSection.value(prefix + idList[i]).toObject();
+                    validateRecord(record, id, type, maxId);
+                }
+            }
+        });
+
+        return records;
+    }
+
+    // decodes the CBOR encoded records of @p entities in parallel
+    template <typename EncodedEntity>
+    QVector<EntityRecord> decodeRecords(const QVector<EncodedEntity> & entities, EntityType type,
+                                        qint64 maxId)
+    {
+        QVector<EntityRecord> records(entities.size());
+        EntityRecord * const data = records.data();
+
+        parallelFor(entities.size(), [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                EntityRecord & record = data[i];
+                record.json = QCborValue::fromCbor(entities[i].data).toMap().toJsonObject();
+                validateRecord(record, entities[i].id, type, maxId);
+            }
+        });
+
+        return records;
+    }
+
+    // creates the entities of all valid @p records in @p doc
+    void commitRecords(QVector<EntityRecord> & records, EntityType type, Document * doc)
+    {
+        // reserve the entity storage once for all entities
+        qint64 maxId = 0;
+        int count = 0;
+        for (const auto & record : qAsConst(records)) {
+            if (record.id >= 0) {
+                maxId = std::max(maxId, record.id);
+                ++count;
+            }
+        }
+        doc->reserveEntities(type, maxId, count);
+
+        for (auto & record : records) {
+            if (record.id < 0) {
+                qWarning() << "Skipping invalid" << toString(type) << "record";
+                continue;
+            }
+
+            const Uid uid(record.id, doc);
+            if (uid.entity()) {
+                qWarning() << "Skipping duplicate" << toString(type) << "with id" << record.id;
+                continue;
+            }
+
+            record.entity = (type == EntityType::Path)
+                ? doc->createPath(record.pathType, uid)
+                : doc->createEntity(uid, type);
+        }
+    }
+
+    // loads the state of all committed @p records
+    void loadRecords(const QVector<EntityRecord> & records)
+    {
+        for (const auto & record : records) {
+            if (record.entity) {
+                record.entity->load(record.json);
+            }
+        }
+    }
+}
+
 DeserializeVisitor::DeserializeVisitor()
     : Visitor()
 {
@@ -54,57 +229,82 @@ bool DeserializeVisitor::load(const QString & filename)
     }
 
     QJsonDocument json = QJsonDocument::fromJson(file.readAll());
-    m_root = json.object();
+    load(json.object());
 
-    m_nodes = m_root["nodes"].toObject();
-    m_paths = m_root["paths"].toObject();
-    m_styles = m_root["styles"].toObject();
+    return true;
+}
 
-//     qDebug() << m_nodes << m_paths;
+void DeserializeVisitor::load(const QJsonObject & json)
+{
+    m_root = json;
+}
 
-    return true;
+void DeserializeVisitor::addEntity(EntityType type, qint64 id, const QByteArray & data)
+{
+    switch (type) {
+        case EntityType::Style: m_styles.append({ id, data }); break;
+        case EntityType::Node: m_nodes.append({ id, data }); break;
+        case EntityType::Path: m_paths.append({ id, data }); break;
+        default:
+            qWarning() << "Skipping entity" << id << "of type" << toString(type);
+            break;
+    }
 }
 
 void DeserializeVisitor::visit(Document * doc)
 {
-    // aggregate node ids
-    QStringList list = m_root["node-ids"].toString().split(',');
-    for (const QString & uid : qAsConst(list)) {
-        doc->createEntity(Uid(uid, doc), tikz::EntityType::Node);
-    }
+    const QStringList styleIds = m_root["style-ids"].toString().split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const QStringList nodeIds = m_root["node-ids"].toString().split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const QStringList pathIds = m_root["path-ids"].toString().split(QLatin1Char(','), Qt::SkipEmptyParts);
+    const qint64 maxId = idLimit(qint64(styleIds.size()) + nodeIds.size() + pathIds.size()
+                                 + m_styles.size() + m_nodes.size() + m_paths.size());
 
-    // aggregate edge ids
-    list = m_root["path-ids"].toString().split(',');
-    for (const QString & idAsStr : qAsConst(list)) {
-        const Uid uid(idAsStr, doc);
-        const QString type = m_root["paths"].toObject()["path-" + uid.toString()].toObject()["type"].toString();
-//         qDebug() << type << pathType(type);
-        doc->createPath(toEnum<PathType>(type), uid);
-    }
+    // phase 1: parse and validate all entity records in parallel
+    auto styles = parseRecords(styleIds, m_root["styles"].toObject(),
+                               QStringLiteral("style-"), EntityType::Style, maxId);
+    auto nodes = parseRecords(nodeIds, m_root["nodes"].toObject(),
+                              QStringLiteral("node-"), EntityType::Node, maxId);
+    auto paths = parseRecords(pathIds, m_root["paths"].toObject(),
+                              QStringLiteral("path-"), EntityType::Path, maxId);
+    styles += decodeRecords(m_styles, EntityType::Style, maxId);
+    nodes += decodeRecords(m_nodes, EntityType::Node, maxId);
+    paths += decodeRecords(m_paths, EntityType::Path, maxId);
 
-    // aggregate style ids
-    list = m_root["style-ids"].toString().split(',');
-    for (const QString & uid : qAsConst(list)) {
-        doc->createEntity(Uid(uid, doc), tikz::EntityType::Style);
-    }
+    // phase 2: create all entities, so that the entities can refer to each
+    // other when loaded, e.g. a node to its style
+    commitRecords(styles, EntityType::Style, doc);
+    commitRecords(nodes, EntityType::Node, doc);
+    commitRecords(paths, EntityType::Path, doc);
 
     // load document style
     doc->style()->load(m_root["document-style"].toObject());
+
+    // load all entities in the same order as Document::accept() visits them
+    loadRecords(styles);
+    loadRecords(nodes);
+    loadRecords(paths);
+
+    // register styles loaded before their parent style as children
+    for (const auto & record : qAsConst(styles)) {
+        if (record.entity) {
+            static_cast<Style *>(record.entity)->linkParentStyle();
+        }
+    }
 }
 
 void DeserializeVisitor::visit(Node * node)
 {
-    node->load(m_nodes["node-" + node->uid().toString()].toObject());
+    Q_UNUSED(node)
 }
 
 void DeserializeVisitor::visit(Path * path)
 {
-    path->load(m_paths["path-" + path->uid().toString()].toObject());
+    Q_UNUSED(path)
 }
 
 void DeserializeVisitor::visit(Style * style)
 {
-    style->load(m_styles["style-" + style->uid().toString()].toObject());
+    Q_UNUSED(style)
 }
 
 }
@@ -21,7 +21,11 @@
 #define TIKZ_DESERIALIZE_VISITOR_H
 
 #include "Visitor.h"
+#include "tikz.h"
+
+#include <QByteArray>
 #include <QJsonObject>
+#include <QVector>
 
 namespace tikz {
 namespace core {
@@ -33,6 +37,12 @@ class Path;
 
 /**
  * Deserializes a tikz::core::Document from a json file.
+ *
+ * Loading runs in two phases in visit(Document*): first, the entity records
+ * are parsed and validated in parallel, without touching the Document.
+ * Second, all valid entities are created in one batched pass, and loaded
+ * from their records. Therefore, the visits of the single entities have
+ * nothing left to do.
  */
 class DeserializeVisitor : public Visitor
 {
@@ -57,27 +67,40 @@ class DeserializeVisitor : public Visitor
          */
         bool load(const QString & filename);
 
+        /**
+         * Load the tikz::Document from the json object @p json, as returned
+         * by SerializeVisitor::json().
+         */
+        void load(const QJsonObject & json);
+
+        /**
+         * Adds the entity @p id of type @p type to the entities loaded by
+         * visit(Document*). The state of the entity is passed as CBOR
+         * encoded json object @p data, and is decoded in parallel.
+         */
+        void addEntity(EntityType type, qint64 id, const QByteArray & data);
+
     //
     // Visitor pattern
     //
     public:
         /**
-         * Serializes document @p doc document.
+         * Creates and loads all entities of @p doc.
          */
         void visit(Document * doc) override;
 
         /**
-         * Serializes @p node.
+         * Does nothing, @p node is already loaded in visit(Document*).
          */
         void visit(Node * node) override;
 
         /**
-         * Serializes @p path.
+         * Does nothing, @p path is already loaded in visit(Document*).
          */
         void visit(Path * path) override;
 
         /**
-         * Serializes @p style.
+         * Does nothing, @p style is already loaded in visit(Document*).
          */
         void visit(Style * style) override;
 
@@ -86,9 +109,16 @@ class DeserializeVisitor : public Visitor
     //
     private:
         QJsonObject m_root;
-        QJsonObject m_nodes;
-        QJsonObject m_paths;
-        QJsonObject m_styles;
+
+        // entity passed to addEntity()
+        struct EncodedEntity
+        {
+            qint64 id;
+            QByteArray data;
+        };
+        QVector<EncodedEntity> m_styles;
+        QVector<EncodedEntity> m_nodes;
+        QVector<EncodedEntity> m_paths;
 };
 
 }
@@ -0,0 +1,205 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "JsonWriter.h"
+#include "NumberCodec.h"
+
+#include <QIODevice>
+#include <QString>
+
+#include <cmath>
+
+namespace tikz {
+namespace core {
+
+JsonWriter::JsonWriter(QIODevice * device)
+    : m_device(device)
+{
+    Q_ASSERT(m_device);
+    m_buffer.reserve(bufferSize() + 1024);
+}
+
+JsonWriter::~JsonWriter()
+{
+    flush();
+}
+
+bool JsonWriter::flush()
+{
+    if (!m_buffer.isEmpty()) {
+        if (m_device->write(m_buffer) != m_buffer.size()) {
+            m_error = true;
+        }
+        m_buffer.resize(0);
+    }
+    return !m_error;
+}
+
+bool JsonWriter::hasError() const
+{
+    return m_error;
+}
+
+void JsonWriter::beginObject()
+{
+    separate();
+    m_buffer.append('{');
+    m_first = true;
+    ++m_depth;
+}
+
+void JsonWriter::endObject()
+{
+    Q_ASSERT(m_depth > 0);
+    Q_ASSERT(!m_afterKey);
+    m_buffer.append('}');
+    m_first = false;
+    --m_depth;
+}
+
+void JsonWriter::beginArray()
+{
+    separate();
+    m_buffer.append('[');
+    m_first = true;
+    ++m_depth;
+}
+
+void JsonWriter::endArray()
+{
+    Q_ASSERT(m_depth > 0);
+    Q_ASSERT(!m_afterKey);
+    m_buffer.append(']');
+    m_first = false;
+    --m_depth;
+}
+
+void JsonWriter::key(const QString & name)
+{
+    Q_ASSERT(m_depth > 0);
+    Q_ASSERT(!m_afterKey);
+    separate();
+    appendString(name);
+    m_buffer.append(':');
+    m_afterKey = true;
+}
+
+void JsonWriter::value(const QString & str)
+{
+    separate();
+    appendString(str);
+}
+
+void JsonWriter::value(double number)
+{
+    separate();
+    if (!std::isfinite(number)) {
+        m_buffer.append("null");
+    } else if (number == std::trunc(number) && std::abs(number) < (1ll << 53)) {
+        // integral values are written without exponent, like QJsonDocument
+        m_buffer.append(QByteArray::number(static_cast<qint64>(number)));
+    } else {
+        // shortest form that is parsed back to exactly the same number
+        char buffer[codec::BufferSize];
+        const char * end = codec::formatShortest(buffer, buffer + codec::BufferSize, number);
+        m_buffer.append(buffer, end - buffer);
+    }
+}
+
+void JsonWriter::value(qint64 number)
+{
+    separate();
+    m_buffer.append(QByteArray::number(number));
+}
+
+void JsonWriter::value(bool b)
+{
+    separate();
+    m_buffer.append(b ? "true" : "false");
+}
+
+void JsonWriter::binary(const QByteArray & data)
+{
+    separate();
+    m_buffer.append('"');
+    m_buffer.append(data.toBase64());
+    m_buffer.append('"');
+}
+
+void JsonWriter::null()
+{
+    separate();
+    m_buffer.append("null");
+}
+
+void JsonWriter::separate()
+{
+    maybeFlush();
+
+    if (m_afterKey) {
+        m_afterKey = false;
+    } else if (!m_first) {
+        m_buffer.append(',');
+    }
+    m_first = false;
+}
+
+void JsonWriter::appendString(const QString & str)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    m_buffer.append('"');
+    const QByteArray utf8 = str.toUtf8();
+    for (const char c : utf8) {
+        const auto u = static_cast<unsigned char>(c);
+        if (u >= 0x20 && c != '"' && c != '\\') {
+            m_buffer.append(c);
+            continue;
+        }
+
+        m_buffer.append('\\');
+        switch (c) {
+            case '"': m_buffer.append('"'); break;
+            case '\\': m_buffer.append('\\'); break;
+            case '\b': m_buffer.append('b'); break;
+            case '\f': m_buffer.append('f'); break;
+            case '\n': m_buffer.append('n'); break;
+            case '\r': m_buffer.append('r'); break;
+            case '\t': m_buffer.append('t'); break;
+            default:
+                m_buffer.append("u00");
+                m_buffer.append(hexDigits[u >> 4]);
+                m_buffer.append(hexDigits[u & 0xf]);
+                break;
+        }
+    }
+    m_buffer.append('"');
+}
+
+void JsonWriter::maybeFlush()
+{
+    if (m_buffer.size() >= bufferSize()) {
+        flush();
+    }
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
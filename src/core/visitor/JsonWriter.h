@@ -0,0 +1,125 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_JSON_WRITER_H
+#define TIKZ_JSON_WRITER_H
+
+#include "StreamWriter.h"
+
+#include <QByteArray>
+
+class QIODevice;
+
+namespace tikz {
+namespace core {
+
+/**
+ * Streaming writer for compact JSON.
+ *
+ * In contrast to QJsonDocument, the JsonWriter does not require the whole
+ * document as QJsonObject tree in memory. Instead, the JSON text is
+ * appended to an internal buffer as the values are passed, and the buffer
+ * is written to the QIODevice whenever it exceeds bufferSize().
+ *
+ * Binary data is written as base64 encoded string.
+ */
+class TIKZKITCORE_EXPORT JsonWriter : public StreamWriter
+{
+    public:
+        /**
+         * Constructor. The JSON text is written to @p device, which must be
+         * open for writing.
+         */
+        explicit JsonWriter(QIODevice * device);
+
+        /**
+         * Destructor. Flushes all buffered data.
+         */
+        ~JsonWriter() override;
+
+        bool flush() override;
+        bool hasError() const override;
+
+        /**
+         * Size in bytes from which the buffer is written to the device.
+         */
+        static constexpr int bufferSize()
+        {
+            return 64 * 1024;
+        }
+
+    //
+    // StreamWriter interface
+    //
+    public:
+        using StreamWriter::key;
+        using StreamWriter::value;
+
+        void beginObject() override;
+        void endObject() override;
+        void beginArray() override;
+        void endArray() override;
+        void key(const QString & name) override;
+
+        /**
+         * Non-finite numbers are written as null, like QJsonDocument does.
+         */
+        void value(double number) override;
+        void value(const QString & str) override;
+        void value(qint64 number) override;
+        void value(bool b) override;
+        void binary(const QByteArray & data) override;
+        void null() override;
+
+    private:
+        /**
+         * Writes the separator required before the next value.
+         * Flushes the buffer first, if it exceeds bufferSize().
+         */
+        void separate();
+
+        /**
+         * Appends @p str as quoted and escaped JSON string.
+         */
+        void appendString(const QString & str);
+
+        /**
+         * Writes the buffer to the device, if it exceeds bufferSize().
+         */
+        void maybeFlush();
+
+    private:
+        QIODevice * m_device;
+        QByteArray m_buffer;
+        bool m_error = false;
+
+        // true, if no value was written yet in the current object or array
+        bool m_first = true;
+        // true, if key() was written, but not yet its value
+        bool m_afterKey = false;
+        // number of open objects and arrays
+        int m_depth = 0;
+};
+
+}
+}
+
+#endif // TIKZ_JSON_WRITER_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -18,6 +18,7 @@
  */
 
 #include "SerializeVisitor.h"
+#include "StreamWriter.h"
 
 #include "Document.h"
 #include "Node.h"
@@ -41,16 +42,20 @@ SerializeVisitor::SerializeVisitor()
 {
 }
 
+SerializeVisitor::SerializeVisitor(StreamWriter * writer)
+    : Visitor()
+    , m_writer(writer)
+{
+    Q_ASSERT(m_writer);
+}
+
 SerializeVisitor::~SerializeVisitor()
 {
 }
 
 bool SerializeVisitor::save(const QString & filename)
 {
-    QJsonObject root = m_root;
-    root["nodes"] = m_nodes;
-    root["paths"] = m_paths;
-    root["styles"] = m_styles;
+    Q_ASSERT(!m_writer);
 
     // open file
     QFile target(filename);
@@ -59,54 +64,126 @@ bool SerializeVisitor::save(const QString & filename)
     }
 
     // write json to text stream
-    QJsonDocument json(root);
+    QJsonDocument jsonDoc(json());
     QTextStream ts(&target);
-    ts << json.toJson();
+    ts << jsonDoc.toJson();
 
     return true;
 }
 
+QJsonObject SerializeVisitor::json() const
+{
+    QJsonObject root = m_root;
+    root["nodes"] = m_nodes;
+    root["paths"] = m_paths;
+    root["styles"] = m_styles;
+    return root;
+}
+
+void SerializeVisitor::finish()
+{
+    if (m_writer) {
+        enterSection(Section::Finished);
+    }
+}
+
+void SerializeVisitor::enterSection(Section section)
+{
+    static const char * const keys[] = { nullptr, "styles", "nodes", "paths" };
+
+    Q_ASSERT(m_writer);
+    Q_ASSERT(m_section <= section);
+
+    while (m_section < section) {
+        if (m_section != Section::Root) {
+            m_writer->endObject();
+        }
+        m_section = static_cast<Section>(static_cast<int>(m_section) + 1);
+        if (m_section == Section::Finished) {
+            m_writer->endObject();
+        } else {
+            m_writer->key(keys[static_cast<int>(m_section)]);
+            m_writer->beginObject();
+        }
+    }
+}
+
 void SerializeVisitor::visit(Document * doc)
 {
     // aggregate node ids
     QStringList list;
-    for (const Uid & uid : doc->nodes()) {
-        list.append(uid.toString());
+    list.reserve(doc->nodeRange().size());
+    for (auto node : doc->nodeRange()) {
+        list.append(node->uid().toString());
     }
     m_root["node-ids"] = list.join(",");
 
     // aggregate path ids
     list.clear();
-    for (const Uid & uid : doc->paths()) {
-        list.append(uid.toString());
+    list.reserve(doc->pathRange().size());
+    for (auto path : doc->pathRange()) {
+        list.append(path->uid().toString());
     }
     m_root["path-ids"] = list.join(",");
 
     // aggregate style ids
     list.clear();
-    for (const Uid & uid : doc->entities()) {
-        if (uid.entityType() == EntityType::Style)
-            list.append(uid.toString());
+    list.reserve(doc->styleRange().size());
+    for (auto style : doc->styleRange()) {
+        list.append(style->uid().toString());
     }
     m_root["style-ids"] = list.join(",");
 
     // save document style
     m_root["document-style"] = doc->style()->save();
+
+    // when streaming, the root object is opened with the document data
+    if (m_writer) {
+        Q_ASSERT(m_section == Section::Root);
+        m_writer->beginObject();
+        for (auto it = m_root.begin(); it != m_root.end(); ++it) {
+            m_writer->key(it.key());
+            m_writer->value(it.value());
+        }
+        m_root = QJsonObject();
+    }
 }
 
 void SerializeVisitor::visit(Node * node)
 {
-    m_nodes["node-" + node->uid().toString()] = node->save();
+    if (m_writer) {
+        enterSection(Section::Nodes);
+        m_writer->key("node-" + node->uid().toString());
+        m_writer->value(node->save());
+    } else {
+        m_nodes["node-" + node->uid().toString()] = node->save();
+    }
 }
 
 void SerializeVisitor::visit(Path * path)
 {
-    m_paths["path-" + path->uid().toString()] = path->save();
+    // the path type is required to create the path when loading
+    QJsonObject json = path->save();
+    json["type"] = toString(path->type());
+
+    if (m_writer) {
+        enterSection(Section::Paths);
+        m_writer->key("path-" + path->uid().toString());
+        m_writer->value(json);
+    } else {
+        m_paths["path-" + path->uid().toString()] = json;
+    }
 }
 
 void SerializeVisitor::visit(Style * style)
 {
-    m_styles["style-" + style->uid().toString()] = style->save();
+    if (m_writer) {
+        enterSection(Section::Styles);
+        m_writer->key("style-" + style->uid().toString());
+        m_writer->value(style->save());
+    } else {
+        m_styles["style-" + style->uid().toString()] = style->save();
+    }
 }
 
 }
@@ -26,9 +26,16 @@
 namespace tikz {
 namespace core {
 
+class StreamWriter;
+
 /**
  * Visitor pattern.
  * Visits all elements of a tikz::core::Document.
+ *
+ * By default, the serialized document is aggregated in memory, see json().
+ * If a StreamWriter is passed to the constructor, each element is written
+ * directly to the writer instead, so that no QJsonObject tree of the whole
+ * document is built. In this case, call finish() after the visit.
  */
 class SerializeVisitor : public Visitor
 {
@@ -38,6 +45,12 @@ class SerializeVisitor : public Visitor
          */
         SerializeVisitor();
 
+        /**
+         * Constructor for streaming into @p writer. The serialized document
+         * is written as object at the current position of @p writer.
+         */
+        explicit SerializeVisitor(StreamWriter * writer);
+
         /**
          * Destructor
          */
@@ -53,6 +66,18 @@ class SerializeVisitor : public Visitor
          */
         bool save(const QString & filename);
 
+        /**
+         * Returns the serialized tikz::Document as json object.
+         * This is the same object that save() writes to a file.
+         */
+        QJsonObject json() const;
+
+        /**
+         * Closes the object written to the StreamWriter.
+         * Only required when streaming, otherwise does nothing.
+         */
+        void finish();
+
     //
     // Visitor pattern
     //
@@ -81,6 +106,27 @@ class SerializeVisitor : public Visitor
     // private data
     //
     private:
+        // the sections of the streamed JSON object, in the order of
+        // Document::accept()
+        enum class Section {
+            Root,
+            Styles,
+            Nodes,
+            Paths,
+            Finished
+        };
+
+        /**
+         * Closes the current section of the streamed object, and opens all
+         * sections up to @p section. Skipped sections are written as empty
+         * objects, so that the output has the same keys as json().
+         */
+        void enterSection(Section section);
+
+    private:
+        StreamWriter * m_writer = nullptr;
+        Section m_section = Section::Root;
+
         QJsonObject m_root;
         QJsonObject m_nodes;
         QJsonObject m_paths;
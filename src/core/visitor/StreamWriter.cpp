@@ -0,0 +1,79 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamWriter.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+
+namespace tikz {
+namespace core {
+
+StreamWriter::~StreamWriter()
+{
+}
+
+void StreamWriter::key(const char * name)
+{
+    key(QString::fromLatin1(name));
+}
+
+void StreamWriter::value(int number)
+{
+    value(static_cast<qint64>(number));
+}
+
+void StreamWriter::value(const QJsonObject & object)
+{
+    beginObject();
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        key(it.key());
+        value(it.value());
+    }
+    endObject();
+}
+
+void StreamWriter::value(const QJsonArray & array)
+{
+    beginArray();
+    for (const auto & element : array) {
+        value(element);
+    }
+    endArray();
+}
+
+void StreamWriter::value(const QJsonValue & json)
+{
+    switch (json.type()) {
+        case QJsonValue::Bool: value(json.toBool()); break;
+        case QJsonValue::Double: value(json.toDouble()); break;
+        case QJsonValue::String: value(json.toString()); break;
+        case QJsonValue::Array: value(json.toArray()); break;
+        case QJsonValue::Object: value(json.toObject()); break;
+        case QJsonValue::Null:
+        case QJsonValue::Undefined: null(); break;
+    }
+}
+
+}
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,147 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIKZ_STREAM_WRITER_H
+#define TIKZ_STREAM_WRITER_H
+
+#include "tikz_export.h"
+
+class QByteArray;
+class QJsonObject;
+class QJsonArray;
+class QJsonValue;
+class QString;
+
+namespace tikz {
+namespace core {
+
+/**
+ * Interface of a streaming writer for structured documents.
+ *
+ * A StreamWriter does not require the whole document as tree in memory.
+ * Instead, the document is written as the values are passed.
+ * Objects and arrays are opened with beginObject() and beginArray(), and
+ * closed with endObject() and endArray(). Within an object, each value is
+ * preceded by key(). Small subtrees, e.g. the state of a single Entity,
+ * can be passed as QJsonObject with value().
+ *
+ * @code
+ * JsonWriter writer(&file);
+ * writer.beginObject();
+ * writer.key("next-id");
+ * writer.value(42);
+ * writer.endObject();
+ * writer.flush();
+ * @endcode
+ *
+ * @see JsonWriter, CborWriter
+ */
+class TIKZKITCORE_EXPORT StreamWriter
+{
+    public:
+        /**
+         * Virtual destructor.
+         */
+        virtual ~StreamWriter();
+
+        /**
+         * Writes all buffered data to the device.
+         * Returns @e false, if writing to the device failed at any time.
+         */
+        virtual bool flush() = 0;
+
+        /**
+         * Returns @e true, if writing to the device failed.
+         */
+        virtual bool hasError() const = 0;
+
+    //
+    // structure
+    //
+    public:
+        /**
+         * Opens an object.
+         */
+        virtual void beginObject() = 0;
+
+        /**
+         * Closes the object opened last.
+         */
+        virtual void endObject() = 0;
+
+        /**
+         * Opens an array.
+         */
+        virtual void beginArray() = 0;
+
+        /**
+         * Closes the array opened last.
+         */
+        virtual void endArray() = 0;
+
+        /**
+         * Writes the key of the next value in the current object.
+         */
+        virtual void key(const QString & name) = 0;
+
+        /**
+         * Overload of key() for ASCII keys.
+         */
+        void key(const char * name);
+
+    //
+    // values
+    //
+    public:
+        /**
+         * Writes a value, either as element of the current array, or
+         * after key() in the current object.
+         */
+        virtual void value(const QString & str) = 0;
+        virtual void value(double number) = 0;
+        virtual void value(qint64 number) = 0;
+        virtual void value(bool b) = 0;
+        void value(int number);
+        void value(const QJsonObject & object);
+        void value(const QJsonArray & array);
+        void value(const QJsonValue & json);
+
+        /**
+         * Not defined, use the QString overload for strings.
+         * Without it, string literals would be written as bool.
+         */
+        void value(const char * str) = delete;
+
+        /**
+         * Writes binary @p data.
+         */
+        virtual void binary(const QByteArray & data) = 0;
+
+        /**
+         * Writes a null value.
+         */
+        virtual void null() = 0;
+};
+
+}
+}
+
+#endif // TIKZ_STREAM_WRITER_H
+
+// kate: indent-width 4; replace-tabs on;
@@ -149,7 +149,13 @@ void TikzExportVisitor::visit(Document * doc)
 
 void TikzExportVisitor::visit(Node * node)
 {
-    QString options = nodeStyleOptions(node->style()).join(", ");
+    // nodes with identical styles share the same option string
+    const quintptr styleKey = node->style()->propertiesKey();
+    auto it = m_nodeOptions.constFind(styleKey);
+    if (it == m_nodeOptions.constEnd()) {
+        it = m_nodeOptions.insert(styleKey, nodeStyleOptions(node->style()).join(", "));
+    }
+    const QString options = *it;
 
     QString cmd = QString("\\node[%1,draw] (%2) at %3 {%4};")
         .arg(options)
@@ -167,10 +173,17 @@ void TikzExportVisitor::visit(Node * node)
 
 void TikzExportVisitor::visit(Path * path)
 {
-    QString options = edgeStyleOptions(path->style()).join(", ");
-    if (!options.isEmpty()) {
-        options = "[" + options + "]";
+    // paths with identical styles share the same option string
+    const quintptr styleKey = path->style()->propertiesKey();
+    auto it = m_edgeOptions.constFind(styleKey);
+    if (it == m_edgeOptions.constEnd()) {
+        QString options = edgeStyleOptions(path->style()).join(", ");
+        if (!options.isEmpty()) {
+            options = "[" + options + "]";
+        }
+        it = m_edgeOptions.insert(styleKey, options);
     }
+    const QString options = *it;
 
     QString cmd;
 
@@ -23,6 +23,7 @@
 #include "Visitor.h"
 #include "TikzExport.h"
 
+#include <QHash>
 #include <QVector>
 #include <QString>
 
@@ -96,6 +97,10 @@ class TikzExportVisitor : public Visitor
     //
     private:
         TikzExport m_tikzExport;
+
+        // option strings of already exported styles, see Style::propertiesKey()
+        QHash<quintptr, QString> m_nodeOptions;
+        QHash<quintptr, QString> m_edgeOptions;
 };
 
 }
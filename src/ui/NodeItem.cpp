@@ -33,6 +33,7 @@
 #include <QStyleOptionGraphicsItem>
 #include <QPainterPath>
 #include <QPixmap>
+#include <QTransform>
 
 #include <QDebug>
 
@@ -54,14 +55,18 @@ class NodeItemPrivate
 
         bool itemChangeRunning : 1;
         bool dirty : 1;
+        quint64 revision = 0; // Node::revision() the cache is based on
         QPainterPath shapePath;
         QPainterPath outlinePath;
 
     public:
         void updateCache()
         {
-            if (!dirty) return;
+            // the Document may query anchors before styleChanged() is called,
+            // therefore also check the revision of the node
+            if (!dirty && revision == node->revision()) return;
             dirty = false;
+            revision = node->revision();
 
             if (node->style()->shape() != shape->type()) {
                 delete shape;
@@ -145,8 +150,11 @@ tikz::Pos NodeItem::anchor(const QString & anchor) const
     // make sure cache is up-to-date
     d->updateCache();
 
+    // map to the scene based on the node's position, since the position
+    // of this item may not yet be updated, see styleChanged()
     const QPointF p = d->shape->anchorPos(anchor);
-    return mapToScene(p);
+    const QPointF nodePos = d->node->pos();
+    return tikz::Pos(nodePos + QTransform().rotate(rotation()).map(p));
 }
 
 QPointF NodeItem::contactPoint(const QString & anchor, qreal rad) const
@@ -39,7 +39,6 @@ NodeTextPrivate::NodeTextPrivate(NodeItem* nodeItem, NodeText* nodeText)
     node = nodeItem;
 
     connect(&texGenerator, SIGNAL(svgReady(QString)), this, SLOT(readSvgFile(QString)));
-    connect(this, SIGNAL(svgChanged()), nodeItem->node(), SIGNAL(changed()));
 }
 
 void NodeTextPrivate::updateCache()
@@ -50,6 +49,10 @@ void NodeTextPrivate::readSvgFile(const QString& file)
 {
     q->prepareGeometryChange();
     svgRenderer.load(file);
+
+    // the text changes the shape and the anchors of the node, so invalidate
+    // the node: this updates all caches and the attached paths
+    node->node()->setTextSize(q->textRect().size());
     Q_EMIT svgChanged();
 }
 
@@ -37,6 +37,7 @@
 #include <QUndoStack>
 
 #include <math.h>
+#include <memory>
 
 namespace tikz {
 namespace ui {
@@ -55,6 +56,9 @@ public:
 
     // currently active tool
     AbstractTool * tool = nullptr;
+
+    // gesture while items are dragged with the mouse
+    std::unique_ptr<tikz::core::Transaction> dragTransaction;
 };
 
 TikzScene::TikzScene(DocumentPrivate * doc)
@@ -97,6 +101,11 @@ void TikzScene::mousePressEvent(QGraphicsSceneMouseEvent * event)
     // first let QGraphicsScene do its work
     QGraphicsScene::mousePressEvent(event);
     if (event->isAccepted()) {
+        // dragging movable items records one undo item per item
+        auto grabber = mouseGrabberItem();
+        if (grabber && (grabber->flags() & QGraphicsItem::ItemIsMovable) && !d->dragTransaction) {
+            d->dragTransaction.reset(new tikz::core::Transaction(d->doc, "Move Nodes", tikz::core::Transaction::Gesture));
+        }
         return;
     }
 
@@ -126,6 +135,12 @@ void TikzScene::mouseReleaseEvent(QGraphicsSceneMouseEvent * event)
 {
     // first let QGraphicsScene do its work
     QGraphicsScene::mouseReleaseEvent(event);
+
+    // finish dragging
+    if (!mouseGrabberItem()) {
+        d->dragTransaction.reset();
+    }
+
     if (event->isAccepted()) {
         return;
     }
@@ -43,11 +43,21 @@
 #include "TikzScene.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QGraphicsView>
+#include <QTimer>
+
+#include <algorithm>
 
 namespace tikz {
 namespace ui {
 
+// time in ms the pending items are created without returning to the event loop
+static const int s_timeSlice = 10;
+
+// number of items created between two checks of the elapsed time
+static const int s_batchSize = 64;
+
 static void setProp(const tikz::core::Uid & entity, const QString & key, const QVariant & value)
 {
     entity.document()->addUndoItem(new tikz::core::UndoSetProperty(entity, key, value));
@@ -64,6 +74,11 @@ DocumentPrivate::DocumentPrivate(QObject * parent)
 
     connect(m_scene, SIGNAL(editModeChanged(TikzEditMode)), this, SIGNAL(editModeChanged(TikzEditMode)));
     connect(this, SIGNAL(aboutToClear()), this, SLOT(clearDocumentPrivate()));
+
+    // create the pending items whenever the event loop is idle
+    m_pendingTimer = new QTimer(this);
+    m_pendingTimer->setInterval(0);
+    connect(m_pendingTimer, SIGNAL(timeout()), this, SLOT(createPendingItems()));
 }
 
 DocumentPrivate::~DocumentPrivate()
@@ -83,6 +98,13 @@ DocumentPrivate::~DocumentPrivate()
 
 void DocumentPrivate::clearDocumentPrivate()
 {
+    // the entities of pending items are deleted as well
+    m_pendingTimer->stop();
+    m_pendingItems.clear();
+    m_pendingQueue.clear();
+    m_pendingIndex = 0;
+    m_pendingTotal = 0;
+
     // free UI part of nodes and paths
     qDeleteAll(m_paths);
     m_pathMap.clear();
@@ -106,7 +128,11 @@ TikzEditMode DocumentPrivate::editMode() const
 tikz::Pos DocumentPrivate::scenePos(const tikz::core::MetaPos & pos) const
 {
     const auto node = pos.node();
-    if (node) {
+
+    // the anchors of pending nodes are unknown. Creating their items here
+    // would create the items of all attached nodes while loading, therefore
+    // use the node center until createPendingItem() invalidates the node.
+    if (node && !m_deferItems && !m_pendingItems.contains(node->uid())) {
         const NodeItem * nodeItem = nodeItemFromId(node->uid());
         Q_ASSERT(nodeItem != nullptr);
         return nodeItem->anchor(pos.anchor());
@@ -424,6 +450,142 @@ void DocumentPrivate::unregisterView(tikz::ui::View * view)
     m_views.remove(m_views.indexOf(view));
 }
 
+bool DocumentPrivate::loadProgressive(const QUrl & url)
+{
+    // all entities are loaded, but their items are only queued
+    m_deferItems = true;
+    const bool loaded = load(url);
+    m_deferItems = false;
+
+    if (!loaded) {
+        return false;
+    }
+
+    // create the items in the visible area right away. Views created
+    // later do the same once they are shown, see Renderer.
+    for (auto view : qAsConst(m_views)) {
+        static_cast<ViewPrivate *>(view)->renderer()->createVisibleItems();
+    }
+
+    m_pendingTotal = m_pendingQueue.size();
+    Q_EMIT loadProgress(m_pendingTotal - m_pendingItems.size(), m_pendingTotal);
+
+    if (!m_pendingItems.isEmpty()) {
+        m_pendingTimer->start();
+    }
+
+    return true;
+}
+
+void DocumentPrivate::createItemsIn(const QRectF & sceneRect)
+{
+    if (m_pendingItems.isEmpty()) {
+        return;
+    }
+
+    // items of nodes referred to by visible paths are created on demand
+    const int pendingCount = m_pendingItems.size();
+    for (const auto & uid : entitiesIn(sceneRect)) {
+        createPendingItem(uid);
+    }
+
+    // during loadProgressive(), the progress is reported afterwards
+    if (m_pendingTimer->isActive() && m_pendingItems.size() != pendingCount) {
+        Q_EMIT loadProgress(m_pendingTotal - m_pendingItems.size(), m_pendingTotal);
+    }
+}
+
+void DocumentPrivate::createPendingItems()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int count = m_pendingQueue.size();
+    while (m_pendingIndex < count && timer.elapsed() < s_timeSlice) {
+        const int end = std::min(m_pendingIndex + s_batchSize, count);
+        for (; m_pendingIndex < end; ++m_pendingIndex) {
+            createPendingItem(m_pendingQueue[m_pendingIndex]);
+        }
+    }
+
+    if (m_pendingIndex == count) {
+        m_pendingTimer->stop();
+        m_pendingQueue.clear();
+        m_pendingIndex = 0;
+        Q_ASSERT(m_pendingItems.isEmpty());
+    }
+
+    Q_EMIT loadProgress(m_pendingTotal - m_pendingItems.size(), m_pendingTotal);
+}
+
+void DocumentPrivate::createPendingItem(const tikz::core::Uid & uid)
+{
+    if (!m_pendingItems.remove(uid)) {
+        return;
+    }
+
+    if (uid.entityType() == tikz::EntityType::Node) {
+        auto node = uid.entity<tikz::core::Node>();
+        addNodeItem(node);
+
+        // the anchors are known now: update cached positions, and the
+        // bounds of the attached paths
+        node->invalidate();
+    } else {
+        addPathItem(uid.entity<tikz::core::Path>());
+    }
+}
+
+void DocumentPrivate::addNodeItem(tikz::core::Node * node)
+{
+    Q_ASSERT(! m_nodeMap.contains(node->uid()));
+
+    // create GUI item
+    NodeItem * nodeItem = new NodeItem(node);
+    m_nodes.append(nodeItem);
+    m_nodeMap.insert(node->uid(), nodeItem);
+
+    // add to graphics scene
+    m_scene->addItem(nodeItem);
+}
+
+void DocumentPrivate::addPathItem(tikz::core::Path * path)
+{
+    Q_ASSERT(! m_pathMap.contains(path->uid()));
+
+    // create GUI item
+    tikz::ui::PathItem * pathItem = nullptr;
+    switch (path->type()) {
+        case tikz::PathType::Line: {
+            pathItem = new tikz::ui::EdgePathItem(path);
+            break;
+        }
+        case tikz::PathType::HVLine: break;
+        case tikz::PathType::VHLine: break;
+        case tikz::PathType::BendCurve: break;
+        case tikz::PathType::InOutCurve: break;
+        case tikz::PathType::BezierCurve: break;
+        case tikz::PathType::Ellipse: {
+            pathItem = new tikz::ui::EllipsePathItem(path);
+            break;
+        }
+        case tikz::PathType::Rectangle: break;
+        case tikz::PathType::Grid: break;
+        case tikz::PathType::Invalid:
+        default: break;
+    }
+
+    // we should always have a valid ui tikz path
+    Q_ASSERT(pathItem);
+
+    // register path
+    m_paths.append(pathItem);
+    m_pathMap.insert(path->uid(), pathItem);
+
+    // add to graphics scene
+    m_scene->addItem(pathItem);
+}
+
 QVector<NodeItem*> DocumentPrivate::nodeItems() const
 {
     return m_nodes;
@@ -476,34 +638,18 @@ tikz::core::Entity * DocumentPrivate::createEntity(const tikz::core::Uid & uid,
     auto entity = Document::createEntity(uid, type);
 
     switch (type) {
-        case tikz::EntityType::Node: {
-            auto node = qobject_cast<tikz::core::Node *>(entity);
-            Q_ASSERT(uid == node->uid());
-            Q_ASSERT(! m_nodeMap.contains(uid));
-
-            // create GUI item
-            NodeItem * nodeItem = new NodeItem(node);
-            m_nodes.append(nodeItem);
-            m_nodeMap.insert(uid, nodeItem);
-
-            // add to graphics scene
-            m_scene->addItem(nodeItem);
-
-            break;
-        }
+        case tikz::EntityType::Node:
         case tikz::EntityType::Path: {
-            auto path = qobject_cast<tikz::core::EdgePath *>(entity);
-            Q_ASSERT(uid == path->uid());
-            Q_ASSERT(! m_pathMap.contains(uid));
-
-            // create GUI item
-            auto * pathItem = new tikz::ui::EdgePathItem(path);
-            m_paths.append(pathItem);
-            m_pathMap.insert(uid, pathItem);
-
-            // add to graphics scene
-            m_scene->addItem(pathItem);
-
+            Q_ASSERT(uid == entity->uid());
+
+            if (m_deferItems) {
+                m_pendingItems.insert(uid);
+                m_pendingQueue.append(uid);
+            } else if (type == tikz::EntityType::Node) {
+                addNodeItem(qobject_cast<tikz::core::Node *>(entity));
+            } else {
+                addPathItem(qobject_cast<tikz::core::Path *>(entity));
+            }
             break;
         }
         case tikz::EntityType::Style:
@@ -517,6 +663,12 @@ tikz::core::Entity * DocumentPrivate::createEntity(const tikz::core::Uid & uid,
 
 void DocumentPrivate::deleteEntity(const tikz::core::Uid & uid)
 {
+    // pending entities have no item yet
+    if (m_pendingItems.remove(uid)) {
+        tikz::core::Document::deleteEntity(uid);
+        return;
+    }
+
     switch (uid.entityType()) {
         case tikz::EntityType::Node: {
             Q_ASSERT(m_nodeMap.contains(uid));
@@ -567,40 +719,14 @@ tikz::core::Path * DocumentPrivate::createPath(tikz::PathType type, const tikz::
 {
     auto path = Document::createPath(type, uid);
     Q_ASSERT(uid == path->uid());
-    Q_ASSERT(! m_pathMap.contains(uid));
 
-    // create GUI item
-    tikz::ui::PathItem * pathItem = nullptr;
-    switch (type) {
-        case tikz::PathType::Line: {
-            pathItem = new tikz::ui::EdgePathItem(path);
-            break;
-        }
-        case tikz::PathType::HVLine: break;
-        case tikz::PathType::VHLine: break;
-        case tikz::PathType::BendCurve: break;
-        case tikz::PathType::InOutCurve: break;
-        case tikz::PathType::BezierCurve: break;
-        case tikz::PathType::Ellipse: {
-            pathItem = new tikz::ui::EllipsePathItem(path);
-            break;
-        }
-        case tikz::PathType::Rectangle: break;
-        case tikz::PathType::Grid: break;
-        case tikz::PathType::Invalid:
-        default: break;
+    if (m_deferItems) {
+        m_pendingItems.insert(uid);
+        m_pendingQueue.append(uid);
+    } else {
+        addPathItem(path);
     }
 
-    // we should always have a valid ui tikz path
-    Q_ASSERT(pathItem);
-
-    // register path
-    m_paths.append(pathItem);
-    m_pathMap.insert(uid, pathItem);
-
-    // add to graphics scene
-    m_scene->addItem(pathItem);
-
     return path;
 }
 
@@ -610,6 +736,11 @@ NodeItem * DocumentPrivate::nodeItemFromId(const tikz::core::Uid & uid) const
         return nullptr;
     }
 
+    // items refer to the items of other nodes, so create these on demand
+    if (m_pendingItems.contains(uid)) {
+        const_cast<DocumentPrivate *>(this)->createPendingItem(uid);
+    }
+
     Q_ASSERT(m_nodeMap.contains(uid));
     return m_nodeMap[uid];
 }
@@ -620,6 +751,10 @@ tikz::ui::PathItem * DocumentPrivate::pathItemFromId(const tikz::core::Uid & uid
         return nullptr;
     }
 
+    if (m_pendingItems.contains(uid)) {
+        const_cast<DocumentPrivate *>(this)->createPendingItem(uid);
+    }
+
     Q_ASSERT(m_pathMap.contains(uid));
     return m_pathMap[uid];
 }
@@ -26,7 +26,10 @@
 #include "Document.h"
 #include <tikz/core/MetaPos.h>
 
+#include <QSet>
+
 class QGraphicsView;
+class QTimer;
 
 namespace tikz {
 namespace core {
@@ -119,17 +122,45 @@ class DocumentPrivate : public tikz::ui::Document
          */
         QVector<View *> views() const override;
 
+    //
+    // progressive loading
+    //
+    public:
+        /**
+         * Loads the document from @p url, and creates the items of all
+         * Node%s and Path%s in the visible area of the views. All other
+         * items are created by createPendingItems() in time slices.
+         */
+        bool loadProgressive(const QUrl & url) override;
+
+        /**
+         * Creates the pending items of all Node%s and Path%s in @p sceneRect
+         * right away. Views call this whenever their visible area changes,
+         * so that the visible items are created first, even if the view is
+         * created after loadProgressive().
+         */
+        void createItemsIn(const QRectF & sceneRect);
+
+    private Q_SLOTS:
+        /**
+         * Creates pending items for about one time slice, and emits
+         * loadProgress().
+         */
+        void createPendingItems();
+
     //
     // Node and path creation
     //
     public:
         /**
          * Returns all NodeItem%s in the DocumentPrivate.
+         * While loading progressively, items not created yet are missing.
          */
         QVector<NodeItem*> nodeItems() const override;
 
         /**
          * Returns all PathItem%s in the DocumentPrivate.
+         * While loading progressively, items not created yet are missing.
          */
         QVector<PathItem*> pathItems() const override;
 
@@ -162,14 +193,14 @@ class DocumentPrivate : public tikz::ui::Document
         void deletePathItem(tikz::ui::PathItem * path) override;
 
         /**
-         * Get the NodeItem with @p uid.
+         * Get the NodeItem with @p uid. A pending item is created now.
          * @param uid unique id of the node
          * @return null, if the id is -1, otherwise a valid pointer to the node
          */
         NodeItem * nodeItemFromId(const tikz::core::Uid & uid) const;
 
         /**
-         * Get the tikz::ui::PathItem with @p uid.
+         * Get the tikz::ui::PathItem with @p uid. A pending item is created now.
          * @param uid unique id of the path
          * @return null, if the id is -1, otherwise a valid pointer to the node
          */
@@ -205,6 +236,22 @@ class DocumentPrivate : public tikz::ui::Document
          */
         void clearDocumentPrivate();
 
+    private:
+        /**
+         * Creates the NodeItem for @p node, and adds it to the scene.
+         */
+        void addNodeItem(tikz::core::Node * node);
+
+        /**
+         * Creates the PathItem for @p path, and adds it to the scene.
+         */
+        void addPathItem(tikz::core::Path * path);
+
+        /**
+         * Creates the item of @p uid, if it is pending.
+         */
+        void createPendingItem(const tikz::core::Uid & uid);
+
     private:
         /**
          * List of NodeItem%s.
@@ -235,6 +282,34 @@ class DocumentPrivate : public tikz::ui::Document
          * List of graphics views.
          */
         QVector<tikz::ui::View*> m_views;
+
+        /**
+         * If true, createEntity() and createPath() defer the creation of
+         * the items, see loadProgressive().
+         */
+        bool m_deferItems = false;
+
+        /**
+         * Node%s and Path%s without item yet.
+         */
+        QSet<tikz::core::Uid> m_pendingItems;
+
+        /**
+         * Order in which createPendingItems() creates the pending items.
+         * Items created on demand are skipped.
+         */
+        QVector<tikz::core::Uid> m_pendingQueue;
+        int m_pendingIndex = 0;
+
+        /**
+         * Number of pending items after loading, see loadProgress().
+         */
+        int m_pendingTotal = 0;
+
+        /**
+         * Timer that triggers createPendingItems().
+         */
+        QTimer * m_pendingTimer;
 };
 
 }
@@ -75,6 +75,16 @@ public:
      */
     virtual QVector<View *> views() const = 0;
 
+public:
+    /**
+     * Loads the document from @p url like load(). However, only the
+     * NodeItem%s and PathItem%s in the visible area of the views are
+     * created immediately. All other items are created in the background
+     * while the event loop runs, see loadProgress().
+     * @return true on success, otherwise false
+     */
+    virtual bool loadProgressive(const QUrl & url) = 0;
+
 Q_SIGNALS:
     /**
      * This signal is emitted whenever the \p document creates a new \p view.
@@ -88,6 +98,15 @@ Q_SIGNALS:
      */
     void viewCreated(tikz::ui::Document *document, tikz::ui::View *view);
 
+    /**
+     * This signal is emitted while the items of a document loaded with
+     * loadProgressive() are created. The items are complete as soon as
+     * \p loaded equals \p total.
+     * \param loaded number of created items
+     * \param total number of items to create
+     */
+    void loadProgress(int loaded, int total);
+
 public:
     /**
      * Returns all NodeItem%s in the DocumentPrivate.
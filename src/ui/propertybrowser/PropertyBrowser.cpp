@@ -87,36 +87,40 @@ public:
 
     QPointer<View> view = nullptr;
     tikz::core::Uid uid;
-    QHash<QtProperty *, QString> propertyMap;
+    // maps to the property id, see tikz::core::PropertyManager::propertyId()
+    QHash<QtProperty *, int> propertyMap;
 
 public:
-    void addProperty(QtProperty *property, const QString & name)
+    void addProperty(QtProperty *property, int id)
     {
         Q_ASSERT(! propertyMap.contains(property));
-        propertyMap[property] = name;
+        propertyMap[property] = id;
 //         QtBrowserItem *item =
         browser->addProperty(property);
 //         browser->setExpanded(item, idToExpanded[name]);
     }
 
-    void addSubProperty(QtProperty *parent, QtProperty *property, const QString & name)
+    void addSubProperty(QtProperty *parent, QtProperty *property, int id)
     {
         Q_ASSERT(! propertyMap.contains(property));
-        propertyMap[property] = name;
+        propertyMap[property] = id;
         parent->addSubProperty(property);
 //         browser->setExpanded(item, idToExpanded[name]);
     }
 
     void addProperty(QObject * object, const QString & name)
     {
-        const auto info = tikz::core::propertyManager().info(name);
+        auto & manager = tikz::core::propertyManager();
+        const auto & info = manager.info(name);
 
         if (!info.isValid()) {
             qDebug() << "Unknown property:" << name;
             return;
         }
 
-        QVariant prop = object->property(name.toLatin1().data());
+        const int id = manager.propertyId(name);
+        const auto accessor = manager.accessor(object->metaObject(), id);
+        QVariant prop = accessor.isValid() ? accessor.read(object) : QVariant();
         if (!prop.isValid()) {
             qDebug() << "Unknown property type:" << name;
             return;
@@ -189,19 +193,15 @@ public:
         if (property) {
             const QString modifiedFunction = info.modifiedFunction();
             if (!modifiedFunction.isEmpty()) {
-                bool isModified = false;
-                const bool ok = QMetaObject::invokeMethod(object,
-                                                          modifiedFunction.toLatin1().data(),
-                                                          Qt::DirectConnection,
-                                                          Q_RETURN_ARG(bool, isModified)
-                );
+                bool ok = false;
+                const bool isModified = accessor.isModified(object, &ok);
                 if (ok) {
                     property->setModified(isModified);
                 } else {
                     tikz::debug("properties.json: Invalid modified getter " + modifiedFunction);
                 }
             }
-            addProperty(property, name);
+            addProperty(property, id);
         }
     }
 
@@ -217,8 +217,8 @@ public:
 
         auto style = styleForItem(uid);
         if (style) {
-            const QString name = propertyMap[property];
-            style->document()->addUndoItem(new tikz::core::UndoSetProperty(style->uid(), name, val));
+            const int id = propertyMap[property];
+            style->document()->addUndoItem(new tikz::core::UndoSetProperty(style->uid(), id, QVariant::fromValue(val)));
         }
     }
 };
@@ -265,7 +265,7 @@ void NodeTool::handleMousePressed(Handle * handle, const QPointF & scenePos, QGr
         default: Q_ASSERT(false);
     }
 
-    m_transaction.reset(new tikz::core::Transaction(document(), action));
+    m_transaction.reset(new tikz::core::Transaction(document(), action, tikz::core::Transaction::Gesture));
 }
 
 void NodeTool::handleMouseReleased(Handle * handle, const QPointF & scenePos, QGraphicsView * view)
@@ -139,6 +139,15 @@ void Renderer::setZoom(qreal zoomFactor)
     QTransform m;
     m.scale(physicalDpiX() / s, -physicalDpiY() / s);
     setTransform(m);
+
+    createVisibleItems();
+}
+
+void Renderer::createVisibleItems()
+{
+    if (m_doc) {
+        m_doc->createItemsIn(mapToScene(viewport()->rect()).boundingRect());
+    }
 }
 
 void Renderer::mousePressEvent(QMouseEvent* event)
@@ -226,6 +235,22 @@ bool Renderer::viewportEvent(QEvent * event)
     return QGraphicsView::viewportEvent(event);
 }
 
+void Renderer::resizeEvent(QResizeEvent * event)
+{
+    QGraphicsView::resizeEvent(event);
+
+    // the visible area changed
+    createVisibleItems();
+}
+
+void Renderer::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    // the visible area changed
+    createVisibleItems();
+}
+
 void Renderer::drawBackground(QPainter * painter, const QRectF & rect)
 {
     // draw default background (typically nothing)
@@ -75,6 +75,12 @@ class Renderer : public QGraphicsView
          */
         ZoomController * zoomController() const;
 
+        /**
+         * Lets the document create the pending items in the visible area,
+         * see DocumentPrivate::loadProgressive().
+         */
+        void createVisibleItems();
+
     public Q_SLOTS:
         /**
          * Sets the zoom factor. 1.0 maps to 100%.
@@ -93,6 +99,8 @@ class Renderer : public QGraphicsView
         void mouseReleaseEvent(QMouseEvent* event) override;
         void wheelEvent(QWheelEvent* event) override;
         bool viewportEvent(QEvent * event) override;
+        void resizeEvent(QResizeEvent * event) override;
+        void scrollContentsBy(int dx, int dy) override;
 
         void drawBackground(QPainter * painter, const QRectF & rect) override;
         void drawForeground(QPainter * painter, const QRectF & rect) override;
@@ -0,0 +1,222 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include "TestJsonWriter.h"
+
+#include <QtTest/QTest>
+#include <QBuffer>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <tikz/core/JsonWriter.h>
+
+QTEST_MAIN(JsonWriterTest)
+
+// parses the data written to @p buffer
+static QJsonDocument parse(const QBuffer & buffer)
+{
+    QJsonParseError error;
+    const QJsonDocument json = QJsonDocument::fromJson(buffer.data(), &error);
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << error.errorString() << buffer.data();
+    }
+    return json;
+}
+
+void JsonWriterTest::initTestCase()
+{
+}
+
+void JsonWriterTest::cleanupTestCase()
+{
+}
+
+void JsonWriterTest::testStructure()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    QJsonObject entity;
+    entity["name"] = "node";
+    entity["pos"] = QJsonArray { 1, 2 };
+
+    {
+        tikz::core::JsonWriter writer(&buffer);
+        writer.beginObject();
+        writer.key("empty-object");
+        writer.beginObject();
+        writer.endObject();
+        writer.key("empty-array");
+        writer.beginArray();
+        writer.endArray();
+        writer.key("array");
+        writer.beginArray();
+        writer.value(true);
+        writer.null();
+        writer.beginArray();
+        writer.value(1);
+        writer.endArray();
+        writer.value(entity);
+        writer.endArray();
+        writer.key("entity");
+        writer.value(entity);
+        writer.endObject();
+        QVERIFY(writer.flush());
+    }
+
+    const QJsonDocument json = parse(buffer);
+    QVERIFY(json.isObject());
+
+    QJsonObject expected;
+    expected["empty-object"] = QJsonObject();
+    expected["empty-array"] = QJsonArray();
+    expected["array"] = QJsonArray { true, QJsonValue(), QJsonArray { 1 }, entity };
+    expected["entity"] = entity;
+    QCOMPARE(json.object(), expected);
+}
+
+void JsonWriterTest::testStrings()
+{
+    const QStringList strings = {
+        QString(),
+        QStringLiteral("plain"),
+        QStringLiteral("quote \" and backslash \\"),
+        QStringLiteral("control \b\f\n\r\t characters"),
+        QString(QChar(0x01)) + QChar(0x1f),
+        QStringLiteral("unicode ä€ \U0001F600"),
+    };
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        tikz::core::JsonWriter writer(&buffer);
+        writer.beginObject();
+        for (int i = 0; i < strings.size(); ++i) {
+            writer.key(strings[i]);
+            writer.value(strings[i]);
+        }
+        writer.endObject();
+    }
+
+    const QJsonObject json = parse(buffer).object();
+    QCOMPARE(json.size(), strings.size());
+    for (const auto & str : strings) {
+        QCOMPARE(json[str].toString(), str);
+    }
+}
+
+void JsonWriterTest::testNumbers()
+{
+    const QVector<double> numbers = {
+        0.0, 1.0, -1.0, 0.5, -2.25, 1.0 / 3.0, 1e-300, 1e300,
+        9007199254740991.0, 123456789.125
+    };
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        tikz::core::JsonWriter writer(&buffer);
+        writer.beginArray();
+        for (double number : numbers) {
+            writer.value(number);
+        }
+        writer.value(static_cast<qint64>(-42));
+        writer.value(std::numeric_limits<double>::quiet_NaN());
+        writer.endArray();
+    }
+
+    // all numbers survive the round trip exactly
+    const QJsonArray json = parse(buffer).array();
+    QCOMPARE(json.size(), numbers.size() + 2);
+    for (int i = 0; i < numbers.size(); ++i) {
+        QCOMPARE(json[i].toDouble(), numbers[i]);
+    }
+    QCOMPARE(json[numbers.size()].toInt(), -42);
+    QVERIFY(json[numbers.size() + 1].isNull());
+
+    // integral values are written without fraction or exponent
+    QVERIFY(buffer.data().startsWith("[0,1,-1,0.5,-2.25,"));
+}
+
+void JsonWriterTest::testNumberRoundTrip()
+{
+    // random finite doubles of all magnitudes
+    QRandomGenerator generator(42);
+    QVector<double> numbers;
+    while (numbers.size() < 100000) {
+        const quint64 bits = generator.generate64();
+        double number;
+        std::memcpy(&number, &bits, sizeof(number));
+        if (std::isfinite(number) && std::abs(number) >= DBL_MIN) {
+            numbers.append(number);
+        }
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        tikz::core::JsonWriter writer(&buffer);
+        writer.beginArray();
+        for (double number : qAsConst(numbers)) {
+            writer.value(number);
+        }
+        writer.endArray();
+    }
+
+    const QJsonArray json = parse(buffer).array();
+    QCOMPARE(json.size(), numbers.size());
+    for (int i = 0; i < numbers.size(); ++i) {
+        if (json[i].toDouble() != numbers[i]) {
+            QCOMPARE(json[i].toDouble(), numbers[i]);
+        }
+    }
+}
+
+void JsonWriterTest::testBuffer()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    // data is written to the device once the buffer is full
+    const int count = tikz::core::JsonWriter::bufferSize() / 4;
+    tikz::core::JsonWriter writer(&buffer);
+    writer.beginArray();
+    for (int i = 0; i < count; ++i) {
+        writer.value(i);
+        writer.value(QStringLiteral("x"));
+    }
+    QVERIFY(buffer.size() > 0);
+
+    writer.endArray();
+    QVERIFY(writer.flush());
+    QVERIFY(!writer.hasError());
+
+    const QJsonArray json = parse(buffer).array();
+    QCOMPARE(json.size(), 2 * count);
+    QCOMPARE(json[2 * count - 2].toInt(), count - 1);
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -1,6 +1,6 @@
 /* This file is part of the TikZKit project.
  *
- * Copyright (C) 2013-2014 Dominik Haumann <dhaumann@kde.org>
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
  *
  * This library is free software; you can redistribute it and/or modify
  * it under the terms of the GNU Library General Public License as published
@@ -16,44 +16,27 @@
  * along with this library; see the file COPYING.LIB.  If not, see
  * <http://www.gnu.org/licenses/>.
  */
+#ifndef TEST_JSON_WRITER_H
+#define TEST_JSON_WRITER_H
 
-#include "MetaPos_p.h"
-#include "MetaPos.h"
+#include <QObject>
 
-namespace tikz {
-namespace core {
-
-MetaPosPrivate::MetaPosPrivate(MetaPos * metaPos)
-    : QObject()
-    , q(metaPos)
-    , nodeId()
-    , anchor()
-{
-}
-
-void MetaPosPrivate::beginChange()
+class JsonWriterTest : public QObject
 {
-    Q_ASSERT(changeRefCounter >= 0);
-    ++changeRefCounter;
-}
+    Q_OBJECT
 
-void MetaPosPrivate::endChange()
-{
-    Q_ASSERT(changeRefCounter > 0);
-
-    --changeRefCounter;
-    if (changeRefCounter == 0) {
-        Q_EMIT changed(q);
-    }
-}
+public Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
 
-void MetaPosPrivate::changeRequest()
-{
-    beginChange();
-    endChange();
-}
+private Q_SLOTS:
+    void testStructure();
+    void testStrings();
+    void testNumbers();
+    void testNumberRoundTrip();
+    void testBuffer();
+};
 
-}
-}
+#endif // TEST_JSON_WRITER_H
 
 // kate: indent-width 4; replace-tabs on;
@@ -19,13 +19,36 @@
 #include "TestMetaPos.h"
 
 #include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+#include <QVector>
+#include <QJsonValue>
 
 #include <tikz/core/Document.h>
 #include <tikz/core/MetaPos.h>
 #include <tikz/core/Node.h>
+#include <tikz/core/Style.h>
 
 QTEST_MAIN(MetaPosTest)
 
+// number of iterations in the benchmarks
+static constexpr int s_count = 100000;
+
+namespace {
+// document, in which the anchors depend on the size of the typeset text
+class TextDocument : public tikz::core::Document
+{
+public:
+    tikz::Pos scenePos(const tikz::core::MetaPos & pos) const override
+    {
+        auto node = pos.node();
+        if (node) {
+            return node->pos() + tikz::Pos(node->textSize().width() / 2.0, 0.0);
+        }
+        return tikz::core::Document::scenePos(pos);
+    }
+};
+}
+
 void MetaPosTest::initTestCase()
 {
 }
@@ -44,25 +67,22 @@ void MetaPosTest::testMetaPos()
     QCOMPARE(m.node(), (tikz::core::Node*)nullptr);
     QVERIFY(m == m);
 
-    // test changed signal
-    connect(m.notificationObject(), SIGNAL(changed(tikz::core::MetaPos*)),
-            this, SLOT(changedEmitted()));
-
-    // reset signal counter
-    m_changeCount = 0;
-
     // perform change
     m.setPos(tikz::Pos(1, 1));
     QCOMPARE(m.pos(), tikz::Pos(1, 1));
     QVERIFY(m == m);
 
-    // make sure signals are emitted only once
-    QCOMPARE(m_changeCount, 1);
+    // copies are independent values
+    tikz::core::MetaPos copy = m;
+    QVERIFY(copy == m);
+    copy.setPos(tikz::Pos(2, 2));
+    QVERIFY(copy != m);
+    QCOMPARE(m.pos(), tikz::Pos(1, 1));
 
     // make sure setNode with null pointer has no effect
     QVERIFY( ! m.setNode(nullptr));
     QVERIFY(m == m);
-    QCOMPARE(m_changeCount, 1);
+    QCOMPARE(m.pos(), tikz::Pos(1, 1));
 }
 
 void MetaPosTest::changedEmitted()
@@ -80,22 +100,14 @@ void MetaPosTest::testMetaPosWithNode()
     n->setPos(tikz::Pos(5, 5));
     QCOMPARE(n->pos(), tikz::Pos(5, 5));
 
-    // connect to changed signal
-    connect(m.notificationObject(), SIGNAL(changed(tikz::core::MetaPos*)),
-            this, SLOT(changedEmitted()));
-
-    // reset changed counter
-    m_changeCount = 0;
-
     // check setting node
     QVERIFY(m.setNode(n));
     QCOMPARE(m.node(), n);
+    QCOMPARE(m.nodeUid(), n->uid());
     QVERIFY(m == m);
-    QCOMPARE(m_changeCount, 1);
 
     // make sure setting same node again does nothing
     QVERIFY(! m.setNode(n));
-    QCOMPARE(m_changeCount, 1);
 
     // should be same as node pos
     QCOMPARE(m.pos(), tikz::Pos(5, 5));
@@ -112,12 +124,10 @@ void MetaPosTest::testMetaPosWithNode()
     // using setPos() resets node, test this
     QCOMPARE(m.node(), (tikz::core::Node*)nullptr);
 
-    // make sure signals are emitted only once
-    QCOMPARE(m_changeCount, 1);
-
     //
     // now connect to node again and change node position.
-    // The MetaPos.pos() should adapt automatically
+    // The MetaPos.pos() should adapt automatically, and subscribers
+    // to the node are notified through the Document.
     //
     QVERIFY(m.setNode(n));
     QCOMPARE(m.node(), n);
@@ -127,11 +137,20 @@ void MetaPosTest::testMetaPosWithNode()
 
     // now change node position
     m_changeCount = 0;
+    doc.subscribe(m.nodeUid(), this, [this]() {
+        changedEmitted();
+    });
     n->setPos(tikz::Pos(10, 10));
     QCOMPARE(n->pos(), tikz::Pos(10, 10));
     QCOMPARE(m.pos(), tikz::Pos(10, 10));
     QVERIFY(m == m);
     QCOMPARE(m_changeCount, 1);
+
+    // no notification after unsubscribing
+    doc.unsubscribe(m.nodeUid(), this);
+    n->setPos(tikz::Pos(20, 20));
+    QCOMPARE(m.pos(), tikz::Pos(20, 20));
+    QCOMPARE(m_changeCount, 1);
 }
 
 void MetaPosTest::testSet0()
@@ -249,10 +268,175 @@ void MetaPosTest::testFromString()
     QCOMPARE(m.node(), n);
     QCOMPARE(m.anchor(), QString("south"));
 
+    // anchors may contain spaces, ids are not limited to int
+    m.fromString("(1.north east)");
+    QCOMPARE(m.node(), n);
+    QCOMPARE(m.anchor(), QString("north east"));
+
+    m.fromString("(5000000000.west)");
+    QCOMPARE(m.nodeUid().id(), qint64(5000000000));
+    QCOMPARE(m.node(), (tikz::core::Node*)nullptr);
+    QCOMPARE(m.anchor(), QString("west"));
+
     m.fromString("(-123345in, +124323in)");
     QCOMPARE(m.toString(), QString("(-123345in, 124323in)"));
     QCOMPARE(m.node(), (tikz::core::Node*)nullptr);
     QVERIFY(m.anchor().isEmpty());
 }
 
+void MetaPosTest::testJson()
+{
+    tikz::core::Document doc;
+    auto n = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+
+    // scene coordinates are stored as numbers
+    tikz::core::MetaPos m(&doc);
+    m.setPos(tikz::Pos(-3.0_cm, 4.0_cm));
+    QVERIFY(m.toJson().isArray());
+
+    tikz::core::MetaPos other(&doc);
+    other.fromJson(m.toJson());
+    QCOMPARE(other, m);
+
+    // positions attached to a node are stored as string
+    m.fromString("(" + n->uid().toString() + ".south)");
+    QCOMPARE(m.toJson(), QJsonValue(m.toString()));
+    other.fromJson(m.toJson());
+    QCOMPARE(other.node(), n);
+    QCOMPARE(other.anchor(), QString("south"));
+}
+
+void MetaPosTest::testPosCache()
+{
+    tikz::core::Document doc;
+    auto n = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    n->setPos(tikz::Pos(1, 1));
+
+    tikz::core::MetaPos m(&doc);
+    m.setNode(n);
+    QCOMPARE(m.pos(), tikz::Pos(1, 1));
+
+    // all changes that may move an anchor change the revision
+    quint64 revision = n->revision();
+    n->setPos(tikz::Pos(2, 2));
+    QVERIFY(n->revision() != revision);
+    revision = n->revision();
+    n->setText("text");
+    QVERIFY(n->revision() != revision);
+    revision = n->revision();
+    n->style()->setInnerSep(tikz::Value(5));
+    QVERIFY(n->revision() != revision);
+
+    // revisions are unique across nodes
+    auto n2 = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    QVERIFY(n2->revision() != n->revision());
+
+    // the cached position follows the node
+    QCOMPARE(m.pos(), tikz::Pos(2, 2));
+    n->setPos(tikz::Pos(3, 3));
+    QCOMPARE(m.pos(), tikz::Pos(3, 3));
+
+    // copies keep the cache, but stay independent
+    tikz::core::MetaPos copy = m;
+    QCOMPARE(copy.pos(), tikz::Pos(3, 3));
+    copy.setNode(n2);
+    QCOMPARE(copy.pos(), n2->pos());
+    QCOMPARE(m.pos(), tikz::Pos(3, 3));
+
+    // changing the anchor invalidates the cache
+    m.setAnchor("north");
+    QCOMPARE(m.anchor(), QString("north"));
+    QCOMPARE(m.pos(), doc.scenePos(m));
+}
+
+void MetaPosTest::testPosCacheInvalidate()
+{
+    TextDocument doc;
+    auto n = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    n->setPos(tikz::Pos(1, 1));
+
+    tikz::core::MetaPos m(&doc);
+    m.setNode(n);
+    QCOMPARE(m.pos(), tikz::Pos(1, 1));
+
+    QSignalSpy spy(n, SIGNAL(changed()));
+
+    // the geometry changes without a change of the text or the style
+    quint64 revision = n->revision();
+    n->setTextSize(QSizeF(4, 2));
+    QVERIFY(n->revision() != revision);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(m.pos(), tikz::Pos(3, 1));
+
+    // new text of the same size still changes the node
+    revision = n->revision();
+    n->setTextSize(QSizeF(4, 2));
+    QVERIFY(n->revision() != revision);
+    QCOMPARE(spy.count(), 2);
+
+    revision = n->revision();
+    n->invalidate();
+    QVERIFY(n->revision() != revision);
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(m.pos(), tikz::Pos(3, 1));
+}
+
+void MetaPosTest::benchmarkCopy()
+{
+    tikz::core::Document doc;
+    auto n = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    tikz::core::MetaPos m(&doc);
+    m.setNode(n);
+    m.setAnchor("north");
+
+    QVector<tikz::core::MetaPos> copies;
+    copies.reserve(s_count);
+    QBENCHMARK {
+        copies.clear();
+        for (int i = 0; i < s_count; ++i) {
+            copies.append(m);
+        }
+    }
+    QCOMPARE(copies.size(), s_count);
+}
+
+void MetaPosTest::benchmarkCompare()
+{
+    tikz::core::Document doc;
+    auto n = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    tikz::core::MetaPos m1(&doc);
+    tikz::core::MetaPos m2(&doc);
+    m1.setNode(n);
+    m2.setPos(tikz::Pos(1, 1));
+
+    int equal = 0;
+    QBENCHMARK {
+        for (int i = 0; i < s_count; ++i) {
+            equal += (m1 == m2) ? 1 : 0;
+            equal += (m2 == m2) ? 1 : 0;
+        }
+    }
+    QVERIFY(equal > 0);
+}
+
+void MetaPosTest::benchmarkPos()
+{
+    tikz::core::Document doc;
+    auto n = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    n->setPos(tikz::Pos(1, 2));
+    tikz::core::MetaPos m1(&doc);
+    tikz::core::MetaPos m2(&doc);
+    m1.setNode(n);
+    m2.setPos(tikz::Pos(1, 1));
+
+    qreal sum = 0;
+    QBENCHMARK {
+        for (int i = 0; i < s_count; ++i) {
+            sum += m1.pos().x().value();
+            sum += m2.pos().y().value();
+        }
+    }
+    QVERIFY(sum > 0);
+}
+
 // kate: indent-width 4; replace-tabs on;
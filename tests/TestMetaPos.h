@@ -37,6 +37,12 @@ private Q_SLOTS:
     void testMetaPosPtr();
     void testToString();
     void testFromString();
+    void testJson();
+    void testPosCache();
+    void testPosCacheInvalidate();
+    void benchmarkCopy();
+    void benchmarkCompare();
+    void benchmarkPos();
 
 public Q_SLOTS:
     void changedEmitted();
@@ -19,6 +19,8 @@
 #include "TestPos.h"
 
 #include <QtTest/QTest>
+#include <QJsonArray>
+#include <QJsonValue>
 
 #include <tikz/core/Pos.h>
 
@@ -62,6 +64,33 @@ void PosTest::testFromString()
     QCOMPARE(pos, tikz::Pos::fromString("(3cm, 5cm)").convertTo(tikz::Unit::Millimeter));
     QCOMPARE(pos, tikz::Pos::fromString("(3cm, 5cm)").convertTo(tikz::Unit::Centimeter));
     QCOMPARE(pos, tikz::Pos::fromString("(3cm, 5cm)").convertTo(tikz::Unit::Inch));
+
+    // whitespace, signs and exponents
+    QCOMPARE(pos, tikz::Pos::fromString("( 3cm ,5 cm )"));
+    QCOMPARE(pos, tikz::Pos::fromString("(+3cm, 0.5e1cm)"));
+
+    // mixed units survive the round trip
+    pos = tikz::Pos(tikz::Value(-1.25, tikz::Unit::Millimeter), 0.1_in);
+    QCOMPARE(pos.toString(), QString("(-1.25mm, 0.1in)"));
+    QCOMPARE(tikz::Pos::fromString(pos.toString()), pos);
+}
+
+void PosTest::testJson()
+{
+    // x and y in the same unit
+    const tikz::Pos pos(0.1_cm, -2.0_cm);
+    QCOMPARE(pos.toJson(), QJsonValue(QJsonArray { 0.1, -2.0, "cm" }));
+    QCOMPARE(tikz::Pos::fromJson(pos.toJson()), pos);
+
+    // x and y in different units
+    const tikz::Pos mixed(3.0_pt, 4.5_mm);
+    const tikz::Pos result = tikz::Pos::fromJson(mixed.toJson());
+    QCOMPARE(result.x().unit(), tikz::Unit::Point);
+    QCOMPARE(result.y().unit(), tikz::Unit::Millimeter);
+    QCOMPARE(result, mixed);
+
+    // the string form is still supported
+    QCOMPARE(tikz::Pos::fromJson(QJsonValue("(3cm, 5cm)")), tikz::Pos(3.0_cm, 5.0_cm));
 }
 
 // kate: indent-width 4; replace-tabs on;
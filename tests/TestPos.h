@@ -33,6 +33,7 @@ public Q_SLOTS:
 private Q_SLOTS:
     void testPos();
     void testFromString();
+    void testJson();
 };
 
 #endif // TEST_POS_H
@@ -0,0 +1,359 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include "TestRTree.h"
+
+#include <QtTest/QTest>
+#include <QHash>
+#include <QVector>
+
+#include <tikz/core/RTree.h>
+#include <tikz/core/Document.h>
+#include <tikz/core/Node.h>
+#include <tikz/core/Style.h>
+
+#include <algorithm>
+#include <random>
+
+QTEST_MAIN(RTreeTest)
+
+using tikz::core::RTree;
+using tikz::core::Uid;
+
+// helper: squared distance of rect to point, 0 if inside
+static qreal squaredDistance(const QRectF & rect, const QPointF & p)
+{
+    const qreal dx = std::max({rect.left() - p.x(), qreal(0), p.x() - rect.right()});
+    const qreal dy = std::max({rect.top() - p.y(), qreal(0), p.y() - rect.bottom()});
+    return dx * dx + dy * dy;
+}
+
+// helper: intersection test that includes touching borders and empty rects
+static bool intersects(const QRectF & a, const QRectF & b)
+{
+    return a.left() <= b.right() && b.left() <= a.right()
+        && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+// helper: fills tree with count points, randomly distributed in a square
+// such that the density stays the same for all counts
+static void fillTree(RTree & tree, int count, std::mt19937 & rng)
+{
+    const qreal size = std::sqrt(qreal(count)) * 10;
+    std::uniform_real_distribution<qreal> coord(0, size);
+    for (int i = 0; i < count; ++i) {
+        tree.insert(Uid(i, nullptr), QRectF(coord(rng), coord(rng), 0, 0));
+    }
+}
+
+static void addCounts()
+{
+    QTest::addColumn<int>("count");
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void RTreeTest::initTestCase()
+{
+}
+
+void RTreeTest::cleanupTestCase()
+{
+}
+
+void RTreeTest::testInsertRemove()
+{
+    RTree tree;
+    QVERIFY(tree.isEmpty());
+
+    const Uid a(1, nullptr);
+    const Uid b(2, nullptr);
+    tree.insert(a, QRectF(0, 0, 1, 1));
+    tree.insert(b, QRectF(5, 5, 0, 0));
+    QCOMPARE(tree.size(), 2);
+    QVERIFY(tree.contains(a));
+    QCOMPARE(tree.bounds(b), QRectF(5, 5, 0, 0));
+
+    // inserting again updates the bounds
+    tree.insert(a, QRectF(2, 2, 1, 1));
+    QCOMPARE(tree.size(), 2);
+    QCOMPARE(tree.bounds(a), QRectF(2, 2, 1, 1));
+
+    QVERIFY(tree.remove(a));
+    QVERIFY(!tree.remove(a));
+    QVERIFY(!tree.contains(a));
+    QCOMPARE(tree.size(), 1);
+
+    tree.clear();
+    QVERIFY(tree.isEmpty());
+    QVERIFY(tree.intersecting(QRectF(0, 0, 10, 10)).isEmpty());
+}
+
+void RTreeTest::testIntersecting()
+{
+    RTree tree;
+    for (int x = 0; x < 100; ++x) {
+        for (int y = 0; y < 100; ++y) {
+            tree.insert(Uid(x * 100 + y, nullptr), QRectF(x, y, 0, 0));
+        }
+    }
+
+    // touching borders count as intersection
+    auto result = tree.intersecting(QRectF(10, 10, 2, 3));
+    QCOMPARE(result.size(), 3 * 4);
+
+    std::sort(result.begin(), result.end(), [](const Uid & u1, const Uid & u2) {
+        return u1.id() < u2.id();
+    });
+    QCOMPARE(result.first().id(), qint64(10 * 100 + 10));
+    QCOMPARE(result.last().id(), qint64(12 * 100 + 13));
+
+    QVERIFY(tree.intersecting(QRectF(200, 200, 5, 5)).isEmpty());
+}
+
+void RTreeTest::testNearest()
+{
+    RTree tree;
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(Uid(i, nullptr), QRectF(i, 0, 0, 0));
+    }
+
+    const auto result = tree.nearest(QPointF(500.2, 3), 3);
+    QCOMPARE(result.size(), 3);
+    QCOMPARE(result[0].id(), qint64(500));
+    QCOMPARE(result[1].id(), qint64(501));
+    QCOMPARE(result[2].id(), qint64(499));
+
+    QCOMPARE(tree.nearest(QPointF(0, 0), 5000).size(), 1000);
+    QVERIFY(tree.nearest(QPointF(0, 0), 0).isEmpty());
+}
+
+void RTreeTest::testRandomOperations()
+{
+    // compare against a brute force reference
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<qreal> coord(0, 1000);
+    std::uniform_real_distribution<qreal> extent(0, 20);
+
+    RTree tree;
+    QHash<qint64, QRectF> reference;
+
+    for (int step = 0; step < 20000; ++step) {
+        const qint64 id = rng() % 2000;
+        const Uid uid(id, nullptr);
+        switch (rng() % 3) {
+            case 0:
+            case 1: {
+                const QRectF rect(coord(rng), coord(rng), extent(rng), extent(rng));
+                tree.update(uid, rect);
+                reference[id] = rect;
+                break;
+            }
+            case 2:
+                QCOMPARE(tree.remove(uid), reference.remove(id) > 0);
+                break;
+        }
+        QCOMPARE(tree.size(), reference.size());
+
+        if (step % 500 == 0) {
+            const QRectF query(coord(rng), coord(rng), 100, 100);
+            int expected = 0;
+            for (const auto & rect : reference) {
+                expected += intersects(rect, query) ? 1 : 0;
+            }
+            QCOMPARE(tree.intersecting(query).size(), expected);
+
+            const QPointF point(coord(rng), coord(rng));
+            QVector<qreal> distances;
+            for (const auto & rect : reference) {
+                distances.append(squaredDistance(rect, point));
+            }
+            std::sort(distances.begin(), distances.end());
+
+            const auto nearest = tree.nearest(point, 5);
+            QCOMPARE(nearest.size(), std::min(5, reference.size()));
+            for (int i = 0; i < nearest.size(); ++i) {
+                QCOMPARE(squaredDistance(reference[nearest[i].id()], point), distances[i]);
+            }
+        }
+    }
+}
+
+void RTreeTest::testDocument()
+{
+    tikz::core::Document doc;
+    auto n1 = doc.createNode();
+    auto n2 = doc.createNode();
+    n1->setPos(tikz::Pos(10, 10));
+    n2->setPos(tikz::Pos(100, 100));
+
+    QCOMPARE(doc.entitiesIn(QRectF(0, 0, 50, 50)), QVector<Uid>{n1->uid()});
+    QCOMPARE(doc.nearestEntities(tikz::Pos(90, 90), 1), QVector<Uid>{n2->uid()});
+
+    // moving a node updates the index
+    n1->setPos(tikz::Pos(200, 200));
+    QVERIFY(doc.entitiesIn(QRectF(0, 0, 50, 50)).isEmpty());
+    QCOMPARE(doc.nearestEntities(tikz::Pos(190, 190), 1), QVector<Uid>{n1->uid()});
+
+    // deleted nodes are removed from the index
+    const Uid n2Uid = n2->uid();
+    doc.deleteEntity(n2);
+    QVERIFY(doc.entitiesIn(QRectF(90, 90, 20, 20)).isEmpty());
+
+    doc.undo();
+    QCOMPARE(doc.entitiesIn(QRectF(90, 90, 20, 20)), QVector<Uid>{n2Uid});
+}
+
+void RTreeTest::testNodeBounds()
+{
+    tikz::core::Document doc;
+    auto node = doc.createNode();
+    node->setPos(tikz::Pos(0, 0));
+    node->style()->setInnerSep(tikz::Value(0));
+    node->style()->setOuterSep(tikz::Value(0));
+
+    // a query rect right of the node
+    const QRectF rect(20, -1, 10, 2);
+    QVERIFY(doc.entitiesIn(rect).isEmpty());
+
+    // the inner sep extends the bounds
+    node->style()->setInnerSep(tikz::Value(25));
+    QCOMPARE(doc.entitiesIn(rect), QVector<Uid>{node->uid()});
+    node->style()->setInnerSep(tikz::Value(0));
+    QVERIFY(doc.entitiesIn(rect).isEmpty());
+
+    // the outer sep as well
+    node->style()->setOuterSep(tikz::Value(25));
+    QCOMPARE(doc.entitiesIn(rect), QVector<Uid>{node->uid()});
+    node->style()->setOuterSep(tikz::Value(0));
+    QVERIFY(doc.entitiesIn(rect).isEmpty());
+
+    // changes of inherited values update the index, too
+    doc.style()->setOuterSep(tikz::Value(25));
+    node->style()->unsetOuterSep();
+    QCOMPARE(doc.entitiesIn(rect), QVector<Uid>{node->uid()});
+    node->style()->setOuterSep(tikz::Value(0));
+
+    // the text extends the bounds, once its size is known
+    node->setTextSize(QSizeF(50, 10));
+    QCOMPARE(doc.entitiesIn(rect), QVector<Uid>{node->uid()});
+    node->setTextSize(QSizeF());
+    QVERIFY(doc.entitiesIn(rect).isEmpty());
+
+    // circles enclose the minimum size
+    node->style()->setMinimumWidth(tikz::Value(10));
+    node->style()->setMinimumHeight(tikz::Value(50));
+    QVERIFY(doc.entitiesIn(rect).isEmpty());
+    node->style()->setShape(tikz::Shape::ShapeCircle);
+    QCOMPARE(doc.entitiesIn(rect), QVector<Uid>{node->uid()});
+}
+
+void RTreeTest::benchmarkInsert_data()
+{
+    addCounts();
+}
+
+void RTreeTest::benchmarkInsert()
+{
+    QFETCH(int, count);
+
+    QBENCHMARK_ONCE {
+        std::mt19937 rng(1);
+        RTree tree;
+        fillTree(tree, count, rng);
+    }
+}
+
+void RTreeTest::benchmarkIntersecting_data()
+{
+    addCounts();
+}
+
+void RTreeTest::benchmarkIntersecting()
+{
+    QFETCH(int, count);
+
+    std::mt19937 rng(1);
+    RTree tree;
+    fillTree(tree, count, rng);
+
+    // 1000 queries of a viewport-sized rectangle
+    const qreal size = std::sqrt(qreal(count)) * 10;
+    std::uniform_real_distribution<qreal> coord(0, size);
+    int found = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            found += tree.intersecting(QRectF(coord(rng), coord(rng), 100, 100)).size();
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void RTreeTest::benchmarkNearest_data()
+{
+    addCounts();
+}
+
+void RTreeTest::benchmarkNearest()
+{
+    QFETCH(int, count);
+
+    std::mt19937 rng(1);
+    RTree tree;
+    fillTree(tree, count, rng);
+
+    // 1000 queries for the 10 nearest entities
+    const qreal size = std::sqrt(qreal(count)) * 10;
+    std::uniform_real_distribution<qreal> coord(0, size);
+    int found = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            found += tree.nearest(QPointF(coord(rng), coord(rng)), 10).size();
+        }
+    }
+    QVERIFY(found > 0);
+}
+
+void RTreeTest::benchmarkUpdate_data()
+{
+    addCounts();
+}
+
+void RTreeTest::benchmarkUpdate()
+{
+    QFETCH(int, count);
+
+    std::mt19937 rng(1);
+    RTree tree;
+    fillTree(tree, count, rng);
+
+    // 1000 moves of random entities, as when dragging a selection
+    std::uniform_int_distribution<int> index(0, count - 1);
+    std::uniform_real_distribution<qreal> delta(-5, 5);
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            const Uid uid(index(rng), nullptr);
+            const QRectF bounds = tree.bounds(uid);
+            tree.update(uid, bounds.translated(delta(rng), delta(rng)));
+        }
+    }
+    QCOMPARE(tree.size(), count);
+}
+
+// kate: indent-width 4; replace-tabs on;
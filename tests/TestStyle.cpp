@@ -0,0 +1,463 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include "TestStyle.h"
+
+#include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
+#include <QJsonObject>
+
+#include <tikz/core/Document.h>
+#include <tikz/core/Node.h>
+#include <tikz/core/Style.h>
+#include <tikz/core/Transaction.h>
+#include <tikz/core/PropertyManager.h>
+#include <tikz/core/UndoSetProperty.h>
+
+QTEST_MAIN(StyleTest)
+
+void StyleTest::initTestCase()
+{
+    qRegisterMetaType<QVector<tikz::core::Uid>>();
+}
+
+void StyleTest::cleanupTestCase()
+{
+}
+
+void StyleTest::testInheritance()
+{
+    tikz::core::Document doc;
+    auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    child->setParentStyle(parent->uid());
+
+    // defaults
+    QCOMPARE(child->penColor(), QColor(Qt::black));
+    QCOMPARE(child->lineWidth(), tikz::Value::semiThick());
+
+    // changes in the document style propagate through the whole chain
+    doc.style()->setPenColor(Qt::red);
+    QCOMPARE(parent->penColor(), QColor(Qt::red));
+    QCOMPARE(child->penColor(), QColor(Qt::red));
+
+    // changes in the parent override the document style
+    parent->setPenColor(Qt::green);
+    QCOMPARE(child->penColor(), QColor(Qt::green));
+
+    // own values override the parent
+    child->setPenColor(Qt::blue);
+    QCOMPARE(child->penColor(), QColor(Qt::blue));
+    parent->setPenColor(Qt::yellow);
+    QCOMPARE(child->penColor(), QColor(Qt::blue));
+
+    // unsetting falls back to the parent again
+    child->unsetPenColor();
+    QCOMPARE(child->penColor(), QColor(Qt::yellow));
+    parent->unsetPenColor();
+    QCOMPARE(child->penColor(), QColor(Qt::red));
+}
+
+void StyleTest::testReparent()
+{
+    tikz::core::Document doc;
+    auto a = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto b = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+
+    a->setLineWidth(tikz::Value::thick());
+    b->setLineWidth(tikz::Value::veryThick());
+
+    child->setParentStyle(a->uid());
+    QCOMPARE(child->lineWidth(), tikz::Value::thick());
+
+    child->setParentStyle(b->uid());
+    QCOMPARE(child->lineWidth(), tikz::Value::veryThick());
+
+    // the old parent must not influence the child anymore
+    a->setLineWidth(tikz::Value::ultraThick());
+    QCOMPARE(child->lineWidth(), tikz::Value::veryThick());
+
+    child->setParentStyle(tikz::core::Uid());
+    QCOMPARE(child->lineWidth(), tikz::Value::semiThick());
+}
+
+void StyleTest::testLoadBeforeParent()
+{
+    tikz::core::Document doc;
+    auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    const tikz::core::Uid parentUid(child->uid().id() + 1, &doc);
+
+    // load the child, while its parent does not exist yet
+    QJsonObject json = child->save();
+    QJsonObject data = json["data"].toObject();
+    data["parentStyle"] = parentUid.toString();
+    json["data"] = data;
+    child->load(json);
+    QCOMPARE(child->parentStyle(), parentUid);
+    QCOMPARE(child->penColor(), QColor(Qt::black));
+
+    auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    QCOMPARE(parent->uid(), parentUid);
+    QVERIFY(!parent->hasChildStyles());
+
+    // linking registers the child, so that parent changes propagate
+    child->linkParentStyle();
+    QCOMPARE(parent->childStyles(), QVector<tikz::core::Uid>() << child->uid());
+    parent->setPenColor(Qt::green);
+    QCOMPARE(child->penColor(), QColor(Qt::green));
+
+    // linking twice does not register the child twice
+    child->linkParentStyle();
+    QCOMPARE(parent->childStyles().size(), 1);
+}
+
+void StyleTest::testDerivedProperties()
+{
+    tikz::core::Document doc;
+    auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    child->setParentStyle(parent->uid());
+
+    // the inner line width is only inherited from double lined parents
+    parent->setInnerLineWidth(tikz::Value::thick());
+    QCOMPARE(child->innerLineWidth(), tikz::Value::semiThick());
+    parent->setDoubleLine(true);
+    QCOMPARE(child->innerLineWidth(), tikz::Value::thick());
+
+    // pen width and outer sep follow line width changes in the parent
+    parent->setLineWidth(tikz::Value::thin());
+    QCOMPARE(child->penWidth(), 2.0 * tikz::Value::thin() + tikz::Value::thick());
+    QCOMPARE(child->outerSep(), 0.5 * child->penWidth());
+
+    child->setOuterSep(tikz::Value(1.0));
+    QCOMPARE(child->outerSep(), tikz::Value(1.0));
+}
+
+void StyleTest::testPropertyNames()
+{
+    using Property = tikz::core::Style::Property;
+
+    for (int i = 0; i < static_cast<int>(Property::Count); ++i) {
+        const auto property = static_cast<Property>(i);
+        const QString name = tikz::core::Style::propertyName(property);
+        QCOMPARE(tikz::core::Style::propertyFromName(name), property);
+
+        // each name must be a Q_PROPERTY of Style
+        QVERIFY(tikz::core::Style::staticMetaObject.indexOfProperty(name.toLatin1()) >= 0);
+    }
+
+    QCOMPARE(tikz::core::Style::propertyFromName("noProperty"), Property::Count);
+
+    tikz::core::Document doc;
+    auto style = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    style->setFillColor(Qt::red);
+    QVERIFY(style->propertySet(Property::FillColor));
+    QVERIFY(style->propertySet("fillColor"));
+    QVERIFY(!style->propertySet(Property::PenColor));
+    QVERIFY(!style->propertySet("noProperty"));
+
+    style->removeProperty("fillColor");
+    QVERIFY(!style->fillColorSet());
+}
+
+void StyleTest::testSharedProperties()
+{
+    tikz::core::Document doc;
+    auto a = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto b = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+
+    // default styles share their properties
+    QVERIFY(a->hasSameProperties(b));
+
+    // writing diverges
+    a->setPenColor(Qt::red);
+    QVERIFY(!a->hasSameProperties(b));
+    QCOMPARE(b->penColor(), QColor(Qt::black));
+
+    // identical changes share again
+    b->setPenColor(Qt::red);
+    QVERIFY(a->hasSameProperties(b));
+    QCOMPARE(a->propertiesKey(), b->propertiesKey());
+
+    // the parent style is not part of the properties
+    auto c = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    c->setParentStyle(a->uid());
+    c->setStyle(b);
+    QVERIFY(c->hasSameProperties(b));
+    QCOMPARE(c->parentStyle(), a->uid());
+
+    // unset properties are shared with the defaults again
+    a->unsetPenColor();
+    auto d = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    QVERIFY(a->hasSameProperties(d));
+    QCOMPARE(c->penColor(), QColor(Qt::red));
+}
+
+void StyleTest::testSharedUnits()
+{
+    tikz::core::Document doc;
+    auto a = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto b = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+
+    // equal lengths in different units are not shared, the unit is saved
+    a->setInnerSep(tikz::Value(10, tikz::Unit::Millimeter));
+    b->setInnerSep(tikz::Value(1, tikz::Unit::Centimeter));
+    QVERIFY(!a->hasSameProperties(b));
+    QCOMPARE(a->innerSep().unit(), tikz::Unit::Millimeter);
+    QCOMPARE(b->innerSep().unit(), tikz::Unit::Centimeter);
+    QCOMPARE(a->save()["data"].toObject()["innerSep"], QJsonValue(tikz::Value(10, tikz::Unit::Millimeter).toJson()));
+    QCOMPARE(b->save()["data"].toObject()["innerSep"], QJsonValue(tikz::Value(1, tikz::Unit::Centimeter).toJson()));
+}
+
+void StyleTest::testSetThenUnset()
+{
+    tikz::core::Document doc;
+    auto a = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto b = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+
+    // properties that are set and unset again are shared with the defaults
+    a->setOuterSep(tikz::Value(2, tikz::Unit::Point));
+    a->setShortenStart(tikz::Value(1, tikz::Unit::Millimeter));
+    a->setShortenEnd(tikz::Value(1, tikz::Unit::Millimeter));
+    a->setPenColor(Qt::red);
+    QVERIFY(!a->hasSameProperties(b));
+
+    a->unsetOuterSep();
+    a->unsetShortenStart();
+    a->unsetShortenEnd();
+    a->unsetPenColor();
+    QVERIFY(a->hasSameProperties(b));
+    QCOMPARE(a->propertiesKey(), b->propertiesKey());
+
+    // also if only the set properties agree
+    a->setLineWidth(tikz::Value(2, tikz::Unit::Point));
+    a->setOuterSep(tikz::Value(4, tikz::Unit::Point));
+    a->unsetOuterSep();
+    b->setLineWidth(tikz::Value(2, tikz::Unit::Point));
+    QVERIFY(a->hasSameProperties(b));
+}
+
+void StyleTest::testBatchedChanges()
+{
+    tikz::core::Document doc;
+    auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto grandChild = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto other = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    child->setParentStyle(parent->uid());
+    grandChild->setParentStyle(child->uid());
+    QCOMPARE(parent->childStyles(), QVector<tikz::core::Uid>() << child->uid());
+
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    auto otherNode = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    node->setStyle(grandChild->uid());
+
+    QSignalSpy childSpy(child, SIGNAL(changed()));
+    QSignalSpy grandChildSpy(grandChild, SIGNAL(changed()));
+    QSignalSpy otherSpy(other, SIGNAL(changed()));
+    QSignalSpy docSpy(&doc, SIGNAL(stylesChanged(QVector<tikz::core::Uid>,QVector<tikz::core::Uid>)));
+    QSignalSpy changedSpy(&doc, SIGNAL(changed()));
+
+    // outside of transactions, inheriting styles are notified immediately
+    parent->setPenColor(Qt::red);
+    QCOMPARE(childSpy.count(), 1);
+    QCOMPARE(grandChildSpy.count(), 1);
+    QCOMPARE(docSpy.count(), 1);
+    QCOMPARE(changedSpy.count(), 1);
+
+    // a style without children changes the document once as well
+    other->setPenColor(Qt::red);
+    QCOMPARE(changedSpy.count(), 2);
+    QCOMPARE(docSpy.count(), 2);
+
+    // within a transaction, inheriting styles are notified once at the end
+    {
+        tikz::core::Transaction transaction(&doc, "Change parent");
+        parent->setPenColor(Qt::green);
+        parent->setLineWidth(tikz::Value::thick());
+        parent->setFillColor(Qt::blue);
+        QCOMPARE(childSpy.count(), 1);
+        QCOMPARE(grandChildSpy.count(), 1);
+        QCOMPARE(docSpy.count(), 2);
+
+        // the resolved values are up-to-date nevertheless
+        QCOMPARE(grandChild->penColor(), QColor(Qt::green));
+    }
+    QCOMPARE(childSpy.count(), 2);
+    QCOMPARE(grandChildSpy.count(), 2);
+    QCOMPARE(otherSpy.count(), 1);
+    QCOMPARE(docSpy.count(), 3);
+    QCOMPARE(changedSpy.count(), 3);
+
+    const auto styles = docSpy.last().first().value<QVector<tikz::core::Uid>>();
+    QCOMPARE(styles.size(), 3);
+    QVERIFY(styles.contains(parent->uid()));
+    QVERIFY(styles.contains(child->uid()));
+    QVERIFY(styles.contains(grandChild->uid()));
+
+    // the nodes using an affected style are reported as well
+    const auto entities = docSpy.last().at(1).value<QVector<tikz::core::Uid>>();
+    QCOMPARE(entities, QVector<tikz::core::Uid>() << node->uid());
+    QVERIFY(!entities.contains(otherNode->uid()));
+}
+
+void StyleTest::testUndoSetProperty()
+{
+    tikz::core::Document doc;
+    auto style = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    style->setLineWidth(tikz::Value(1.0));
+
+    // ids are compact and map back to the name
+    auto & manager = tikz::core::propertyManager();
+    const int id = manager.propertyId("lineWidth");
+    QVERIFY(id >= 0);
+    QCOMPARE(manager.propertyId("lineWidth"), id);
+    QCOMPARE(manager.propertyName(id), QString("lineWidth"));
+
+    // accessors resolve the property of the class
+    const auto accessor = manager.accessor(style->metaObject(), id);
+    QVERIFY(accessor.isValid());
+    QCOMPARE(accessor.read(style).value<tikz::Value>(), tikz::Value(1.0));
+    QVERIFY(accessor.isModified(style));
+    QVERIFY(!manager.accessor(style->metaObject(), manager.propertyId("noSuchProperty")).isValid());
+
+    // undo and redo through the accessor table
+    doc.addUndoItem(new tikz::core::UndoSetProperty(style->uid(), "lineWidth", tikz::Value(3.0)));
+    QCOMPARE(style->lineWidth(), tikz::Value(3.0));
+    doc.undo();
+    QCOMPARE(style->lineWidth(), tikz::Value(1.0));
+    doc.redo();
+    QCOMPARE(style->lineWidth(), tikz::Value(3.0));
+
+    // the id constructor is equivalent
+    doc.addUndoItem(new tikz::core::UndoSetProperty(style->uid(), id, tikz::Value(4.0)));
+    QCOMPARE(style->lineWidth(), tikz::Value(4.0));
+    doc.undo();
+    QCOMPARE(style->lineWidth(), tikz::Value(3.0));
+
+    // undo resets properties that were not set before
+    style->unsetLineWidth();
+    doc.addUndoItem(new tikz::core::UndoSetProperty(style->uid(), id, tikz::Value(5.0)));
+    QVERIFY(style->lineWidthSet());
+    doc.undo();
+    QVERIFY(!style->lineWidthSet());
+}
+
+void StyleTest::testPropertyInfo()
+{
+    auto & manager = tikz::core::propertyManager();
+
+    // the meta information is compiled in from properties.json
+    const auto info = manager.info("lineWidth");
+    QVERIFY(info.isValid());
+    QCOMPARE(info.name(), QLatin1String("lineWidth"));
+    QCOMPARE(info.type(), QLatin1String("value"));
+    QCOMPARE(info.modifiedFunction(), QLatin1String("lineWidthSet"));
+    QCOMPARE(info.resetFunction(), QLatin1String("unsetLineWidth"));
+    QVERIFY(info.isResettable());
+    QCOMPARE(info.minimum().toString(), QString("0pt"));
+    QCOMPARE(info.singleStep(), 0.1);
+
+    // numeric ranges are returned as numbers
+    const auto opacity = manager.info("penOpacity");
+    QVERIFY(opacity.isValid());
+    QCOMPARE(opacity.maximum().toDouble(), 1.0);
+
+    // ids of known properties map back to the same meta information
+    QCOMPARE(manager.info(manager.propertyId("lineWidth")).name(), info.name());
+
+    // unknown properties get an id, but no meta information
+    QVERIFY(!manager.info("noSuchProperty").isValid());
+    const int id = manager.propertyId("noSuchProperty");
+    QVERIFY(!manager.info(id).isValid());
+    QCOMPARE(manager.propertyName(id), QString("noSuchProperty"));
+}
+
+void StyleTest::benchmarkGetters()
+{
+    tikz::core::Document doc;
+    auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    child->setParentStyle(parent->uid());
+    parent->setLineWidth(tikz::Value::thick());
+    child->setPenColor(Qt::red);
+
+    qreal sum = 0.0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            sum += child->lineWidth().value();
+            sum += child->innerSep().value();
+            sum += child->outerSep().value();
+            sum += child->penOpacity();
+            sum += child->penColor().redF();
+        }
+    }
+    QVERIFY(sum > 0.0);
+}
+
+void StyleTest::benchmarkPropertySet()
+{
+    tikz::core::Document doc;
+    auto style = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    style->setPenColor(Qt::red);
+    style->setInnerSep(tikz::Value(2.0));
+
+    int count = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            count += style->penColorSet();
+            count += style->fillColorSet();
+            count += style->innerSepSet();
+            count += style->lineWidthSet();
+        }
+    }
+    QVERIFY(count > 0);
+}
+
+void StyleTest::benchmarkSetters()
+{
+    tikz::core::Document doc;
+    auto style = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            style->setLineWidth(tikz::Value(i));
+            style->setPenOpacity(0.5);
+            style->unsetPenOpacity();
+        }
+    }
+    QVERIFY(style->lineWidthSet());
+}
+
+void StyleTest::benchmarkUndoSetProperty()
+{
+    tikz::core::Document doc;
+    auto style = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    const int id = tikz::core::propertyManager().propertyId("lineWidth");
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            tikz::core::UndoSetProperty item(style->uid(), id, tikz::Value(i));
+            item.redo();
+            item.undo();
+        }
+    }
+}
+
+// kate: indent-width 4; replace-tabs on;
@@ -0,0 +1,133 @@
+/* This file is part of the TikZKit project.
+ *
+ * Copyright (C) 2015 Dominik Haumann <dhaumann@kde.org>
+ *
+ * This library is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Library General Public License as published
+ * by the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include "TestUid.h"
+
+#include <QtTest/QTest>
+#include <QHash>
+#include <QVector>
+
+#include <tikz/core/Document.h>
+#include <tikz/core/Node.h>
+#include <tikz/core/Uid.h>
+
+QTEST_MAIN(UidTest)
+
+// number of nodes used in the benchmarks
+static constexpr int s_nodeCount = 10000;
+
+void UidTest::initTestCase()
+{
+}
+
+void UidTest::cleanupTestCase()
+{
+}
+
+void UidTest::testResolve()
+{
+    tikz::core::Document doc;
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+
+    // Uids handed out by the document are bound to a generation
+    QVERIFY(node->uid().generation() != 0);
+    QCOMPARE(node->uid().entity<tikz::core::Node>(), node);
+
+    // unbound Uids resolve to the entity currently stored in the slot
+    const tikz::core::Uid unbound(node->uid().id(), &doc);
+    QCOMPARE(unbound.generation(), 0u);
+    QCOMPARE(unbound.entity<tikz::core::Node>(), node);
+    QVERIFY(unbound == node->uid());
+
+    // the document and its style are always resolvable
+    QCOMPARE(tikz::core::Uid(0, &doc).entity(), &doc);
+    QCOMPARE(tikz::core::Uid(1, &doc).entity(), doc.style());
+
+    // invalid ids resolve to null
+    QVERIFY(tikz::core::Uid(-1, &doc).entity() == nullptr);
+    QVERIFY(tikz::core::Uid(1000, &doc).entity() == nullptr);
+
+    // deleted entities resolve to null, undo brings them back
+    const tikz::core::Uid uid = node->uid();
+    doc.deleteEntity(node);
+    QVERIFY(uid.entity() == nullptr);
+
+    doc.undo();
+    QVERIFY(uid.entity() != nullptr);
+    QCOMPARE(uid.entity()->uid().generation(), uid.generation());
+}
+
+void UidTest::testStaleUid()
+{
+    tikz::core::Document doc;
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    const tikz::core::Uid oldUid = node->uid();
+
+    // closing the document invalidates all Uids bound to the old generation
+    doc.close();
+    QVERIFY(oldUid.entity() == nullptr);
+
+    // a new entity reuses the id, but not the generation
+    auto newNode = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    QCOMPARE(newNode->uid().id(), oldUid.id());
+    QVERIFY(newNode->uid().generation() != oldUid.generation());
+    QVERIFY(oldUid.entity() == nullptr);
+    QCOMPARE(newNode->uid().entity<tikz::core::Node>(), newNode);
+}
+
+void UidTest::benchmarkResolve()
+{
+    tikz::core::Document doc;
+    QVector<tikz::core::Uid> uids;
+    uids.reserve(s_nodeCount);
+    for (int i = 0; i < s_nodeCount; ++i) {
+        uids.append(doc.createEntity(tikz::EntityType::Node)->uid());
+    }
+
+    int resolved = 0;
+    QBENCHMARK {
+        for (const auto & uid : uids) {
+            resolved += (uid.entity() != nullptr);
+        }
+    }
+    QVERIFY(resolved > 0);
+}
+
+void UidTest::benchmarkHashLookup()
+{
+    // reference: resolving through a QHash, as done before the handle table
+    tikz::core::Document doc;
+    QVector<tikz::core::Uid> uids;
+    QHash<tikz::core::Uid, tikz::core::Entity *> map;
+    uids.reserve(s_nodeCount);
+    for (int i = 0; i < s_nodeCount; ++i) {
+        auto entity = doc.createEntity(tikz::EntityType::Node);
+        uids.append(entity->uid());
+        map.insert(entity->uid(), entity);
+    }
+
+    int resolved = 0;
+    QBENCHMARK {
+        for (const auto & uid : uids) {
+            resolved += (map.value(uid) != nullptr);
+        }
+    }
+    QVERIFY(resolved > 0);
+}
+
+// kate: indent-width 4; replace-tabs on;
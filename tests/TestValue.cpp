@@ -19,11 +19,62 @@
 #include "TestValue.h"
 
 #include <QtTest/QTest>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QLocale>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 
 #include <tikz/core/Value.h>
 
 QTEST_MAIN(ValueTest)
 
+// number of values converted in the benchmarks
+static constexpr int s_benchmarkCount = 1000000;
+
+// the units in the order of the enum
+static const tikz::Unit s_units[] = {
+    tikz::Unit::Point, tikz::Unit::Millimeter, tikz::Unit::Centimeter, tikz::Unit::Inch
+};
+
+// the former regular expression based parser, as reference for the benchmark
+static tikz::Value regexFromString(const QString & str)
+{
+    if (str == QLatin1String("nan")) {
+        return tikz::Value::invalid();
+    }
+
+    static QRegularExpression re("([-+]?\\d*\\.?\\d*)\\s*(\\w*)");
+    const QRegularExpressionMatch match = re.match(str);
+    const QString suffix = match.captured(2);
+
+    tikz::Unit unit = tikz::Unit::Point;
+    if (suffix == "mm") {
+        unit = tikz::Unit::Millimeter;
+    } else if (suffix == "cm") {
+        unit = tikz::Unit::Centimeter;
+    } else if (suffix == "in") {
+        unit = tikz::Unit::Inch;
+    }
+
+    return tikz::Value(match.captured(1).toDouble(), unit);
+}
+
+// random doubles with a magnitude between 1e-6 and 1e6
+static QVector<double> randomNumbers(int count)
+{
+    QRandomGenerator generator(42);
+    QVector<double> numbers(count);
+    for (auto & number : numbers) {
+        number = (generator.generateDouble() - 0.5) * std::pow(10.0, generator.bounded(-6, 7));
+    }
+    return numbers;
+}
+
 void ValueTest::initTestCase()
 {
 }
@@ -153,6 +204,86 @@ void ValueTest::testStringAccuracy()
     }
 }
 
+void ValueTest::testStringRoundTrip()
+{
+    // all numbers with up to three decimals are written in their
+    // shortest form, and parsed back to exactly the same number
+    for (int i = -1000000; i <= 1000000; ++i) {
+        const double number = i / 1000.0;
+        const tikz::Unit unit = s_units[i & 3];
+        const QString str = tikz::Value(number, unit).toString();
+        const tikz::Value value = tikz::Value::fromString(str);
+        if (value.value() != number || value.unit() != unit) {
+            QFAIL(qPrintable(str));
+        }
+
+        const QString expected = (i == 0 ? QString("0")
+            : QLocale::c().toString(number, 'f', QLocale::FloatingPointShortest))
+            + str.right(2);
+        if (str != expected) {
+            QCOMPARE(str, expected);
+        }
+    }
+
+    // arbitrary doubles are written with 15 significant digits, so that
+    // the string form is stable under parsing and writing again
+    QRandomGenerator generator(42);
+    int tested = 0;
+    while (tested < 1000000) {
+        const quint64 bits = generator.generate64();
+        double number;
+        std::memcpy(&number, &bits, sizeof(number));
+        if (!std::isfinite(number) || std::abs(number) < DBL_MIN) {
+            continue;
+        }
+        ++tested;
+
+        const QString str = tikz::Value(number).toString();
+        QVERIFY(!str.contains(QLatin1Char('e')));
+        const tikz::Value value = tikz::Value::fromString(str);
+        if (std::abs(value.value() - number) > 1e-14 * std::abs(number)
+            || value.toString() != str)
+        {
+            QFAIL(qPrintable(str));
+        }
+    }
+
+    // rounding noise of calculations is not written
+    QCOMPARE(tikz::Value(0.1 + 0.2).toString(), QString("0.3pt"));
+    QCOMPARE(tikz::Value(2.9999999999999996).toString(), QString("3pt"));
+    QCOMPARE(tikz::Value(-0.0).toString(), QString("0pt"));
+    QCOMPARE(tikz::Value(1e-10, tikz::Unit::Inch).toString(), QString("0.0000000001in"));
+}
+
+void ValueTest::testStringGrammar()
+{
+    QCOMPARE(tikz::Value::fromString("+3pt"), 3.0_pt);
+    QCOMPARE(tikz::Value::fromString(".5cm"), 0.5_cm);
+    QCOMPARE(tikz::Value::fromString("5.in"), 5.0_in);
+    QCOMPARE(tikz::Value::fromString("1e2mm"), 100.0_mm);
+    QCOMPARE(tikz::Value::fromString("-2.5E-1 cm"), tikz::Value(-0.25, tikz::Unit::Centimeter));
+    QCOMPARE(tikz::Value::fromString("  7"), 7.0_pt);
+    QCOMPARE(tikz::Value::fromString("-0pt").toString(), QString("0pt"));
+    QCOMPARE(tikz::Value::fromString("nan"), tikz::Value::invalid());
+}
+
+void ValueTest::testJson()
+{
+    // numbers are stored as raw doubles, and therefore round-trip exactly
+    const tikz::Value third(1.0 / 3.0, tikz::Unit::Centimeter);
+    QCOMPARE(third.toJson(), QJsonValue(QJsonArray { 1.0 / 3.0, "cm" }));
+    const tikz::Value value = tikz::Value::fromJson(third.toJson());
+    QCOMPARE(value.value(), third.value());
+    QCOMPARE(value.unit(), tikz::Unit::Centimeter);
+
+    // the string form is still supported
+    QCOMPARE(tikz::Value::fromJson(QJsonValue("2.5mm")), 2.5_mm);
+
+    // invalid values
+    QCOMPARE(tikz::Value::invalid().toJson(), QJsonValue("nan"));
+    QVERIFY(!tikz::Value::fromJson(QJsonValue("nan")).isValid());
+}
+
 void ValueTest::testLiteralOperators()
 {
     QCOMPARE(1.01_pt, tikz::Value(1.01, tikz::Unit::Point));
@@ -161,4 +292,72 @@ void ValueTest::testLiteralOperators()
     QCOMPARE(8.99_in, tikz::Value(8.99, tikz::Unit::Inch));
 }
 
+void ValueTest::benchmarkFromString_data()
+{
+    QTest::addColumn<bool>("regex");
+
+    QTest::newRow("regex") << true;
+    QTest::newRow("from_chars") << false;
+}
+
+void ValueTest::benchmarkFromString()
+{
+    QFETCH(bool, regex);
+
+    const QVector<double> numbers = randomNumbers(s_benchmarkCount);
+    QStringList strings;
+    strings.reserve(numbers.size());
+    for (int i = 0; i < numbers.size(); ++i) {
+        strings.append(tikz::Value(numbers[i], s_units[i & 3]).toString());
+    }
+
+    double sum = 0;
+    QBENCHMARK {
+        if (regex) {
+            for (const auto & str : qAsConst(strings)) {
+                sum += regexFromString(str).value();
+            }
+        } else {
+            for (const auto & str : qAsConst(strings)) {
+                sum += tikz::Value::fromString(str).value();
+            }
+        }
+    }
+    QVERIFY(std::isfinite(sum));
+}
+
+void ValueTest::benchmarkToString_data()
+{
+    QTest::addColumn<bool>("locale");
+
+    QTest::newRow("QLocale") << true;
+    QTest::newRow("to_chars") << false;
+}
+
+void ValueTest::benchmarkToString()
+{
+    QFETCH(bool, locale);
+
+    const QVector<double> numbers = randomNumbers(s_benchmarkCount);
+
+    // the former conversion formatted 20 decimals with QLocale, and then
+    // removed the rounding noise
+    QLocale c = QLocale::c();
+    c.setNumberOptions(QLocale::OmitGroupSeparator);
+
+    int length = 0;
+    QBENCHMARK {
+        if (locale) {
+            for (double number : numbers) {
+                length += (c.toString(number, 'f', 20) + QLatin1String("pt")).size();
+            }
+        } else {
+            for (double number : numbers) {
+                length += tikz::Value(number).toString().size();
+            }
+        }
+    }
+    QVERIFY(length > 0);
+}
+
 // kate: indent-width 4; replace-tabs on;
@@ -35,7 +35,14 @@ private Q_SLOTS:
     void testPoint();
     void testFromString();
     void testStringAccuracy();
+    void testStringRoundTrip();
+    void testStringGrammar();
+    void testJson();
     void testLiteralOperators();
+    void benchmarkFromString_data();
+    void benchmarkFromString();
+    void benchmarkToString_data();
+    void benchmarkToString();
 };
 
 #endif // TEST_VALUE_H
@@ -1,17 +1,81 @@
 #include "documenttest.h"
 
 #include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
 #include <QDebug>
 #include <QUndoStack>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFont>
+#include <QUrl>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include <tikz/core/Document.h>
 #include <tikz/core/Node.h>
 #include <tikz/core/Path.h>
+#include <tikz/core/EdgePath.h>
+#include <tikz/core/Style.h>
+#include <tikz/core/Transaction.h>
+#include <tikz/core/PropertyManager.h>
+#include <tikz/core/UndoSetProperty.h>
 
 QTEST_MAIN(DocumentTest)
 
+// number of nodes created in the benchmarks
+static constexpr int s_nodeCount = 10000;
+
+// returns the value of @p key in /proc/self/status in KiB, or -1
+static long memoryStatus(const QByteArray & key)
+{
+    QFile file(QStringLiteral("/proc/self/status"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+
+    // e.g. "VmHWM:     1234 kB"
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith(key)) {
+            return line.mid(key.size()).simplified().split(' ').value(0).toLong();
+        }
+    }
+    return -1;
+}
+
+// resets the peak resident set size of this process to the current
+// resident set size, and returns it in KiB, or -1 if not supported
+static long resetPeakMemoryUsage()
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::open("/proc/self/clear_refs", O_WRONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    const bool reset = ::write(fd, "5", 1) == 1;
+    ::close(fd);
+    return reset ? memoryStatus("VmRSS:") : -1;
+#else
+    return -1;
+#endif
+}
+
+// returns the peak resident set size of this process in KiB, or -1
+static long peakMemoryUsage()
+{
+    return memoryStatus("VmHWM:");
+}
+
 void DocumentTest::initTestCase()
 {
+    qRegisterMetaType<tikz::core::ChangeSet>();
 }
 
 void DocumentTest::cleanupTestCase()
@@ -59,4 +123,995 @@ void DocumentTest::documentTest()
 #endif
 }
 
+void DocumentTest::entityRangeTest()
+{
+    tikz::core::Document doc;
+    QVERIFY(doc.nodeRange().isEmpty());
+    QVERIFY(doc.pathRange().isEmpty());
+    QVERIFY(doc.styleRange().isEmpty());
+
+    // createNode() and createPath() each create an additional style
+    auto n1 = doc.createNode();
+    auto n2 = doc.createNode();
+    auto n3 = doc.createNode();
+    auto p1 = doc.createPath();
+
+    QCOMPARE(doc.nodeRange().size(), 3);
+    QCOMPARE(doc.pathRange().size(), 1);
+    QCOMPARE(doc.styleRange().size(), 4);
+
+    // iteration order is the creation order
+    QVector<tikz::core::Node *> nodes;
+    for (auto node : doc.nodeRange()) {
+        nodes.append(node);
+    }
+    QCOMPARE(nodes, (QVector<tikz::core::Node *>{n1, n2, n3}));
+    QCOMPARE(doc.nodes(), (QVector<tikz::core::Uid>{n1->uid(), n2->uid(), n3->uid()}));
+
+    for (auto path : doc.pathRange()) {
+        QCOMPARE(path, p1);
+    }
+
+    // deleting keeps the order of the remaining entities
+    doc.deleteEntity(n2);
+    nodes.clear();
+    for (auto node : doc.nodeRange()) {
+        nodes.append(node);
+    }
+    QCOMPARE(nodes, (QVector<tikz::core::Node *>{n1, n3}));
+    QCOMPARE(doc.nodeRange().size(), 2);
+
+    // undo brings the node back
+    doc.undo();
+    QCOMPARE(doc.nodeRange().size(), 3);
+}
+
+void DocumentTest::changeSetTest()
+{
+    tikz::core::Document doc;
+    QSignalSpy spy(&doc, SIGNAL(changesCommitted(tikz::core::ChangeSet)));
+
+    // creating a node is one transaction
+    auto node = doc.createNode();
+    QCOMPARE(spy.count(), 1);
+    auto changes = spy.last().first().value<tikz::core::ChangeSet>();
+    QVERIFY(changes.created().contains(node->uid()));
+    QVERIFY(changes.created().contains(node->styleUid()));
+    QVERIFY(changes.propertyChanged(node->uid(), "style"));
+
+    // several changes within a transaction are passed on once
+    {
+        tikz::core::Transaction transaction(&doc, "Change node");
+        node->setPos(tikz::Pos(1, 1));
+        node->setText("a");
+        node->style()->setPenColor(Qt::red);
+        node->style()->setLineWidth(tikz::Value::thick());
+        QCOMPARE(spy.count(), 1);
+    }
+    QCOMPARE(spy.count(), 2);
+    changes = spy.last().first().value<tikz::core::ChangeSet>();
+    QVERIFY(changes.propertyChanged(node->uid(), "pos"));
+    QVERIFY(changes.propertyChanged(node->uid(), "text"));
+    QVERIFY(changes.propertyChanged(node->styleUid(), "penColor"));
+    QVERIFY(changes.propertyChanged(node->styleUid(), "lineWidth"));
+    QVERIFY(!changes.propertyChanged(node->styleUid(), "fillColor"));
+    QVERIFY(changes.created().isEmpty());
+
+    // the properties are listed by their property id
+    const int posId = tikz::core::propertyManager().propertyId("pos");
+    QVERIFY(changes.properties(node->uid()).contains(posId));
+    QVERIFY(changes.propertyChanged(node->uid(), posId));
+
+    // styles inheriting a change are contained without properties
+    doc.style()->setFillColor(Qt::blue);
+    changes = spy.last().first().value<tikz::core::ChangeSet>();
+    QVERIFY(changes.propertyChanged(doc.style()->uid(), "fillColor"));
+    QVERIFY(changes.contains(node->styleUid()));
+    QVERIFY(changes.properties(node->styleUid()).isEmpty());
+
+    // deleting
+    const tikz::core::Uid nodeUid = node->uid();
+    doc.deleteEntity(node);
+    changes = spy.last().first().value<tikz::core::ChangeSet>();
+    QCOMPARE(changes.deleted(), QVector<tikz::core::Uid>() << nodeUid);
+}
+
+void DocumentTest::createEntitiesTest()
+{
+    tikz::core::Document doc;
+    QSignalSpy spy(&doc, SIGNAL(changesCommitted(tikz::core::ChangeSet)));
+
+    QVariantMap properties;
+    properties["text"] = QString("x");
+    properties["pos"] = QVariant::fromValue(tikz::Pos(1, 2));
+
+    const auto entities = doc.createEntities(tikz::EntityType::Node, 3, properties);
+    QCOMPARE(entities.size(), 3);
+    QCOMPARE(doc.nodeRange().size(), 3);
+
+    // all nodes are created with the initial properties
+    for (int i = 0; i < entities.size(); ++i) {
+        auto node = qobject_cast<tikz::core::Node *>(entities[i]);
+        QVERIFY(node);
+        QCOMPARE(node->text(), QString("x"));
+        QCOMPARE(node->pos(), tikz::Pos(1, 2));
+        if (i > 0) {
+            QCOMPARE(node->uid().id(), entities[i - 1]->uid().id() + 1);
+        }
+    }
+
+    // one change notification
+    QCOMPARE(spy.count(), 1);
+    const auto changes = spy.last().first().value<tikz::core::ChangeSet>();
+    QCOMPARE(changes.created().size(), 3);
+
+    // the entities are deleted by undo, so keep their uids
+    QVector<tikz::core::Uid> uids;
+    for (auto entity : entities) {
+        uids.append(entity->uid());
+    }
+
+    // one undo item removes all nodes
+    doc.undo();
+    QCOMPARE(doc.nodeRange().size(), 0);
+    QVERIFY(!doc.undoAvailable());
+    for (const auto & uid : qAsConst(uids)) {
+        QVERIFY(!doc.entity(uid));
+    }
+
+    // redo creates the nodes with the same uids
+    doc.redo();
+    QCOMPARE(doc.nodeRange().size(), 3);
+    for (const auto & uid : qAsConst(uids)) {
+        QVERIFY(doc.entity(uid));
+    }
+}
+
+void DocumentTest::historyMemoryBudgetTest()
+{
+    tikz::core::Document doc;
+    doc.setHistoryMemoryBudget(1024);
+    QCOMPARE(doc.historyMemoryBudget(), qint64(1024));
+
+    // one group per move, one group to delete another node
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    auto other = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    other->setPos(tikz::Pos(-1, -1));
+    const tikz::core::Uid otherUid = other->uid();
+    doc.deleteEntity(other);
+
+    const int moves = 200;
+    for (int i = 1; i <= moves; ++i) {
+        node->setPos(tikz::Pos(i, 2 * i));
+    }
+
+    // old groups were spilled to disk
+    QVERIFY(doc.historyMemoryUsage() > 0);
+    QVERIFY(doc.historyMemoryUsage() <= doc.historyMemoryBudget());
+
+    // undo transparently loads the spilled groups again
+    for (int i = moves - 1; i >= 0; --i) {
+        doc.undo();
+        QCOMPARE(node->pos(), tikz::Pos(i, 2 * i));
+    }
+
+    // undo the deletion of the other node
+    doc.undo();
+    auto restored = otherUid.entity<tikz::core::Node>();
+    QVERIFY(restored);
+    QCOMPARE(restored->pos(), tikz::Pos(-1, -1));
+
+    // redo everything
+    while (doc.redoAvailable()) {
+        doc.redo();
+    }
+    QVERIFY(!otherUid.entity());
+    QCOMPARE(node->pos(), tikz::Pos(moves, 2 * moves));
+    QVERIFY(doc.historyMemoryUsage() <= doc.historyMemoryBudget());
+
+    // without budget, everything is kept in memory
+    doc.setHistoryMemoryBudget(0);
+    while (doc.undoAvailable()) {
+        doc.undo();
+    }
+    QCOMPARE(doc.nodeRange().size(), 0);
+    QVERIFY(doc.historyMemoryUsage() > 1024);
+}
+
+void DocumentTest::spilledEnumTest()
+{
+    tikz::core::Document doc;
+    doc.setHistoryMemoryBudget(1024);
+
+    // enums have no stream operators, yet survive spilling
+    auto style = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+    doc.addUndoItem(new tikz::core::UndoSetProperty(style->uid(), "shape", QVariant::fromValue(tikz::Shape::ShapeCircle)));
+    doc.addUndoItem(new tikz::core::UndoSetProperty(style->uid(), "penStyle", QVariant::fromValue(tikz::PenStyle::DashedLine)));
+    doc.addUndoItem(new tikz::core::UndoSetProperty(style->uid(), "penStyle", QVariant::fromValue(tikz::PenStyle::DottedLine)));
+
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    const int moves = 100;
+    for (int i = 1; i <= moves; ++i) {
+        node->setPos(tikz::Pos(i, i));
+    }
+    QVERIFY(doc.historyMemoryUsage() <= doc.historyMemoryBudget());
+
+    for (int i = 0; i <= moves; ++i) {
+        doc.undo();
+    }
+    QCOMPARE(style->penStyle(), tikz::PenStyle::DottedLine);
+    doc.undo();
+    QCOMPARE(style->penStyle(), tikz::PenStyle::DashedLine);
+    doc.undo();
+    QVERIFY(!style->penStyleSet());
+    QCOMPARE(style->shape(), tikz::Shape::ShapeCircle);
+    doc.undo();
+    QVERIFY(!style->shapeSet());
+
+    doc.redo();
+    doc.redo();
+    QCOMPARE(style->shape(), tikz::Shape::ShapeCircle);
+    QCOMPARE(style->penStyle(), tikz::PenStyle::DashedLine);
+}
+
+void DocumentTest::checkpointLoadTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("checkpoint.tikzkit"));
+
+    // a history with moves and a deleted node
+    qint64 nodeId;
+    qint64 otherId;
+    {
+        tikz::core::Document doc;
+        auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        auto other = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        other->setPos(tikz::Pos(-1, -1));
+        nodeId = node->uid().id();
+        otherId = other->uid().id();
+        doc.deleteEntity(other);
+        for (int i = 1; i <= 10; ++i) {
+            node->setPos(tikz::Pos(i, 2 * i));
+        }
+        QVERIFY(doc.saveAs(url));
+    }
+
+    // the state is restored from the checkpoint, the history is not loaded
+    tikz::core::Document doc;
+    QVERIFY(doc.load(url));
+    QCOMPARE(doc.nodeRange().size(), 1);
+    auto node = tikz::core::Uid(nodeId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(10, 20));
+    QVERIFY(!doc.isModified());
+    QVERIFY(doc.undoAvailable());
+    QCOMPARE(doc.historyMemoryUsage(), qint64(0));
+
+    // undo past the checkpoint
+    for (int i = 9; i >= 0; --i) {
+        doc.undo();
+        QCOMPARE(node->pos(), tikz::Pos(i, 2 * i));
+    }
+    QVERIFY(doc.historyMemoryUsage() > 0);
+
+    doc.undo();
+    auto other = tikz::core::Uid(otherId, &doc).entity<tikz::core::Node>();
+    QVERIFY(other);
+    QCOMPARE(other->pos(), tikz::Pos(-1, -1));
+
+    while (doc.undoAvailable()) {
+        doc.undo();
+    }
+    QCOMPARE(doc.nodeRange().size(), 0);
+
+    // new entities do not reuse ids of the history
+    while (doc.redoAvailable()) {
+        doc.redo();
+    }
+    auto newNode = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    QVERIFY(newNode->uid().id() > otherId);
+}
+
+void DocumentTest::propertyOrderTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("properties.tikzkit"));
+
+    // "parentStyle" is not described in properties.json, its id is
+    // assigned on the fly
+    qint64 parentId;
+    qint64 childId;
+    {
+        tikz::core::Document doc;
+        auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+        auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+        parentId = parent->uid().id();
+        childId = child->uid().id();
+        doc.addUndoItem(new tikz::core::UndoSetProperty(child->uid(), "parentStyle", QVariant::fromValue(parent->uid())));
+        QVERIFY(doc.saveAs(url));
+    }
+
+    // a new application run registers the properties in another order
+    auto & manager = tikz::core::propertyManager();
+    manager.clearRegisteredProperties();
+    manager.propertyId("someProperty");
+    manager.propertyId("anotherProperty");
+
+    // the history is restored by property name
+    tikz::core::Document doc;
+    QVERIFY(doc.load(url));
+    auto child = tikz::core::Uid(childId, &doc).entity<tikz::core::Style>();
+    QVERIFY(child);
+    QCOMPARE(child->parentStyle().id(), parentId);
+
+    doc.undo();
+    QVERIFY(!child->parentStyle().isValid());
+    doc.redo();
+    QCOMPARE(child->parentStyle().id(), parentId);
+}
+
+void DocumentTest::compactReplayTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("replay.tikzkit");
+
+    qint64 nodeId;
+    {
+        tikz::core::Document doc;
+        auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        nodeId = node->uid().id();
+        node->setPos(tikz::Pos(1, 1));
+        node->setPos(tikz::Pos(2, 3));
+        QVERIFY(doc.saveAs(QUrl::fromLocalFile(filename)));
+    }
+
+    // without checkpoint, the compact history is replayed from the start
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+    QVERIFY(root.contains("checkpoints"));
+    root.remove("checkpoints");
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    tikz::core::Document doc;
+    QVERIFY(doc.load(QUrl::fromLocalFile(filename)));
+    auto node = tikz::core::Uid(nodeId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(2, 3));
+    doc.undo();
+    QCOMPARE(node->pos(), tikz::Pos(1, 1));
+
+    // a corrupt entry fails the load
+    QJsonArray history = root["history"].toArray();
+    QJsonObject entry = history.last().toObject();
+    entry["data"] = QString::fromLatin1(QByteArray("corrupt").toBase64());
+    history[history.size() - 1] = entry;
+    root["history"] = history;
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    tikz::core::Document corrupt;
+    QVERIFY(!corrupt.load(QUrl::fromLocalFile(filename)));
+    QCOMPARE(corrupt.nodeRange().size(), 0);
+}
+
+void DocumentTest::incompleteHistoryTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("incomplete.tikzkit");
+
+    qint64 nodeId;
+    {
+        tikz::core::Document doc;
+        auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        nodeId = node->uid().id();
+        node->setPos(tikz::Pos(1, 1));
+        node->setPos(tikz::Pos(2, 2));
+        node->setPos(tikz::Pos(3, 3));
+        QVERIFY(doc.saveAs(QUrl::fromLocalFile(filename)));
+    }
+
+    // a history entry before the checkpoint cannot be attached
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+    QJsonArray history = root["history"].toArray();
+    QCOMPARE(history.size(), 4);
+    QJsonObject entry = history[1].toObject();
+    entry.remove("data");
+    history[1] = entry;
+    root["history"] = history;
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    // the state is loaded, but no later entry is attached on top of the gap
+    tikz::core::Document doc;
+    QVERIFY(doc.load(QUrl::fromLocalFile(filename)));
+    auto node = tikz::core::Uid(nodeId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(3, 3));
+    QVERIFY(!doc.undoAvailable());
+}
+
+void DocumentTest::loadEntitiesTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("entities.tikzkit"));
+
+    // enough entities that the records are parsed in parallel
+    const int count = 5000;
+    {
+        tikz::core::Document doc;
+        const auto nodes = doc.createEntities(tikz::EntityType::Node, count);
+        const auto paths = doc.createEntities(tikz::EntityType::Path, count);
+        tikz::core::Transaction transaction(&doc, "Move");
+        for (int i = 0; i < count; ++i) {
+            static_cast<tikz::core::Node *>(nodes[i])->setPos(tikz::Pos(i, -i));
+            static_cast<tikz::core::EdgePath *>(paths[i])->setStartPos(tikz::Pos(-i, i));
+        }
+        transaction.finish();
+        QVERIFY(doc.saveAs(url));
+    }
+
+    tikz::core::Document doc;
+    QVERIFY(doc.load(url));
+    QCOMPARE(doc.nodeRange().size(), count);
+    QCOMPARE(doc.pathRange().size(), count);
+
+    // the entities are created in the order of the file
+    int i = 0;
+    for (auto node : doc.nodeRange()) {
+        QCOMPARE(node->pos(), tikz::Pos(i, -i));
+        ++i;
+    }
+    i = 0;
+    for (auto path : doc.pathRange()) {
+        QCOMPARE(path->type(), tikz::PathType::Line);
+        QCOMPARE(static_cast<tikz::core::EdgePath *>(path)->startPos(), tikz::Pos(-i, i));
+        ++i;
+    }
+}
+
+void DocumentTest::invalidIdTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("ids.tikzkit");
+
+    qint64 nodeId;
+    {
+        tikz::core::Document doc;
+        auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        nodeId = node->uid().id();
+        node->setPos(tikz::Pos(1, 1));
+        QVERIFY(doc.saveAs(QUrl::fromLocalFile(filename)));
+    }
+
+    // add copies of the node with ids that exceed int, or are very sparse
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+    QJsonArray checkpoints = root["checkpoints"].toArray();
+    QCOMPARE(checkpoints.size(), 1);
+    QJsonObject checkpoint = checkpoints[0].toObject();
+    QJsonObject state = checkpoint["state"].toObject();
+    QJsonObject nodes = state["nodes"].toObject();
+    const QJsonValue record = nodes["node-" + QString::number(nodeId)];
+    QVERIFY(record.isObject());
+    nodes["node-5000000000"] = record;
+    nodes["node-1000000000"] = record;
+    state["nodes"] = nodes;
+    state["node-ids"] = state["node-ids"].toString() + ",5000000000,1000000000";
+    checkpoint["state"] = state;
+    checkpoints[0] = checkpoint;
+    root["checkpoints"] = checkpoints;
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+
+    // the invalid records are skipped
+    tikz::core::Document doc;
+    QVERIFY(doc.load(QUrl::fromLocalFile(filename)));
+    QCOMPARE(doc.nodeRange().size(), 1);
+    auto node = tikz::core::Uid(nodeId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(1, 1));
+}
+
+void DocumentTest::cborFormatTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl jsonUrl = QUrl::fromLocalFile(dir.filePath("document.tikzkit"));
+    const QUrl cborUrl = QUrl::fromLocalFile(dir.filePath("document.cbor"));
+
+    qint64 nodeId;
+    {
+        tikz::core::Document doc;
+        QCOMPARE(doc.fileFormat(), tikz::core::Document::FileFormat::Json);
+        auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        nodeId = node->uid().id();
+        node->setPos(tikz::Pos(1.0 / 3.0, 2.0, tikz::Unit::Centimeter));
+        node->setPos(tikz::Pos(0.1, -0.2, tikz::Unit::Centimeter));
+        QVERIFY(doc.saveAs(jsonUrl));
+
+        doc.setFileFormat(tikz::core::Document::FileFormat::Cbor);
+        QVERIFY(doc.saveAs(cborUrl));
+    }
+
+    // the binary file is smaller
+    QVERIFY(QFileInfo(cborUrl.toLocalFile()).size() < QFileInfo(jsonUrl.toLocalFile()).size());
+
+    // the format is detected, and kept when saving again
+    tikz::core::Document doc;
+    QVERIFY(doc.load(cborUrl));
+    QCOMPARE(doc.fileFormat(), tikz::core::Document::FileFormat::Cbor);
+    auto node = tikz::core::Uid(nodeId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(0.1, -0.2, tikz::Unit::Centimeter));
+    QCOMPARE(node->pos().x().value(), 0.1);
+
+    // the history is restored from the binary data
+    doc.undo();
+    QCOMPARE(node->pos().x().value(), 1.0 / 3.0);
+
+    QVERIFY(doc.load(jsonUrl));
+    QCOMPARE(doc.fileFormat(), tikz::core::Document::FileFormat::Json);
+}
+
+void DocumentTest::chunkedFormatTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("document.tikzkit"));
+    const QString filename = url.toLocalFile();
+
+    qint64 fullSize;
+    qint64 movedId;
+    qint64 deletedId;
+    {
+        tikz::core::Document doc;
+        doc.setFileFormat(tikz::core::Document::FileFormat::Chunked);
+        const auto nodes = doc.createEntities(tikz::EntityType::Node, 1000);
+        {
+            tikz::core::Transaction transaction(&doc, "Move Nodes");
+            for (int i = 0; i < nodes.size(); ++i) {
+                static_cast<tikz::core::Node *>(nodes[i])->setPos(tikz::Pos(i, 0));
+            }
+        }
+        QVERIFY(doc.saveAs(url));
+        fullSize = QFileInfo(filename).size();
+
+        // moving one node appends only a small part of the file
+        auto node = static_cast<tikz::core::Node *>(nodes[500]);
+        movedId = node->uid().id();
+        node->setPos(tikz::Pos(-1, -1));
+        QVERIFY(doc.save());
+        const qint64 growth = QFileInfo(filename).size() - fullSize;
+        QVERIFY(growth > 0);
+        QVERIFY(growth < fullSize / 4);
+
+        deletedId = nodes[0]->uid().id();
+        doc.deleteEntity(nodes[0]->uid());
+        QVERIFY(doc.save());
+    }
+
+    // the state and the history of the last save are restored
+    tikz::core::Document doc;
+    QVERIFY(doc.load(url));
+    QCOMPARE(doc.fileFormat(), tikz::core::Document::FileFormat::Chunked);
+    QCOMPARE(doc.nodeRange().size(), 999);
+    QVERIFY(!tikz::core::Uid(deletedId, &doc).entity());
+    auto node = tikz::core::Uid(movedId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(-1, -1));
+
+    doc.undo();
+    QVERIFY(tikz::core::Uid(deletedId, &doc).entity());
+    doc.undo();
+    QCOMPARE(node->pos(), tikz::Pos(500, 0));
+    doc.redo();
+    doc.redo();
+
+    // the unreferenced chunks of repeated saves are compacted
+    for (int i = 0; i < 200; ++i) {
+        node->setPos(tikz::Pos(i, i));
+        QVERIFY(doc.save());
+    }
+    QVERIFY(QFileInfo(filename).size() < 2 * fullSize + 512 * 1024);
+
+    QVERIFY(doc.load(url));
+    node = tikz::core::Uid(movedId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QCOMPARE(node->pos(), tikz::Pos(199, 199));
+    QCOMPARE(doc.nodeRange().size(), 999);
+}
+
+void DocumentTest::historyModelTest()
+{
+    tikz::core::Document doc;
+    QAbstractItemModel * model = doc.historyModel();
+    QSignalSpy insertSpy(model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removeSpy(model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy resetSpy(model, &QAbstractItemModel::modelReset);
+
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+    node->setPos(tikz::Pos(1, 1));
+    node->setPos(tikz::Pos(2, 2));
+    QCOMPARE(model->rowCount(), 3);
+    QCOMPARE(insertSpy.count(), 3);
+    QCOMPARE(insertSpy.last().at(1).toInt(), 2);
+    QCOMPARE(insertSpy.last().at(2).toInt(), 2);
+
+    // the current group is bold
+    QVERIFY(model->index(2, 0).data(Qt::FontRole).value<QFont>().bold());
+    QVERIFY(!model->index(1, 0).data(Qt::FontRole).isValid());
+
+    // undo and redo only move the cursor, the rows stay
+    doc.undo();
+    QCOMPARE(model->rowCount(), 3);
+    QVERIFY(model->index(1, 0).data(Qt::FontRole).value<QFont>().bold());
+    QVERIFY(!model->index(2, 0).data(Qt::FontRole).isValid());
+
+    // child rows are the undo items of a group
+    const QModelIndex group = model->index(1, 0);
+    QCOMPARE(model->rowCount(group), 1);
+    const QPersistentModelIndex item = model->index(0, 0, group);
+    QVERIFY(item.isValid());
+    QCOMPARE(model->parent(item), group);
+    QCOMPARE(item.data().toString(), QStringLiteral("Move Node"));
+
+    // a new group replaces the redo group with one removal
+    node->setPos(tikz::Pos(3, 3));
+    QCOMPARE(model->rowCount(), 3);
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(removeSpy.last().at(1).toInt(), 2);
+    QCOMPARE(removeSpy.last().at(2).toInt(), 2);
+
+    // the limit removes the oldest group, items of other groups stay valid
+    doc.setHistoryLimit(2);
+    QCOMPARE(model->rowCount(), 2);
+    QCOMPARE(removeSpy.count(), 2);
+    QCOMPARE(removeSpy.last().at(1).toInt(), 0);
+    QCOMPARE(removeSpy.last().at(2).toInt(), 0);
+    QVERIFY(item.isValid());
+    QCOMPARE(item.parent().row(), 0);
+    QCOMPARE(item.data().toString(), QStringLiteral("Move Node"));
+
+    doc.undo();
+    doc.undo();
+    QVERIFY(!doc.undoAvailable());
+    QCOMPARE(node->pos(), tikz::Pos(0, 0));
+
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void DocumentTest::gestureTest()
+{
+    tikz::core::Document doc;
+    auto nodes = doc.createEntities(tikz::EntityType::Node, 3);
+    QAbstractItemModel * model = doc.historyModel();
+    const int groups = model->rowCount();
+
+    // drag all nodes in 10 steps
+    {
+        tikz::core::Transaction transaction(&doc, "Move Nodes", tikz::core::Transaction::Gesture);
+        QVERIFY(doc.gestureRunning());
+        for (int step = 1; step <= 10; ++step) {
+            for (int i = 0; i < nodes.size(); ++i) {
+                static_cast<tikz::core::Node *>(nodes[i])->setPos(tikz::Pos(step, i));
+            }
+            // the model is updated right away
+            QCOMPARE(static_cast<tikz::core::Node *>(nodes[0])->pos(), tikz::Pos(step, 0));
+        }
+    }
+    QVERIFY(!doc.gestureRunning());
+
+    // one undo group with one undo item per node
+    QCOMPARE(model->rowCount(), groups + 1);
+    QCOMPARE(model->rowCount(model->index(groups, 0)), 3);
+
+    doc.undo();
+    for (int i = 0; i < nodes.size(); ++i) {
+        QCOMPARE(static_cast<tikz::core::Node *>(nodes[i])->pos(), tikz::Pos(0, 0));
+    }
+
+    doc.redo();
+    for (int i = 0; i < nodes.size(); ++i) {
+        QCOMPARE(static_cast<tikz::core::Node *>(nodes[i])->pos(), tikz::Pos(10, i));
+    }
+
+    // canceling a gesture reverts all steps
+    {
+        tikz::core::Transaction transaction(&doc, "Move Nodes", tikz::core::Transaction::Gesture);
+        for (int step = 1; step <= 10; ++step) {
+            static_cast<tikz::core::Node *>(nodes[0])->setPos(tikz::Pos(-step, -step));
+        }
+        transaction.cancel();
+    }
+    QCOMPARE(static_cast<tikz::core::Node *>(nodes[0])->pos(), tikz::Pos(10, 0));
+    QCOMPARE(model->rowCount(), groups + 1);
+
+    // gesture changes and other changes are reverted in reverse order
+    const tikz::core::Uid uid = nodes[2]->uid();
+    for (bool cancel : { true, false }) {
+        tikz::core::Transaction transaction(&doc, "Move and Delete", tikz::core::Transaction::Gesture);
+        uid.entity<tikz::core::Node>()->setPos(tikz::Pos(20, 20));
+        doc.deleteEntity(uid);
+        QVERIFY(!uid.entity());
+        if (cancel) {
+            transaction.cancel();
+            QVERIFY(uid.entity());
+            QCOMPARE(uid.entity<tikz::core::Node>()->pos(), tikz::Pos(10, 2));
+        }
+    }
+    QVERIFY(!uid.entity());
+    doc.undo();
+    QVERIFY(uid.entity());
+    QCOMPARE(uid.entity<tikz::core::Node>()->pos(), tikz::Pos(10, 2));
+}
+
+void DocumentTest::journalTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString journal = dir.filePath("autosave.journal");
+
+    // a session that is never saved
+    qint64 nodeId;
+    qint64 otherId;
+    {
+        tikz::core::Document doc;
+        QVERIFY(doc.setJournalFile(journal));
+        QCOMPARE(doc.journalFile(), journal);
+
+        auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        auto other = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+        nodeId = node->uid().id();
+        otherId = other->uid().id();
+        node->setPos(tikz::Pos(1, 1));
+        node->setPos(tikz::Pos(2, 2));
+        doc.undo();
+        other->setPos(tikz::Pos(3, 3));
+        doc.undo();
+        doc.redo();
+    }
+
+    // a crash may leave an incomplete record
+    {
+        QFile file(journal);
+        QVERIFY(file.open(QIODevice::Append));
+        file.write("\x00\x00\x01", 3);
+    }
+
+    // recovery replays the journal, including undo and redo
+    tikz::core::Document doc;
+    QVERIFY(doc.recoverJournal(journal));
+    QCOMPARE(doc.nodeRange().size(), 2);
+    auto node = tikz::core::Uid(nodeId, &doc).entity<tikz::core::Node>();
+    auto other = tikz::core::Uid(otherId, &doc).entity<tikz::core::Node>();
+    QVERIFY(node);
+    QVERIFY(other);
+    QCOMPARE(node->pos(), tikz::Pos(1, 1));
+    QCOMPARE(other->pos(), tikz::Pos(3, 3));
+    QVERIFY(!doc.redoAvailable());
+
+    // the recovered history can be undone
+    doc.undo();
+    QCOMPARE(other->pos(), tikz::Pos(0, 0));
+    doc.redo();
+
+    // the journal continues, and saving truncates it
+    QCOMPARE(doc.journalFile(), journal);
+    const qint64 size = QFileInfo(journal).size();
+    node->setPos(tikz::Pos(4, 4));
+    QVERIFY(QFileInfo(journal).size() > size);
+    QVERIFY(doc.saveAs(QUrl::fromLocalFile(dir.filePath("saved.tikzkit"))));
+    QVERIFY(QFileInfo(journal).size() < size);
+
+    // an empty journal replays nothing
+    tikz::core::Document empty;
+    QVERIFY(empty.recoverJournal(journal));
+    QCOMPARE(empty.nodeRange().size(), 0);
+}
+
+void DocumentTest::journalPropertyOrderTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString journal = dir.filePath("autosave.journal");
+
+    // the crashed session changes a property without an entry in properties.json
+    qint64 parentId;
+    qint64 childId;
+    {
+        tikz::core::Document doc;
+        QVERIFY(doc.setJournalFile(journal));
+        auto parent = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+        auto child = doc.createEntity<tikz::core::Style>(tikz::EntityType::Style);
+        parentId = parent->uid().id();
+        childId = child->uid().id();
+        doc.addUndoItem(new tikz::core::UndoSetProperty(child->uid(), "parentStyle", QVariant::fromValue(parent->uid())));
+    }
+
+    // the recovering run registers the properties in another order
+    auto & manager = tikz::core::propertyManager();
+    manager.clearRegisteredProperties();
+    manager.propertyId("someProperty");
+    manager.propertyId("anotherProperty");
+
+    tikz::core::Document doc;
+    QVERIFY(doc.recoverJournal(journal));
+    auto child = tikz::core::Uid(childId, &doc).entity<tikz::core::Style>();
+    QVERIFY(child);
+    QCOMPARE(child->parentStyle().id(), parentId);
+
+    doc.undo();
+    QVERIFY(!child->parentStyle().isValid());
+}
+
+void DocumentTest::benchmarkCreateEntity()
+{
+    QBENCHMARK {
+        tikz::core::Document doc;
+        tikz::core::Transaction transaction(&doc, "Create Nodes");
+        for (int i = 0; i < s_nodeCount; ++i) {
+            doc.createEntity(tikz::EntityType::Node);
+        }
+    }
+}
+
+void DocumentTest::benchmarkCreateEntities()
+{
+    QBENCHMARK {
+        tikz::core::Document doc;
+        doc.createEntities(tikz::EntityType::Node, s_nodeCount);
+    }
+}
+
+void DocumentTest::benchmarkDragGesture()
+{
+    // drag 1000 selected nodes in 1000 steps
+    const int count = 1000;
+    const int steps = 1000;
+
+    tikz::core::Document doc;
+    const auto nodes = doc.createEntities(tikz::EntityType::Node, count);
+
+    QBENCHMARK {
+        tikz::core::Transaction transaction(&doc, "Move Nodes", tikz::core::Transaction::Gesture);
+        for (int step = 1; step <= steps; ++step) {
+            for (int i = 0; i < count; ++i) {
+                static_cast<tikz::core::Node *>(nodes[i])->setPos(tikz::Pos(step, i));
+            }
+        }
+    }
+}
+
+void DocumentTest::benchmarkJournalCommit()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // the cost of a journaled transaction does not depend on the document size
+    tikz::core::Document doc;
+    doc.createEntities(tikz::EntityType::Node, s_nodeCount);
+    QVERIFY(doc.setJournalFile(dir.filePath("autosave.journal")));
+    auto node = doc.createEntity<tikz::core::Node>(tikz::EntityType::Node);
+
+    int step = 0;
+    QBENCHMARK {
+        ++step;
+        node->setPos(tikz::Pos(step, step));
+    }
+}
+
+void DocumentTest::benchmarkSaveLargeDocument()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("large.tikzkit"));
+
+    tikz::core::Document doc;
+    const auto nodes = doc.createEntities(tikz::EntityType::Node, 100000);
+    {
+        tikz::core::Transaction transaction(&doc, "Move Nodes");
+        for (int i = 0; i < nodes.size(); ++i) {
+            static_cast<tikz::core::Node *>(nodes[i])->setPos(tikz::Pos(i % 1000, i / 1000));
+        }
+    }
+
+    // measure a single save in isolation: reset the peak first, so that
+    // creating the document above does not hide the peak of the save
+    const long rssBefore = resetPeakMemoryUsage();
+    QVERIFY(doc.saveAs(url));
+    const long peakAfter = peakMemoryUsage();
+
+    // the file is streamed, so saving must not raise the peak memory usage
+    // by a multiple of the file size, as building a JSON tree would
+    if (rssBefore >= 0 && peakAfter >= 0) {
+        const long fileSize = QFileInfo(url.toLocalFile()).size() / 1024;
+        const long increase = peakAfter - rssBefore;
+        QVERIFY2(increase < 2 * fileSize,
+                 qPrintable(QStringLiteral("peak RSS increase of %1 KiB for a file of %2 KiB")
+                            .arg(increase).arg(fileSize)));
+    }
+
+    QBENCHMARK {
+        QVERIFY(doc.saveAs(url));
+    }
+}
+
+void DocumentTest::benchmarkIncrementalSave()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("large.tikzkit"));
+
+    tikz::core::Document doc;
+    doc.setFileFormat(tikz::core::Document::FileFormat::Chunked);
+    const auto nodes = doc.createEntities(tikz::EntityType::Node, 100000);
+    QVERIFY(doc.saveAs(url));
+
+    // each save writes only the moved node
+    auto node = static_cast<tikz::core::Node *>(nodes[nodes.size() / 2]);
+    int step = 0;
+    QBENCHMARK {
+        ++step;
+        node->setPos(tikz::Pos(step, step));
+        QVERIFY(doc.save());
+    }
+}
+
+void DocumentTest::benchmarkLoad_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<tikz::core::Document::FileFormat>("format");
+
+    const auto json = tikz::core::Document::FileFormat::Json;
+    const auto cbor = tikz::core::Document::FileFormat::Cbor;
+    QTest::newRow("json 1k") << 1000 << json;
+    QTest::newRow("json 10k") << 10000 << json;
+    QTest::newRow("json 100k") << 100000 << json;
+    QTest::newRow("cbor 1k") << 1000 << cbor;
+    QTest::newRow("cbor 10k") << 10000 << cbor;
+    QTest::newRow("cbor 100k") << 100000 << cbor;
+}
+
+void DocumentTest::benchmarkLoad()
+{
+    QFETCH(int, count);
+    QFETCH(tikz::core::Document::FileFormat, format);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("load.tikzkit"));
+
+    // half of the entities are nodes, the other half are paths
+    {
+        tikz::core::Document doc;
+        doc.setFileFormat(format);
+        doc.createEntities(tikz::EntityType::Node, count / 2);
+        doc.createEntities(tikz::EntityType::Path, count - count / 2);
+        QVERIFY(doc.saveAs(url));
+    }
+
+    QBENCHMARK {
+        tikz::core::Document doc;
+        QVERIFY(doc.load(url));
+    }
+}
+
 // kate: indent-width 4; replace-tabs on;
@@ -13,6 +13,31 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void documentTest();
+    void entityRangeTest();
+    void changeSetTest();
+    void createEntitiesTest();
+    void historyMemoryBudgetTest();
+    void spilledEnumTest();
+    void checkpointLoadTest();
+    void propertyOrderTest();
+    void compactReplayTest();
+    void incompleteHistoryTest();
+    void loadEntitiesTest();
+    void invalidIdTest();
+    void cborFormatTest();
+    void chunkedFormatTest();
+    void historyModelTest();
+    void gestureTest();
+    void journalTest();
+    void journalPropertyOrderTest();
+    void benchmarkCreateEntity();
+    void benchmarkCreateEntities();
+    void benchmarkDragGesture();
+    void benchmarkJournalCommit();
+    void benchmarkSaveLargeDocument();
+    void benchmarkIncrementalSave();
+    void benchmarkLoad_data();
+    void benchmarkLoad();
 };
 
 #endif // DOCUMENT_TEST_H
@@ -1,10 +1,14 @@
 #include "edgetest.h"
 
 #include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
 
 #include <tikz/core/Node.h>
 #include <tikz/core/Path.h>
+#include <tikz/core/EdgePath.h>
 #include <tikz/core/Document.h>
+#include <tikz/core/Transaction.h>
+#include <tikz/core/UndoDeleteEntity.h>
 
 QTEST_MAIN(EdgeTest)
 
@@ -47,4 +51,88 @@ void EdgeTest::edgeTest()
 #endif
 }
 
+void EdgeTest::attachedPathsTest()
+{
+    tikz::core::Document doc;
+    auto n1 = doc.createNode();
+    auto n2 = doc.createNode();
+    auto edge = qobject_cast<tikz::core::EdgePath *>(doc.createPath());
+    QVERIFY(edge);
+    QVERIFY(doc.attachedPaths(n1->uid()).isEmpty());
+
+    const tikz::core::Uid n1Uid = n1->uid();
+    const QVector<tikz::core::Uid> edgeOnly{edge->uid()};
+
+    edge->setStartNode(n1);
+    edge->setEndNode(n2);
+    QCOMPARE(doc.attachedPaths(n1Uid), edgeOnly);
+    QCOMPARE(doc.attachedPaths(n2->uid()), edgeOnly);
+
+    // attaching both ends to the same node lists the path once
+    edge->setEndNode(n1);
+    QCOMPARE(doc.attachedPaths(n1Uid), edgeOnly);
+    QVERIFY(doc.attachedPaths(n2->uid()).isEmpty());
+
+    // moving a node notifies the attached paths
+    QSignalSpy spy(edge, SIGNAL(changed()));
+    n1->setPos(tikz::Pos(1, 1));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(edge->startPos(), tikz::Pos(1, 1));
+
+    // deleting a node detaches all attached paths
+    doc.deleteEntity(n1);
+    QVERIFY(edge->startNode() == nullptr);
+    QVERIFY(edge->endNode() == nullptr);
+    QCOMPARE(edge->startPos(), tikz::Pos(1, 1));
+    QVERIFY(doc.attachedPaths(n1Uid).isEmpty());
+
+    // undo attaches the path again
+    doc.undo();
+    QCOMPARE(doc.attachedPaths(n1Uid), edgeOnly);
+    QVERIFY(edge->startNode() != nullptr);
+    QCOMPARE(edge->startNode()->uid(), n1Uid);
+
+    // deleting the path removes its attachments
+    doc.deleteEntity(edge);
+    QVERIFY(doc.attachedPaths(n1Uid).isEmpty());
+}
+
+void EdgeTest::deleteAttachedNodeTest()
+{
+    tikz::core::Document doc;
+    auto node = doc.createNode();
+    auto edge = qobject_cast<tikz::core::EdgePath *>(doc.createPath());
+    QVERIFY(edge);
+    node->setPos(tikz::Pos(1, 1));
+    edge->setStartNode(node);
+    edge->setEndNode(node);
+
+    const tikz::core::Uid nodeUid = node->uid();
+    const QVector<tikz::core::Uid> edgeOnly{edge->uid()};
+
+    // delete the node without detaching the edge first
+    {
+        tikz::core::Transaction transaction(&doc, "Delete node");
+        doc.addUndoItem(new tikz::core::UndoDeleteEntity(nodeUid, &doc));
+    }
+    QVERIFY(!nodeUid.entity());
+    QVERIFY(edge->startNode() == nullptr);
+    QVERIFY(edge->endNode() == nullptr);
+    QCOMPARE(edge->startPos(), tikz::Pos(1, 1));
+    QVERIFY(doc.attachedPaths(nodeUid).isEmpty());
+
+    // undo restores both the node and the attachments of the edge
+    doc.undo();
+    QVERIFY(nodeUid.entity());
+    QVERIFY(edge->startNode() != nullptr);
+    QCOMPARE(edge->startNode()->uid(), nodeUid);
+    QCOMPARE(edge->endNode()->uid(), nodeUid);
+    QCOMPARE(doc.attachedPaths(nodeUid), edgeOnly);
+
+    // redo detaches again
+    doc.redo();
+    QVERIFY(edge->startNode() == nullptr);
+    QVERIFY(doc.attachedPaths(nodeUid).isEmpty());
+}
+
 // kate: indent-width 4; replace-tabs on;
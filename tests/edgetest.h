@@ -13,6 +13,8 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void edgeTest();
+    void attachedPathsTest();
+    void deleteAttachedNodeTest();
 };
 
 #endif // EDGE_TEST_H
@@ -1,16 +1,24 @@
 #include "tikzdocumenttest.h"
 
 #include <QtTest/QTest>
+#include <QtTest/QSignalSpy>
 #include <QDebug>
 #include <QUndoStack>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QGraphicsView>
+#include <QSet>
 
 #include <tikz/core/Document.h>
 #include <tikz/core/Node.h>
 #include <tikz/core/Path.h>
+#include <tikz/core/EdgePath.h>
 
 #include <tikz/ui/Editor.h>
 #include <tikz/ui/Document.h>
 #include <tikz/ui/NodeItem.h>
+#include <tikz/ui/PathItem.h>
+#include <tikz/ui/View.h>
 
 QTEST_MAIN(TikzDocumentTest)
 
@@ -33,4 +41,106 @@ void TikzDocumentTest::documentTest()
 //     tikz::core::Node * node = doc.createNode();
 }
 
+void TikzDocumentTest::progressiveLoadTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("progressive.tikzkit"));
+
+    {
+        // each path connects two nodes
+        auto doc = tikz::ui::Editor::instance()->createDocument(nullptr);
+        const auto nodes = doc->createEntities(tikz::EntityType::Node, 2000);
+        const auto paths = doc->createEntities(tikz::EntityType::Path, 1000);
+        for (int i = 0; i < paths.size(); ++i) {
+            auto edge = static_cast<tikz::core::EdgePath *>(paths[i]);
+            edge->setStartNode(static_cast<tikz::core::Node *>(nodes[2 * i]));
+            edge->setEndNode(static_cast<tikz::core::Node *>(nodes[2 * i + 1]));
+        }
+        QVERIFY(doc->saveAs(url));
+        delete doc;
+    }
+
+    auto doc = tikz::ui::Editor::instance()->createDocument(nullptr);
+    QSignalSpy progressSpy(doc, &tikz::ui::Document::loadProgress);
+    QVERIFY(doc->loadProgressive(url));
+
+    // without views, no items are visible, so all items are pending.
+    // Attached paths must not create the items of their nodes.
+    QCOMPARE(doc->nodeRange().size(), 2000);
+    QCOMPARE(doc->pathRange().size(), 1000);
+    QVERIFY(doc->nodeItems().size() < 100);
+    QVERIFY(doc->pathItems().size() < 100);
+    QCOMPARE(progressSpy.count(), 1);
+    QCOMPARE(progressSpy.first().at(1).toInt(), 3000);
+
+    // the remaining items are created on the event loop
+    QTRY_COMPARE(doc->nodeItems().size(), 2000);
+    QTRY_COMPARE(doc->pathItems().size(), 1000);
+    QCOMPARE(progressSpy.last().at(0).toInt(), 3000);
+    QCOMPARE(progressSpy.last().at(1).toInt(), 3000);
+
+    // deleting entities while the items are pending
+    QVERIFY(doc->loadProgressive(url));
+    doc->deleteEntity(*doc->nodeRange().begin());
+    QTRY_COMPARE(doc->nodeItems().size(), 1999);
+    QTRY_COMPARE(doc->pathItems().size(), 1000);
+
+    delete doc;
+}
+
+void TikzDocumentTest::progressiveLoadViewTest()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QUrl url = QUrl::fromLocalFile(dir.filePath("progressive.tikzkit"));
+
+    // a grid of nodes around the origin, 1cm apart
+    {
+        auto doc = tikz::ui::Editor::instance()->createDocument(nullptr);
+        const auto nodes = doc->createEntities(tikz::EntityType::Node, 2000);
+        for (int i = 0; i < nodes.size(); ++i) {
+            static_cast<tikz::core::Node *>(nodes[i])->setPos(
+                tikz::Pos(i % 50 - 25, i / 50 - 20, tikz::Unit::Centimeter));
+        }
+        QVERIFY(doc->saveAs(url));
+        delete doc;
+    }
+
+    // like DocumentManager::openUrl(), the view is created after loading
+    auto doc = tikz::ui::Editor::instance()->createDocument(nullptr);
+    QVERIFY(doc->loadProgressive(url));
+    QVERIFY(doc->nodeItems().isEmpty());
+
+    // showing the view creates the visible items, without the event loop
+    auto view = doc->createView(nullptr);
+    view->resize(400, 300);
+    view->show();
+
+    auto renderer = view->findChild<QGraphicsView *>();
+    QVERIFY(renderer);
+    const QRectF visibleRect = renderer->mapToScene(renderer->viewport()->rect()).boundingRect();
+
+    QSet<tikz::core::Uid> items;
+    for (auto item : doc->nodeItems()) {
+        items.insert(item->uid());
+    }
+
+    int visible = 0;
+    for (auto node : doc->nodeRange()) {
+        if (visibleRect.contains(node->pos())) {
+            QVERIFY(items.contains(node->uid()));
+            ++visible;
+        }
+    }
+    QVERIFY(visible > 0);
+    QVERIFY(items.size() < 2000);
+
+    // the remaining items are created on the event loop
+    QTRY_COMPARE(doc->nodeItems().size(), 2000);
+
+    delete view;
+    delete doc;
+}
+
 // kate: indent-width 4; replace-tabs on;
@@ -13,6 +13,8 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     void documentTest();
+    void progressiveLoadTest();
+    void progressiveLoadViewTest();
 };
 
 #endif // TIKZ_DOCUMENT_TEST_H